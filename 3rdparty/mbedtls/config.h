@@ -430,7 +430,11 @@
 //#define MBEDTLS_MD5_PROCESS_ALT
 //#define MBEDTLS_RIPEMD160_PROCESS_ALT
 //#define MBEDTLS_SHA1_PROCESS_ALT
-//#define MBEDTLS_SHA256_PROCESS_ALT
+// Open Enclave: hash blocks with oe_sha256_compress(), which uses the SHA
+// extensions of the CPU when it has them (mbedtls_sha256_process.c)
+#if defined(__x86_64__)
+#define MBEDTLS_SHA256_PROCESS_ALT
+#endif
 //#define MBEDTLS_SHA512_PROCESS_ALT
 //#define MBEDTLS_DES_SETKEY_ALT
 //#define MBEDTLS_DES_CRYPT_ECB_ALT
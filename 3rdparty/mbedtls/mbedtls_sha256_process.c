@@ -0,0 +1,17 @@
+// Copyright (c) Open Enclave SDK contributors.
+// Licensed under the MIT License.
+
+#include <openenclave/internal/sha256.h>
+#include "mbedtls/include/mbedtls/sha256.h"
+
+#if defined(MBEDTLS_SHA256_PROCESS_ALT)
+
+int mbedtls_internal_sha256_process(
+    mbedtls_sha256_context* ctx,
+    const unsigned char data[64])
+{
+    oe_sha256_compress(ctx->state, data, 1);
+    return 0;
+}
+
+#endif /* MBEDTLS_SHA256_PROCESS_ALT */
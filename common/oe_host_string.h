@@ -34,6 +34,12 @@ int oe_strncmp(const char* s1, const char* s2, size_t n)
     return strncmp(s1, s2, n);
 }
 
+OE_INLINE
+char* oe_strstr(const char* haystack, const char* needle)
+{
+    return strstr(haystack, needle);
+}
+
 /* host already has an oe_strlcpy implementation */
 
 /* host already has an oe_strlcat implementation */
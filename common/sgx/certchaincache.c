@@ -0,0 +1,297 @@
+// Copyright (c) Open Enclave SDK contributors.
+// Licensed under the MIT License.
+
+#include "certchaincache.h"
+#include <openenclave/internal/crypto/sha.h>
+#include <openenclave/internal/raise.h>
+#include <openenclave/internal/trace.h>
+#include "../common.h"
+
+#ifdef OE_BUILD_ENCLAVE
+#include <openenclave/internal/thread.h>
+typedef oe_mutex_t _mutex_t;
+#define _MUTEX_INITIALIZER OE_MUTEX_INITIALIZER
+#else
+#include "../../host/hostthread.h"
+typedef oe_mutex _mutex_t;
+#define _MUTEX_INITIALIZER OE_H_MUTEX_INITIALIZER
+#endif
+
+/*
+**==============================================================================
+**
+** SGX certificate chain cache:
+**
+**     Every quote carries its PCK certificate chain, and every set of
+**     endorsements carries the TCB info, QE identity and CRL issuer chains.
+**     Apart from the PCK certificate itself, these chains consist of the
+**     same few Intel CA certificates for all platforms of a family.
+**     Reading a chain parses each certificate and verifies each signature,
+**     so the verified chains are cached by the SHA-256 of their PEM data.
+**
+**     Only chains anchored at Intel's root CA are cached. There are few of
+**     them, so the fixed number of entries is not exhausted by chains that a
+**     caller makes up, and those are read and verified on every call.
+**
+**     Entries are only added, never replaced, so a chain handed out by the
+**     cache stays valid without reference counting. Chains are read-only
+**     once cached; the crypto layer's reference counts are atomic, so
+**     certificates can be taken from a cached chain concurrently.
+**
+**==============================================================================
+*/
+
+// Public key of Intel's root certificate, as the X and Y coordinates of a
+// P-256 point, so that it is imported without parsing PEM.
+static const uint8_t _intel_root_key_x[] = {
+    0x0b, 0xa9, 0xc4, 0xc0, 0xc0, 0xc8, 0x61, 0x93, 0xa3, 0xfe, 0x23,
+    0xd6, 0xb0, 0x2c, 0xda, 0x10, 0xa8, 0xbb, 0xd4, 0xe8, 0x8e, 0x48,
+    0xb4, 0x45, 0x85, 0x61, 0xa3, 0x6e, 0x70, 0x55, 0x25, 0xf5,
+};
+
+static const uint8_t _intel_root_key_y[] = {
+    0x67, 0x91, 0x8e, 0x2e, 0xdc, 0x88, 0xe4, 0x0d, 0x86, 0x0b, 0xd0,
+    0xcc, 0x4e, 0xe2, 0x6a, 0xac, 0xc9, 0x88, 0xe5, 0x05, 0xa9, 0x53,
+    0x55, 0x8c, 0x45, 0x3f, 0x6b, 0x09, 0x04, 0xae, 0x73, 0x94,
+};
+
+static oe_ec_public_key_t _intel_root_key;
+static bool _intel_root_key_parsed;
+
+typedef struct _entry
+{
+    OE_SHA256 hash;
+    size_t pem_size;
+    oe_cert_chain_t chain;
+    bool intel_root;
+} _entry_t;
+
+static _entry_t _entries[OE_SGX_CERT_CHAIN_CACHE_SIZE];
+static size_t _num_entries;
+static oe_sgx_cert_chain_cache_stats_t _stats;
+
+/* Protects all of the above */
+static _mutex_t _lock = _MUTEX_INITIALIZER;
+
+oe_result_t oe_sgx_get_intel_root_key(const oe_ec_public_key_t** key)
+{
+    oe_result_t result = OE_UNEXPECTED;
+
+    if (!key)
+        OE_RAISE(OE_INVALID_PARAMETER);
+
+    oe_mutex_lock(&_lock);
+
+    if (!_intel_root_key_parsed)
+    {
+        result = oe_ec_public_key_from_coordinates(
+            &_intel_root_key,
+            OE_EC_TYPE_SECP256R1,
+            _intel_root_key_x,
+            sizeof(_intel_root_key_x),
+            _intel_root_key_y,
+            sizeof(_intel_root_key_y));
+        _intel_root_key_parsed = (result == OE_OK);
+    }
+    else
+        result = OE_OK;
+
+    oe_mutex_unlock(&_lock);
+
+    if (result != OE_OK)
+        OE_RAISE_MSG(result, "Failed to read expected root cert key.", NULL);
+
+    *key = &_intel_root_key;
+
+done:
+    return result;
+}
+
+static oe_result_t _has_intel_root(oe_cert_chain_t* chain, bool* intel_root)
+{
+    oe_result_t result = OE_UNEXPECTED;
+    const oe_ec_public_key_t* intel_root_key = NULL;
+    oe_cert_t root_cert = {0};
+    oe_ec_public_key_t root_key = {0};
+
+    *intel_root = false;
+
+    OE_CHECK(oe_sgx_get_intel_root_key(&intel_root_key));
+    OE_CHECK_MSG(
+        oe_cert_chain_get_root_cert(chain, &root_cert),
+        "Failed to get root certificate.",
+        NULL);
+
+    // A root with a key of another type is simply not Intel's root.
+    if (oe_cert_get_ec_public_key(&root_cert, &root_key) == OE_OK)
+        OE_CHECK(oe_ec_public_key_equal(&root_key, intel_root_key, intel_root));
+
+    result = OE_OK;
+
+done:
+    oe_ec_public_key_free(&root_key);
+    oe_cert_free(&root_cert);
+
+    return result;
+}
+
+oe_result_t oe_sgx_read_cert_chain(
+    const uint8_t* pem_data,
+    size_t pem_size,
+    oe_sgx_cert_chain_t* chain)
+{
+    oe_result_t result = OE_UNEXPECTED;
+
+    if (chain)
+        memset(chain, 0, sizeof(*chain));
+
+    if (!pem_data || !pem_size || !chain)
+        OE_RAISE(OE_INVALID_PARAMETER);
+
+    OE_CHECK_MSG(
+        oe_cert_chain_read_pem(&chain->owned_chain, pem_data, pem_size),
+        "Failed to parse certificate chain.",
+        NULL);
+    chain->chain = &chain->owned_chain;
+
+    OE_CHECK(_has_intel_root(chain->chain, &chain->intel_root));
+
+    result = OE_OK;
+
+done:
+    if (result != OE_OK && chain)
+        oe_sgx_free_cert_chain(chain);
+
+    return result;
+}
+
+static oe_result_t _hash(const uint8_t* data, size_t size, OE_SHA256* hash)
+{
+    oe_result_t result = OE_UNEXPECTED;
+    oe_sha256_context_t context = {0};
+
+    OE_CHECK(oe_sha256_init(&context));
+    OE_CHECK(oe_sha256_update(&context, data, size));
+    OE_CHECK(oe_sha256_final(&context, hash));
+
+    result = OE_OK;
+
+done:
+    return result;
+}
+
+/* Find the cached entry for the chain. Called with _lock held */
+static _entry_t* _find(const OE_SHA256* hash, size_t pem_size)
+{
+    for (size_t i = 0; i < _num_entries; i++)
+    {
+        if (_entries[i].pem_size == pem_size &&
+            memcmp(&_entries[i].hash, hash, sizeof(*hash)) == 0)
+            return &_entries[i];
+    }
+
+    return NULL;
+}
+
+static void _use_entry(const _entry_t* entry, oe_sgx_cert_chain_t* chain)
+{
+    chain->chain = (oe_cert_chain_t*)&entry->chain;
+    chain->intel_root = entry->intel_root;
+}
+
+oe_result_t oe_sgx_get_cert_chain(
+    const uint8_t* pem_data,
+    size_t pem_size,
+    oe_sgx_cert_chain_t* chain)
+{
+    oe_result_t result = OE_UNEXPECTED;
+    OE_SHA256 hash = {0};
+    _entry_t* entry = NULL;
+
+    if (chain)
+        memset(chain, 0, sizeof(*chain));
+
+    if (!pem_data || !pem_size || !chain)
+        OE_RAISE(OE_INVALID_PARAMETER);
+
+    OE_CHECK(_hash(pem_data, pem_size, &hash));
+
+    oe_mutex_lock(&_lock);
+    if ((entry = _find(&hash, pem_size)))
+    {
+        _use_entry(entry, chain);
+        _stats.hits++;
+    }
+    oe_mutex_unlock(&_lock);
+
+    if (entry)
+    {
+        result = OE_OK;
+        goto done;
+    }
+
+    // Parse and verify outside the lock.
+    OE_CHECK(oe_sgx_read_cert_chain(pem_data, pem_size, chain));
+
+    oe_mutex_lock(&_lock);
+
+    _stats.misses++;
+
+    // Another thread may have cached the same chain in the meantime.
+    if ((entry = _find(&hash, pem_size)))
+    {
+        oe_sgx_free_cert_chain(chain);
+        _use_entry(entry, chain);
+    }
+    else if (chain->intel_root && _num_entries < OE_COUNTOF(_entries))
+    {
+        entry = &_entries[_num_entries++];
+        entry->hash = hash;
+        entry->pem_size = pem_size;
+        entry->chain = chain->owned_chain;
+        entry->intel_root = chain->intel_root;
+        memset(&chain->owned_chain, 0, sizeof(chain->owned_chain));
+        _use_entry(entry, chain);
+    }
+
+    oe_mutex_unlock(&_lock);
+
+    result = OE_OK;
+
+done:
+    return result;
+}
+
+void oe_sgx_free_cert_chain(oe_sgx_cert_chain_t* chain)
+{
+    if (!chain)
+        return;
+
+    if (chain->chain == &chain->owned_chain)
+        oe_cert_chain_free(&chain->owned_chain);
+
+    memset(chain, 0, sizeof(*chain));
+}
+
+void oe_sgx_cert_chain_cache_clear(void)
+{
+    oe_mutex_lock(&_lock);
+
+    for (size_t i = 0; i < _num_entries; i++)
+        oe_cert_chain_free(&_entries[i].chain);
+
+    memset(_entries, 0, sizeof(_entries));
+    _num_entries = 0;
+
+    oe_mutex_unlock(&_lock);
+}
+
+void oe_sgx_cert_chain_cache_get_stats(oe_sgx_cert_chain_cache_stats_t* stats)
+{
+    if (!stats)
+        return;
+
+    oe_mutex_lock(&_lock);
+    *stats = _stats;
+    oe_mutex_unlock(&_lock);
+}
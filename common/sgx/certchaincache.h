@@ -0,0 +1,105 @@
+// Copyright (c) Open Enclave SDK contributors.
+// Licensed under the MIT License.
+
+#ifndef _OE_COMMON_SGX_CERTCHAINCACHE_H
+#define _OE_COMMON_SGX_CERTCHAINCACHE_H
+
+#include <openenclave/bits/defs.h>
+#include <openenclave/bits/result.h>
+#include <openenclave/bits/types.h>
+#include <openenclave/internal/crypto/cert.h>
+#include <openenclave/internal/crypto/ec.h>
+
+OE_EXTERNC_BEGIN
+
+/* The maximum number of distinct issuer chains that are cached */
+#define OE_SGX_CERT_CHAIN_CACHE_SIZE 32
+
+/**
+ * A verified certificate chain.
+ */
+typedef struct _oe_sgx_cert_chain
+{
+    /* The chain. Points either into the cache or to owned_chain */
+    oe_cert_chain_t* chain;
+
+    /* Whether the root of the chain has the public key of Intel's SGX root
+     * CA */
+    bool intel_root;
+
+    /* Storage for a chain that is not cached */
+    oe_cert_chain_t owned_chain;
+} oe_sgx_cert_chain_t;
+
+/**
+ * Get the public key of Intel's SGX root CA, which is parsed only once.
+ *
+ * @param[out] key The key, which must not be freed.
+ */
+oe_result_t oe_sgx_get_intel_root_key(const oe_ec_public_key_t** key);
+
+/**
+ * Read and verify a certificate chain (see oe_cert_chain_read_pem()).
+ *
+ * Issuer chains (intermediate CA and root CA) are shared by all platforms
+ * of a family, so a verified chain whose root has the key of Intel's SGX
+ * root CA is cached, keyed by the SHA-256 of **pem_data**, and later calls
+ * with the same chain do not parse or verify it again. Cached chains are
+ * kept until oe_sgx_cert_chain_cache_clear() is called. Chains with another
+ * root, and all chains once the cache is full, are read into **chain**
+ * without being cached.
+ *
+ * @param[in] pem_data The PEM certificate chain.
+ * @param[in] pem_size The size of **pem_data**.
+ * @param[out] chain The verified chain. Release it with
+ * oe_sgx_free_cert_chain().
+ */
+oe_result_t oe_sgx_get_cert_chain(
+    const uint8_t* pem_data,
+    size_t pem_size,
+    oe_sgx_cert_chain_t* chain);
+
+/**
+ * Read and verify a certificate chain without caching it. Use this for
+ * chains that contain a platform-specific leaf certificate.
+ *
+ * @param[in] pem_data The PEM certificate chain.
+ * @param[in] pem_size The size of **pem_data**.
+ * @param[out] chain The verified chain. Release it with
+ * oe_sgx_free_cert_chain().
+ */
+oe_result_t oe_sgx_read_cert_chain(
+    const uint8_t* pem_data,
+    size_t pem_size,
+    oe_sgx_cert_chain_t* chain);
+
+/**
+ * Release a chain returned by oe_sgx_get_cert_chain() or
+ * oe_sgx_read_cert_chain().
+ */
+void oe_sgx_free_cert_chain(oe_sgx_cert_chain_t* chain);
+
+/**
+ * Remove all chains from the cache. Must not be called while chains returned
+ * by oe_sgx_get_cert_chain() are in use (for tests).
+ */
+void oe_sgx_cert_chain_cache_clear(void);
+
+typedef struct _oe_sgx_cert_chain_cache_stats
+{
+    /* Number of chains served from the cache */
+    uint64_t hits;
+
+    /* Number of chains that were parsed and verified */
+    uint64_t misses;
+} oe_sgx_cert_chain_cache_stats_t;
+
+/**
+ * Get the certificate chain cache counters (for tests and diagnostics).
+ */
+void oe_sgx_cert_chain_cache_get_stats(
+    oe_sgx_cert_chain_cache_stats_t* stats);
+
+OE_EXTERNC_END
+
+#endif // _OE_COMMON_SGX_CERTCHAINCACHE_H
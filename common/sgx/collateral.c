@@ -19,7 +19,11 @@
 #include <openenclave/internal/trace.h>
 #include <openenclave/internal/utils.h>
 #include "../common.h"
+#include "certchaincache.h"
+#include "collateralcache.h"
 #include "tcbinfo.h"
+#include "tcbinfocache.h"
+#include "verificationcache.h"
 
 // Defaults to Intel SGX 1.8 Release Date.
 oe_datetime_t _sgx_minimim_crl_tcb_issue_date = {2017, 3, 17};
@@ -38,6 +42,9 @@ oe_result_t __oe_sgx_set_minimum_crl_tcb_issue_date(
     OE_CHECK(oe_datetime_is_valid(&tmp));
     _sgx_minimim_crl_tcb_issue_date = tmp;
 
+    // Cached results may not satisfy the new minimum date.
+    oe_sgx_verification_cache_clear();
+
     result = OE_OK;
 done:
     return result;
@@ -182,6 +189,71 @@ typedef struct _url
     char str[256];
 } url_t;
 
+oe_result_t oe_get_sgx_pck_fmspc(oe_cert_t* leaf_cert, uint8_t fmspc[6])
+{
+    oe_result_t result = OE_FAILURE;
+    ParsedExtensionInfo parsed_extension_info = {{0}};
+
+    if (leaf_cert == NULL || fmspc == NULL)
+        OE_RAISE(OE_INVALID_PARAMETER);
+
+    OE_CHECK(_parse_sgx_extensions(leaf_cert, &parsed_extension_info));
+    OE_CHECK(oe_memcpy_s(
+        fmspc,
+        sizeof(parsed_extension_info.fmspc),
+        parsed_extension_info.fmspc,
+        sizeof(parsed_extension_info.fmspc)));
+
+    result = OE_OK;
+done:
+
+    return result;
+}
+
+oe_result_t oe_get_sgx_pck_ca(const oe_cert_t* leaf_cert, const char** ca)
+{
+    oe_result_t result = OE_UNEXPECTED;
+    char** urls = NULL;
+    size_t num_urls = 0;
+    uint8_t* buffer = NULL;
+    size_t buffer_size = 0;
+
+    if (leaf_cert == NULL || ca == NULL)
+        OE_RAISE(OE_INVALID_PARAMETER);
+
+    *ca = OE_SGX_PCK_CA_PROCESSOR;
+
+    // A PCK certificate points at the CRL of the CA that issued it, and the
+    // CRL URL names that CA with a "ca=processor" or "ca=platform" query.
+    // Certificates without the extension keep the processor CA.
+    result = oe_get_crl_distribution_points(
+        leaf_cert, &urls, &num_urls, NULL, &buffer_size);
+    if (result != OE_BUFFER_TOO_SMALL)
+    {
+        result = OE_OK;
+        goto done;
+    }
+
+    if (!(buffer = (uint8_t*)oe_malloc(buffer_size)))
+        OE_RAISE(OE_OUT_OF_MEMORY);
+
+    OE_CHECK(oe_get_crl_distribution_points(
+        leaf_cert, &urls, &num_urls, buffer, &buffer_size));
+
+    for (size_t i = 0; i < num_urls; i++)
+    {
+        if (oe_strstr(urls[i], "ca=" OE_SGX_PCK_CA_PLATFORM))
+            *ca = OE_SGX_PCK_CA_PLATFORM;
+    }
+
+    result = OE_OK;
+
+done:
+    oe_free(buffer);
+
+    return result;
+}
+
 /**
  * Call into host to fetch collateral given the PCK certificate.
  */
@@ -190,18 +262,12 @@ oe_result_t oe_get_sgx_quote_verification_collateral_from_certs(
     oe_get_sgx_quote_verification_collateral_args_t* args)
 {
     oe_result_t result = OE_FAILURE;
-    ParsedExtensionInfo parsed_extension_info = {{0}};
 
-    if (leaf_cert == NULL)
+    if (leaf_cert == NULL || args == NULL)
         OE_RAISE(OE_INVALID_PARAMETER);
 
     // Gather fmspc.
-    OE_CHECK(_parse_sgx_extensions(leaf_cert, &parsed_extension_info));
-    OE_CHECK(oe_memcpy_s(
-        args->fmspc,
-        sizeof(args->fmspc),
-        parsed_extension_info.fmspc,
-        sizeof(parsed_extension_info.fmspc)));
+    OE_CHECK(oe_get_sgx_pck_fmspc(leaf_cert, args->fmspc));
 
     OE_CHECK(oe_get_sgx_quote_verification_collateral(args));
 
@@ -220,9 +286,10 @@ oe_result_t oe_validate_revocation_list(
     oe_result_t result = OE_UNEXPECTED;
 
     ParsedExtensionInfo parsed_extension_info = {{0}};
-    oe_cert_chain_t tcb_issuer_chain = {0};
-    oe_cert_chain_t crl_issuer_chain[3] = {{{0}}};
+    oe_sgx_cert_chain_t tcb_issuer_chain = {0};
+    oe_sgx_cert_chain_t crl_issuer_chain[3] = {{0}};
     oe_cert_t tcb_cert = {0};
+    const oe_compiled_tcb_info_t* tcb_info = NULL;
     oe_parsed_tcb_info_t parsed_tcb_info = {0};
     oe_tcb_info_tcb_level_t platform_tcb_level = {{0}};
 
@@ -256,12 +323,12 @@ oe_result_t oe_validate_revocation_list(
         oe_result_str(result));
 
     OE_CHECK_MSG(
-        oe_cert_chain_read_pem(
-            &tcb_issuer_chain,
+        oe_sgx_get_cert_chain(
             sgx_endorsements->items[OE_SGX_ENDORSEMENT_FIELD_TCB_ISSUER_CHAIN]
                 .data,
             sgx_endorsements->items[OE_SGX_ENDORSEMENT_FIELD_TCB_ISSUER_CHAIN]
-                .size),
+                .size,
+            &tcb_issuer_chain),
         "Failed to read TCB chain certificate. %s",
         oe_result_str(result));
 
@@ -281,8 +348,7 @@ oe_result_t oe_validate_revocation_list(
             "Failed to read CRL. %s",
             oe_result_str(result));
         OE_CHECK_MSG(
-            oe_cert_chain_read_pem(
-                &crl_issuer_chain[i],
+            oe_sgx_get_cert_chain(
                 sgx_endorsements
                     ->items
                         [OE_SGX_ENDORSEMENT_FIELD_CRL_ISSUER_CHAIN_PCK_CERT + i]
@@ -290,7 +356,8 @@ oe_result_t oe_validate_revocation_list(
                 sgx_endorsements
                     ->items
                         [OE_SGX_ENDORSEMENT_FIELD_CRL_ISSUER_CHAIN_PCK_CERT + i]
-                    .size),
+                    .size,
+                &crl_issuer_chain[i]),
             "Failed to read CRL cert chain. %s",
             oe_result_str(result));
         OE_TRACE_VERBOSE(
@@ -318,7 +385,10 @@ oe_result_t oe_validate_revocation_list(
     // for certificates in the chain.
     OE_CHECK_MSG(
         oe_cert_verify(
-            pck_cert, crl_issuer_chain, crl_ptrs, OE_COUNTOF(crl_ptrs)),
+            pck_cert,
+            crl_issuer_chain[0].chain,
+            crl_ptrs,
+            OE_COUNTOF(crl_ptrs)),
         "Failed to verify leaf certificate. %s",
         oe_result_str(result));
 
@@ -331,22 +401,22 @@ oe_result_t oe_validate_revocation_list(
     platform_tcb_level.pce_svn = parsed_extension_info.pce_svn;
     platform_tcb_level.status.AsUINT32 = OE_TCB_LEVEL_STATUS_UNKNOWN;
 
-    OE_CHECK_MSG(
-        oe_parse_tcb_info_json(
-            sgx_endorsements->items[OE_SGX_ENDORSEMENT_FIELD_TCB_INFO].data,
-            sgx_endorsements->items[OE_SGX_ENDORSEMENT_FIELD_TCB_INFO].size,
-            &platform_tcb_level,
-            &parsed_tcb_info),
-        "Failed to parse TCB info or Platform TCB is not up-to-date. %s",
-        oe_result_str(result));
+    // The TCB info is parsed and its signature verified once, after which
+    // the platform's TCB level is looked up in the compiled TCB levels.
+    OE_CHECK(oe_sgx_get_tcb_info(
+        sgx_endorsements->items[OE_SGX_ENDORSEMENT_FIELD_TCB_INFO].data,
+        sgx_endorsements->items[OE_SGX_ENDORSEMENT_FIELD_TCB_INFO].size,
+        sgx_endorsements->items[OE_SGX_ENDORSEMENT_FIELD_TCB_ISSUER_CHAIN]
+            .data,
+        sgx_endorsements->items[OE_SGX_ENDORSEMENT_FIELD_TCB_ISSUER_CHAIN]
+            .size,
+        tcb_issuer_chain.chain,
+        &tcb_info));
 
     OE_CHECK_MSG(
-        oe_verify_ecdsa256_signature(
-            parsed_tcb_info.tcb_info_start,
-            parsed_tcb_info.tcb_info_size,
-            (sgx_ecdsa256_signature_t*)parsed_tcb_info.signature,
-            &tcb_issuer_chain),
-        "Failed to verify ECDSA 256 signature in TCB. %s",
+        oe_compiled_tcb_info_get_tcb_level(
+            tcb_info, &platform_tcb_level, &parsed_tcb_info),
+        "Platform TCB is not up-to-date. %s",
         oe_result_str(result));
 
     OE_CHECK_MSG(
@@ -386,7 +456,7 @@ oe_result_t oe_validate_revocation_list(
 
     // Get TCB cert validity period.
     OE_CHECK_MSG(
-        oe_cert_chain_get_leaf_cert(&tcb_issuer_chain, &tcb_cert),
+        oe_cert_chain_get_leaf_cert(tcb_issuer_chain.chain, &tcb_cert),
         "Failed to get TCB certificate.",
         NULL);
     oe_cert_get_validity_dates(&tcb_cert, &from, &until);
@@ -417,10 +487,84 @@ done:
     }
     for (uint32_t i = 0; i < OE_SGX_ENDORSEMENTS_CRL_COUNT; ++i)
     {
-        oe_cert_chain_free(&crl_issuer_chain[i]);
+        oe_sgx_free_cert_chain(&crl_issuer_chain[i]);
     }
-    oe_cert_chain_free(&tcb_issuer_chain);
+    oe_sgx_release_tcb_info(tcb_info);
+    oe_sgx_free_cert_chain(&tcb_issuer_chain);
     oe_cert_free(&tcb_cert);
 
     return result;
 }
+
+oe_result_t oe_get_sgx_endorsements_next_update(
+    const oe_sgx_endorsements_t* sgx_endorsements,
+    oe_datetime_t* next_update)
+{
+    oe_result_t result = OE_UNEXPECTED;
+    oe_crl_t crls[2] = {{{0}}};
+    oe_compiled_tcb_info_t tcb_info = {{0}};
+    oe_compiled_qe_identity_info_t qe_identity_info = {{0}};
+    oe_datetime_t this_update = {0};
+    oe_datetime_t crl_next_update = {0};
+
+    if (sgx_endorsements == NULL || next_update == NULL)
+        OE_RAISE(OE_INVALID_PARAMETER);
+
+    OE_STATIC_ASSERT(OE_COUNTOF(crls) >= OE_SGX_ENDORSEMENTS_CRL_COUNT);
+
+    // The TCB info and the QE identity each have a nextUpdate date.
+    OE_CHECK_MSG(
+        oe_compile_tcb_info_json(
+            sgx_endorsements->items[OE_SGX_ENDORSEMENT_FIELD_TCB_INFO].data,
+            sgx_endorsements->items[OE_SGX_ENDORSEMENT_FIELD_TCB_INFO].size,
+            &tcb_info),
+        "Failed to parse TCB info. %s",
+        oe_result_str(result));
+    OE_CHECK_MSG(
+        oe_compile_qe_identity_info_json(
+            sgx_endorsements->items[OE_SGX_ENDORSEMENT_FIELD_QE_ID_INFO].data,
+            sgx_endorsements->items[OE_SGX_ENDORSEMENT_FIELD_QE_ID_INFO].size,
+            &qe_identity_info),
+        "Failed to parse QE identity info. %s",
+        oe_result_str(result));
+
+    *next_update = tcb_info.parsed_info.next_update;
+    if (oe_datetime_compare(
+            &qe_identity_info.parsed_info.next_update, next_update) < 0)
+        *next_update = qe_identity_info.parsed_info.next_update;
+
+    // So does each CRL.
+    for (uint32_t i = 0; i < OE_SGX_ENDORSEMENTS_CRL_COUNT; ++i)
+    {
+        OE_CHECK_MSG(
+            oe_crl_read_pem(
+                &crls[i],
+                sgx_endorsements
+                    ->items[OE_SGX_ENDORSEMENT_FIELD_CRL_PCK_CERT + i]
+                    .data,
+                sgx_endorsements
+                    ->items[OE_SGX_ENDORSEMENT_FIELD_CRL_PCK_CERT + i]
+                    .size),
+            "Failed to read CRL. %s",
+            oe_result_str(result));
+        OE_CHECK_MSG(
+            oe_crl_get_update_dates(&crls[i], &this_update, &crl_next_update),
+            "Failed to get CRL update dates. %s",
+            oe_result_str(result));
+
+        if (oe_datetime_compare(&crl_next_update, next_update) < 0)
+            *next_update = crl_next_update;
+    }
+
+    result = OE_OK;
+
+done:
+    for (int32_t i = (int32_t)OE_SGX_ENDORSEMENTS_CRL_COUNT - 1; i >= 0; --i)
+    {
+        oe_crl_free(&crls[i]);
+    }
+    oe_free_compiled_qe_identity_info(&qe_identity_info);
+    oe_free_compiled_tcb_info(&tcb_info);
+
+    return result;
+}
@@ -33,6 +33,35 @@ oe_result_t oe_validate_revocation_list(
     oe_datetime_t* validity_from,
     oe_datetime_t* validity_until);
 
+/**
+ * Get the FMSPC (family-model-stepping-platform-customSKU) of the platform
+ * from the SGX extensions of its PCK certificate.
+ *
+ * @param[in] leaf_cert The PCK certificate.
+ * @param[out] fmspc The FMSPC.
+ */
+oe_result_t oe_get_sgx_pck_fmspc(oe_cert_t* leaf_cert, uint8_t fmspc[6]);
+
+/**
+ * Get the PCK CA (OE_SGX_PCK_CA_PROCESSOR or OE_SGX_PCK_CA_PLATFORM) that
+ * issued the given PCK certificate, from its CRL distribution point.
+ *
+ * @param[in] leaf_cert The PCK certificate.
+ * @param[out] ca The name of the CA.
+ */
+oe_result_t oe_get_sgx_pck_ca(const oe_cert_t* leaf_cert, const char** ca);
+
+/**
+ * Get the time after which the given endorsements are stale, which is the
+ * earliest nextUpdate date of the CRLs, the TCB info and the QE identity.
+ *
+ * @param[in] sgx_endorsements The SGX endorsements.
+ * @param[out] next_update The earliest next update time.
+ */
+oe_result_t oe_get_sgx_endorsements_next_update(
+    const oe_sgx_endorsements_t* sgx_endorsements,
+    oe_datetime_t* next_update);
+
 /**
  * Fetch quote verification collateral from the quote provider given the PCK
  * certificate and CA certificate.
@@ -0,0 +1,392 @@
+// Copyright (c) Open Enclave SDK contributors.
+// Licensed under the MIT License.
+
+#include "collateralcache.h"
+#include <openenclave/internal/datetime.h>
+#include <openenclave/internal/raise.h>
+#include <openenclave/internal/safecrt.h>
+#include "../common.h"
+
+#ifdef OE_BUILD_ENCLAVE
+#include <openenclave/internal/thread.h>
+typedef oe_mutex_t _mutex_t;
+#define _MUTEX_INITIALIZER OE_MUTEX_INITIALIZER
+#else
+#include "../../host/hostthread.h"
+typedef oe_mutex _mutex_t;
+#define _MUTEX_INITIALIZER OE_H_MUTEX_INITIALIZER
+#endif
+
+/*
+**==============================================================================
+**
+** SGX collateral cache:
+**
+**     Quote verification needs the collateral (TCB info, CRLs, QE identity
+**     and their issuer chains) of the platform that generated the quote.
+**     Fetching it goes through the quote provider (and, in an enclave,
+**     through an ocall), yet it only changes when Intel publishes new
+**     collateral. Entries are therefore cached per platform, identified by
+**     its FMSPC and PCK CA, until the earliest nextUpdate of the collateral.
+**
+**     Lookups hold _lock only while copying an entry. A miss starts a flight
+**     for its platform unless one is already in progress. The caller that
+**     started the flight fetches while holding the flight's lock, and other
+**     callers for the same platform wait on that lock and then share its
+**     result. Fetches for different platforms run concurrently.
+**
+**==============================================================================
+*/
+
+typedef struct _entry
+{
+    bool used;
+    uint8_t fmspc[6];
+    char ca[16];
+    uint8_t* data;
+    size_t size;
+    oe_datetime_t next_update;
+} _entry_t;
+
+/* A fetch in progress for one platform */
+typedef struct _flight
+{
+    struct _flight* next;
+    uint8_t fmspc[6];
+    char ca[16];
+    size_t refs;
+
+    /* Held by the fetching caller until the fetch completes */
+    _mutex_t lock;
+
+    /* The result of the fetch, valid once lock has been released */
+    oe_result_t result;
+} _flight_t;
+
+static _entry_t _entries[OE_SGX_COLLATERAL_CACHE_SIZE];
+static oe_sgx_collateral_cache_stats_t _stats;
+
+/* Flights in progress */
+static _flight_t* _flights;
+
+/* Protects _entries, _stats and _flights */
+static _mutex_t _lock = _MUTEX_INITIALIZER;
+
+static bool _matches(
+    const _entry_t* entry,
+    const uint8_t* fmspc,
+    const char* ca)
+{
+    return entry->used &&
+           memcmp(entry->fmspc, fmspc, sizeof(entry->fmspc)) == 0 &&
+           oe_strcmp(entry->ca, ca) == 0;
+}
+
+static oe_result_t _copy(
+    const uint8_t* data,
+    size_t size,
+    uint8_t** copy,
+    size_t* copy_size)
+{
+    oe_result_t result = OE_UNEXPECTED;
+
+    if (!(*copy = (uint8_t*)oe_malloc(size)))
+        OE_RAISE(OE_OUT_OF_MEMORY);
+
+    OE_CHECK(oe_memcpy_s(*copy, size, data, size));
+    *copy_size = size;
+
+    result = OE_OK;
+
+done:
+    return result;
+}
+
+/* Copy out an unexpired entry. Return OE_NOT_FOUND on a miss */
+static oe_result_t _lookup(
+    const uint8_t* fmspc,
+    const char* ca,
+    const oe_datetime_t* now,
+    uint8_t** data,
+    size_t* size)
+{
+    oe_result_t result = OE_NOT_FOUND;
+
+    oe_mutex_lock(&_lock);
+
+    for (size_t i = 0; i < OE_COUNTOF(_entries); i++)
+    {
+        _entry_t* entry = &_entries[i];
+
+        if (_matches(entry, fmspc, ca))
+        {
+            if (oe_datetime_compare(now, &entry->next_update) < 0)
+            {
+                result = _copy(entry->data, entry->size, data, size);
+
+                if (result == OE_OK)
+                    _stats.hits++;
+            }
+            break;
+        }
+    }
+
+    oe_mutex_unlock(&_lock);
+
+    return result;
+}
+
+/* Store the collateral, taking ownership of data. Replaces the existing
+ * entry for the platform, a free entry, or the entry that expires first */
+static void _insert(
+    const uint8_t* fmspc,
+    const char* ca,
+    uint8_t* data,
+    size_t size,
+    const oe_datetime_t* next_update)
+{
+    _entry_t* victim = NULL;
+
+    oe_mutex_lock(&_lock);
+
+    for (size_t i = 0; i < OE_COUNTOF(_entries); i++)
+    {
+        _entry_t* entry = &_entries[i];
+
+        if (_matches(entry, fmspc, ca))
+        {
+            victim = entry;
+            break;
+        }
+
+        if (!victim || (victim->used && !entry->used))
+            victim = entry;
+        else if (
+            victim->used && entry->used &&
+            oe_datetime_compare(&entry->next_update, &victim->next_update) <
+                0)
+            victim = entry;
+    }
+
+    oe_free(victim->data);
+    victim->used = true;
+    memcpy(victim->fmspc, fmspc, sizeof(victim->fmspc));
+    memcpy(victim->ca, ca, oe_strlen(ca) + 1);
+    victim->data = data;
+    victim->size = size;
+    victim->next_update = *next_update;
+
+    oe_mutex_unlock(&_lock);
+}
+
+/* Join the flight for the platform, or start one. The caller that starts
+ * a flight owns its lock. The new flight is locked before _lock is taken, so
+ * that a flight's lock is never acquired while holding _lock */
+static oe_result_t _join_flight(
+    const uint8_t* fmspc,
+    const char* ca,
+    _flight_t** flight,
+    bool* owner)
+{
+    oe_result_t result = OE_UNEXPECTED;
+    _flight_t* fresh = NULL;
+    _flight_t* p;
+
+    if (!(fresh = (_flight_t*)oe_calloc(1, sizeof(_flight_t))))
+        OE_RAISE(OE_OUT_OF_MEMORY);
+
+    if (oe_mutex_init(&fresh->lock))
+    {
+        oe_free(fresh);
+        fresh = NULL;
+        OE_RAISE(OE_FAILURE);
+    }
+
+    memcpy(fresh->fmspc, fmspc, sizeof(fresh->fmspc));
+    memcpy(fresh->ca, ca, oe_strlen(ca) + 1);
+    oe_mutex_lock(&fresh->lock);
+
+    oe_mutex_lock(&_lock);
+
+    for (p = _flights; p; p = p->next)
+    {
+        if (memcmp(p->fmspc, fmspc, sizeof(p->fmspc)) == 0 &&
+            oe_strcmp(p->ca, ca) == 0)
+            break;
+    }
+
+    *owner = !p;
+    if (!p)
+    {
+        p = fresh;
+        fresh = NULL;
+        p->next = _flights;
+        _flights = p;
+    }
+
+    p->refs++;
+    *flight = p;
+
+    oe_mutex_unlock(&_lock);
+
+    result = OE_OK;
+
+done:
+    if (fresh)
+    {
+        oe_mutex_unlock(&fresh->lock);
+        oe_mutex_destroy(&fresh->lock);
+        oe_free(fresh);
+    }
+
+    return result;
+}
+
+static void _leave_flight(_flight_t* flight)
+{
+    bool last;
+
+    oe_mutex_lock(&_lock);
+
+    if ((last = (--flight->refs == 0)))
+    {
+        for (_flight_t** p = &_flights; *p; p = &(*p)->next)
+        {
+            if (*p == flight)
+            {
+                *p = flight->next;
+                break;
+            }
+        }
+    }
+
+    oe_mutex_unlock(&_lock);
+
+    if (last)
+    {
+        oe_mutex_destroy(&flight->lock);
+        oe_free(flight);
+    }
+}
+
+/* Fetch the collateral, copy it out and cache it unless it is stale */
+static oe_result_t _fetch(
+    const uint8_t* fmspc,
+    const char* ca,
+    const oe_datetime_t* now,
+    oe_sgx_collateral_fetch_t fetch,
+    void* arg,
+    uint8_t** data,
+    size_t* size)
+{
+    oe_result_t result = OE_UNEXPECTED;
+    oe_datetime_t next_update = {0};
+    uint8_t* fetched = NULL;
+    size_t fetched_size = 0;
+
+    OE_CHECK(fetch(arg, &fetched, &fetched_size, &next_update));
+
+    oe_mutex_lock(&_lock);
+    _stats.fetches++;
+    oe_mutex_unlock(&_lock);
+
+    OE_CHECK(_copy(fetched, fetched_size, data, size));
+
+    // Collateral that is already stale is returned but not cached.
+    if (oe_datetime_compare(now, &next_update) < 0)
+    {
+        _insert(fmspc, ca, fetched, fetched_size, &next_update);
+        fetched = NULL;
+    }
+
+    result = OE_OK;
+
+done:
+    oe_free(fetched);
+
+    return result;
+}
+
+oe_result_t oe_sgx_collateral_cache_get(
+    const uint8_t fmspc[6],
+    const char* ca,
+    oe_sgx_collateral_fetch_t fetch,
+    void* arg,
+    uint8_t** data,
+    size_t* size)
+{
+    oe_result_t result = OE_UNEXPECTED;
+    oe_datetime_t now = {0};
+    _flight_t* flight = NULL;
+    bool owner = false;
+
+    if (!fmspc || !ca || oe_strlen(ca) >= sizeof(_entries[0].ca) || !fetch ||
+        !data || !size)
+        OE_RAISE(OE_INVALID_PARAMETER);
+
+    *data = NULL;
+    *size = 0;
+
+    OE_CHECK(oe_datetime_now(&now));
+
+    for (;;)
+    {
+        result = _lookup(fmspc, ca, &now, data, size);
+        if (result != OE_NOT_FOUND)
+            goto done;
+
+        OE_CHECK(_join_flight(fmspc, ca, &flight, &owner));
+
+        if (owner)
+        {
+            // A flight that completed since the lookup may have filled the
+            // entry.
+            result = _lookup(fmspc, ca, &now, data, size);
+            if (result == OE_NOT_FOUND)
+                result = _fetch(fmspc, ca, &now, fetch, arg, data, size);
+
+            flight->result = result;
+            oe_mutex_unlock(&flight->lock);
+            _leave_flight(flight);
+            goto done;
+        }
+
+        // Wait for the fetching caller and share its failure, if any.
+        oe_mutex_lock(&flight->lock);
+        result = flight->result;
+        oe_mutex_unlock(&flight->lock);
+        _leave_flight(flight);
+
+        if (result != OE_OK)
+            goto done;
+
+        // The fetched collateral is normally cached now. If it was stale and
+        // not cached, the lookup misses again and this caller fetches.
+    }
+
+done:
+    return result;
+}
+
+void oe_sgx_collateral_cache_clear(void)
+{
+    oe_mutex_lock(&_lock);
+
+    for (size_t i = 0; i < OE_COUNTOF(_entries); i++)
+    {
+        oe_free(_entries[i].data);
+        memset(&_entries[i], 0, sizeof(_entries[i]));
+    }
+
+    oe_mutex_unlock(&_lock);
+}
+
+void oe_sgx_collateral_cache_get_stats(oe_sgx_collateral_cache_stats_t* stats)
+{
+    if (!stats)
+        return;
+
+    oe_mutex_lock(&_lock);
+    *stats = _stats;
+    oe_mutex_unlock(&_lock);
+}
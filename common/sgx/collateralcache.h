@@ -0,0 +1,80 @@
+// Copyright (c) Open Enclave SDK contributors.
+// Licensed under the MIT License.
+
+#ifndef _OE_COMMON_SGX_COLLATERALCACHE_H
+#define _OE_COMMON_SGX_COLLATERALCACHE_H
+
+#include <openenclave/bits/defs.h>
+#include <openenclave/bits/result.h>
+#include <openenclave/bits/types.h>
+
+OE_EXTERNC_BEGIN
+
+/* The PCK CA that issues the PCK certificates of a platform */
+#define OE_SGX_PCK_CA_PROCESSOR "processor"
+#define OE_SGX_PCK_CA_PLATFORM "platform"
+
+/* The maximum number of platforms (FMSPC, CA) whose collateral is cached */
+#define OE_SGX_COLLATERAL_CACHE_SIZE 16
+
+/**
+ * Fetch the collateral for a platform on a cache miss.
+ *
+ * @param[in] arg The argument passed to oe_sgx_collateral_cache_get().
+ * @param[out] data The collateral, allocated with oe_malloc().
+ * @param[out] size The size of **data**.
+ * @param[out] next_update The time after which the collateral is stale,
+ * which is the earliest nextUpdate of its CRLs, TCB info and QE identity.
+ */
+typedef oe_result_t (*oe_sgx_collateral_fetch_t)(
+    void* arg,
+    uint8_t** data,
+    size_t* size,
+    oe_datetime_t* next_update);
+
+/**
+ * Get the collateral for the platform identified by **fmspc** and **ca**.
+ *
+ * Collateral is served from a process-wide (or enclave-wide) cache until its
+ * next update time has passed. On a miss, **fetch** is called to retrieve it.
+ * Concurrent misses for the same platform are coalesced so that only one
+ * caller fetches; the others wait for it and share its result. Misses for
+ * different platforms fetch concurrently.
+ *
+ * @param[in] fmspc The FMSPC of the platform.
+ * @param[in] ca The PCK CA (OE_SGX_PCK_CA_PROCESSOR or OE_SGX_PCK_CA_PLATFORM).
+ * @param[in] fetch The function that fetches the collateral on a miss.
+ * @param[in] arg The argument passed to **fetch**.
+ * @param[out] data A copy of the collateral, to be freed with oe_free().
+ * @param[out] size The size of **data**.
+ */
+oe_result_t oe_sgx_collateral_cache_get(
+    const uint8_t fmspc[6],
+    const char* ca,
+    oe_sgx_collateral_fetch_t fetch,
+    void* arg,
+    uint8_t** data,
+    size_t* size);
+
+/**
+ * Remove all entries from the collateral cache.
+ */
+void oe_sgx_collateral_cache_clear(void);
+
+typedef struct _oe_sgx_collateral_cache_stats
+{
+    /* Number of requests served from the cache */
+    uint64_t hits;
+
+    /* Number of times the collateral was fetched */
+    uint64_t fetches;
+} oe_sgx_collateral_cache_stats_t;
+
+/**
+ * Get the collateral cache counters (for tests and diagnostics).
+ */
+void oe_sgx_collateral_cache_get_stats(oe_sgx_collateral_cache_stats_t* stats);
+
+OE_EXTERNC_END
+
+#endif // _OE_COMMON_SGX_COLLATERALCACHE_H
@@ -9,6 +9,7 @@
 #include "../common.h"
 
 #include "collateral.h"
+#include "collateralcache.h"
 #include "quote.h"
 
 #define CREATION_DATETIME_SIZE 21
@@ -353,6 +354,89 @@ done:
     return result;
 }
 
+/**
+ * Fetch the endorsements for the platform whose FMSPC is set in **arg**
+ * (oe_get_sgx_quote_verification_collateral_args_t) on a collateral cache
+ * miss.
+ */
+static oe_result_t _fetch_sgx_endorsements(
+    void* arg,
+    uint8_t** data,
+    size_t* size,
+    oe_datetime_t* next_update)
+{
+    oe_result_t result = OE_UNEXPECTED;
+    oe_get_sgx_quote_verification_collateral_args_t*
+        quote_verification_collateral =
+            (oe_get_sgx_quote_verification_collateral_args_t*)arg;
+    oe_sgx_endorsements_t sgx_endorsements = {{{0}}};
+
+    OE_CHECK_MSG(
+        oe_get_sgx_quote_verification_collateral(
+            quote_verification_collateral),
+        "Failed to get certificate quote verification collateral information. "
+        "%s",
+        oe_result_str(result));
+
+    OE_CHECK_MSG(
+        oe_create_sgx_endorsements(
+            quote_verification_collateral, (oe_endorsements_t**)data, size),
+        "Failed to create SGX endorsements.",
+        oe_result_str(result));
+
+    OE_CHECK(oe_parse_sgx_endorsements(
+        (const oe_endorsements_t*)*data, *size, &sgx_endorsements));
+    OE_CHECK(
+        oe_get_sgx_endorsements_next_update(&sgx_endorsements, next_update));
+
+    result = OE_OK;
+
+done:
+    if (result != OE_OK)
+    {
+        oe_free(*data);
+        *data = NULL;
+        *size = 0;
+    }
+
+    return result;
+}
+
+/**
+ * Set the creation datetime of endorsements served from the collateral cache
+ * to the current time, which is when they were last known to be valid.
+ */
+static oe_result_t _update_creation_datetime(
+    uint8_t* endorsements_buffer,
+    size_t endorsements_buffer_size)
+{
+    oe_result_t result = OE_UNEXPECTED;
+    oe_sgx_endorsements_t sgx_endorsements = {{{0}}};
+    oe_sgx_endorsement_item* item = NULL;
+    oe_datetime_t datetime_now = {0};
+    size_t datetime_size = CREATION_DATETIME_SIZE;
+
+    OE_CHECK(oe_parse_sgx_endorsements(
+        (const oe_endorsements_t*)endorsements_buffer,
+        endorsements_buffer_size,
+        &sgx_endorsements));
+
+    item = &sgx_endorsements.items[OE_SGX_ENDORSEMENT_FIELD_CREATION_DATETIME];
+    if (item->size != CREATION_DATETIME_SIZE)
+        OE_RAISE(OE_INVALID_PARAMETER);
+
+    OE_CHECK(oe_datetime_now(&datetime_now));
+    OE_CHECK_MSG(
+        oe_datetime_to_string(&datetime_now, (char*)item->data, &datetime_size),
+        "Failed to update endorsement creation time. %s",
+        oe_result_str(result));
+
+    result = OE_OK;
+
+done:
+    return result;
+}
+
 oe_result_t oe_get_sgx_endorsements(
     const uint8_t* remote_report,
     size_t remote_report_size,
@@ -363,11 +447,9 @@ oe_result_t oe_get_sgx_endorsements(
     oe_get_sgx_quote_verification_collateral_args_t
         quote_verification_collateral = {0};
 
-    const uint8_t* pem_pck_certificate = NULL;
-    size_t pem_pck_certificate_size = 0;
-    oe_cert_chain_t pck_cert_chain = {0};
+    oe_sgx_cert_chain_t issuer_chain = {0};
     oe_cert_t leaf_cert = {0};
-    oe_cert_t intermediate_cert = {0};
+    const char* ca = NULL;
 
     OE_TRACE_INFO("Enter call %s\n", __FUNCTION__);
 
@@ -379,49 +461,51 @@ oe_result_t oe_get_sgx_endorsements(
     *endorsements_buffer = NULL;
     *endorsements_buffer_size = 0;
 
-    // Get PCK cert chain from the quote.
+    // Get the PCK certificate from the quote.
     OE_CHECK_MSG(
-        oe_get_quote_cert_chain_internal(
-            remote_report,
-            remote_report_size,
-            &pem_pck_certificate,
-            &pem_pck_certificate_size,
-            &pck_cert_chain),
+        oe_get_quote_pck_cert_internal(
+            remote_report, remote_report_size, &leaf_cert, &issuer_chain),
         "Failed to get certificate chain from quote. %s",
         oe_result_str(result));
 
-    // Fetch leaf and intermediate certificates.
+    // Get the endorsements of the platform, fetching them from the quote
+    // provider only if they are not cached or have expired.
     OE_CHECK_MSG(
-        oe_cert_chain_get_leaf_cert(&pck_cert_chain, &leaf_cert),
-        "Failed to get leaf certificate. %s",
+        oe_get_sgx_pck_fmspc(&leaf_cert, quote_verification_collateral.fmspc),
+        "Failed to get FMSPC from leaf certificate. %s",
         oe_result_str(result));
     OE_CHECK_MSG(
-        oe_cert_chain_get_cert(&pck_cert_chain, 1, &intermediate_cert),
-        "Failed to get intermediate certificate. %s",
-        oe_result_str(result));
-
-    // Get quote verification collateral
-    OE_CHECK_MSG(
-        oe_get_sgx_quote_verification_collateral_from_certs(
-            &leaf_cert, &quote_verification_collateral),
-        "Failed to get certificate quote verification collateral information. "
-        "%s",
-        oe_result_str(result));
-
-    OE_CHECK_MSG(
-        oe_create_sgx_endorsements(
-            &quote_verification_collateral,
-            (oe_endorsements_t**)endorsements_buffer,
-            endorsements_buffer_size),
-        "Failed to create SGX endorsements.",
+        oe_get_sgx_pck_ca(&leaf_cert, &ca),
+        "Failed to get PCK CA from leaf certificate. %s",
         oe_result_str(result));
+    OE_CHECK(oe_strncpy_s(
+        quote_verification_collateral.ca,
+        sizeof(quote_verification_collateral.ca),
+        ca,
+        oe_strlen(ca)));
+
+    OE_CHECK(oe_sgx_collateral_cache_get(
+        quote_verification_collateral.fmspc,
+        ca,
+        _fetch_sgx_endorsements,
+        &quote_verification_collateral,
+        endorsements_buffer,
+        endorsements_buffer_size));
+
+    OE_CHECK(_update_creation_datetime(
+        *endorsements_buffer, *endorsements_buffer_size));
 
     result = OE_OK;
 
 done:
+    if (result != OE_OK && endorsements_buffer && endorsements_buffer_size)
+    {
+        oe_free(*endorsements_buffer);
+        *endorsements_buffer = NULL;
+        *endorsements_buffer_size = 0;
+    }
     oe_cert_free(&leaf_cert);
-    oe_cert_free(&intermediate_cert);
-    oe_cert_chain_free(&pck_cert_chain);
+    oe_sgx_free_cert_chain(&issuer_chain);
     oe_free_sgx_quote_verification_collateral_args(
         &quote_verification_collateral);
 
@@ -6,7 +6,9 @@
 #include <openenclave/internal/raise.h>
 #include <openenclave/internal/utils.h>
 #include "../common.h"
+#include "certchaincache.h"
 #include "tcbinfo.h"
+#include "tcbinfocache.h"
 
 extern oe_datetime_t _sgx_minimim_crl_tcb_issue_date;
 
@@ -31,8 +33,9 @@ oe_result_t oe_validate_qe_identity(
     oe_result_t result = OE_FAILURE;
     const uint8_t* pem_pck_certificate = NULL;
     size_t pem_pck_certificate_size = 0;
-    oe_cert_chain_t pck_cert_chain = {0};
+    oe_sgx_cert_chain_t pck_cert_chain = {0};
     oe_cert_t leaf_cert = {0};
+    const oe_compiled_qe_identity_info_t* qe_identity_info = NULL;
     oe_parsed_qe_identity_info_t parsed_info = {0};
     oe_qe_identity_info_tcb_level_t platform_tcb_level = {{0}};
     oe_datetime_t from = {0};
@@ -59,36 +62,32 @@ oe_result_t oe_validate_qe_identity(
             .size;
 
     // validate the cert chain.
-    OE_CHECK(oe_cert_chain_read_pem(
-        &pck_cert_chain, pem_pck_certificate, pem_pck_certificate_size));
+    OE_CHECK(oe_sgx_get_cert_chain(
+        pem_pck_certificate, pem_pck_certificate_size, &pck_cert_chain));
 
     // Configure the platform isvsvn from the QE report.
     // The platform isvsvn is needed for matching tcb level
     // during qe identity info json parsing.
     platform_tcb_level.isvsvn[0] = qe_report_body->isvsvn;
 
-    // parse identity info json blob
+    // Get the identity info json blob, parsed and with its signature
+    // verified, and look up the QE's tcb level in it.
     OE_TRACE_INFO(
         "*qe_identity.qe_id_info:[%s]\n",
         sgx_endorsements->items[OE_SGX_ENDORSEMENT_FIELD_QE_ID_INFO].data);
-    OE_CHECK(oe_parse_qe_identity_info_json(
+    OE_CHECK(oe_sgx_get_qe_identity_info(
         sgx_endorsements->items[OE_SGX_ENDORSEMENT_FIELD_QE_ID_INFO].data,
         sgx_endorsements->items[OE_SGX_ENDORSEMENT_FIELD_QE_ID_INFO].size,
-        &platform_tcb_level,
-        &parsed_info));
-
-    // verify qe identity signature
-    OE_TRACE_INFO("Calling oe_verify_ecdsa256_signature\n");
-    OE_CHECK(oe_verify_ecdsa256_signature(
-        parsed_info.info_start,
-        parsed_info.info_size,
-        (sgx_ecdsa256_signature_t*)parsed_info.signature,
-        &pck_cert_chain));
-    OE_TRACE_INFO("oe_verify_ecdsa256_signature succeeded\n");
+        pem_pck_certificate,
+        pem_pck_certificate_size,
+        pck_cert_chain.chain,
+        &qe_identity_info));
+    OE_CHECK(oe_compiled_qe_identity_info_get_tcb_level(
+        qe_identity_info, &platform_tcb_level, &parsed_info));
 
     // Get leaf certificate
     OE_CHECK_MSG(
-        oe_cert_chain_get_leaf_cert(&pck_cert_chain, &leaf_cert),
+        oe_cert_chain_get_leaf_cert(pck_cert_chain.chain, &leaf_cert),
         "Failed to get leaf certificate. %s",
         oe_result_str(result));
     OE_CHECK_MSG(
@@ -209,8 +208,8 @@ oe_result_t oe_validate_qe_identity(
     result = OE_OK;
 
 done:
-    if (pck_cert_chain.impl[0] != 0)
-        oe_cert_chain_free(&pck_cert_chain);
+    oe_sgx_release_qe_identity_info(qe_identity_info);
+    oe_sgx_free_cert_chain(&pck_cert_chain);
     oe_cert_free(&leaf_cert);
 
     return result;
@@ -7,21 +7,17 @@
 #include <openenclave/internal/crypto/sha.h>
 #include <openenclave/internal/datetime.h>
 #include <openenclave/internal/raise.h>
+#include <openenclave/internal/safecrt.h>
 #include <openenclave/internal/utils.h>
 #include "../common.h"
+#include "certchaincache.h"
 #include "collateral.h"
 #include "endorsements.h"
 #include "qeidentity.h"
+#include "verificationcache.h"
 
 #include <time.h>
 
-// Public key of Intel's root certificate.
-static const char* g_expected_root_certificate_key =
-    "-----BEGIN PUBLIC KEY-----\n"
-    "MFkwEwYHKoZIzj0CAQYIKoZIzj0DAQcDQgAEC6nEwMDIYZOj/iPWsCzaEKi71OiO\n"
-    "SLRFhWGjbnBVJfVnkY4u3IjkDYYL0MxO4mqsyYjlBalTVYxFP2sJBK5zlA==\n"
-    "-----END PUBLIC KEY-----\n";
-
 OE_INLINE uint16_t ReadUint16(const uint8_t* p)
 {
     return (uint16_t)(p[0] | (p[1] << 8));
@@ -204,6 +200,128 @@ done:
     return result;
 }
 
+static const char _pem_end_certificate[] = "-----END CERTIFICATE-----";
+
+/* Split a PEM certificate chain after its first certificate */
+static oe_result_t _split_pem_chain(
+    const uint8_t* pem_data,
+    size_t pem_size,
+    size_t* first_size)
+{
+    oe_result_t result = OE_UNEXPECTED;
+    const size_t marker_size = sizeof(_pem_end_certificate) - 1;
+
+    for (size_t i = 0; i + marker_size <= pem_size; i++)
+    {
+        if (memcmp(pem_data + i, _pem_end_certificate, marker_size) == 0)
+        {
+            *first_size = i + marker_size;
+            result = OE_OK;
+            goto done;
+        }
+    }
+
+    OE_RAISE_MSG(OE_INVALID_PARAMETER, "No certificate in PEM chain.", NULL);
+
+done:
+    return result;
+}
+
+/* The PCK certificate chain in a quote is the PCK certificate followed by
+ * the issuer chain (the platform or processor CA and the root CA). The issuer
+ * chain is the same for all platforms of a family, so only the PCK
+ * certificate is read and verified against the cached issuer chain. */
+static oe_result_t _read_pck_cert_with_cached_issuers(
+    const uint8_t* pem_data,
+    size_t pem_size,
+    oe_cert_t* pck_cert,
+    oe_sgx_cert_chain_t* issuer_chain)
+{
+    oe_result_t result = OE_UNEXPECTED;
+    size_t pck_pem_size = 0;
+    char* pck_pem = NULL;
+
+    OE_CHECK(_split_pem_chain(pem_data, pem_size, &pck_pem_size));
+    if (pck_pem_size == pem_size)
+        OE_RAISE(OE_INVALID_PARAMETER);
+
+    // oe_cert_read_pem() requires a zero-terminated certificate.
+    if (!(pck_pem = (char*)oe_malloc(pck_pem_size + 1)))
+        OE_RAISE(OE_OUT_OF_MEMORY);
+
+    OE_CHECK(oe_memcpy_s(pck_pem, pck_pem_size + 1, pem_data, pck_pem_size));
+    pck_pem[pck_pem_size] = '\0';
+
+    OE_CHECK(oe_cert_read_pem(pck_cert, pck_pem, pck_pem_size + 1));
+    OE_CHECK(oe_sgx_get_cert_chain(
+        pem_data + pck_pem_size, pem_size - pck_pem_size, issuer_chain));
+    OE_CHECK(oe_cert_verify(pck_cert, issuer_chain->chain, NULL, 0));
+
+    result = OE_OK;
+
+done:
+    if (result != OE_OK)
+    {
+        oe_cert_free(pck_cert);
+        oe_sgx_free_cert_chain(issuer_chain);
+    }
+    oe_free(pck_pem);
+
+    return result;
+}
+
+oe_result_t oe_get_quote_pck_cert_internal(
+    const uint8_t* quote,
+    size_t quote_size,
+    oe_cert_t* pck_cert,
+    oe_sgx_cert_chain_t* issuer_chain)
+{
+    oe_result_t result = OE_UNEXPECTED;
+    sgx_quote_t* sgx_quote = NULL;
+    sgx_quote_auth_data_t* quote_auth_data = NULL;
+    sgx_qe_auth_data_t qe_auth_data = {0};
+    sgx_qe_cert_data_t qe_cert_data = {0};
+
+    if (quote == NULL || pck_cert == NULL || issuer_chain == NULL)
+        OE_RAISE(OE_INVALID_PARAMETER);
+
+    OE_CHECK_MSG(
+        _parse_quote(
+            quote,
+            quote_size,
+            &sgx_quote,
+            &quote_auth_data,
+            &qe_auth_data,
+            &qe_cert_data),
+        "Failed to parse quote. %s",
+        oe_result_str(result));
+
+    if (_read_pck_cert_with_cached_issuers(
+            qe_cert_data.data, qe_cert_data.size, pck_cert, issuer_chain) ==
+        OE_OK)
+    {
+        result = OE_OK;
+        goto done;
+    }
+
+    // The chain is not in the expected order (or is invalid): read and verify
+    // the whole chain, which also reports why an invalid chain is rejected.
+    OE_CHECK(oe_sgx_read_cert_chain(
+        qe_cert_data.data, qe_cert_data.size, issuer_chain));
+    OE_CHECK_MSG(
+        oe_cert_chain_get_leaf_cert(issuer_chain->chain, pck_cert),
+        "Failed to get leaf certificate.",
+        NULL);
+
+    result = OE_OK;
+
+done:
+    if (result != OE_OK && issuer_chain)
+        oe_sgx_free_cert_chain(issuer_chain);
+
+    return result;
+}
+
 static oe_result_t oe_verify_quote_internal(
     const uint8_t* quote,
     size_t quote_size)
@@ -213,20 +331,12 @@ static oe_result_t oe_verify_quote_internal(
     sgx_quote_auth_data_t* quote_auth_data = NULL;
     sgx_qe_auth_data_t qe_auth_data = {0};
     sgx_qe_cert_data_t qe_cert_data = {0};
-    oe_cert_chain_t pck_cert_chain = {0};
     oe_sha256_context_t sha256_ctx = {0};
     OE_SHA256 sha256 = {0};
     oe_ec_public_key_t attestation_key = {0};
     oe_cert_t leaf_cert = {0};
-    oe_cert_t root_cert = {0};
-    oe_cert_t intermediate_cert = {0};
+    oe_sgx_cert_chain_t issuer_chain = {0};
     oe_ec_public_key_t leaf_public_key = {0};
-    oe_ec_public_key_t root_public_key = {0};
-    oe_ec_public_key_t expected_root_public_key = {0};
-    bool key_equal = false;
-
-    uint8_t* pem_pck_certificate = NULL;
-    size_t pem_pck_certificate_size = 0;
 
     OE_CHECK_MSG(
         _parse_quote(
@@ -239,56 +349,23 @@ static oe_result_t oe_verify_quote_internal(
         "Failed to parse quote. %s",
         oe_result_str(result));
 
-    pem_pck_certificate = qe_cert_data.data;
-    pem_pck_certificate_size = qe_cert_data.size;
-
     // PckCertificate Chain validations.
     {
         // Read and validate the chain.
         OE_CHECK_MSG(
-            oe_cert_chain_read_pem(
-                &pck_cert_chain, pem_pck_certificate, pem_pck_certificate_size),
+            oe_get_quote_pck_cert_internal(
+                quote, quote_size, &leaf_cert, &issuer_chain),
             "Failed to parse certificate chain.",
             NULL);
 
-        // Fetch leaf and root certificates.
-        OE_CHECK_MSG(
-            oe_cert_chain_get_leaf_cert(&pck_cert_chain, &leaf_cert),
-            "Failed to get leaf certificate.",
-            NULL);
-        OE_CHECK_MSG(
-            oe_cert_chain_get_root_cert(&pck_cert_chain, &root_cert),
-            "Failed to get root certificate.",
-            NULL);
-        OE_CHECK_MSG(
-            oe_cert_chain_get_cert(&pck_cert_chain, 1, &intermediate_cert),
-            "Failed to get intermediate certificate.",
-            NULL);
-
         // Get public keys.
         OE_CHECK_MSG(
             oe_cert_get_ec_public_key(&leaf_cert, &leaf_public_key),
             "Failed to get leaf cert public key.",
             NULL);
-        OE_CHECK_MSG(
-            oe_cert_get_ec_public_key(&root_cert, &root_public_key),
-            "Failed to get root cert public key.",
-            NULL);
 
         // Ensure that the root certificate matches root of trust.
-        OE_CHECK_MSG(
-            oe_ec_public_key_read_pem(
-                &expected_root_public_key,
-                (const uint8_t*)g_expected_root_certificate_key,
-                oe_strlen(g_expected_root_certificate_key) + 1),
-            "Failed to read expected root cert key.",
-            NULL);
-        OE_CHECK_MSG(
-            oe_ec_public_key_equal(
-                &root_public_key, &expected_root_public_key, &key_equal),
-            "Failed to compare keys.",
-            NULL);
-        if (!key_equal)
+        if (!issuer_chain.intel_root)
             OE_RAISE_MSG(
                 OE_QUOTE_VERIFICATION_ERROR,
                 "Failed to verify root public key.",
@@ -354,55 +431,9 @@ static oe_result_t oe_verify_quote_internal(
 
 done:
     oe_ec_public_key_free(&leaf_public_key);
-    oe_ec_public_key_free(&root_public_key);
-    oe_ec_public_key_free(&expected_root_public_key);
     oe_ec_public_key_free(&attestation_key);
     oe_cert_free(&leaf_cert);
-    oe_cert_free(&root_cert);
-    oe_cert_free(&intermediate_cert);
-    oe_cert_chain_free(&pck_cert_chain);
-    return result;
-}
-
-oe_result_t oe_get_quote_cert_chain_internal(
-    const uint8_t* quote,
-    const size_t quote_size,
-    const uint8_t** pem_pck_certificate,
-    size_t* pem_pck_certificate_size,
-    oe_cert_chain_t* pck_cert_chain)
-{
-    oe_result_t result = OE_UNEXPECTED;
-    sgx_quote_t* sgx_quote = NULL;
-    sgx_quote_auth_data_t* quote_auth_data = NULL;
-    sgx_qe_auth_data_t qe_auth_data = {0};
-    sgx_qe_cert_data_t qe_cert_data = {0};
-
-    if (quote == NULL || pem_pck_certificate == NULL || pck_cert_chain == NULL)
-    {
-        OE_RAISE(OE_INVALID_PARAMETER);
-    }
-
-    OE_CHECK_MSG(
-        _parse_quote(
-            quote,
-            quote_size,
-            &sgx_quote,
-            &quote_auth_data,
-            &qe_auth_data,
-            &qe_cert_data),
-        "Failed to parse quote. %s",
-        oe_result_str(result));
-
-    *pem_pck_certificate = qe_cert_data.data;
-    *pem_pck_certificate_size = qe_cert_data.size;
-
-    // Read and validate the chain.
-    OE_CHECK(oe_cert_chain_read_pem(
-        pck_cert_chain, *pem_pck_certificate, *pem_pck_certificate_size));
-
-    result = OE_OK;
-done:
-
+    oe_sgx_free_cert_chain(&issuer_chain);
     return result;
 }
 
@@ -487,21 +518,11 @@ oe_result_t oe_verify_quote_with_sgx_endorsements(
     oe_datetime_t validity_from = {0};
     oe_datetime_t validity_until = {0};
     oe_datetime_t validation_time = {0};
+    bool use_cache = oe_sgx_verification_cache_enabled();
+    OE_SHA256 key = {0};
 
-    OE_CHECK_MSG(
-        oe_verify_quote_internal(quote, quote_size),
-        "Failed to verify remote quote.",
-        NULL);
-
-    OE_CHECK_MSG(
-        oe_get_sgx_quote_validity(
-            quote,
-            quote_size,
-            sgx_endorsements,
-            &validity_from,
-            &validity_until),
-        "Failed to validate quote. %s",
-        oe_result_str(result));
+    if (quote == NULL || sgx_endorsements == NULL)
+        OE_RAISE(OE_INVALID_PARAMETER);
 
     // Verify quote/endorsements for the given time.  Use endorsements
     // creation time if one was not provided.
@@ -526,6 +547,34 @@ oe_result_t oe_verify_quote_with_sgx_endorsements(
         validation_time = *input_validation_time;
     }
 
+    // The same quote and endorsements have been verified for this time.
+    if (use_cache)
+    {
+        OE_CHECK(oe_sgx_verification_cache_get_key(
+            quote, quote_size, sgx_endorsements, &key));
+
+        if (oe_sgx_verification_cache_lookup(&key, &validation_time) == OE_OK)
+        {
+            result = OE_OK;
+            goto done;
+        }
+    }
+
+    OE_CHECK_MSG(
+        oe_verify_quote_internal(quote, quote_size),
+        "Failed to verify remote quote.",
+        NULL);
+
+    OE_CHECK_MSG(
+        oe_get_sgx_quote_validity(
+            quote,
+            quote_size,
+            sgx_endorsements,
+            &validity_from,
+            &validity_until),
+        "Failed to validate quote. %s",
+        oe_result_str(result));
+
     oe_datetime_log("Validation datetime: ", &validation_time);
     if (oe_datetime_compare(&validation_time, &validity_from) < 0)
     {
@@ -546,6 +595,9 @@ oe_result_t oe_verify_quote_with_sgx_endorsements(
             NULL);
     }
 
+    if (use_cache)
+        oe_sgx_verification_cache_add(&key, &validity_from, &validity_until);
+
     result = OE_OK;
 
 done:
@@ -566,13 +618,9 @@ oe_result_t oe_get_sgx_quote_validity(
     sgx_qe_auth_data_t qe_auth_data = {0};
     sgx_qe_cert_data_t qe_cert_data = {0};
 
-    const uint8_t* pem_pck_certificate = NULL;
-    size_t pem_pck_certificate_size = 0;
-    oe_cert_chain_t pck_cert_chain = {0};
-
-    oe_cert_t root_cert = {0};
-    oe_cert_t intermediate_cert = {0};
+    oe_sgx_cert_chain_t issuer_chain = {0};
     oe_cert_t pck_cert = {0};
+    size_t issuer_chain_length = 0;
 
     oe_datetime_t latest_from = {0};
     oe_datetime_t earliest_until = {0};
@@ -596,49 +644,36 @@ oe_result_t oe_get_sgx_quote_validity(
         "Failed to parse quote. %s",
         oe_result_str(result));
 
-    pem_pck_certificate = qe_cert_data.data;
-    pem_pck_certificate_size = qe_cert_data.size;
-
     OE_CHECK_MSG(
-        oe_get_quote_cert_chain_internal(
-            quote,
-            quote_size,
-            &pem_pck_certificate,
-            &pem_pck_certificate_size,
-            &pck_cert_chain),
+        oe_get_quote_pck_cert_internal(
+            quote, quote_size, &pck_cert, &issuer_chain),
         "Failed to retreive PCK cert chain. %s",
         oe_result_str(result));
 
-    // Fetch certificates.
-    OE_CHECK_MSG(
-        oe_cert_chain_get_leaf_cert(&pck_cert_chain, &pck_cert),
-        "Failed to get leaf certificate.",
-        NULL);
-    OE_CHECK_MSG(
-        oe_cert_chain_get_root_cert(&pck_cert_chain, &root_cert),
-        "Failed to get root certificate.",
-        NULL);
-    OE_CHECK_MSG(
-        oe_cert_chain_get_cert(&pck_cert_chain, 1, &intermediate_cert),
-        "Failed to get intermediate certificate.",
-        NULL);
-
     // Process certs validity dates.
     OE_CHECK_MSG(
-        oe_cert_get_validity_dates(&root_cert, &latest_from, &earliest_until),
+        oe_cert_get_validity_dates(&pck_cert, &latest_from, &earliest_until),
         "Failed to get validity info from cert. %s",
         oe_result_str(result));
-    OE_CHECK_MSG(
-        oe_cert_get_validity_dates(&intermediate_cert, &from, &until),
-        "Failed to get validity info from cert. %s",
-        oe_result_str(result));
-    _update_validity(&latest_from, &earliest_until, &from, &until);
 
-    OE_CHECK_MSG(
-        oe_cert_get_validity_dates(&pck_cert, &from, &until),
-        "Failed to get validity info from cert. %s",
-        oe_result_str(result));
-    _update_validity(&latest_from, &earliest_until, &from, &until);
+    OE_CHECK(
+        oe_cert_chain_get_length(issuer_chain.chain, &issuer_chain_length));
+    for (size_t i = 0; i < issuer_chain_length; i++)
+    {
+        oe_cert_t cert = {0};
+
+        OE_CHECK_MSG(
+            oe_cert_chain_get_cert(issuer_chain.chain, i, &cert),
+            "Failed to get certificate from chain.",
+            NULL);
+        result = oe_cert_get_validity_dates(&cert, &from, &until);
+        oe_cert_free(&cert);
+        OE_CHECK_MSG(
+            result,
+            "Failed to get validity info from cert. %s",
+            oe_result_str(result));
+        _update_validity(&latest_from, &earliest_until, &from, &until);
+    }
 
     // Fetch revocation info validity dates.
     OE_CHECK_MSG(
@@ -672,9 +707,7 @@ oe_result_t oe_get_sgx_quote_validity(
 
 done:
     oe_cert_free(&pck_cert);
-    oe_cert_free(&intermediate_cert);
-    oe_cert_free(&root_cert);
-    oe_cert_chain_free(&pck_cert_chain);
+    oe_sgx_free_cert_chain(&issuer_chain);
 
     return result;
 }
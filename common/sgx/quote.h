@@ -9,30 +9,31 @@
 #include <openenclave/bits/types.h>
 #include <openenclave/internal/crypto/cert.h>
 #include <openenclave/internal/datetime.h>
+#include "certchaincache.h"
 #include "endorsements.h"
 
 OE_EXTERNC_BEGIN
 
 /*!
- * Retrieves certifate chain from the quote.
+ * Retrieves the PCK certificate from the quote, verified against its issuer
+ * chain.
  *
- * Caller is responsible for deallocating memory in pck_cert_chain.
+ * The issuer chain is shared by all quotes from platforms of the same family
+ * and is served from the certificate chain cache.
  *
  * @param[in] quote Input quote.
  * @param[in] quote_size The size of the quote.
- * @param[out] pem_pck_certifcate Pointer to the quote where the certificate PCK
- * starts.
- * @param[out] pem_pck_certificate_size Size of the PCK certificate.
- * @param[out] pck_cert_chain Reference to an instance of oe_cert_chain_t where
- * to store the chain.  Caller needs to free resources by calling
- * oe_cert_chain_free()
+ * @param[out] pck_cert The PCK certificate. Caller needs to free it by
+ * calling oe_cert_free().
+ * @param[out] issuer_chain The verified chain that issued the PCK
+ * certificate. Caller needs to release it by calling
+ * oe_sgx_free_cert_chain().
  */
-oe_result_t oe_get_quote_cert_chain_internal(
+oe_result_t oe_get_quote_pck_cert_internal(
     const uint8_t* quote,
-    const size_t quote_size,
-    const uint8_t** pem_pck_certificate,
-    size_t* pem_pck_certificate_size,
-    oe_cert_chain_t* pck_cert_chain);
+    size_t quote_size,
+    oe_cert_t* pck_cert,
+    oe_sgx_cert_chain_t* issuer_chain);
 
 /*!
  * Verify SGX quote and endorsements.
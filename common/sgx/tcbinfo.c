@@ -7,13 +7,7 @@
 #include <openenclave/internal/trace.h>
 #include <openenclave/internal/utils.h>
 #include "../common.h"
-
-// Public key of Intel's root certificate.
-static const char* _trusted_root_key_pem =
-    "-----BEGIN PUBLIC KEY-----\n"
-    "MFkwEwYHKoZIzj0CAQYIKoZIzj0DAQcDQgAEC6nEwMDIYZOj/iPWsCzaEKi71OiO\n"
-    "SLRFhWGjbnBVJfVnkY4u3IjkDYYL0MxO4mqsyYjlBalTVYxFP2sJBK5zlA==\n"
-    "-----END PUBLIC KEY-----\n";
+#include "certchaincache.h"
 
 OE_INLINE uint8_t _is_space(uint8_t c)
 {
@@ -220,6 +214,45 @@ done:
     return result;
 }
 
+// The TCB levels collected while compiling a TCB info or QE identity info.
+// Levels are appended in the order of the JSON, which is the order in which
+// Intel's algorithm matches them.
+typedef struct _tcb_levels
+{
+    void** levels;
+    size_t* count;
+    size_t capacity;
+    size_t level_size;
+} _tcb_levels_t;
+
+static oe_result_t _append_tcb_level(_tcb_levels_t* levels, const void* level)
+{
+    oe_result_t result = OE_UNEXPECTED;
+
+    if (*levels->count == levels->capacity)
+    {
+        size_t capacity = levels->capacity ? levels->capacity * 2 : 8;
+        void* tmp = oe_realloc(*levels->levels, capacity * levels->level_size);
+
+        if (!tmp)
+            OE_RAISE(OE_OUT_OF_MEMORY);
+
+        *levels->levels = tmp;
+        levels->capacity = capacity;
+    }
+
+    memcpy(
+        (uint8_t*)*levels->levels + *levels->count * levels->level_size,
+        level,
+        levels->level_size);
+    (*levels->count)++;
+
+    result = OE_OK;
+
+done:
+    return result;
+}
+
 static oe_tcb_level_status_t _parse_tcb_status(
     const uint8_t* str,
     size_t length)
@@ -321,7 +354,7 @@ done:
 // 4. If no tcb level was chosen, then the status of the platform is unknown.
 static void _determine_platform_tcb_info_tcb_level(
     oe_tcb_info_tcb_level_t* platform_tcb_level,
-    oe_tcb_info_tcb_level_t* tcb_level)
+    const oe_tcb_info_tcb_level_t* tcb_level)
 {
     // If the platform's status has already been determined, return.
     if (platform_tcb_level->status.AsUINT32 != OE_TCB_LEVEL_STATUS_UNKNOWN)
@@ -357,18 +390,20 @@ static void _determine_platform_tcb_info_tcb_level(
 static oe_result_t _read_tcb_info_tcb_level_v1(
     const uint8_t** itr,
     const uint8_t* end,
-    oe_tcb_info_tcb_level_t* platform_tcb_level)
+    oe_tcb_info_tcb_level_t* platform_tcb_level,
+    oe_tcb_info_tcb_level_t* tcb_level)
 {
     oe_result_t result = OE_JSON_INFO_PARSE_ERROR;
-    oe_tcb_info_tcb_level_t tcb_level = {{0}};
     const uint8_t* status = NULL;
     size_t status_length = 0;
 
+    memset(tcb_level, 0, sizeof(*tcb_level));
+
     OE_CHECK(_read('{', itr, end));
 
     OE_TRACE_VERBOSE("Reading tcb");
     OE_CHECK(_read_property_name_and_colon("tcb", itr, end));
-    OE_CHECK(_read_tcb_info_tcb_level(itr, end, &tcb_level));
+    OE_CHECK(_read_tcb_info_tcb_level(itr, end, tcb_level));
     OE_CHECK(_read(',', itr, end));
 
     OE_TRACE_VERBOSE("Reading status");
@@ -378,10 +413,10 @@ static oe_result_t _read_tcb_info_tcb_level_v1(
 
     OE_CHECK(_read('}', itr, end));
 
-    tcb_level.status = _parse_tcb_status(status, status_length);
-    if (tcb_level.status.AsUINT32 != OE_TCB_LEVEL_STATUS_UNKNOWN)
+    tcb_level->status = _parse_tcb_status(status, status_length);
+    if (tcb_level->status.AsUINT32 != OE_TCB_LEVEL_STATUS_UNKNOWN)
     {
-        _determine_platform_tcb_info_tcb_level(platform_tcb_level, &tcb_level);
+        _determine_platform_tcb_info_tcb_level(platform_tcb_level, tcb_level);
         result = OE_OK;
     }
 
@@ -490,18 +525,22 @@ done:
  *    "tcbEvaluationDataNumber" : integer
  *    "tcbLevels" : [ objects of type oe_tcb_info_tcb_level_t ]
  * }
+ *
+ * If levels is not NULL, all TCB levels are read and appended to it.
  */
 static oe_result_t _read_tcb_info(
     const uint8_t* tcb_info_json,
     const uint8_t** itr,
     const uint8_t* end,
     oe_tcb_info_tcb_level_t* platform_tcb_level,
-    oe_parsed_tcb_info_t* parsed_info)
+    oe_parsed_tcb_info_t* parsed_info,
+    _tcb_levels_t* levels)
 {
     oe_result_t result = OE_JSON_INFO_PARSE_ERROR;
     uint64_t value = 0;
     const uint8_t* date_str = NULL;
     size_t date_size = 0;
+    oe_tcb_info_tcb_level_t tcb_level = {{0}};
 
     parsed_info->tcb_info_start = *itr;
     OE_CHECK(_read('{', itr, end));
@@ -578,16 +617,26 @@ static oe_result_t _read_tcb_info(
         OE_CHECK(_read('[', itr, end));
         while (*itr < end)
         {
-            OE_CHECK(_read_tcb_info_tcb_level_v2(
-                tcb_info_json,
-                itr,
-                end,
-                platform_tcb_level,
-                &parsed_info->tcb_level));
+            if (levels)
+            {
+                memset(&tcb_level, 0, sizeof(tcb_level));
+                OE_CHECK(_read_tcb_info_tcb_level_v2(
+                    tcb_info_json, itr, end, platform_tcb_level, &tcb_level));
+                OE_CHECK(_append_tcb_level(levels, &tcb_level));
+            }
+            else
+            {
+                OE_CHECK(_read_tcb_info_tcb_level_v2(
+                    tcb_info_json,
+                    itr,
+                    end,
+                    platform_tcb_level,
+                    &parsed_info->tcb_level));
+            }
 
             // Optimization
-            if (platform_tcb_level->status.AsUINT32 !=
-                OE_TCB_LEVEL_STATUS_UNKNOWN)
+            if (!levels && platform_tcb_level->status.AsUINT32 !=
+                               OE_TCB_LEVEL_STATUS_UNKNOWN)
             {
                 // Found matching TCB level, go to the end of the array.
                 while (*itr < end && **itr != ']')
@@ -609,7 +658,10 @@ static oe_result_t _read_tcb_info(
         OE_CHECK(_read('[', itr, end));
         while (*itr < end)
         {
-            OE_CHECK(_read_tcb_info_tcb_level_v1(itr, end, platform_tcb_level));
+            OE_CHECK(_read_tcb_info_tcb_level_v1(
+                itr, end, platform_tcb_level, &tcb_level));
+            if (levels)
+                OE_CHECK(_append_tcb_level(levels, &tcb_level));
             // Read end of array or comma separator.
             if (*itr < end && **itr == ']')
                 break;
@@ -645,11 +697,12 @@ done:
  *    "signature" : "hex string"
  * }
  */
-oe_result_t oe_parse_tcb_info_json(
+static oe_result_t _parse_tcb_info_json(
     const uint8_t* tcb_info_json,
     size_t tcb_info_json_size,
     oe_tcb_info_tcb_level_t* platform_tcb_level,
-    oe_parsed_tcb_info_t* parsed_info)
+    oe_parsed_tcb_info_t* parsed_info,
+    _tcb_levels_t* levels)
 {
     oe_result_t result = OE_JSON_INFO_PARSE_ERROR;
     const uint8_t* itr = tcb_info_json;
@@ -672,7 +725,7 @@ oe_result_t oe_parse_tcb_info_json(
     OE_TRACE_VERBOSE("Reading tcbInfo");
     OE_CHECK(_read_property_name_and_colon("tcbInfo", &itr, end));
     OE_CHECK(_read_tcb_info(
-        tcb_info_json, &itr, end, platform_tcb_level, parsed_info));
+        tcb_info_json, &itr, end, platform_tcb_level, parsed_info, levels));
     OE_CHECK(_read(',', &itr, end));
 
     OE_TRACE_VERBOSE("Reading signature");
@@ -683,37 +736,144 @@ oe_result_t oe_parse_tcb_info_json(
     OE_CHECK(_read('}', &itr, end));
 
     if (itr == end)
+        result = OE_OK;
+done:
+    return result;
+}
+
+static oe_result_t _check_platform_tcb_level(
+    const oe_tcb_info_tcb_level_t* platform_tcb_level)
+{
+    oe_result_t result = OE_UNEXPECTED;
+
+    if (platform_tcb_level->status.fields.up_to_date != 1)
     {
-        if (platform_tcb_level->status.fields.up_to_date != 1)
-        {
-            for (uint32_t i = 0;
-                 i < OE_COUNTOF(platform_tcb_level->sgx_tcb_comp_svn);
-                 ++i)
-                OE_TRACE_VERBOSE(
-                    "sgx_tcb_comp_svn[%d] = 0x%x",
-                    i,
-                    platform_tcb_level->sgx_tcb_comp_svn[i]);
-            OE_TRACE_VERBOSE("pce_svn = 0x%x", platform_tcb_level->pce_svn);
-            OE_RAISE_MSG(
-                OE_TCB_LEVEL_INVALID,
-                "Platform TCB (%d) is not up-to-date",
-                platform_tcb_level->status);
-        }
+        for (uint32_t i = 0;
+             i < OE_COUNTOF(platform_tcb_level->sgx_tcb_comp_svn);
+             ++i)
+            OE_TRACE_VERBOSE(
+                "sgx_tcb_comp_svn[%d] = 0x%x",
+                i,
+                platform_tcb_level->sgx_tcb_comp_svn[i]);
+        OE_TRACE_VERBOSE("pce_svn = 0x%x", platform_tcb_level->pce_svn);
+        OE_RAISE_MSG(
+            OE_TCB_LEVEL_INVALID,
+            "Platform TCB (%d) is not up-to-date",
+            platform_tcb_level->status);
+    }
 
-        // Display any advisory IDs as warnings
-        if (platform_tcb_level->advisory_ids_size > 0)
-        {
-            OE_TRACE_WARNING(
-                "Found %d AdvisoryIDs for this tcb level.",
-                platform_tcb_level->advisory_ids_size);
-        }
+    // Display any advisory IDs as warnings
+    if (platform_tcb_level->advisory_ids_size > 0)
+    {
+        OE_TRACE_WARNING(
+            "Found %d AdvisoryIDs for this tcb level.",
+            platform_tcb_level->advisory_ids_size);
+    }
 
-        result = OE_OK;
+    result = OE_OK;
+done:
+    return result;
+}
+
+oe_result_t oe_parse_tcb_info_json(
+    const uint8_t* tcb_info_json,
+    size_t tcb_info_json_size,
+    oe_tcb_info_tcb_level_t* platform_tcb_level,
+    oe_parsed_tcb_info_t* parsed_info)
+{
+    oe_result_t result = OE_UNEXPECTED;
+
+    OE_CHECK(_parse_tcb_info_json(
+        tcb_info_json,
+        tcb_info_json_size,
+        platform_tcb_level,
+        parsed_info,
+        NULL));
+    OE_CHECK(_check_platform_tcb_level(platform_tcb_level));
+
+    result = OE_OK;
+done:
+    return result;
+}
+
+oe_result_t oe_compile_tcb_info_json(
+    const uint8_t* tcb_info_json,
+    size_t tcb_info_json_size,
+    oe_compiled_tcb_info_t* compiled)
+{
+    oe_result_t result = OE_UNEXPECTED;
+    oe_tcb_info_tcb_level_t scratch_tcb_level = {{0}};
+    _tcb_levels_t levels = {0};
+
+    if (compiled)
+        memset(compiled, 0, sizeof(*compiled));
+
+    if (compiled == NULL)
+        OE_RAISE(OE_INVALID_PARAMETER);
+
+    levels.levels = (void**)&compiled->tcb_levels;
+    levels.count = &compiled->num_tcb_levels;
+    levels.level_size = sizeof(*compiled->tcb_levels);
+
+    OE_CHECK(_parse_tcb_info_json(
+        tcb_info_json,
+        tcb_info_json_size,
+        &scratch_tcb_level,
+        &compiled->parsed_info,
+        &levels));
+
+    result = OE_OK;
+done:
+    if (result != OE_OK)
+        oe_free_compiled_tcb_info(compiled);
+
+    return result;
+}
+
+oe_result_t oe_compiled_tcb_info_get_tcb_level(
+    const oe_compiled_tcb_info_t* compiled,
+    oe_tcb_info_tcb_level_t* platform_tcb_level,
+    oe_parsed_tcb_info_t* parsed_info)
+{
+    oe_result_t result = OE_UNEXPECTED;
+    const oe_tcb_info_tcb_level_t* tcb_level = NULL;
+
+    if (compiled == NULL || platform_tcb_level == NULL || parsed_info == NULL)
+        OE_RAISE(OE_INVALID_PARAMETER);
+
+    *parsed_info = compiled->parsed_info;
+    platform_tcb_level->status.AsUINT32 = OE_TCB_LEVEL_STATUS_UNKNOWN;
+
+    // The first level that the platform meets determines its status.
+    for (size_t i = 0; i < compiled->num_tcb_levels; i++)
+    {
+        tcb_level = &compiled->tcb_levels[i];
+        _determine_platform_tcb_info_tcb_level(platform_tcb_level, tcb_level);
+
+        if (platform_tcb_level->status.AsUINT32 != OE_TCB_LEVEL_STATUS_UNKNOWN)
+            break;
     }
+
+    // As when parsing, V2 reports the matching (or else the last) level.
+    if (parsed_info->version == 2 && tcb_level)
+        parsed_info->tcb_level = *tcb_level;
+
+    OE_CHECK(_check_platform_tcb_level(platform_tcb_level));
+
+    result = OE_OK;
 done:
     return result;
 }
 
+void oe_free_compiled_tcb_info(oe_compiled_tcb_info_t* compiled)
+{
+    if (compiled)
+    {
+        oe_free(compiled->tcb_levels);
+        memset(compiled, 0, sizeof(*compiled));
+    }
+}
+
 OE_INLINE uint32_t read_uint32(const uint8_t* p)
 {
     return (uint32_t)(p[0] | (p[1] << 8) | (p[2] << 16) | (p[3] << 24));
@@ -898,7 +1058,7 @@ done:
 // 4. If no tcb level was chosen, then the status of the platform is unknown.
 static void _determine_platform_qe_tcb_level(
     oe_qe_identity_info_tcb_level_t* platform_tcb_level,
-    oe_qe_identity_info_tcb_level_t* tcb_level)
+    const oe_qe_identity_info_tcb_level_t* tcb_level)
 {
     // If the platform's status has already been determined, return.
     if (platform_tcb_level->tcb_status.AsUINT32 != OE_TCB_LEVEL_STATUS_UNKNOWN)
@@ -1022,7 +1182,8 @@ static oe_result_t _read_qe_identity_info_v2(
     const uint8_t** itr,
     const uint8_t* end,
     oe_qe_identity_info_tcb_level_t* platform_tcb_level,
-    oe_parsed_qe_identity_info_t* parsed_info)
+    oe_parsed_qe_identity_info_t* parsed_info,
+    _tcb_levels_t* levels)
 {
     oe_result_t result = OE_JSON_INFO_PARSE_ERROR;
     uint64_t value = 0;
@@ -1133,9 +1294,12 @@ static oe_result_t _read_qe_identity_info_v2(
         OE_CHECK(_read_qe_tcb_level(
             info_json, itr, end, platform_tcb_level, &parsed_info->tcb_level));
 
+        if (levels)
+            OE_CHECK(_append_tcb_level(levels, &parsed_info->tcb_level));
+
         // Optimization
-        if (platform_tcb_level->tcb_status.AsUINT32 !=
-            OE_TCB_LEVEL_STATUS_UNKNOWN)
+        if (!levels && platform_tcb_level->tcb_status.AsUINT32 !=
+                           OE_TCB_LEVEL_STATUS_UNKNOWN)
         {
             // Found matching TCB level, go to the end of the array.
             while (*itr < end && **itr != ']')
@@ -1181,11 +1345,12 @@ done:
  *    "signature" : "hex string"
  * }
  */
-oe_result_t oe_parse_qe_identity_info_json(
+static oe_result_t _parse_qe_identity_info_json(
     const uint8_t* info_json,
     size_t info_json_size,
     oe_qe_identity_info_tcb_level_t* platform_tcb_level,
-    oe_parsed_qe_identity_info_t* parsed_info)
+    oe_parsed_qe_identity_info_t* parsed_info,
+    _tcb_levels_t* levels)
 {
     oe_result_t result = OE_JSON_INFO_PARSE_ERROR;
 
@@ -1207,7 +1372,7 @@ oe_result_t oe_parse_qe_identity_info_json(
     {
         OE_TRACE_VERBOSE("Reading enclaveIdentity");
         OE_CHECK(_read_qe_identity_info_v2(
-            info_json, &itr, end, platform_tcb_level, parsed_info));
+            info_json, &itr, end, platform_tcb_level, parsed_info, levels));
         OE_CHECK(_read(',', &itr, end));
     }
     else
@@ -1225,37 +1390,148 @@ oe_result_t oe_parse_qe_identity_info_json(
     OE_CHECK(_read('}', &itr, end));
 
     if (itr == end)
+        result = OE_OK;
+
+done:
+    OE_TRACE_VERBOSE(
+        "oe_parse_qe_identity_info_json ended with [%s]\n",
+        oe_result_str(result));
+    return result;
+}
+
+static oe_result_t _check_platform_qe_tcb_level(
+    const oe_qe_identity_info_tcb_level_t* platform_tcb_level,
+    const oe_parsed_qe_identity_info_t* parsed_info)
+{
+    oe_result_t result = OE_UNEXPECTED;
+
+    if (parsed_info->version == 2 &&
+        platform_tcb_level->tcb_status.fields.up_to_date != 1)
     {
-        if (parsed_info->version == 2 &&
-            platform_tcb_level->tcb_status.fields.up_to_date != 1)
-        {
-            for (uint32_t i = 0; i < OE_COUNTOF(platform_tcb_level->isvsvn);
-                 ++i)
-                OE_TRACE_VERBOSE(
-                    "isvsvn[%d] = 0x%x", i, platform_tcb_level->isvsvn[i]);
-            OE_RAISE_MSG(
-                OE_TCB_LEVEL_INVALID,
-                "QE Identity Information (%d) is not up-to-date",
-                platform_tcb_level->tcb_status.AsUINT32);
-        }
+        for (uint32_t i = 0; i < OE_COUNTOF(platform_tcb_level->isvsvn); ++i)
+            OE_TRACE_VERBOSE(
+                "isvsvn[%d] = 0x%x", i, platform_tcb_level->isvsvn[i]);
+        OE_RAISE_MSG(
+            OE_TCB_LEVEL_INVALID,
+            "QE Identity Information (%d) is not up-to-date",
+            platform_tcb_level->tcb_status.AsUINT32);
+    }
+
+    // Display any advisory IDs as warnings
+    if (parsed_info->tcb_level.advisory_ids_size > 0)
+    {
+        OE_TRACE_WARNING(
+            "Found %d AdvisoryIDs for this tcb level.",
+            parsed_info->tcb_level.advisory_ids_size);
+    }
+
+    result = OE_OK;
+done:
+    return result;
+}
+
+oe_result_t oe_parse_qe_identity_info_json(
+    const uint8_t* info_json,
+    size_t info_json_size,
+    oe_qe_identity_info_tcb_level_t* platform_tcb_level,
+    oe_parsed_qe_identity_info_t* parsed_info)
+{
+    oe_result_t result = OE_UNEXPECTED;
 
-        // Display any advisory IDs as warnings
-        if (parsed_info->tcb_level.advisory_ids_size > 0)
+    OE_CHECK(_parse_qe_identity_info_json(
+        info_json, info_json_size, platform_tcb_level, parsed_info, NULL));
+    OE_CHECK(_check_platform_qe_tcb_level(platform_tcb_level, parsed_info));
+
+    result = OE_OK;
+done:
+    return result;
+}
+
+oe_result_t oe_compile_qe_identity_info_json(
+    const uint8_t* info_json,
+    size_t info_json_size,
+    oe_compiled_qe_identity_info_t* compiled)
+{
+    oe_result_t result = OE_UNEXPECTED;
+    oe_qe_identity_info_tcb_level_t scratch_tcb_level = {{0}};
+    _tcb_levels_t levels = {0};
+
+    if (compiled)
+        memset(compiled, 0, sizeof(*compiled));
+
+    if (compiled == NULL)
+        OE_RAISE(OE_INVALID_PARAMETER);
+
+    levels.levels = (void**)&compiled->tcb_levels;
+    levels.count = &compiled->num_tcb_levels;
+    levels.level_size = sizeof(*compiled->tcb_levels);
+
+    OE_CHECK(_parse_qe_identity_info_json(
+        info_json,
+        info_json_size,
+        &scratch_tcb_level,
+        &compiled->parsed_info,
+        &levels));
+
+    result = OE_OK;
+done:
+    if (result != OE_OK)
+        oe_free_compiled_qe_identity_info(compiled);
+
+    return result;
+}
+
+oe_result_t oe_compiled_qe_identity_info_get_tcb_level(
+    const oe_compiled_qe_identity_info_t* compiled,
+    oe_qe_identity_info_tcb_level_t* platform_tcb_level,
+    oe_parsed_qe_identity_info_t* parsed_info)
+{
+    oe_result_t result = OE_UNEXPECTED;
+    const oe_qe_identity_info_tcb_level_t* tcb_level = NULL;
+
+    if (compiled == NULL || platform_tcb_level == NULL || parsed_info == NULL)
+        OE_RAISE(OE_INVALID_PARAMETER);
+
+    *parsed_info = compiled->parsed_info;
+
+    if (parsed_info->version == 2)
+    {
+        platform_tcb_level->tcb_status.AsUINT32 = OE_TCB_LEVEL_STATUS_UNKNOWN;
+
+        // The first level that the QE meets determines its status.
+        for (size_t i = 0; i < compiled->num_tcb_levels; i++)
         {
-            OE_TRACE_WARNING(
-                "Found %d AdvisoryIDs for this tcb level.",
-                parsed_info->tcb_level.advisory_ids_size);
+            tcb_level = &compiled->tcb_levels[i];
+            _determine_platform_qe_tcb_level(platform_tcb_level, tcb_level);
+
+            if (platform_tcb_level->tcb_status.AsUINT32 !=
+                OE_TCB_LEVEL_STATUS_UNKNOWN)
+                break;
         }
-        result = OE_OK;
+
+        // As when parsing, report the matching (or else the last) level and
+        // synchronize the legacy V1 field with it.
+        if (tcb_level)
+            parsed_info->tcb_level = *tcb_level;
+        parsed_info->isvsvn = (uint16_t)parsed_info->tcb_level.isvsvn[0];
     }
 
+    OE_CHECK(_check_platform_qe_tcb_level(platform_tcb_level, parsed_info));
+
+    result = OE_OK;
 done:
-    OE_TRACE_VERBOSE(
-        "oe_parse_qe_identity_info_json ended with [%s]\n",
-        oe_result_str(result));
     return result;
 }
 
+void oe_free_compiled_qe_identity_info(oe_compiled_qe_identity_info_t* compiled)
+{
+    if (compiled)
+    {
+        oe_free(compiled->tcb_levels);
+        memset(compiled, 0, sizeof(*compiled));
+    }
+}
+
 static oe_result_t _ecdsa_verify(
     oe_ec_public_key_t* publicKey,
     const void* data,
@@ -1304,7 +1580,7 @@ oe_result_t oe_verify_ecdsa256_signature(
     oe_cert_t leaf_cert = {0};
     oe_ec_public_key_t tcb_root_key = {0};
     oe_ec_public_key_t tcb_signing_key = {0};
-    oe_ec_public_key_t trusted_root_key = {0};
+    const oe_ec_public_key_t* trusted_root_key = NULL;
     bool root_of_trust_match = false;
 
     if (tcb_info_start == NULL || tcb_info_size == 0 || signature == NULL ||
@@ -1321,13 +1597,9 @@ oe_result_t oe_verify_ecdsa256_signature(
         &tcb_signing_key, tcb_info_start, tcb_info_size, signature));
 
     // Ensure that the root certificate matches root of trust.
-    OE_CHECK(oe_ec_public_key_read_pem(
-        &trusted_root_key,
-        (const uint8_t*)_trusted_root_key_pem,
-        oe_strlen(_trusted_root_key_pem) + 1));
-
+    OE_CHECK(oe_sgx_get_intel_root_key(&trusted_root_key));
     OE_CHECK(oe_ec_public_key_equal(
-        &trusted_root_key, &tcb_root_key, &root_of_trust_match));
+        trusted_root_key, &tcb_root_key, &root_of_trust_match));
 
     if (!root_of_trust_match)
     {
@@ -1338,7 +1610,6 @@ oe_result_t oe_verify_ecdsa256_signature(
 
     result = OE_OK;
 done:
-    oe_ec_public_key_free(&trusted_root_key);
     oe_ec_public_key_free(&tcb_signing_key);
     oe_ec_public_key_free(&tcb_root_key);
 
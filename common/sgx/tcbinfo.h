@@ -116,6 +116,52 @@ oe_result_t oe_parse_tcb_info_json(
     oe_tcb_info_tcb_level_t* platform_tcb_level,
     oe_parsed_tcb_info_t* parsed_info);
 
+/*! \struct oe_compiled_tcb_info_t
+ *  \brief TCB info with all of its TCB levels, parsed once.
+ */
+typedef struct _oe_compiled_tcb_info
+{
+    //! The TCB info. The tcb_level field is not set.
+    oe_parsed_tcb_info_t parsed_info;
+
+    //! The TCB levels in the order of the JSON.
+    oe_tcb_info_tcb_level_t* tcb_levels;
+    size_t num_tcb_levels;
+} oe_compiled_tcb_info_t;
+
+/**
+ * Parse the given tcb info json string, including all of its TCB levels,
+ * so that the status of any platform can later be determined with
+ * oe_compiled_tcb_info_get_tcb_level() without parsing the json again.
+ * The tcb_info_start field of the result points into **tcb_info_json**.
+ *
+ * @param[in] tcb_info_json The json string to parse.
+ * @param[in] tcb_info_json_size The string length of info_json
+ * @param[out] compiled The compiled TCB info. Release it with
+ * oe_free_compiled_tcb_info().
+ */
+oe_result_t oe_compile_tcb_info_json(
+    const uint8_t* tcb_info_json,
+    size_t tcb_info_json_size,
+    oe_compiled_tcb_info_t* compiled);
+
+/**
+ * Determine the status of the platform_tcb_level from a compiled TCB info,
+ * with the same results as oe_parse_tcb_info_json().
+ *
+ * @param[in] compiled The compiled TCB info.
+ * @param[in,out] platform_tcb_level The platform tcb level.
+ *                The sgx_tcb_comp_svn and pce_svn fields are required to be
+ * set.
+ * @param[out] parsed_info The parsed results.
+ */
+oe_result_t oe_compiled_tcb_info_get_tcb_level(
+    const oe_compiled_tcb_info_t* compiled,
+    oe_tcb_info_tcb_level_t* platform_tcb_level,
+    oe_parsed_tcb_info_t* parsed_info);
+
+void oe_free_compiled_tcb_info(oe_compiled_tcb_info_t* compiled);
+
 oe_result_t oe_verify_ecdsa256_signature(
     const uint8_t* tcb_info_start,
     size_t tcb_info_size,
@@ -192,6 +238,52 @@ oe_result_t oe_parse_qe_identity_info_json(
     oe_qe_identity_info_tcb_level_t* platform_tcb_level,
     oe_parsed_qe_identity_info_t* parsed_info);
 
+/*! \struct oe_compiled_qe_identity_info_t
+ *  \brief QE identity info with all of its TCB levels, parsed once.
+ */
+typedef struct _oe_compiled_qe_identity_info
+{
+    //! The QE identity info. For V2, the tcb_level and isvsvn fields are
+    //! those of the last TCB level.
+    oe_parsed_qe_identity_info_t parsed_info;
+
+    //! The TCB levels (V2 only) in the order of the JSON.
+    oe_qe_identity_info_tcb_level_t* tcb_levels;
+    size_t num_tcb_levels;
+} oe_compiled_qe_identity_info_t;
+
+/*!
+ * Parse a QE or QVE identity json string, including all of its TCB levels.
+ * The info_start field of the result points into **info_json**.
+ *
+ * @param[in] info_json The json string to parse.
+ * @param[in] info_json_size The string length of info_json
+ * @param[out] compiled The compiled info. Release it with
+ * oe_free_compiled_qe_identity_info().
+ */
+oe_result_t oe_compile_qe_identity_info_json(
+    const uint8_t* info_json,
+    size_t info_json_size,
+    oe_compiled_qe_identity_info_t* compiled);
+
+/*!
+ * Determine the status of the platform_tcb_level from a compiled QE identity
+ * info, with the same results as oe_parse_qe_identity_info_json().
+ *
+ * @param[in] compiled The compiled info.
+ * @param[in,out] platform_tcb_level The platform tcb level.
+ *                The platform isvsvn is required to be set as input.
+ *                The status field is updated as output.
+ * @param[out] parsed_info The parsed results.
+ */
+oe_result_t oe_compiled_qe_identity_info_get_tcb_level(
+    const oe_compiled_qe_identity_info_t* compiled,
+    oe_qe_identity_info_tcb_level_t* platform_tcb_level,
+    oe_parsed_qe_identity_info_t* parsed_info);
+
+void oe_free_compiled_qe_identity_info(
+    oe_compiled_qe_identity_info_t* compiled);
+
 /*!
  * Parse an advisoryIDs field json string.
  *
@@ -0,0 +1,434 @@
+// Copyright (c) Open Enclave SDK contributors.
+// Licensed under the MIT License.
+
+#include "tcbinfocache.h"
+#include <openenclave/internal/crypto/sha.h>
+#include <openenclave/internal/datetime.h>
+#include <openenclave/internal/raise.h>
+#include <openenclave/internal/trace.h>
+#include "../common.h"
+
+#ifdef OE_BUILD_ENCLAVE
+#include <openenclave/internal/thread.h>
+typedef oe_mutex_t _mutex_t;
+#define _MUTEX_INITIALIZER OE_MUTEX_INITIALIZER
+#else
+#include "../../host/hostthread.h"
+typedef oe_mutex _mutex_t;
+#define _MUTEX_INITIALIZER OE_H_MUTEX_INITIALIZER
+#endif
+
+/*
+**==============================================================================
+**
+** SGX TCB info cache:
+**
+**     Verifying a quote evaluates the TCB info of the platform's FMSPC and
+**     the QE identity info. Both are signed JSON documents that change at
+**     most daily, so instead of parsing the JSON and verifying its signature
+**     for every quote, each document is compiled once into its parsed fields
+**     and an array of TCB levels, and the compiled form is cached.
+**
+**     The cache is an array of entries sorted by key, the SHA-256 of the
+**     document and of its issuer chain, so a lookup is a binary search.
+**     Entries are reference counted: an entry is only evicted (the one with
+**     the earliest nextUpdate) while it is unused, and an entry that could
+**     not be cached is freed when it is released.
+**
+**==============================================================================
+*/
+
+typedef enum _entry_type
+{
+    ENTRY_TYPE_TCB_INFO = 1,
+    ENTRY_TYPE_QE_IDENTITY_INFO = 2
+} _entry_type_t;
+
+typedef struct _entry
+{
+    /* The compiled document. Must be the first field */
+    union {
+        oe_compiled_tcb_info_t tcb_info;
+        oe_compiled_qe_identity_info_t qe_identity_info;
+    } u;
+
+    _entry_type_t type;
+    OE_SHA256 key;
+    uint64_t refs;
+    bool cached;
+} _entry_t;
+
+static _entry_t* _entries[OE_SGX_TCB_INFO_CACHE_SIZE];
+static size_t _num_entries;
+static oe_sgx_tcb_info_cache_stats_t _stats;
+
+/* Protects all of the above */
+static _mutex_t _lock = _MUTEX_INITIALIZER;
+
+static oe_result_t _compute_key(
+    _entry_type_t type,
+    const uint8_t* json,
+    size_t json_size,
+    const uint8_t* issuer_chain_pem,
+    size_t issuer_chain_pem_size,
+    OE_SHA256* key)
+{
+    oe_result_t result = OE_UNEXPECTED;
+    oe_sha256_context_t context = {0};
+    uint64_t sizes[3] = {type, json_size, issuer_chain_pem_size};
+
+    // The sizes keep the concatenation unambiguous.
+    OE_CHECK(oe_sha256_init(&context));
+    OE_CHECK(oe_sha256_update(&context, sizes, sizeof(sizes)));
+    OE_CHECK(oe_sha256_update(&context, json, json_size));
+    OE_CHECK(
+        oe_sha256_update(&context, issuer_chain_pem, issuer_chain_pem_size));
+    OE_CHECK(oe_sha256_final(&context, key));
+
+    result = OE_OK;
+
+done:
+    return result;
+}
+
+static const oe_datetime_t* _next_update(const _entry_t* entry)
+{
+    if (entry->type == ENTRY_TYPE_TCB_INFO)
+        return &entry->u.tcb_info.parsed_info.next_update;
+
+    return &entry->u.qe_identity_info.parsed_info.next_update;
+}
+
+static void _free_entry(_entry_t* entry)
+{
+    if (entry->type == ENTRY_TYPE_TCB_INFO)
+        oe_free_compiled_tcb_info(&entry->u.tcb_info);
+    else
+        oe_free_compiled_qe_identity_info(&entry->u.qe_identity_info);
+
+    oe_free(entry);
+}
+
+/* Find the index of the first entry whose key is not less than key. Called
+ * with _lock held */
+static size_t _lower_bound(const OE_SHA256* key)
+{
+    size_t low = 0;
+    size_t high = _num_entries;
+
+    while (low < high)
+    {
+        size_t mid = low + (high - low) / 2;
+
+        if (memcmp(&_entries[mid]->key, key, sizeof(*key)) < 0)
+            low = mid + 1;
+        else
+            high = mid;
+    }
+
+    return low;
+}
+
+/* Find and reference the entry with the key. Called with _lock held */
+static _entry_t* _find(const OE_SHA256* key)
+{
+    size_t index = _lower_bound(key);
+
+    if (index < _num_entries &&
+        memcmp(&_entries[index]->key, key, sizeof(*key)) == 0)
+    {
+        _entries[index]->refs++;
+        return _entries[index];
+    }
+
+    return NULL;
+}
+
+/* Remove the unused entry with the earliest nextUpdate. Called with _lock
+ * held */
+static bool _evict(void)
+{
+    size_t victim = _num_entries;
+
+    for (size_t i = 0; i < _num_entries; i++)
+    {
+        if (_entries[i]->refs)
+            continue;
+
+        if (victim == _num_entries ||
+            oe_datetime_compare(
+                _next_update(_entries[i]), _next_update(_entries[victim])) < 0)
+            victim = i;
+    }
+
+    if (victim == _num_entries)
+        return false;
+
+    _free_entry(_entries[victim]);
+    memmove(
+        &_entries[victim],
+        &_entries[victim + 1],
+        (_num_entries - victim - 1) * sizeof(_entries[0]));
+    _num_entries--;
+
+    return true;
+}
+
+/* Add a new entry, or return the equal entry that another thread added in
+ * the meantime. Called with _lock held */
+static _entry_t* _insert(_entry_t* entry)
+{
+    _entry_t* existing = NULL;
+    size_t index;
+
+    if ((existing = _find(&entry->key)))
+    {
+        _free_entry(entry);
+        return existing;
+    }
+
+    if (_num_entries == OE_COUNTOF(_entries) && !_evict())
+        return entry;
+
+    index = _lower_bound(&entry->key);
+    memmove(
+        &_entries[index + 1],
+        &_entries[index],
+        (_num_entries - index) * sizeof(_entries[0]));
+    _entries[index] = entry;
+    _num_entries++;
+    entry->cached = true;
+
+    return entry;
+}
+
+static oe_result_t _compile(
+    _entry_type_t type,
+    const uint8_t* json,
+    size_t json_size,
+    oe_cert_chain_t* issuer_chain,
+    _entry_t* entry)
+{
+    oe_result_t result = OE_UNEXPECTED;
+
+    entry->type = type;
+    entry->refs = 1;
+
+    if (type == ENTRY_TYPE_TCB_INFO)
+    {
+        oe_parsed_tcb_info_t* info = &entry->u.tcb_info.parsed_info;
+
+        OE_CHECK_MSG(
+            oe_compile_tcb_info_json(json, json_size, &entry->u.tcb_info),
+            "Failed to parse TCB info. %s",
+            oe_result_str(result));
+
+        OE_CHECK_MSG(
+            oe_verify_ecdsa256_signature(
+                info->tcb_info_start,
+                info->tcb_info_size,
+                (sgx_ecdsa256_signature_t*)info->signature,
+                issuer_chain),
+            "Failed to verify ECDSA 256 signature in TCB. %s",
+            oe_result_str(result));
+
+        // The json is owned by the caller.
+        info->tcb_info_start = NULL;
+    }
+    else
+    {
+        oe_parsed_qe_identity_info_t* info =
+            &entry->u.qe_identity_info.parsed_info;
+
+        OE_CHECK(oe_compile_qe_identity_info_json(
+            json, json_size, &entry->u.qe_identity_info));
+
+        OE_TRACE_INFO("Calling oe_verify_ecdsa256_signature\n");
+        OE_CHECK(oe_verify_ecdsa256_signature(
+            info->info_start,
+            info->info_size,
+            (sgx_ecdsa256_signature_t*)info->signature,
+            issuer_chain));
+        OE_TRACE_INFO("oe_verify_ecdsa256_signature succeeded\n");
+
+        // The json is owned by the caller.
+        info->info_start = NULL;
+    }
+
+    result = OE_OK;
+
+done:
+    return result;
+}
+
+static oe_result_t _get(
+    _entry_type_t type,
+    const uint8_t* json,
+    size_t json_size,
+    const uint8_t* issuer_chain_pem,
+    size_t issuer_chain_pem_size,
+    oe_cert_chain_t* issuer_chain,
+    _entry_t** entry_out)
+{
+    oe_result_t result = OE_UNEXPECTED;
+    OE_SHA256 key = {0};
+    _entry_t* entry = NULL;
+
+    *entry_out = NULL;
+
+    if (!json || !json_size || !issuer_chain_pem || !issuer_chain_pem_size ||
+        !issuer_chain)
+        OE_RAISE(OE_INVALID_PARAMETER);
+
+    OE_CHECK(_compute_key(
+        type, json, json_size, issuer_chain_pem, issuer_chain_pem_size, &key));
+
+    oe_mutex_lock(&_lock);
+    if ((entry = _find(&key)))
+        _stats.hits++;
+    oe_mutex_unlock(&_lock);
+
+    if (entry)
+    {
+        *entry_out = entry;
+        result = OE_OK;
+        goto done;
+    }
+
+    // Parse and verify outside the lock.
+    if (!(entry = (_entry_t*)oe_calloc(1, sizeof(*entry))))
+        OE_RAISE(OE_OUT_OF_MEMORY);
+
+    entry->key = key;
+    OE_CHECK(_compile(type, json, json_size, issuer_chain, entry));
+
+    oe_mutex_lock(&_lock);
+    _stats.misses++;
+    *entry_out = _insert(entry);
+    oe_mutex_unlock(&_lock);
+
+    entry = NULL;
+    result = OE_OK;
+
+done:
+    if (entry && result != OE_OK)
+        _free_entry(entry);
+
+    return result;
+}
+
+static void _release(_entry_t* entry)
+{
+    bool free_entry;
+
+    if (!entry)
+        return;
+
+    oe_mutex_lock(&_lock);
+    free_entry = (--entry->refs == 0 && !entry->cached);
+    oe_mutex_unlock(&_lock);
+
+    if (free_entry)
+        _free_entry(entry);
+}
+
+oe_result_t oe_sgx_get_tcb_info(
+    const uint8_t* tcb_info_json,
+    size_t tcb_info_json_size,
+    const uint8_t* issuer_chain_pem,
+    size_t issuer_chain_pem_size,
+    oe_cert_chain_t* issuer_chain,
+    const oe_compiled_tcb_info_t** tcb_info)
+{
+    oe_result_t result = OE_UNEXPECTED;
+    _entry_t* entry = NULL;
+
+    if (!tcb_info)
+        OE_RAISE(OE_INVALID_PARAMETER);
+
+    OE_CHECK(_get(
+        ENTRY_TYPE_TCB_INFO,
+        tcb_info_json,
+        tcb_info_json_size,
+        issuer_chain_pem,
+        issuer_chain_pem_size,
+        issuer_chain,
+        &entry));
+
+    *tcb_info = &entry->u.tcb_info;
+    result = OE_OK;
+
+done:
+    return result;
+}
+
+void oe_sgx_release_tcb_info(const oe_compiled_tcb_info_t* tcb_info)
+{
+    _release((_entry_t*)tcb_info);
+}
+
+oe_result_t oe_sgx_get_qe_identity_info(
+    const uint8_t* info_json,
+    size_t info_json_size,
+    const uint8_t* issuer_chain_pem,
+    size_t issuer_chain_pem_size,
+    oe_cert_chain_t* issuer_chain,
+    const oe_compiled_qe_identity_info_t** qe_identity_info)
+{
+    oe_result_t result = OE_UNEXPECTED;
+    _entry_t* entry = NULL;
+
+    if (!qe_identity_info)
+        OE_RAISE(OE_INVALID_PARAMETER);
+
+    OE_CHECK(_get(
+        ENTRY_TYPE_QE_IDENTITY_INFO,
+        info_json,
+        info_json_size,
+        issuer_chain_pem,
+        issuer_chain_pem_size,
+        issuer_chain,
+        &entry));
+
+    *qe_identity_info = &entry->u.qe_identity_info;
+    result = OE_OK;
+
+done:
+    return result;
+}
+
+void oe_sgx_release_qe_identity_info(
+    const oe_compiled_qe_identity_info_t* qe_identity_info)
+{
+    _release((_entry_t*)qe_identity_info);
+}
+
+void oe_sgx_tcb_info_cache_clear(void)
+{
+    oe_mutex_lock(&_lock);
+
+    // Entries in use are dropped from the cache and freed on release.
+    for (size_t i = 0; i < _num_entries; i++)
+    {
+        if (_entries[i]->refs)
+            _entries[i]->cached = false;
+        else
+            _free_entry(_entries[i]);
+
+        _entries[i] = NULL;
+    }
+
+    _num_entries = 0;
+
+    oe_mutex_unlock(&_lock);
+}
+
+void oe_sgx_tcb_info_cache_get_stats(oe_sgx_tcb_info_cache_stats_t* stats)
+{
+    if (!stats)
+        return;
+
+    oe_mutex_lock(&_lock);
+    *stats = _stats;
+    oe_mutex_unlock(&_lock);
+}
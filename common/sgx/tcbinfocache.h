@@ -0,0 +1,91 @@
+// Copyright (c) Open Enclave SDK contributors.
+// Licensed under the MIT License.
+
+#ifndef _OE_COMMON_SGX_TCBINFOCACHE_H
+#define _OE_COMMON_SGX_TCBINFOCACHE_H
+
+#include <openenclave/bits/defs.h>
+#include <openenclave/bits/result.h>
+#include <openenclave/bits/types.h>
+#include <openenclave/internal/crypto/cert.h>
+#include "tcbinfo.h"
+
+OE_EXTERNC_BEGIN
+
+/* The maximum number of verified TCB infos and QE identity infos cached */
+#define OE_SGX_TCB_INFO_CACHE_SIZE 32
+
+/**
+ * Get the compiled form of a TCB info whose signature has been verified
+ * with the leaf of **issuer_chain**.
+ *
+ * TCB info changes at most daily for a given FMSPC, so the compiled TCB info
+ * is cached, keyed by the SHA-256 of **tcb_info_json** and
+ * **issuer_chain_pem**, and later calls with the same data neither parse the
+ * json nor verify its signature again. The tcb_info_start field of the result
+ * is not set.
+ *
+ * @param[in] tcb_info_json The TCB info json string.
+ * @param[in] tcb_info_json_size The size of **tcb_info_json**.
+ * @param[in] issuer_chain_pem The PEM of the TCB info issuer chain.
+ * @param[in] issuer_chain_pem_size The size of **issuer_chain_pem**.
+ * @param[in] issuer_chain The verified TCB info issuer chain.
+ * @param[out] tcb_info The compiled TCB info. Release it with
+ * oe_sgx_release_tcb_info().
+ */
+oe_result_t oe_sgx_get_tcb_info(
+    const uint8_t* tcb_info_json,
+    size_t tcb_info_json_size,
+    const uint8_t* issuer_chain_pem,
+    size_t issuer_chain_pem_size,
+    oe_cert_chain_t* issuer_chain,
+    const oe_compiled_tcb_info_t** tcb_info);
+
+void oe_sgx_release_tcb_info(const oe_compiled_tcb_info_t* tcb_info);
+
+/**
+ * Get the compiled form of a QE identity info whose signature has been
+ * verified with the leaf of **issuer_chain**. Cached like
+ * oe_sgx_get_tcb_info(). The info_start field of the result is not set.
+ *
+ * @param[in] info_json The QE identity info json string.
+ * @param[in] info_json_size The size of **info_json**.
+ * @param[in] issuer_chain_pem The PEM of the QE identity issuer chain.
+ * @param[in] issuer_chain_pem_size The size of **issuer_chain_pem**.
+ * @param[in] issuer_chain The verified QE identity issuer chain.
+ * @param[out] qe_identity_info The compiled QE identity info. Release it with
+ * oe_sgx_release_qe_identity_info().
+ */
+oe_result_t oe_sgx_get_qe_identity_info(
+    const uint8_t* info_json,
+    size_t info_json_size,
+    const uint8_t* issuer_chain_pem,
+    size_t issuer_chain_pem_size,
+    oe_cert_chain_t* issuer_chain,
+    const oe_compiled_qe_identity_info_t** qe_identity_info);
+
+void oe_sgx_release_qe_identity_info(
+    const oe_compiled_qe_identity_info_t* qe_identity_info);
+
+/**
+ * Remove all unused entries from the cache (for tests).
+ */
+void oe_sgx_tcb_info_cache_clear(void);
+
+typedef struct _oe_sgx_tcb_info_cache_stats
+{
+    /* Number of infos served from the cache */
+    uint64_t hits;
+
+    /* Number of infos that were parsed and verified */
+    uint64_t misses;
+} oe_sgx_tcb_info_cache_stats_t;
+
+/**
+ * Get the TCB info cache counters (for tests and diagnostics).
+ */
+void oe_sgx_tcb_info_cache_get_stats(oe_sgx_tcb_info_cache_stats_t* stats);
+
+OE_EXTERNC_END
+
+#endif // _OE_COMMON_SGX_TCBINFOCACHE_H
@@ -0,0 +1,241 @@
+// Copyright (c) Open Enclave SDK contributors.
+// Licensed under the MIT License.
+
+#include "verificationcache.h"
+#include <openenclave/bits/report.h>
+#include <openenclave/internal/raise.h>
+#include "../common.h"
+
+#ifdef OE_BUILD_ENCLAVE
+#include <openenclave/internal/thread.h>
+typedef oe_mutex_t _mutex_t;
+#define _MUTEX_INITIALIZER OE_MUTEX_INITIALIZER
+#else
+#include "../../host/hostthread.h"
+typedef oe_mutex _mutex_t;
+#define _MUTEX_INITIALIZER OE_H_MUTEX_INITIALIZER
+#endif
+
+/*
+**==============================================================================
+**
+** SGX verification result cache:
+**
+**     Peers present the same quote on every TLS handshake, and verifying it
+**     again gives the same result for as long as its endorsements are valid.
+**     When enabled, the cache remembers successful verifications, keyed by
+**     the SHA-256 of the quote and its endorsements, together with their
+**     validity period. A result is reused only for a validation time within
+**     that period, and is dropped once the period has ended, so a quote is
+**     verified again with fresh collateral after Intel's next update.
+**
+**     The creation datetime of the endorsements is left out of the key:
+**     they are restamped with the current time whenever they are fetched,
+**     and only their validity period matters.
+**
+**     Failures are not cached. The cache is a small array; the least
+**     recently used result is replaced when it is full.
+**
+**==============================================================================
+*/
+
+typedef struct _entry
+{
+    OE_SHA256 key;
+    oe_datetime_t valid_from;
+    oe_datetime_t valid_until;
+
+    /* Value of _clock when the entry was last used; 0 for a free entry */
+    uint64_t last_used;
+} _entry_t;
+
+static _entry_t* _entries;
+static size_t _num_entries;
+static uint64_t _clock;
+static oe_verification_result_cache_stats_t _stats;
+
+/* Protects all of the above */
+static _mutex_t _lock = _MUTEX_INITIALIZER;
+
+oe_result_t oe_set_verification_result_cache_size(size_t max_entries)
+{
+    oe_result_t result = OE_UNEXPECTED;
+    _entry_t* entries = NULL;
+
+    if (max_entries > OE_SGX_VERIFICATION_CACHE_MAX_SIZE)
+        OE_RAISE(OE_INVALID_PARAMETER);
+
+    if (max_entries &&
+        !(entries = (_entry_t*)oe_calloc(max_entries, sizeof(*entries))))
+        OE_RAISE(OE_OUT_OF_MEMORY);
+
+    oe_mutex_lock(&_lock);
+    oe_free(_entries);
+    _entries = entries;
+    _num_entries = max_entries;
+    oe_mutex_unlock(&_lock);
+
+    result = OE_OK;
+
+done:
+    return result;
+}
+
+oe_result_t oe_get_verification_result_cache_stats(
+    oe_verification_result_cache_stats_t* stats)
+{
+    if (!stats)
+        return OE_INVALID_PARAMETER;
+
+    oe_mutex_lock(&_lock);
+    *stats = _stats;
+    oe_mutex_unlock(&_lock);
+
+    return OE_OK;
+}
+
+bool oe_sgx_verification_cache_enabled(void)
+{
+    bool enabled;
+
+    oe_mutex_lock(&_lock);
+    enabled = (_num_entries != 0);
+    oe_mutex_unlock(&_lock);
+
+    return enabled;
+}
+
+oe_result_t oe_sgx_verification_cache_get_key(
+    const uint8_t* quote,
+    size_t quote_size,
+    const oe_sgx_endorsements_t* sgx_endorsements,
+    OE_SHA256* key)
+{
+    oe_result_t result = OE_UNEXPECTED;
+    oe_sha256_context_t context = {0};
+    uint64_t size = quote_size;
+
+    if (!quote || !sgx_endorsements || !key)
+        OE_RAISE(OE_INVALID_PARAMETER);
+
+    // The sizes keep the concatenation unambiguous.
+    OE_CHECK(oe_sha256_init(&context));
+    OE_CHECK(oe_sha256_update(&context, &size, sizeof(size)));
+    OE_CHECK(oe_sha256_update(&context, quote, quote_size));
+
+    for (size_t i = 0; i < OE_SGX_ENDORSEMENT_COUNT; i++)
+    {
+        const oe_sgx_endorsement_item* item = &sgx_endorsements->items[i];
+
+        if (i == OE_SGX_ENDORSEMENT_FIELD_CREATION_DATETIME)
+            continue;
+
+        size = item->size;
+        OE_CHECK(oe_sha256_update(&context, &size, sizeof(size)));
+        OE_CHECK(oe_sha256_update(&context, item->data, item->size));
+    }
+
+    OE_CHECK(oe_sha256_final(&context, key));
+
+    result = OE_OK;
+
+done:
+    return result;
+}
+
+/* Find the entry with the key. Called with _lock held */
+static _entry_t* _find(const OE_SHA256* key)
+{
+    for (size_t i = 0; i < _num_entries; i++)
+    {
+        if (_entries[i].last_used &&
+            memcmp(&_entries[i].key, key, sizeof(*key)) == 0)
+            return &_entries[i];
+    }
+
+    return NULL;
+}
+
+oe_result_t oe_sgx_verification_cache_lookup(
+    const OE_SHA256* key,
+    const oe_datetime_t* validation_time)
+{
+    oe_result_t result = OE_NOT_FOUND;
+    oe_datetime_t now = {0};
+    _entry_t* entry = NULL;
+
+    if (oe_datetime_now(&now) != OE_OK)
+        return OE_NOT_FOUND;
+
+    oe_mutex_lock(&_lock);
+
+    if (!_num_entries)
+        goto done;
+
+    if ((entry = _find(key)))
+    {
+        if (oe_datetime_compare(&now, &entry->valid_until) > 0)
+        {
+            memset(entry, 0, sizeof(*entry));
+        }
+        else if (
+            oe_datetime_compare(validation_time, &entry->valid_from) >= 0 &&
+            oe_datetime_compare(validation_time, &entry->valid_until) <= 0)
+        {
+            entry->last_used = ++_clock;
+            result = OE_OK;
+        }
+    }
+
+    if (result == OE_OK)
+        _stats.hits++;
+    else
+        _stats.misses++;
+
+done:
+    oe_mutex_unlock(&_lock);
+
+    return result;
+}
+
+void oe_sgx_verification_cache_add(
+    const OE_SHA256* key,
+    const oe_datetime_t* valid_from,
+    const oe_datetime_t* valid_until)
+{
+    _entry_t* entry = NULL;
+
+    oe_mutex_lock(&_lock);
+
+    if (!_num_entries)
+        goto done;
+
+    if (!(entry = _find(key)))
+    {
+        entry = &_entries[0];
+
+        for (size_t i = 1; i < _num_entries && entry->last_used; i++)
+        {
+            if (_entries[i].last_used < entry->last_used)
+                entry = &_entries[i];
+        }
+    }
+
+    entry->key = *key;
+    entry->valid_from = *valid_from;
+    entry->valid_until = *valid_until;
+    entry->last_used = ++_clock;
+
+done:
+    oe_mutex_unlock(&_lock);
+}
+
+void oe_sgx_verification_cache_clear(void)
+{
+    oe_mutex_lock(&_lock);
+
+    if (_entries)
+        memset(_entries, 0, _num_entries * sizeof(*_entries));
+
+    oe_mutex_unlock(&_lock);
+}
@@ -0,0 +1,80 @@
+// Copyright (c) Open Enclave SDK contributors.
+// Licensed under the MIT License.
+
+#ifndef _OE_COMMON_SGX_VERIFICATIONCACHE_H
+#define _OE_COMMON_SGX_VERIFICATIONCACHE_H
+
+#include <openenclave/bits/defs.h>
+#include <openenclave/bits/result.h>
+#include <openenclave/bits/types.h>
+#include <openenclave/internal/crypto/sha.h>
+#include <openenclave/internal/datetime.h>
+#include "endorsements.h"
+
+OE_EXTERNC_BEGIN
+
+/* The largest size accepted by oe_set_verification_result_cache_size() */
+#define OE_SGX_VERIFICATION_CACHE_MAX_SIZE 4096
+
+/**
+ * Whether the verification result cache is enabled. It is disabled until
+ * oe_set_verification_result_cache_size() is called with a non-zero size.
+ */
+bool oe_sgx_verification_cache_enabled(void);
+
+/**
+ * Compute the cache key of a quote and its endorsements, the SHA-256 of the
+ * quote and of every endorsement item but the creation datetime, which
+ * changes every time the endorsements are fetched.
+ *
+ * @param[in] quote The quote.
+ * @param[in] quote_size The size of **quote**.
+ * @param[in] sgx_endorsements The endorsements the quote is verified with.
+ * @param[out] key The key.
+ */
+oe_result_t oe_sgx_verification_cache_get_key(
+    const uint8_t* quote,
+    size_t quote_size,
+    const oe_sgx_endorsements_t* sgx_endorsements,
+    OE_SHA256* key);
+
+/**
+ * Look up a successful verification.
+ *
+ * A cached result is only used when **validation_time** lies within the
+ * validity period of the quote and its endorsements. Results whose validity
+ * period has ended are dropped.
+ *
+ * @param[in] key The key of the quote and its endorsements.
+ * @param[in] validation_time The time the quote is verified for.
+ *
+ * @retval OE_OK The quote was verified successfully for this time.
+ * @retval OE_NOT_FOUND The quote must be verified.
+ */
+oe_result_t oe_sgx_verification_cache_lookup(
+    const OE_SHA256* key,
+    const oe_datetime_t* validation_time);
+
+/**
+ * Record a successful verification, replacing the least recently used
+ * result when the cache is full.
+ *
+ * @param[in] key The key of the quote and its endorsements.
+ * @param[in] valid_from The start of the validity period of the quote and
+ * its endorsements.
+ * @param[in] valid_until The end of the validity period.
+ */
+void oe_sgx_verification_cache_add(
+    const OE_SHA256* key,
+    const oe_datetime_t* valid_from,
+    const oe_datetime_t* valid_until);
+
+/**
+ * Remove all results from the cache. Called when verification settings, such
+ * as the minimum CRL and TCB info issue date, change.
+ */
+void oe_sgx_verification_cache_clear(void);
+
+OE_EXTERNC_END
+
+#endif // _OE_COMMON_SGX_VERIFICATIONCACHE_H
@@ -37,10 +37,43 @@ static oe_result_t _on_unregister(oe_attestation_role_t* context)
     return OE_OK;
 }
 
+/*
+**==============================================================================
+**
+** Claims lists:
+**
+**     By default every claim name and value is a separate allocation. With the
+**     OE_POLICY_CONTIGUOUS_CLAIMS policy, the claims list is instead a single
+**     allocation, the claims array followed by the arena that holds the values
+**     and the names of the custom claims. The names of the known claims point
+**     at the OE_REQUIRED_CLAIMS and OE_OPTIONAL_CLAIMS constants, which is
+**     also how such a list is recognized when it is freed: the first claim is
+**     always the ID version.
+**
+**==============================================================================
+*/
+
+/* Alignment of the claim values in an arena */
+#define CLAIM_VALUE_ALIGNMENT 8
+
+typedef struct _claims_arena
+{
+    uint8_t* data;
+    size_t size;
+    size_t used;
+} _claims_arena_t;
+
+static bool _is_contiguous_claims_list(const oe_claim_t* claims)
+{
+    return claims[0].name == OE_REQUIRED_CLAIMS[0];
+}
+
 static void _free_claim(oe_claim_t* claim)
 {
     oe_free(claim->name);
     oe_free(claim->value);
+    claim->name = NULL;
+    claim->value = NULL;
 }
 
 static oe_result_t _free_claims_list(
@@ -52,12 +85,27 @@ static oe_result_t _free_claims_list(
     if (!claims)
         return OE_OK;
 
-    for (size_t i = 0; i < claims_length; i++)
-        _free_claim(&claims[i]);
+    if (!claims_length || !_is_contiguous_claims_list(claims))
+    {
+        for (size_t i = 0; i < claims_length; i++)
+            _free_claim(&claims[i]);
+    }
+
     oe_free(claims);
     return OE_OK;
 }
 
+static void* _arena_alloc(_claims_arena_t* arena, size_t size, size_t align)
+{
+    size_t offset = (arena->used + align - 1) & ~(align - 1);
+
+    if (offset > arena->size || arena->size - offset < size)
+        return NULL;
+
+    arena->used = offset + size;
+    return arena->data + offset;
+}
+
 static oe_result_t _get_input_time(
     const oe_policy_t* policies,
     size_t policies_size,
@@ -86,6 +134,27 @@ static oe_result_t _get_input_time(
     return OE_OK;
 }
 
+static oe_result_t _get_contiguous_claims(
+    const oe_policy_t* policies,
+    size_t policies_size,
+    bool* contiguous_claims)
+{
+    *contiguous_claims = false;
+
+    for (size_t i = 0; policies && i < policies_size; i++)
+    {
+        if (policies[i].type == OE_POLICY_CONTIGUOUS_CLAIMS)
+        {
+            if (policies[i].policy_size != 0)
+                return OE_INVALID_PARAMETER;
+
+            *contiguous_claims = true;
+        }
+    }
+
+    return OE_OK;
+}
+
 static oe_result_t _verify_local_report(
     const uint8_t* evidence_buffer,
     size_t evidence_buffer_size)
@@ -137,15 +206,38 @@ done:
 }
 
 static oe_result_t _add_claim(
+    _claims_arena_t* arena,
     oe_claim_t* claim,
-    void* name,
+    const char* name,
     size_t name_size,
-    void* value,
+    bool known_name,
+    const void* value,
     size_t value_size)
 {
-    if (*((uint8_t*)name + name_size - 1) != '\0')
+    if (name[name_size - 1] != '\0')
         return OE_CONSTRAINT_FAILED;
 
+    if (arena)
+    {
+        claim->name = (char*)name;
+        if (!known_name)
+        {
+            claim->name = (char*)_arena_alloc(arena, name_size, 1);
+            if (claim->name == NULL)
+                return OE_UNEXPECTED;
+            memcpy(claim->name, name, name_size);
+        }
+
+        claim->value = (uint8_t*)_arena_alloc(
+            arena, value_size, CLAIM_VALUE_ALIGNMENT);
+        if (claim->value == NULL)
+            return OE_UNEXPECTED;
+        memcpy(claim->value, value, value_size);
+        claim->value_size = value_size;
+
+        return OE_OK;
+    }
+
     claim->name = (char*)oe_malloc(name_size);
     if (claim->name == NULL)
         return OE_OUT_OF_MEMORY;
@@ -164,7 +256,19 @@ static oe_result_t _add_claim(
     return OE_OK;
 }
 
+static oe_result_t _add_known_claim(
+    _claims_arena_t* arena,
+    oe_claim_t* claim,
+    const char* name,
+    const void* value,
+    size_t value_size)
+{
+    return _add_claim(
+        arena, claim, name, oe_strlen(name) + 1, true, value, value_size);
+}
+
 static oe_result_t _fill_with_known_claims(
+    _claims_arena_t* arena,
     const uint8_t* report,
     size_t report_size,
     const oe_sgx_endorsements_t* sgx_endorsements,
@@ -191,58 +295,58 @@ static oe_result_t _fill_with_known_claims(
         OE_RAISE(OE_INVALID_PARAMETER);
 
     // ID version.
-    OE_CHECK(_add_claim(
+    OE_CHECK(_add_known_claim(
+        arena,
         &claims[claims_index++],
-        OE_CLAIM_ID_VERSION,
-        sizeof(OE_CLAIM_ID_VERSION),
+        OE_REQUIRED_CLAIMS[0],
         &id->id_version,
         sizeof(id->id_version)));
 
     // Security version.
-    OE_CHECK(_add_claim(
+    OE_CHECK(_add_known_claim(
+        arena,
         &claims[claims_index++],
-        OE_CLAIM_SECURITY_VERSION,
-        sizeof(OE_CLAIM_SECURITY_VERSION),
+        OE_REQUIRED_CLAIMS[1],
         &id->security_version,
         sizeof(id->security_version)));
 
     // Attributes.
-    OE_CHECK(_add_claim(
+    OE_CHECK(_add_known_claim(
+        arena,
         &claims[claims_index++],
-        OE_CLAIM_ATTRIBUTES,
-        sizeof(OE_CLAIM_ATTRIBUTES),
+        OE_REQUIRED_CLAIMS[2],
         &id->attributes,
         sizeof(id->attributes)));
 
     // Unique ID
-    OE_CHECK(_add_claim(
+    OE_CHECK(_add_known_claim(
+        arena,
         &claims[claims_index++],
-        OE_CLAIM_UNIQUE_ID,
-        sizeof(OE_CLAIM_UNIQUE_ID),
+        OE_REQUIRED_CLAIMS[3],
         &id->unique_id,
         sizeof(id->unique_id)));
 
     // Signer ID
-    OE_CHECK(_add_claim(
+    OE_CHECK(_add_known_claim(
+        arena,
         &claims[claims_index++],
-        OE_CLAIM_SIGNER_ID,
-        sizeof(OE_CLAIM_SIGNER_ID),
+        OE_REQUIRED_CLAIMS[4],
         &id->signer_id,
         sizeof(id->signer_id)));
 
     // Product ID
-    OE_CHECK(_add_claim(
+    OE_CHECK(_add_known_claim(
+        arena,
         &claims[claims_index++],
-        OE_CLAIM_PRODUCT_ID,
-        sizeof(OE_CLAIM_PRODUCT_ID),
+        OE_REQUIRED_CLAIMS[5],
         &id->product_id,
         sizeof(id->product_id)));
 
     // Plugin UUID
-    OE_CHECK(_add_claim(
+    OE_CHECK(_add_known_claim(
+        arena,
         &claims[claims_index++],
-        OE_CLAIM_PLUGIN_UUID,
-        sizeof(OE_CLAIM_PLUGIN_UUID),
+        OE_REQUIRED_CLAIMS[6],
         &plugin_id,
         sizeof(plugin_id)));
 
@@ -257,18 +361,18 @@ static oe_result_t _fill_with_known_claims(
             &valid_until));
 
         // Validity from.
-        OE_CHECK(_add_claim(
+        OE_CHECK(_add_known_claim(
+            arena,
             &claims[claims_index++],
-            OE_CLAIM_VALIDITY_FROM,
-            sizeof(OE_CLAIM_VALIDITY_FROM),
+            OE_OPTIONAL_CLAIMS[0],
             &valid_from,
             sizeof(valid_from)));
 
         // Validity to.
-        OE_CHECK(_add_claim(
+        OE_CHECK(_add_known_claim(
+            arena,
             &claims[claims_index++],
-            OE_CLAIM_VALIDITY_UNTIL,
-            sizeof(OE_CLAIM_VALIDITY_UNTIL),
+            OE_OPTIONAL_CLAIMS[1],
             &valid_until,
             sizeof(valid_until)));
     }
@@ -277,7 +381,7 @@ static oe_result_t _fill_with_known_claims(
     result = OE_OK;
 
 done:
-    if (result != OE_OK)
+    if (result != OE_OK && !arena)
     {
         for (size_t i = 0; i < claims_index; i++)
             _free_claim(&claims[i]);
@@ -286,6 +390,7 @@ done:
 }
 
 static oe_result_t _fill_with_custom_claims(
+    _claims_arena_t* arena,
     const uint8_t* claims_buf,
     size_t claims_buf_size,
     oe_claim_t* claims,
@@ -318,10 +423,15 @@ static oe_result_t _fill_with_custom_claims(
             OE_RAISE(OE_CONSTRAINT_FAILED);
 
         // Finally, add the claim.
+        if (entry->name_size == 0)
+            OE_RAISE(OE_CONSTRAINT_FAILED);
+
         OE_CHECK(_add_claim(
+            arena,
             &claims[claims_index++],
-            entry->name,
+            (const char*)entry->name,
             entry->name_size,
+            false,
             entry->name + entry->name_size,
             entry->value_size));
 
@@ -333,7 +443,7 @@ static oe_result_t _fill_with_custom_claims(
     result = OE_OK;
 
 done:
-    if (result != OE_OK)
+    if (result != OE_OK && !arena)
     {
         for (size_t i = 0; i < claims_index; i++)
             _free_claim(&claims[i]);
@@ -345,6 +455,7 @@ static oe_result_t _extract_claims(
     const uint8_t* evidence,
     size_t evidence_size,
     const oe_sgx_endorsements_t* sgx_endorsements,
+    bool contiguous_claims,
     oe_claim_t** claims_out,
     size_t* claims_length_out)
 {
@@ -355,7 +466,9 @@ static oe_result_t _extract_claims(
     oe_claim_t* claims = NULL;
     uint64_t claims_length = 0;
     uint64_t claims_size = 0;
+    uint64_t alloc_size = 0;
     size_t claims_added = 0;
+    _claims_arena_t arena = {0};
 
     // Check if the buffer is the proper size.
     if (evidence_size - report_size < sizeof(*claims_header))
@@ -382,13 +495,43 @@ static oe_result_t _extract_claims(
     }
 
     OE_CHECK(oe_safe_mul_u64(claims_length, sizeof(oe_claim_t), &claims_size));
+    alloc_size = claims_size;
 
-    claims = (oe_claim_t*)oe_malloc(claims_size);
+    // The arena is large enough for the values of the known claims, the
+    // names and values of the custom claims, which are no larger than their
+    // serialized form, and the alignment of every value.
+    if (contiguous_claims)
+    {
+        uint64_t padding = 0;
+
+        OE_CHECK(oe_safe_add_u64(
+            alloc_size,
+            sizeof(oe_identity_t) + sizeof(oe_uuid_t) +
+                2 * sizeof(oe_datetime_t),
+            &alloc_size));
+        OE_CHECK(oe_safe_add_u64(
+            alloc_size, evidence_size - report_size, &alloc_size));
+        OE_CHECK(oe_safe_mul_u64(
+            claims_length, CLAIM_VALUE_ALIGNMENT - 1, &padding));
+        OE_CHECK(oe_safe_add_u64(alloc_size, padding, &alloc_size));
+    }
+
+    claims = (oe_claim_t*)oe_malloc(alloc_size);
     if (claims == NULL)
         OE_RAISE(OE_OUT_OF_MEMORY);
 
+    memset(claims, 0, claims_size);
+
+    if (contiguous_claims)
+    {
+        arena.data = (uint8_t*)claims;
+        arena.size = alloc_size;
+        arena.used = claims_size;
+    }
+
     // Fill the list with the known claims.
     OE_CHECK(_fill_with_known_claims(
+        contiguous_claims ? &arena : NULL,
         evidence,
         report_size,
         sgx_endorsements,
@@ -398,6 +541,7 @@ static oe_result_t _extract_claims(
 
     // Fill with the custom claims.
     OE_CHECK(_fill_with_custom_claims(
+        contiguous_claims ? &arena : NULL,
         evidence + report_size,
         evidence_size - report_size,
         claims + claims_added,
@@ -428,6 +572,7 @@ static oe_result_t _verify_evidence(
     oe_result_t result = OE_UNEXPECTED;
     oe_report_header_t* header = (oe_report_header_t*)evidence_buffer;
     oe_datetime_t* time = NULL;
+    bool contiguous_claims = false;
     uint8_t* local_endorsements_buffer = NULL;
     size_t local_endorsements_buffer_size = 0;
     oe_sgx_endorsements_t sgx_endorsements;
@@ -440,6 +585,8 @@ static oe_result_t _verify_evidence(
 
     // Check the datetime policy if it exists.
     OE_CHECK(_get_input_time(policies, policies_size, &time));
+    OE_CHECK(
+        _get_contiguous_claims(policies, policies_size, &contiguous_claims));
 
     // Verify the report. Send the report size to just the oe report,
     // not including the custom claims section.
@@ -478,6 +625,7 @@ static oe_result_t _verify_evidence(
         evidence_buffer,
         evidence_buffer_size,
         &sgx_endorsements,
+        contiguous_claims,
         claims,
         claims_length));
 
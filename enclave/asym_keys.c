@@ -5,9 +5,11 @@
 #include <openenclave/corelibc/string.h>
 #include <openenclave/enclave.h>
 #include <openenclave/internal/crypto/ec.h>
+#include <openenclave/internal/crypto/sha.h>
 #include <openenclave/internal/kdf.h>
 #include <openenclave/internal/raise.h>
 #include <openenclave/internal/safecrt.h>
+#include <openenclave/internal/thread.h>
 #include <openenclave/internal/utils.h>
 #include <stdlib.h>
 
@@ -226,54 +228,424 @@ done:
     return result;
 }
 
-static oe_result_t _derive_asymmetric_key(
+/*
+**==============================================================================
+**
+** Derived key cache:
+**
+**     Deriving an asymmetric key takes an EGETKEY, the KDF and an EC point
+**     multiplication. When enabled with oe_set_asymmetric_key_cache_size(),
+**     derived key pairs are kept as parsed keys, looked up by the SHA-256 of
+**     the seal policy (or the key info) and the key parameters, so that
+**     further requests for the key only write it in the requested format.
+**
+**     A key pair found in the cache is handed out as shared handles, so the
+**     key is written without holding the lock. The least recently used key
+**     pair is freed, and its memory zeroed, when the cache is full; all of
+**     them are when the cache is resized and when the enclave terminates.
+**     Failures are not cached.
+**
+**     A seal policy stands for the key request of the first derivation, so
+**     the keys of a policy stay those of the CPU and ISV SVNs at that time
+**     until the cache is resized.
+**
+**==============================================================================
+*/
+
+#define KEY_CACHE_MAX_SIZE 64
+
+typedef struct _key_entry
+{
+    OE_SHA256 id;
+
+    /* The key info of a key pair derived by seal policy, for callers that
+     * ask for it */
+    uint8_t* key_info;
+    size_t key_info_size;
+
+    oe_ec_private_key_t private_key;
+    oe_ec_public_key_t public_key;
+
+    /* Value of _key_clock when the entry was last used; 0 for a free entry */
+    uint64_t last_used;
+} key_entry_t;
+
+static key_entry_t* _key_entries;
+static size_t _num_key_entries;
+static uint64_t _key_clock;
+static bool _key_cache_atexit;
+
+/* Protects all of the above */
+static oe_mutex_t _key_lock = OE_MUTEX_INITIALIZER;
+
+static oe_result_t _sha256_update_u64(
+    oe_sha256_context_t* context,
+    uint64_t value)
+{
+    return oe_sha256_update(context, &value, sizeof(value));
+}
+
+/* Get the cache ID of the key derived with the key parameters from the seal
+ * key of the policy (if key_info is NULL) or of the key info */
+static oe_result_t _get_key_id(
+    oe_seal_policy_t policy,
+    const uint8_t* key_info,
+    size_t key_info_size,
     const oe_asymmetric_key_params_t* key_params,
-    bool is_public,
-    const uint8_t* master_key,
-    size_t master_key_size,
-    uint8_t** key_buffer,
-    size_t* key_buffer_size)
+    OE_SHA256* id)
 {
     oe_result_t result = OE_UNEXPECTED;
-    oe_ec_public_key_t public_key;
-    oe_ec_private_key_t private_key;
-    bool keypair_created = false;
+    oe_sha256_context_t context = {0};
+
+    // The sizes keep the concatenation unambiguous.
+    OE_CHECK(oe_sha256_init(&context));
+
+    if (key_info)
+    {
+        OE_CHECK(_sha256_update_u64(&context, key_info_size));
+        OE_CHECK(oe_sha256_update(&context, key_info, key_info_size));
+    }
+    else
+    {
+        OE_CHECK(_sha256_update_u64(&context, OE_UINT64_MAX));
+        OE_CHECK(_sha256_update_u64(&context, (uint64_t)policy));
+    }
+
+    OE_CHECK(_sha256_update_u64(&context, (uint64_t)key_params->type));
+    OE_CHECK(_sha256_update_u64(&context, (uint64_t)key_params->format));
+    OE_CHECK(_sha256_update_u64(&context, key_params->user_data_size));
+
+    if (key_params->user_data_size)
+        OE_CHECK(oe_sha256_update(
+            &context, key_params->user_data, key_params->user_data_size));
+
+    OE_CHECK(oe_sha256_final(&context, id));
+
+    result = OE_OK;
+
+done:
+    return result;
+}
+
+/* Release the keys of an entry and zero it. Called with _key_lock held */
+static void _free_key_entry(key_entry_t* entry)
+{
+    if (!entry->last_used)
+        return;
+
+    oe_ec_private_key_free(&entry->private_key);
+    oe_ec_public_key_free(&entry->public_key);
+
+    if (entry->key_info)
+    {
+        oe_secure_zero_fill(entry->key_info, entry->key_info_size);
+        oe_free(entry->key_info);
+    }
+
+    oe_secure_zero_fill(entry, sizeof(*entry));
+}
+
+/* Release all entries and the cache. Called with _key_lock held */
+static void _free_key_entries(void)
+{
+    for (size_t i = 0; i < _num_key_entries; i++)
+        _free_key_entry(&_key_entries[i]);
+
+    oe_free(_key_entries);
+    _key_entries = NULL;
+    _num_key_entries = 0;
+}
+
+static void _free_key_cache(void)
+{
+    oe_mutex_lock(&_key_lock);
+    _free_key_entries();
+    oe_mutex_unlock(&_key_lock);
+}
+
+static bool _key_cache_enabled(void)
+{
+    bool enabled;
+
+    oe_mutex_lock(&_key_lock);
+    enabled = (_num_key_entries != 0);
+    oe_mutex_unlock(&_key_lock);
+
+    return enabled;
+}
+
+/* Find the entry with the ID. Called with _key_lock held */
+static key_entry_t* _find_key_entry(const OE_SHA256* id)
+{
+    for (size_t i = 0; i < _num_key_entries; i++)
+    {
+        if (_key_entries[i].last_used &&
+            memcmp(&_key_entries[i].id, id, sizeof(*id)) == 0)
+            return &_key_entries[i];
+    }
+
+    return NULL;
+}
+
+/* Get shared handles of the cached key pair with the ID and, if key_info is
+ * not NULL, a copy of its key info. Returns OE_NOT_FOUND if it is not
+ * cached */
+static oe_result_t _get_cached_keypair(
+    const OE_SHA256* id,
+    oe_ec_private_key_t* private_key,
+    oe_ec_public_key_t* public_key,
+    uint8_t** key_info,
+    size_t* key_info_size)
+{
+    oe_result_t result = OE_NOT_FOUND;
+    key_entry_t* entry;
+    bool private_shared = false;
+    bool public_shared = false;
+    uint8_t* key_info_local = NULL;
 
-    /* Check invalid arguments. */
-    if (!master_key || !key_buffer || !key_buffer_size)
+    oe_mutex_lock(&_key_lock);
+
+    if (!(entry = _find_key_entry(id)))
+        goto done;
+
+    if (key_info)
+    {
+        if (!entry->key_info)
+            goto done;
+
+        if (!(key_info_local = (uint8_t*)oe_malloc(entry->key_info_size)))
+            OE_RAISE(OE_OUT_OF_MEMORY);
+
+        OE_CHECK(oe_memcpy_s(
+            key_info_local,
+            entry->key_info_size,
+            entry->key_info,
+            entry->key_info_size));
+    }
+
+    OE_CHECK(oe_ec_private_key_share(&entry->private_key, private_key));
+    private_shared = true;
+    OE_CHECK(oe_ec_public_key_share(&entry->public_key, public_key));
+    public_shared = true;
+
+    entry->last_used = ++_key_clock;
+
+    if (key_info)
+    {
+        *key_info = key_info_local;
+        *key_info_size = entry->key_info_size;
+        key_info_local = NULL;
+    }
+
+    result = OE_OK;
+
+done:
+    oe_mutex_unlock(&_key_lock);
+
+    if (result != OE_OK)
+    {
+        if (private_shared)
+            oe_ec_private_key_free(private_key);
+
+        if (public_shared)
+            oe_ec_public_key_free(public_key);
+    }
+
+    oe_free(key_info_local);
+
+    return result;
+}
+
+/* Add a key pair to the cache unless it is cached already. Failures only
+ * leave the key pair out of the cache */
+static void _cache_keypair(
+    const OE_SHA256* id,
+    const oe_ec_private_key_t* private_key,
+    const oe_ec_public_key_t* public_key,
+    const uint8_t* key_info,
+    size_t key_info_size)
+{
+    key_entry_t* entry = NULL;
+    key_entry_t new_entry = {0};
+
+    oe_mutex_lock(&_key_lock);
+
+    if (!_num_key_entries || _find_key_entry(id))
+        goto done;
+
+    if (key_info)
+    {
+        if (!(new_entry.key_info = (uint8_t*)oe_malloc(key_info_size)))
+            goto done;
+
+        memcpy(new_entry.key_info, key_info, key_info_size);
+        new_entry.key_info_size = key_info_size;
+    }
+
+    if (oe_ec_private_key_share(private_key, &new_entry.private_key) != OE_OK)
+        goto done;
+
+    if (oe_ec_public_key_share(public_key, &new_entry.public_key) != OE_OK)
+    {
+        oe_ec_private_key_free(&new_entry.private_key);
+        goto done;
+    }
+
+    /* Use a free entry or else the least recently used one */
+    entry = &_key_entries[0];
+
+    for (size_t i = 0; i < _num_key_entries && entry->last_used; i++)
+    {
+        if (_key_entries[i].last_used < entry->last_used)
+            entry = &_key_entries[i];
+    }
+
+    _free_key_entry(entry);
+
+    new_entry.id = *id;
+    new_entry.last_used = ++_key_clock;
+    *entry = new_entry;
+    new_entry.key_info = NULL;
+
+done:
+    oe_mutex_unlock(&_key_lock);
+
+    if (new_entry.key_info)
+    {
+        oe_secure_zero_fill(new_entry.key_info, new_entry.key_info_size);
+        oe_free(new_entry.key_info);
+    }
+}
+
+oe_result_t oe_set_asymmetric_key_cache_size(size_t max_entries)
+{
+    oe_result_t result = OE_UNEXPECTED;
+    key_entry_t* entries = NULL;
+    bool locked = false;
+
+    if (max_entries > KEY_CACHE_MAX_SIZE)
         OE_RAISE(OE_INVALID_PARAMETER);
 
-    OE_CHECK(_check_asymmetric_key_params(key_params));
+    if (max_entries &&
+        !(entries = (key_entry_t*)oe_calloc(max_entries, sizeof(*entries))))
+        OE_RAISE(OE_OUT_OF_MEMORY);
 
-    /* Derive the public/private key from the master key. */
-    OE_CHECK(_create_asymmetric_keypair(
-        key_params, master_key, master_key_size, &private_key, &public_key));
+    oe_mutex_lock(&_key_lock);
+    locked = true;
 
-    keypair_created = true;
+    /* Zero the cached keys when the enclave terminates */
+    if (max_entries && !_key_cache_atexit)
+    {
+        if (oe_atexit(_free_key_cache) != 0)
+            OE_RAISE(OE_FAILURE);
 
-    /* Export the key depending on what was requested. */
-    OE_CHECK(_export_keypair(
-        key_params,
-        is_public,
-        &private_key,
-        &public_key,
-        key_buffer,
-        key_buffer_size));
+        _key_cache_atexit = true;
+    }
+
+    _free_key_entries();
+    _key_entries = entries;
+    _num_key_entries = max_entries;
+    entries = NULL;
 
     result = OE_OK;
 
 done:
-    if (keypair_created)
+    if (locked)
+        oe_mutex_unlock(&_key_lock);
+
+    oe_free(entries);
+
+    return result;
+}
+
+/* Get the key pair derived with the key parameters from the seal key of the
+ * policy (if key_info_in is NULL) or of the key info, and in the first case
+ * the key info of the seal key if key_info is not NULL */
+static oe_result_t _get_asymmetric_keypair(
+    oe_seal_policy_t policy,
+    const uint8_t* key_info_in,
+    size_t key_info_in_size,
+    const oe_asymmetric_key_params_t* key_params,
+    oe_ec_private_key_t* private_key,
+    oe_ec_public_key_t* public_key,
+    uint8_t** key_info,
+    size_t* key_info_size)
+{
+    oe_result_t result = OE_UNEXPECTED;
+    bool cache = _key_cache_enabled();
+    OE_SHA256 id = {0};
+    uint8_t* key = NULL;
+    size_t key_size = 0;
+    uint8_t* key_info_local = NULL;
+    size_t key_info_size_local = 0;
+
+    if (cache)
     {
-        oe_ec_private_key_free(&private_key);
-        oe_ec_public_key_free(&public_key);
+        OE_CHECK(_get_key_id(
+            policy, key_info_in, key_info_in_size, key_params, &id));
+
+        result = _get_cached_keypair(
+            &id, private_key, public_key, key_info, key_info_size);
+
+        if (result != OE_NOT_FOUND)
+            goto done;
+    }
+
+    /* Load seal key. The cache keeps the key info of a policy. */
+    if (key_info_in)
+    {
+        OE_CHECK(
+            _load_seal_key(key_info_in, key_info_in_size, &key, &key_size));
+    }
+    else
+    {
+        bool want_key_info = cache || key_info;
+
+        OE_CHECK(_load_seal_key_by_policy(
+            policy,
+            &key,
+            &key_size,
+            want_key_info ? &key_info_local : NULL,
+            want_key_info ? &key_info_size_local : NULL));
+    }
+
+    /* Derive the public/private key from the seal key. */
+    OE_CHECK(_create_asymmetric_keypair(
+        key_params, key, key_size, private_key, public_key));
+
+    if (cache)
+        _cache_keypair(
+            &id, private_key, public_key, key_info_local, key_info_size_local);
+
+    result = OE_OK;
+
+    if (key_info)
+    {
+        *key_info = key_info_local;
+        *key_info_size = key_info_size_local;
+        key_info_local = NULL;
+    }
+
+done:
+    if (key_info_local != NULL)
+    {
+        oe_secure_zero_fill(key_info_local, key_info_size_local);
+        oe_free(key_info_local);
+    }
+
+    if (key != NULL)
+    {
+        oe_secure_zero_fill(key, key_size);
+        oe_free(key);
     }
 
     return result;
 }
 
-static oe_result_t _load_asymmetric_key_by_policy(
+static oe_result_t _load_asymmetric_key_common(
     oe_seal_policy_t policy,
+    const uint8_t* key_info_in,
+    size_t key_info_in_size,
     const oe_asymmetric_key_params_t* key_params,
     bool is_public,
     uint8_t** key_buffer,
@@ -282,66 +654,90 @@ static oe_result_t _load_asymmetric_key_by_policy(
     size_t* key_info_size)
 {
     oe_result_t result = OE_UNEXPECTED;
-    uint8_t* key = NULL;
-    size_t key_size = 0;
-    uint8_t* key_buffer_local = NULL;
-    size_t key_buffer_size_local = 0;
+    oe_ec_public_key_t public_key;
+    oe_ec_private_key_t private_key;
+    bool keypair_created = false;
     uint8_t* key_info_local = NULL;
     size_t key_info_size_local = 0;
 
-    /* Check invalid params. */
-    if (!key_buffer || !key_buffer_size || (key_info && !key_info_size))
-        OE_RAISE(OE_INVALID_PARAMETER);
-
     OE_CHECK(_check_asymmetric_key_params(key_params));
 
-    /* Load seal key. */
-    OE_CHECK(_load_seal_key_by_policy(
+    /* Derive the public/private key or take it from the cache. */
+    OE_CHECK(_get_asymmetric_keypair(
         policy,
-        &key,
-        &key_size,
+        key_info_in,
+        key_info_in_size,
+        key_params,
+        &private_key,
+        &public_key,
         key_info ? &key_info_local : NULL,
         key_info ? &key_info_size_local : NULL));
 
-    /* Derive the asymmetric key. */
-    OE_CHECK(_derive_asymmetric_key(
+    keypair_created = true;
+
+    /* Export the key depending on what was requested. */
+    OE_CHECK(_export_keypair(
         key_params,
         is_public,
-        key,
-        key_size,
-        &key_buffer_local,
-        &key_buffer_size_local));
+        &private_key,
+        &public_key,
+        key_buffer,
+        key_buffer_size));
 
     result = OE_OK;
-    *key_buffer = key_buffer_local;
-    *key_buffer_size = key_buffer_size_local;
+
     if (key_info)
     {
         *key_info = key_info_local;
         *key_info_size = key_info_size_local;
+        key_info_local = NULL;
     }
-    key_buffer_local = NULL;
-    key_info_local = NULL;
 
 done:
-    if (key_buffer_local != NULL)
+    if (keypair_created)
     {
-        oe_secure_zero_fill(key_buffer_local, key_buffer_size_local);
-        free(key_buffer_local);
+        oe_ec_private_key_free(&private_key);
+        oe_ec_public_key_free(&public_key);
     }
 
     if (key_info_local != NULL)
     {
         oe_secure_zero_fill(key_info_local, key_info_size_local);
-        free(key_info_local);
+        oe_free(key_info_local);
     }
 
-    if (key != NULL)
-    {
-        oe_secure_zero_fill(key, key_size);
-        oe_free(key);
-    }
+    return result;
+}
+
+static oe_result_t _load_asymmetric_key_by_policy(
+    oe_seal_policy_t policy,
+    const oe_asymmetric_key_params_t* key_params,
+    bool is_public,
+    uint8_t** key_buffer,
+    size_t* key_buffer_size,
+    uint8_t** key_info,
+    size_t* key_info_size)
+{
+    oe_result_t result = OE_UNEXPECTED;
+
+    /* Check invalid params. */
+    if (!key_buffer || !key_buffer_size || (key_info && !key_info_size))
+        OE_RAISE(OE_INVALID_PARAMETER);
+
+    OE_CHECK(_load_asymmetric_key_common(
+        policy,
+        NULL,
+        0,
+        key_params,
+        is_public,
+        key_buffer,
+        key_buffer_size,
+        key_info,
+        key_info_size));
+
+    result = OE_OK;
 
+done:
     return result;
 }
 
@@ -354,47 +750,25 @@ static oe_result_t _load_asymmetric_key(
     size_t* key_buffer_size)
 {
     oe_result_t result = OE_UNEXPECTED;
-    uint8_t* key = NULL;
-    size_t key_size = 0;
-    uint8_t* key_buffer_local = NULL;
-    size_t key_buffer_size_local = 0;
 
     /* Check invalid params. */
     if (!key_info || !key_buffer || !key_buffer_size)
         OE_RAISE(OE_INVALID_PARAMETER);
 
-    OE_CHECK(_check_asymmetric_key_params(key_params));
-
-    /* Load seal key. */
-    OE_CHECK(_load_seal_key(key_info, key_info_size, &key, &key_size));
-
-    /* Derive the asymmetric key. */
-    OE_CHECK(_derive_asymmetric_key(
+    OE_CHECK(_load_asymmetric_key_common(
+        OE_SEAL_POLICY_UNIQUE,
+        key_info,
+        key_info_size,
         key_params,
         is_public,
-        key,
-        key_size,
-        &key_buffer_local,
-        &key_buffer_size_local));
+        key_buffer,
+        key_buffer_size,
+        NULL,
+        NULL));
 
     result = OE_OK;
-    *key_buffer = key_buffer_local;
-    *key_buffer_size = key_buffer_size_local;
-    key_buffer_local = NULL;
 
 done:
-    if (key_buffer_local != NULL)
-    {
-        oe_secure_zero_fill(key_buffer_local, key_buffer_size_local);
-        free(key_buffer_local);
-    }
-
-    if (key != NULL)
-    {
-        oe_secure_zero_fill(key, key_size);
-        free(key);
-    }
-
     return result;
 }
 
@@ -0,0 +1,407 @@
+// Copyright (c) Open Enclave SDK contributors.
+// Licensed under the MIT License.
+
+#include "heapprofiler.h"
+#include <openenclave/corelibc/stdarg.h>
+#include <openenclave/corelibc/stdio.h>
+#include <openenclave/corelibc/string.h>
+#include <openenclave/enclave.h>
+#include <openenclave/internal/backtrace.h>
+#include <openenclave/internal/malloc.h>
+#include <openenclave/internal/raise.h>
+#include <openenclave/internal/rdrand.h>
+#include <openenclave/internal/thread.h>
+#include <openenclave/internal/types.h>
+#include "oe_nodebug_alloc.h"
+
+/*
+**==============================================================================
+**
+** Sampling heap profiler:
+**
+**     Unlike the debug allocator, which records a backtrace for every block,
+**     the profiler records the backtrace of one allocation per
+**     oe_heap_profiler_sampling_rate bytes on average. Each thread counts
+**     down the bytes it allocates and samples the allocation that reaches
+**     zero, then draws the next count from an exponential distribution. Every
+**     allocated byte is therefore equally likely to be sampled, which is what
+**     pprof assumes when it scales the samples of a heap_v2 profile back to
+**     estimated totals. Allocations that are not sampled cost a thread-local
+**     subtraction.
+**
+**     Sampled blocks that are still in use are kept in a hash table keyed by
+**     address. Frees only take the lock when the bucket of the block is not
+**     empty, which with few live samples is rarely the case.
+**
+**     oe_heap_profiler_dump() writes the samples in the legacy pprof heap
+**     profile text format through an ocall. The host adds the memory map of
+**     the enclave, so "pprof ENCLAVE PROFILE" symbolizes the samples.
+**
+**==============================================================================
+*/
+
+/* The number of hash table buckets, a power of two */
+#define NUM_BUCKETS_LOG2 12
+#define NUM_BUCKETS ((size_t)1 << NUM_BUCKETS_LOG2)
+
+/* Keep intervals well within int64_t */
+#define MAX_SAMPLING_RATE ((uint64_t)1 << 40)
+
+typedef struct _sample
+{
+    struct _sample* next;
+    void* ptr;
+    size_t size;
+    uint64_t num_addrs;
+    void* addrs[];
+} sample_t;
+
+uint64_t oe_heap_profiler_sampling_rate;
+
+/* Allocated by the first oe_heap_profiler_start() and never freed, since
+ * frees peek at the buckets without the lock */
+static sample_t** _buckets;
+
+/* Protects the lists of the buckets and serializes changes of the sampling
+ * rate */
+static oe_spinlock_t _lock = OE_SPINLOCK_INITIALIZER;
+
+static __thread bool _sampler_initialized;
+static __thread int64_t _bytes_until_sample;
+
+static size_t _hash(const void* ptr)
+{
+    // Fibonacci hashing of the address without its alignment bits.
+    uint64_t h = ((uint64_t)ptr >> 4) * 0x9e3779b97f4a7c15;
+    return (size_t)(h >> (64 - NUM_BUCKETS_LOG2));
+}
+
+/* Approximate log2(q) for q > 0 to within 0.02 */
+static double _log2(uint64_t q)
+{
+    int e = 63 - __builtin_clzll(q);
+    double x = (double)q / (double)((uint64_t)1 << e) - 1.0;
+
+    return e + x * (1.4425449 + x * (-0.7181452 + x * 0.2761642));
+}
+
+/* Draw the bytes until the next sample from an exponential distribution
+ * with the given mean */
+static int64_t _next_interval(uint64_t mean)
+{
+    // q is uniform in [1, 2^26], so -ln(q / 2^26) is exponential with mean 1.
+    uint64_t q = (oe_rdrand() >> 38) + 1;
+    double interval = (26.0 - _log2(q)) * 0.6931471805599453 * (double)mean;
+
+    return interval < 1.0 ? 1 : (int64_t)interval;
+}
+
+static void _free_samples(void)
+{
+    for (size_t i = 0; _buckets && i < NUM_BUCKETS; i++)
+    {
+        sample_t* sample = _buckets[i];
+
+        __atomic_store_n(&_buckets[i], NULL, __ATOMIC_RELEASE);
+
+        while (sample)
+        {
+            sample_t* next = sample->next;
+            oe_nodebug_free(sample);
+            sample = next;
+        }
+    }
+}
+
+void oe_heap_profiler_sample_alloc(void* ptr, size_t size)
+{
+    uint64_t rate =
+        __atomic_load_n(&oe_heap_profiler_sampling_rate, __ATOMIC_RELAXED);
+    void* addrs[OE_BACKTRACE_MAX];
+    int num_addrs;
+    sample_t* sample;
+    size_t index;
+
+    // The exponential distribution is memoryless, so drawing a new interval
+    // when thread-local storage is reset for a new ecall adds no bias.
+    if (!_sampler_initialized)
+    {
+        _sampler_initialized = true;
+        _bytes_until_sample = _next_interval(rate);
+    }
+
+    if ((_bytes_until_sample -= (int64_t)size) > 0)
+        return;
+
+    _bytes_until_sample = _next_interval(rate);
+
+    if ((num_addrs = oe_backtrace(addrs, OE_BACKTRACE_MAX)) < 0)
+        num_addrs = 0;
+
+    if (!(sample = (sample_t*)oe_nodebug_malloc(
+              sizeof(sample_t) + (size_t)num_addrs * sizeof(void*))))
+        return;
+
+    sample->ptr = ptr;
+    sample->size = size;
+    sample->num_addrs = (uint64_t)num_addrs;
+    memcpy(sample->addrs, addrs, (size_t)num_addrs * sizeof(void*));
+
+    index = _hash(ptr);
+
+    oe_spin_lock(&_lock);
+
+    // Drop the sample if the profiler was stopped in the meantime.
+    if (oe_heap_profiler_sampling_rate != rate)
+    {
+        oe_spin_unlock(&_lock);
+        oe_nodebug_free(sample);
+        return;
+    }
+
+    sample->next = _buckets[index];
+    __atomic_store_n(&_buckets[index], sample, __ATOMIC_RELEASE);
+
+    oe_spin_unlock(&_lock);
+}
+
+void oe_heap_profiler_sample_free(void* ptr)
+{
+    sample_t** buckets = __atomic_load_n(&_buckets, __ATOMIC_ACQUIRE);
+    size_t index = _hash(ptr);
+    sample_t* sample = NULL;
+
+    if (!buckets || !__atomic_load_n(&buckets[index], __ATOMIC_ACQUIRE))
+        return;
+
+    oe_spin_lock(&_lock);
+
+    for (sample_t** p = &buckets[index]; *p; p = &(*p)->next)
+    {
+        if ((*p)->ptr == ptr)
+        {
+            sample = *p;
+            __atomic_store_n(p, sample->next, __ATOMIC_RELEASE);
+            break;
+        }
+    }
+
+    oe_spin_unlock(&_lock);
+
+    if (sample)
+        oe_nodebug_free(sample);
+}
+
+oe_result_t oe_heap_profiler_start(uint64_t sampling_rate)
+{
+    oe_result_t result = OE_UNEXPECTED;
+    sample_t** buckets = NULL;
+
+    if (sampling_rate == 0 || sampling_rate > MAX_SAMPLING_RATE)
+        OE_RAISE(OE_INVALID_PARAMETER);
+
+    if (!__atomic_load_n(&_buckets, __ATOMIC_ACQUIRE))
+    {
+        size_t size = NUM_BUCKETS * sizeof(sample_t*);
+
+        if (!(buckets = (sample_t**)oe_nodebug_malloc(size)))
+            OE_RAISE(OE_OUT_OF_MEMORY);
+
+        memset(buckets, 0, size);
+    }
+
+    oe_spin_lock(&_lock);
+
+    if (!_buckets && buckets)
+    {
+        __atomic_store_n(&_buckets, buckets, __ATOMIC_RELEASE);
+        buckets = NULL;
+    }
+
+    // Samples taken at another rate would be scaled wrongly.
+    _free_samples();
+    __atomic_store_n(
+        &oe_heap_profiler_sampling_rate, sampling_rate, __ATOMIC_RELEASE);
+
+    oe_spin_unlock(&_lock);
+
+    result = OE_OK;
+
+done:
+    oe_nodebug_free(buckets);
+    return result;
+}
+
+oe_result_t oe_heap_profiler_stop(void)
+{
+    oe_spin_lock(&_lock);
+    __atomic_store_n(&oe_heap_profiler_sampling_rate, 0, __ATOMIC_RELEASE);
+    _free_samples();
+    oe_spin_unlock(&_lock);
+
+    return OE_OK;
+}
+
+typedef struct _text
+{
+    char* data;
+    size_t size;
+    size_t capacity;
+} text_t;
+
+OE_PRINTF_FORMAT(2, 3)
+static oe_result_t _append(text_t* text, const char* format, ...)
+{
+    oe_result_t result = OE_UNEXPECTED;
+    oe_va_list ap;
+    int n;
+
+    for (;;)
+    {
+        size_t available = text->capacity - text->size;
+
+        oe_va_start(ap, format);
+        n = oe_vsnprintf(text->data + text->size, available, format, ap);
+        oe_va_end(ap);
+
+        if (n < 0)
+            OE_RAISE(OE_FAILURE);
+
+        if ((size_t)n < available)
+            break;
+
+        // Grow the buffer and format again.
+        size_t capacity = text->capacity * 2 + (size_t)n + 1;
+        char* data = (char*)oe_nodebug_realloc(text->data, capacity);
+
+        if (!data)
+            OE_RAISE(OE_OUT_OF_MEMORY);
+
+        text->data = data;
+        text->capacity = capacity;
+    }
+
+    text->size += (size_t)n;
+    result = OE_OK;
+
+done:
+    return result;
+}
+
+/* Copy the samples so that they can be formatted without the lock */
+static oe_result_t _copy_samples(
+    uint8_t** copy_out,
+    size_t* copy_size_out,
+    uint64_t* rate_out)
+{
+    oe_result_t result = OE_UNEXPECTED;
+    uint8_t* copy = NULL;
+    size_t copy_size = 0;
+    size_t offset = 0;
+
+    oe_spin_lock(&_lock);
+
+    if (!(*rate_out = oe_heap_profiler_sampling_rate))
+    {
+        oe_spin_unlock(&_lock);
+        OE_RAISE(OE_UNEXPECTED);
+    }
+
+    for (size_t i = 0; i < NUM_BUCKETS; i++)
+    {
+        for (sample_t* s = _buckets[i]; s; s = s->next)
+            copy_size += sizeof(sample_t) + s->num_addrs * sizeof(void*);
+    }
+
+    if (copy_size && !(copy = (uint8_t*)oe_nodebug_malloc(copy_size)))
+    {
+        oe_spin_unlock(&_lock);
+        OE_RAISE(OE_OUT_OF_MEMORY);
+    }
+
+    for (size_t i = 0; i < NUM_BUCKETS; i++)
+    {
+        for (sample_t* s = _buckets[i]; s; s = s->next)
+        {
+            size_t size = sizeof(sample_t) + s->num_addrs * sizeof(void*);
+            memcpy(copy + offset, s, size);
+            offset += size;
+        }
+    }
+
+    oe_spin_unlock(&_lock);
+
+    *copy_out = copy;
+    *copy_size_out = copy_size;
+    copy = NULL;
+    result = OE_OK;
+
+done:
+    oe_nodebug_free(copy);
+    return result;
+}
+
+oe_result_t oe_heap_profiler_dump(const char* name)
+{
+    oe_result_t result = OE_UNEXPECTED;
+    text_t text = {NULL, 0, 0};
+    uint8_t* copy = NULL;
+    size_t copy_size = 0;
+    uint64_t rate = 0;
+    uint64_t count = 0;
+    uint64_t bytes = 0;
+
+    if (!name)
+        OE_RAISE(OE_INVALID_PARAMETER);
+
+    if (!__atomic_load_n(&oe_heap_profiler_sampling_rate, __ATOMIC_RELAXED))
+        OE_RAISE_MSG(OE_UNEXPECTED, "The heap profiler is not running", NULL);
+
+    OE_CHECK(_copy_samples(&copy, &copy_size, &rate));
+
+    for (size_t offset = 0; offset < copy_size;)
+    {
+        const sample_t* s = (const sample_t*)(copy + offset);
+
+        count++;
+        bytes += s->size;
+        offset += sizeof(sample_t) + s->num_addrs * sizeof(void*);
+    }
+
+    // The allocation columns repeat the in-use values, as only the samples
+    // of blocks still in use are kept.
+    OE_CHECK(_append(
+        &text,
+        "heap profile: %llu: %llu [%llu: %llu] @ heap_v2/%llu\n",
+        OE_LLU(count),
+        OE_LLU(bytes),
+        OE_LLU(count),
+        OE_LLU(bytes),
+        OE_LLU(rate)));
+
+    for (size_t offset = 0; offset < copy_size;)
+    {
+        const sample_t* s = (const sample_t*)(copy + offset);
+
+        OE_CHECK(_append(
+            &text,
+            "1: %llu [1: %llu] @",
+            OE_LLU(s->size),
+            OE_LLU(s->size)));
+
+        for (uint64_t i = 0; i < s->num_addrs; i++)
+            OE_CHECK(_append(&text, " 0x%llx", OE_LLX((uint64_t)s->addrs[i])));
+
+        OE_CHECK(_append(&text, "\n"));
+        offset += sizeof(sample_t) + s->num_addrs * sizeof(void*);
+    }
+
+    OE_CHECK(oe_heap_profiler_write(name, text.data, text.size));
+
+    result = OE_OK;
+
+done:
+    oe_nodebug_free(copy);
+    oe_nodebug_free(text.data);
+    return result;
+}
@@ -0,0 +1,43 @@
+// Copyright (c) Open Enclave SDK contributors.
+// Licensed under the MIT License.
+
+#ifndef _OE_HEAPPROFILER_H
+#define _OE_HEAPPROFILER_H
+
+#include <openenclave/bits/defs.h>
+#include <openenclave/bits/result.h>
+#include <openenclave/bits/types.h>
+
+OE_EXTERNC_BEGIN
+
+/* The mean number of bytes between samples, or zero when not profiling */
+extern uint64_t oe_heap_profiler_sampling_rate;
+
+void oe_heap_profiler_sample_alloc(void* ptr, size_t size);
+void oe_heap_profiler_sample_free(void* ptr);
+
+/* Called by the allocator after a block has been allocated */
+OE_INLINE void oe_heap_profiler_on_alloc(void* ptr, size_t size)
+{
+    if (ptr &&
+        __atomic_load_n(&oe_heap_profiler_sampling_rate, __ATOMIC_RELAXED))
+        oe_heap_profiler_sample_alloc(ptr, size);
+}
+
+/* Called by the allocator before a block is freed or reallocated */
+OE_INLINE void oe_heap_profiler_on_free(void* ptr)
+{
+    if (ptr &&
+        __atomic_load_n(&oe_heap_profiler_sampling_rate, __ATOMIC_RELAXED))
+        oe_heap_profiler_sample_free(ptr);
+}
+
+/* Write a heap profile to a file on the host (implemented per TEE) */
+oe_result_t oe_heap_profiler_write(
+    const char* name,
+    const void* profile,
+    size_t profile_size);
+
+OE_EXTERNC_END
+
+#endif /* _OE_HEAPPROFILER_H */
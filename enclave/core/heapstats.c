@@ -0,0 +1,81 @@
+// Copyright (c) Open Enclave SDK contributors.
+// Licensed under the MIT License.
+
+#include "heapstats.h"
+#include <openenclave/corelibc/string.h>
+#include <openenclave/internal/globals.h>
+
+/*
+**==============================================================================
+**
+** Heap statistics:
+**
+**     The allocator counts allocations and frees per size class in one of
+**     OE_HEAP_STATS_NUM_SHARDS shards chosen by thread, with relaxed atomic
+**     increments and no lock. oe_sbrk() records the break and committed size
+**     under its own lock. A snapshot sums the shards and is read by the host
+**     through the OE_ECALL_GET_HEAP_STATS builtin ecall.
+**
+**==============================================================================
+*/
+
+oe_heap_stats_shard_t oe_heap_stats_shards[OE_HEAP_STATS_NUM_SHARDS];
+
+static uint64_t _heap_used_bytes;
+static uint64_t _heap_peak_used_bytes;
+static uint64_t _heap_committed_bytes;
+static uint64_t _heap_grow_count;
+
+void oe_heap_stats_on_sbrk(uint64_t used_bytes, uint64_t committed_bytes)
+{
+    // oe_sbrk() serializes the writers, so only readers need atomics.
+    if (used_bytes > _heap_used_bytes)
+        __atomic_store_n(
+            &_heap_grow_count, _heap_grow_count + 1, __ATOMIC_RELAXED);
+
+    if (used_bytes > _heap_peak_used_bytes)
+        __atomic_store_n(&_heap_peak_used_bytes, used_bytes, __ATOMIC_RELAXED);
+
+    __atomic_store_n(&_heap_used_bytes, used_bytes, __ATOMIC_RELAXED);
+    __atomic_store_n(&_heap_committed_bytes, committed_bytes, __ATOMIC_RELAXED);
+}
+
+void oe_get_heap_stats(oe_enclave_heap_stats_t* stats)
+{
+    int64_t in_use_bytes = 0;
+
+    memset(stats, 0, sizeof(*stats));
+
+    stats->heap_size = __oe_get_heap_size();
+    stats->heap_used_bytes =
+        __atomic_load_n(&_heap_used_bytes, __ATOMIC_RELAXED);
+    stats->heap_peak_used_bytes =
+        __atomic_load_n(&_heap_peak_used_bytes, __ATOMIC_RELAXED);
+    stats->heap_grow_count =
+        __atomic_load_n(&_heap_grow_count, __ATOMIC_RELAXED);
+
+    // A static heap is committed when the enclave is created.
+    if (__oe_is_heap_dynamic())
+        stats->heap_committed_bytes =
+            __atomic_load_n(&_heap_committed_bytes, __ATOMIC_RELAXED);
+    else
+        stats->heap_committed_bytes = stats->heap_size;
+
+    for (size_t i = 0; i < OE_HEAP_STATS_NUM_SHARDS; i++)
+    {
+        const oe_heap_stats_shard_t* shard = &oe_heap_stats_shards[i];
+
+        for (size_t j = 0; j < OE_HEAP_STATS_NUM_SIZE_CLASSES; j++)
+        {
+            stats->alloc_count[j] +=
+                __atomic_load_n(&shard->alloc_count[j], __ATOMIC_RELAXED);
+            stats->free_count[j] +=
+                __atomic_load_n(&shard->free_count[j], __ATOMIC_RELAXED);
+        }
+
+        in_use_bytes += __atomic_load_n(&shard->in_use_bytes, __ATOMIC_RELAXED);
+    }
+
+    // The shards are read one by one, so the sum may briefly go negative.
+    stats->in_use_bytes = in_use_bytes > 0 ? (uint64_t)in_use_bytes : 0;
+}
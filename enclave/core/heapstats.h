@@ -0,0 +1,84 @@
+// Copyright (c) Open Enclave SDK contributors.
+// Licensed under the MIT License.
+
+#ifndef _OE_HEAPSTATS_H
+#define _OE_HEAPSTATS_H
+
+#include <openenclave/bits/defs.h>
+#include <openenclave/bits/heapstats.h>
+#include <openenclave/bits/result.h>
+#include <openenclave/bits/types.h>
+#include <openenclave/internal/thread.h>
+
+OE_EXTERNC_BEGIN
+
+/* Threads spread their allocation counters over this many shards so that
+ * they rarely update the same cache line */
+#define OE_HEAP_STATS_NUM_SHARDS_LOG2 3
+#define OE_HEAP_STATS_NUM_SHARDS (1 << OE_HEAP_STATS_NUM_SHARDS_LOG2)
+
+typedef struct _oe_heap_stats_shard
+{
+    uint64_t alloc_count[OE_HEAP_STATS_NUM_SIZE_CLASSES];
+    uint64_t free_count[OE_HEAP_STATS_NUM_SIZE_CLASSES];
+
+    /* Negative when blocks allocated through other shards were freed */
+    int64_t in_use_bytes;
+} OE_ALIGNED(64) oe_heap_stats_shard_t;
+
+extern oe_heap_stats_shard_t oe_heap_stats_shards[OE_HEAP_STATS_NUM_SHARDS];
+
+OE_INLINE oe_heap_stats_shard_t* oe_heap_stats_shard(void)
+{
+    uint64_t h = (uint64_t)oe_thread_self() * 0x9e3779b97f4a7c15;
+    return &oe_heap_stats_shards[h >> (64 - OE_HEAP_STATS_NUM_SHARDS_LOG2)];
+}
+
+OE_INLINE size_t oe_heap_stats_size_class(size_t size)
+{
+    size_t size_class;
+
+    if (size <= 16)
+        return 0;
+
+    size_class = (size_t)(64 - __builtin_clzll((uint64_t)(size - 1) >> 4));
+
+    if (size_class >= OE_HEAP_STATS_NUM_SIZE_CLASSES)
+        return OE_HEAP_STATS_NUM_SIZE_CLASSES - 1;
+
+    return size_class;
+}
+
+/* Called by the allocator with the usable size of an allocated block */
+OE_INLINE void oe_heap_stats_on_alloc(size_t size)
+{
+    oe_heap_stats_shard_t* shard = oe_heap_stats_shard();
+
+    __atomic_fetch_add(
+        &shard->alloc_count[oe_heap_stats_size_class(size)],
+        1,
+        __ATOMIC_RELAXED);
+    __atomic_fetch_add(&shard->in_use_bytes, (int64_t)size, __ATOMIC_RELAXED);
+}
+
+/* Called by the allocator with the usable size of a block being freed */
+OE_INLINE void oe_heap_stats_on_free(size_t size)
+{
+    oe_heap_stats_shard_t* shard = oe_heap_stats_shard();
+
+    __atomic_fetch_add(
+        &shard->free_count[oe_heap_stats_size_class(size)],
+        1,
+        __ATOMIC_RELAXED);
+    __atomic_fetch_sub(&shard->in_use_bytes, (int64_t)size, __ATOMIC_RELAXED);
+}
+
+/* Called by oe_sbrk() with its lock held after it moved the break */
+void oe_heap_stats_on_sbrk(uint64_t used_bytes, uint64_t committed_bytes);
+
+/* Take a snapshot of the counters */
+void oe_get_heap_stats(oe_enclave_heap_stats_t* stats);
+
+OE_EXTERNC_END
+
+#endif /* _OE_HEAPSTATS_H */
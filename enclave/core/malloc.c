@@ -16,8 +16,11 @@
 #include <openenclave/internal/malloc.h>
 #include <openenclave/internal/raise.h>
 #include <openenclave/internal/safecrt.h>
+#include <openenclave/internal/safemath.h>
 #include <openenclave/internal/thread.h>
 #include "debugmalloc.h"
+#include "heapprofiler.h"
+#include "heapstats.h"
 #include "oe_alloc_thread.h"
 #include "oe_nodebug_alloc.h"
 
@@ -65,6 +68,18 @@ static int _dlmalloc_stats_fprintf(FILE* stream, const char* format, ...);
 #define MALLOC_USABLE_SIZE dlmalloc_usable_size
 #endif
 
+#if !defined(OE_USE_DEBUG_MALLOC)
+static void* _cache_malloc(size_t size);
+static void* _cache_calloc(size_t nmemb, size_t size);
+static void _cache_free(void* ptr);
+#undef MALLOC
+#undef CALLOC
+#undef FREE
+#define MALLOC _cache_malloc
+#define CALLOC _cache_calloc
+#define FREE _cache_free
+#endif
+
 void* oe_nodebug_malloc(size_t s)
 {
     return dlmalloc(s);
@@ -84,6 +99,26 @@ void* oe_nodebug_memalign(size_t alignment, size_t size)
 
 static oe_allocation_failure_callback_t _failure_callback;
 
+/* Account an allocated block in the heap statistics and the profiler */
+static void _on_alloc(void* ptr, size_t size)
+{
+    if (ptr)
+    {
+        oe_heap_stats_on_alloc(MALLOC_USABLE_SIZE(ptr));
+        oe_heap_profiler_on_alloc(ptr, size);
+    }
+}
+
+/* Account a block that is about to be freed */
+static void _on_free(void* ptr)
+{
+    if (ptr)
+    {
+        oe_heap_profiler_on_free(ptr);
+        oe_heap_stats_on_free(MALLOC_USABLE_SIZE(ptr));
+    }
+}
+
 void oe_set_allocation_failure_callback(
     oe_allocation_failure_callback_t function)
 {
@@ -102,16 +137,20 @@ void* oe_malloc(size_t size)
             _failure_callback(__FILE__, __LINE__, __FUNCTION__, size);
     }
 
+    _on_alloc(p, size);
+
     return p;
 }
 
 void oe_free(void* ptr)
 {
+    _on_free(ptr);
     FREE(ptr);
 }
 
 void oe_memalign_free(void* ptr)
 {
+    _on_free(ptr);
     FREE(ptr);
 }
 
@@ -127,12 +166,22 @@ void* oe_calloc(size_t nmemb, size_t size)
             _failure_callback(__FILE__, __LINE__, __FUNCTION__, nmemb * size);
     }
 
+    // The product cannot overflow when the allocation succeeded.
+    _on_alloc(p, nmemb * size);
+
     return p;
 }
 
 void* oe_realloc(void* ptr, size_t size)
 {
-    void* p = REALLOC(ptr, size);
+    size_t old_size = ptr ? MALLOC_USABLE_SIZE(ptr) : 0;
+    void* p;
+
+    // Forget a sampled block before it may be freed. Should realloc fail,
+    // the block stays allocated but unsampled.
+    oe_heap_profiler_on_free(ptr);
+
+    p = REALLOC(ptr, size);
 
     if (!p && size)
     {
@@ -141,6 +190,12 @@ void* oe_realloc(void* ptr, size_t size)
         if (_failure_callback)
             _failure_callback(__FILE__, __LINE__, __FUNCTION__, size);
     }
+    else if (ptr)
+    {
+        oe_heap_stats_on_free(old_size);
+    }
+
+    _on_alloc(p, size);
 
     return p;
 }
@@ -157,6 +212,9 @@ int oe_posix_memalign(void** memptr, size_t alignment, size_t size)
             _failure_callback(__FILE__, __LINE__, __FUNCTION__, size);
     }
 
+    if (rc == 0)
+        _on_alloc(*memptr, size);
+
     return rc;
 }
 
@@ -172,6 +230,8 @@ void* oe_memalign(size_t alignment, size_t size)
             _failure_callback(__FILE__, __LINE__, __FUNCTION__, size);
     }
 
+    _on_alloc(p, size);
+
     return p;
 }
 
@@ -269,6 +329,339 @@ done:
     return result;
 }
 
+/*
+**==============================================================================
+**
+** Per-thread allocation cache:
+**
+**     dlmalloc serializes every allocation on one global lock. To keep most
+**     small allocations off that lock, each thread keeps free lists of small
+**     blocks, one list per dlmalloc chunk size up to _CACHE_MAX_CHUNK bytes.
+**
+**     Cached blocks remain allocated chunks as far as dlmalloc is concerned,
+**     so oe_malloc_usable_size() and oe_realloc() work unchanged and a block
+**     may be freed by any thread: it is filed under its own chunk size in
+**     the cache of the thread that frees it. An empty list is refilled with
+**     dlindependent_comalloc(), which carves a batch of chunks out of one
+**     allocation, and a list that grows beyond _CACHE_LIST_BYTES gives half
+**     of its blocks back with one dlbulk_free() call. The refill batch starts
+**     small and doubles with every refill of the list, so that ecalls which
+**     make a few allocations do not take many blocks from the heap.
+**
+**     Enclave threads have little thread-local space, so the thread-local
+**     part is a pointer to the cache, which is allocated when the thread
+**     first allocates or frees a small block. Thread-local storage is
+**     cleared when the outermost ecall of a thread returns, so
+**     oe_alloc_thread_teardown() parks the cache in a list, keyed by the
+**     thread (its td, which is fixed for the TCS), and the next ecall on the
+**     same TCS takes it back with its blocks. There are at most as many
+**     caches as TCSs. When the heap is exhausted, the blocks of the calling
+**     thread and of all parked caches are given back to dlmalloc.
+**
+**     The cache is not used with the debug allocator, which must see every
+**     block.
+**
+**==============================================================================
+*/
+
+#if !defined(OE_USE_DEBUG_MALLOC)
+
+/* The largest chunk (request plus chunk overhead) that is cached */
+#define _CACHE_MAX_CHUNK 512
+#define _CACHE_MAX_REQUEST (_CACHE_MAX_CHUNK - CHUNK_OVERHEAD)
+
+/* Lists are indexed by chunk size divided by the chunk alignment */
+#define _CACHE_NUM_LISTS (_CACHE_MAX_CHUNK / MALLOC_ALIGNMENT + 1)
+
+/* The most bytes a list holds before half of its blocks are released */
+#define _CACHE_LIST_BYTES 2048
+
+/* The most blocks a list holds (the limit of a list of the smallest chunks) */
+#define _CACHE_MAX_BLOCKS (_CACHE_LIST_BYTES / MIN_CHUNK_SIZE)
+
+/* The number of blocks taken by the first refill of a list */
+#define _CACHE_FIRST_BATCH 4
+
+typedef struct _cache_block
+{
+    struct _cache_block* next;
+
+    /* The cache holding the block, to detect double frees */
+    const struct _thread_cache* cache;
+} _cache_block_t;
+
+typedef struct _cache_list
+{
+    _cache_block_t* head;
+    size_t count;
+
+    /* The number of blocks the next refill takes from dlmalloc */
+    size_t batch;
+} _cache_list_t;
+
+typedef struct _thread_cache
+{
+    _cache_list_t lists[_CACHE_NUM_LISTS];
+
+    /* The thread the cache belongs to and the next parked cache */
+    oe_thread_t owner;
+    struct _thread_cache* next;
+} _thread_cache_t;
+
+/* Set between oe_alloc_thread_startup() and oe_alloc_thread_teardown() */
+static __thread bool _thread_cache_active;
+static __thread _thread_cache_t* _thread_cache;
+
+/* The caches of threads that are not in an ecall */
+static _thread_cache_t* _parked_caches;
+static oe_spinlock_t _parked_caches_lock = OE_SPINLOCK_INITIALIZER;
+
+static bool _thread_cache_enabled = true;
+
+oe_result_t oe_set_malloc_thread_cache_enabled(bool enabled)
+{
+    __atomic_store_n(&_thread_cache_enabled, enabled, __ATOMIC_RELAXED);
+    return OE_OK;
+}
+
+/* Take the parked cache of the calling thread, or allocate one */
+static _thread_cache_t* _unpark_thread_cache(void)
+{
+    oe_thread_t self = oe_thread_self();
+    _thread_cache_t* cache = NULL;
+
+    oe_spin_lock(&_parked_caches_lock);
+
+    for (_thread_cache_t** p = &_parked_caches; *p; p = &(*p)->next)
+    {
+        if ((*p)->owner == self)
+        {
+            cache = *p;
+            *p = cache->next;
+            cache->next = NULL;
+            break;
+        }
+    }
+
+    oe_spin_unlock(&_parked_caches_lock);
+
+    if (!cache &&
+        (cache = (_thread_cache_t*)dlcalloc(1, sizeof(_thread_cache_t))))
+        cache->owner = self;
+
+    return cache;
+}
+
+/* Get the cache of the calling thread, or NULL if it must not be used */
+static _thread_cache_t* _get_thread_cache(void)
+{
+    if (!_thread_cache_active ||
+        !__atomic_load_n(&_thread_cache_enabled, __ATOMIC_RELAXED))
+        return NULL;
+
+    if (!_thread_cache)
+        _thread_cache = _unpark_thread_cache();
+
+    return _thread_cache;
+}
+
+static size_t _list_limit(size_t chunk)
+{
+    return _CACHE_LIST_BYTES / chunk;
+}
+
+static void _list_push(
+    _thread_cache_t* cache,
+    _cache_list_t* list,
+    _cache_block_t* block)
+{
+    block->next = list->head;
+    block->cache = cache;
+    list->head = block;
+    list->count++;
+}
+
+/* Give up to OE_COUNTOF(blocks) blocks of the list back to dlmalloc, keeping
+ * the given number of blocks */
+static void _list_release(_cache_list_t* list, size_t keep)
+{
+    void* blocks[_CACHE_MAX_BLOCKS];
+    size_t n = 0;
+
+    while (list->count > keep && n < OE_COUNTOF(blocks))
+    {
+        _cache_block_t* block = list->head;
+
+        list->head = block->next;
+        list->count--;
+        blocks[n++] = block;
+    }
+
+    dlbulk_free(blocks, n);
+}
+
+static void _thread_cache_flush(_thread_cache_t* cache)
+{
+    for (size_t i = 0; i < OE_COUNTOF(cache->lists); i++)
+    {
+        while (cache->lists[i].count)
+            _list_release(&cache->lists[i], 0);
+
+        cache->lists[i].batch = 0;
+    }
+}
+
+/* Give the blocks of the parked caches back to dlmalloc */
+static void _flush_parked_caches(void)
+{
+    oe_spin_lock(&_parked_caches_lock);
+
+    for (_thread_cache_t* cache = _parked_caches; cache; cache = cache->next)
+        _thread_cache_flush(cache);
+
+    oe_spin_unlock(&_parked_caches_lock);
+}
+
+static bool _list_refill(
+    _thread_cache_t* cache,
+    _cache_list_t* list,
+    size_t chunk)
+{
+    void* blocks[_CACHE_MAX_BLOCKS / 2];
+    size_t sizes[_CACHE_MAX_BLOCKS / 2];
+    size_t n = list->batch ? list->batch : _CACHE_FIRST_BATCH;
+
+    if (n > _list_limit(chunk) / 2)
+        n = _list_limit(chunk) / 2;
+
+    for (size_t i = 0; i < n; i++)
+        sizes[i] = chunk - CHUNK_OVERHEAD;
+
+    if (!dlindependent_comalloc(n, sizes, blocks))
+        return false;
+
+    // Push in reverse so that blocks are handed out in address order.
+    for (size_t i = n; i > 0; i--)
+        _list_push(cache, list, (_cache_block_t*)blocks[i - 1]);
+
+    list->batch = n * 2;
+
+    return true;
+}
+
+static void* _cache_malloc(size_t size)
+{
+    _thread_cache_t* cache;
+    _cache_list_t* list;
+    _cache_block_t* block;
+    size_t chunk;
+
+    if (size > _CACHE_MAX_REQUEST || !(cache = _get_thread_cache()))
+        return dlmalloc(size);
+
+    chunk = request2size(size);
+    list = &cache->lists[chunk / MALLOC_ALIGNMENT];
+
+    if (!list->head && !_list_refill(cache, list, chunk))
+    {
+        // The heap is exhausted: give the cached blocks back and retry.
+        _thread_cache_flush(cache);
+        _flush_parked_caches();
+        return dlmalloc(size);
+    }
+
+    block = list->head;
+    list->head = block->next;
+    list->count--;
+    block->cache = NULL;
+
+    return block;
+}
+
+static void* _cache_calloc(size_t nmemb, size_t size)
+{
+    size_t total;
+    void* ptr;
+
+    if (oe_safe_mul_sizet(nmemb, size, &total) != OE_OK ||
+        total > _CACHE_MAX_REQUEST || !_get_thread_cache())
+        return dlcalloc(nmemb, size);
+
+    if ((ptr = _cache_malloc(total)))
+        memset(ptr, 0, total);
+
+    return ptr;
+}
+
+static void _cache_free(void* ptr)
+{
+    _thread_cache_t* cache;
+    _cache_list_t* list;
+    _cache_block_t* block = (_cache_block_t*)ptr;
+    mchunkptr p;
+    size_t chunk;
+
+    if (!ptr)
+        return;
+
+    p = mem2chunk(ptr);
+
+    // Chunks that are not in use are passed on for dlfree() to report.
+    if (!is_inuse(p) || (chunk = chunksize(p)) > _CACHE_MAX_CHUNK ||
+        !(cache = _get_thread_cache()))
+    {
+        dlfree(ptr);
+        return;
+    }
+
+    list = &cache->lists[chunk / MALLOC_ALIGNMENT];
+
+    if (block->cache == cache)
+    {
+        for (const _cache_block_t* b = list->head; b; b = b->next)
+        {
+            if (b == block)
+                ABORT;
+        }
+    }
+
+    _list_push(cache, list, block);
+
+    if (list->count > _list_limit(chunk))
+        _list_release(list, list->count / 2);
+}
+
+void oe_alloc_thread_startup()
+{
+    _thread_cache_active = true;
+}
+
+void oe_alloc_thread_teardown()
+{
+    _thread_cache_t* cache = _thread_cache;
+
+    _thread_cache_active = false;
+    _thread_cache = NULL;
+
+    // Thread-local storage is about to be cleared: keep the cache and its
+    // blocks for the next ecall on this TCS.
+    if (cache)
+    {
+        oe_spin_lock(&_parked_caches_lock);
+        cache->next = _parked_caches;
+        _parked_caches = cache;
+        oe_spin_unlock(&_parked_caches_lock);
+    }
+}
+
+#else /* defined(OE_USE_DEBUG_MALLOC) */
+
+oe_result_t oe_set_malloc_thread_cache_enabled(bool enabled)
+{
+    OE_UNUSED(enabled);
+    return OE_UNSUPPORTED;
+}
+
 void oe_alloc_thread_startup()
 {
 }
@@ -276,3 +669,5 @@ void oe_alloc_thread_startup()
 void oe_alloc_thread_teardown()
 {
 }
+
+#endif /* defined(OE_USE_DEBUG_MALLOC) */
@@ -2,6 +2,7 @@
 // Licensed under the MIT License.
 
 #include <openenclave/enclave.h>
+#include "../heapprofiler.h"
 
 int oe_backtrace(void** buffer, int size)
 {
@@ -24,3 +25,15 @@ void oe_backtrace_symbols_free(char** ptr)
 {
     OE_UNUSED(ptr);
 }
+
+oe_result_t oe_heap_profiler_write(
+    const char* name,
+    const void* profile,
+    size_t profile_size)
+{
+    OE_UNUSED(name);
+    OE_UNUSED(profile);
+    OE_UNUSED(profile_size);
+
+    return OE_UNSUPPORTED;
+}
@@ -50,3 +50,22 @@ const void* __oe_get_heap_end()
 {
     return (const uint8_t*)__oe_get_heap_base() + __oe_get_heap_size();
 }
+
+bool __oe_is_heap_dynamic(void)
+{
+    return false;
+}
+
+oe_result_t __oe_commit_heap_pages(const void* addr, size_t size)
+{
+    OE_UNUSED(addr);
+    OE_UNUSED(size);
+    return OE_UNSUPPORTED;
+}
+
+oe_result_t __oe_release_heap_pages(const void* addr, size_t size)
+{
+    OE_UNUSED(addr);
+    OE_UNUSED(size);
+    return OE_UNSUPPORTED;
+}
@@ -4,29 +4,155 @@
 #include <openenclave/enclave.h>
 #include <openenclave/internal/globals.h>
 #include <openenclave/internal/thread.h>
+#include <openenclave/internal/utils.h>
+#include "heapstats.h"
+
+/* Commit dynamic heap pages in chunks of this size to amortize the cost of
+ * the host call that adds them */
+#define OE_HEAP_COMMIT_GRANULARITY (64 * OE_PAGE_SIZE)
+
+static unsigned char* _commit_limit(unsigned char* brk)
+{
+    unsigned char* heap_base = (unsigned char*)__oe_get_heap_base();
+    unsigned char* heap_end = (unsigned char*)__oe_get_heap_end();
+    uint64_t offset = (uint64_t)(brk - heap_base);
+
+    offset = oe_round_up_to_multiple(offset, OE_HEAP_COMMIT_GRANULARITY);
+
+    if (offset > (uint64_t)(heap_end - heap_base))
+        return heap_end;
+
+    return heap_base + offset;
+}
+
+static unsigned char* _heap_next;
+static unsigned char* _heap_committed;
+
+/* Set while a thread commits or releases dynamic heap pages, which it does
+ * without holding the lock */
+static bool _heap_busy;
+
+/* Set once the host has reported that it cannot release committed pages */
+static bool _release_unsupported;
+
+static oe_spinlock_t _lock = OE_SPINLOCK_INITIALIZER;
+
+static void _update_heap_stats(void)
+{
+    unsigned char* heap_base = (unsigned char*)__oe_get_heap_base();
+
+    oe_heap_stats_on_sbrk(
+        (uint64_t)(_heap_next - heap_base),
+        (uint64_t)(_heap_committed - heap_base));
+}
 
 void* oe_sbrk(ptrdiff_t increment)
 {
-    static unsigned char* _heap_next;
-    static oe_spinlock_t _lock = OE_SPINLOCK_INITIALIZER;
-    void* ptr = (void*)-1;
+    unsigned char* ptr;
+    unsigned char* heap_next;
+    unsigned char* committed;
+    unsigned char* limit;
+    bool release;
 
-    oe_spin_lock(&_lock);
+    /* Commit the pages up to the new break first. The host call is made
+     * without holding the lock; threads that need more pages meanwhile wait
+     * for it to return. */
+    for (;;)
     {
-        ptrdiff_t remaining;
+        oe_result_t result;
+
+        oe_spin_lock(&_lock);
 
         if (!_heap_next)
+        {
             _heap_next = (unsigned char*)__oe_get_heap_base();
 
-        remaining = (unsigned char*)__oe_get_heap_end() - _heap_next;
+            /* A static heap is fully committed when the enclave is created */
+            if (__oe_is_heap_dynamic())
+                _heap_committed = _heap_next;
+            else
+                _heap_committed = (unsigned char*)__oe_get_heap_end();
+        }
+
+        if (increment > (unsigned char*)__oe_get_heap_end() - _heap_next ||
+            increment < (unsigned char*)__oe_get_heap_base() - _heap_next)
+        {
+            oe_spin_unlock(&_lock);
+            return (void*)-1;
+        }
+
+        heap_next = _heap_next + increment;
+
+        if (heap_next <= _heap_committed)
+            break;
 
-        if (increment <= remaining)
+        if (_heap_busy)
         {
-            ptr = _heap_next;
-            _heap_next += increment;
+            oe_spin_unlock(&_lock);
+            continue;
         }
+
+        _heap_busy = true;
+        committed = _heap_committed;
+        limit = _commit_limit(heap_next);
+        oe_spin_unlock(&_lock);
+
+        result =
+            __oe_commit_heap_pages(committed, (size_t)(limit - committed));
+
+        oe_spin_lock(&_lock);
+        if (result == OE_OK)
+            _heap_committed = limit;
+        _heap_busy = false;
+        oe_spin_unlock(&_lock);
+
+        if (result != OE_OK)
+            return (void*)-1;
+    }
+
+    /* The lock is held */
+    ptr = _heap_next;
+    _heap_next = heap_next;
+
+    /* The allocator shrinks the break only after it has accumulated a large
+     * enough free block at the top of the heap (trimming), so return
+     * whatever lies beyond the new break to the host, unless the host has
+     * said that it cannot take pages back. The pages are no longer counted
+     * as committed while they are released, so that no thread uses them. */
+    committed = _heap_committed;
+    limit = _commit_limit(heap_next);
+    release = increment < 0 && __oe_is_heap_dynamic() &&
+              !_release_unsupported && !_heap_busy && limit < committed;
+
+    if (release)
+    {
+        _heap_busy = true;
+        _heap_committed = limit;
     }
+
+    _update_heap_stats();
     oe_spin_unlock(&_lock);
 
+    if (release)
+    {
+        oe_result_t result =
+            __oe_release_heap_pages(limit, (size_t)(committed - limit));
+
+        oe_spin_lock(&_lock);
+
+        /* The pages remain committed, for later reuse */
+        if (result != OE_OK)
+        {
+            _heap_committed = committed;
+
+            if (result == OE_UNSUPPORTED)
+                _release_unsupported = true;
+        }
+
+        _heap_busy = false;
+        _update_heap_stats();
+        oe_spin_unlock(&_lock);
+    }
+
     return ptr;
 }
@@ -11,6 +11,7 @@
 #define ENCLU_EGETKEY 1
 #define ENCLU_EENTER 2
 #define ENCLU_EEXIT 4
+#define ENCLU_EACCEPT 5
 
 #define PAGE_SIZE 4096
 #define STATIC_STACK_SIZE 8 * 100
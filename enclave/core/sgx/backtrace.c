@@ -11,6 +11,7 @@
 #include <openenclave/internal/print.h>
 #include <openenclave/internal/raise.h>
 #include <openenclave/internal/safecrt.h>
+#include "../heapprofiler.h"
 #include "../oe_nodebug_alloc.h"
 #include "sgx_t.h"
 #include "tee_t.h"
@@ -193,3 +194,21 @@ void oe_backtrace_symbols_free(char** ptr)
     /* Backtrace must use the internal allocator to bypass debug-malloc. */
     oe_nodebug_free(ptr);
 }
+
+oe_result_t oe_heap_profiler_write(
+    const char* name,
+    const void* profile,
+    size_t profile_size)
+{
+    oe_result_t result = OE_UNEXPECTED;
+    oe_result_t retval;
+
+    OE_CHECK(oe_sgx_write_heap_profile_ocall(
+        &retval, oe_get_enclave(), name, profile, profile_size));
+    OE_CHECK(retval);
+
+    result = OE_OK;
+
+done:
+    return result;
+}
@@ -24,6 +24,7 @@
 #include "../../sgx/report.h"
 #include "../arena.h"
 #include "../atexit.h"
+#include "../heapstats.h"
 #include "../tracee.h"
 #include "asmdefs.h"
 #include "cpuid.h"
@@ -189,6 +190,35 @@ done:
     return result;
 }
 
+/*
+**==============================================================================
+**
+** _handle_get_heap_stats()
+**
+**     Handle the OE_ECALL_GET_HEAP_STATS from host by copying a snapshot of
+**     the heap statistics to the oe_enclave_heap_stats_t at arg_in. No EDL
+**     marshalling is involved, so the host can poll the statistics cheaply.
+**
+**==============================================================================
+*/
+static oe_result_t _handle_get_heap_stats(uint64_t arg_in)
+{
+    oe_result_t result = OE_UNEXPECTED;
+    oe_enclave_heap_stats_t* host_stats = (oe_enclave_heap_stats_t*)arg_in;
+    oe_enclave_heap_stats_t stats;
+
+    if (!host_stats || !oe_is_outside_enclave(host_stats, sizeof(stats)))
+        OE_RAISE(OE_INVALID_PARAMETER);
+
+    oe_get_heap_stats(&stats);
+    OE_CHECK(oe_memcpy_s(host_stats, sizeof(stats), &stats, sizeof(stats)));
+
+    result = OE_OK;
+
+done:
+    return result;
+}
+
 /**
  * This is the preferred way to call enclave functions.
  */
@@ -439,6 +469,11 @@ static void _handle_ecall(
             arg_out = _handle_init_enclave(arg_in);
             break;
         }
+        case OE_ECALL_GET_HEAP_STATS:
+        {
+            arg_out = _handle_get_heap_stats(arg_in);
+            break;
+        }
         default:
         {
             /* No function found with the number */
@@ -0,0 +1,102 @@
+// Copyright (c) Open Enclave SDK contributors.
+// Licensed under the MIT License.
+
+#include <openenclave/bits/sgx/sgxtypes.h>
+#include <openenclave/enclave.h>
+#include <openenclave/internal/globals.h>
+#include <openenclave/internal/raise.h>
+#include "sgx_t.h"
+#include "td.h"
+
+/*
+**==============================================================================
+**
+** Enclave dynamic memory management (EDMM):
+**
+**     With OE_SGX_CONFIG_FLAGS_DYNAMIC_HEAP, the host only reserves the heap
+**     when the enclave is created. oe_sbrk() commits pages as the break
+**     moves up, and releases them as the break moves down again:
+**
+**         (1) The enclave asks the host to add the pages (EAUG)
+**         (2) The enclave accepts each page (EACCEPT), which verifies that
+**             the page is a fresh, zero-filled, pending page
+**
+**     The host only creates such enclaves in simulation mode, where it maps
+**     the pages readable and writable and there is nothing to accept. The
+**     enclave still accepts the pages when it is not simulated, so that a
+**     host cannot hand it pages it did not ask for.
+**
+**==============================================================================
+*/
+
+uint64_t oe_eaccept(const sgx_secinfo_t* secinfo, const void* page);
+
+static bool _is_within_heap(const void* addr, size_t size)
+{
+    const uint8_t* start = (const uint8_t*)addr;
+    const uint8_t* heap_base = (const uint8_t*)__oe_get_heap_base();
+    const uint8_t* heap_end = (const uint8_t*)__oe_get_heap_end();
+
+    if ((uint64_t)addr % OE_PAGE_SIZE || size % OE_PAGE_SIZE || size == 0)
+        return false;
+
+    return start >= heap_base && start < heap_end &&
+           size <= (size_t)(heap_end - start);
+}
+
+oe_result_t __oe_commit_heap_pages(const void* addr, size_t size)
+{
+    oe_result_t result = OE_UNEXPECTED;
+    oe_result_t retval = OE_UNEXPECTED;
+
+    if (!__oe_is_heap_dynamic() || !_is_within_heap(addr, size))
+        OE_RAISE(OE_INVALID_PARAMETER);
+
+    if (oe_sgx_commit_pages_ocall(
+            &retval, oe_get_enclave(), (uint64_t)addr, size) != OE_OK)
+        OE_RAISE(OE_FAILURE);
+
+    OE_CHECK(retval);
+
+    if (!oe_get_td()->simulate)
+    {
+        static const sgx_secinfo_t secinfo = {
+            .flags = SGX_SECINFO_REG | SGX_SECINFO_R | SGX_SECINFO_W |
+                     SGX_SECINFO_PENDING};
+        const uint8_t* page = (const uint8_t*)addr;
+        const uint8_t* end = page + size;
+
+        /* Fails unless the host added fresh pages at these addresses */
+        for (; page < end; page += OE_PAGE_SIZE)
+        {
+            if (oe_eaccept(&secinfo, page) != 0)
+                OE_RAISE_MSG(
+                    OE_FAILURE, "EACCEPT failed for page %p", (void*)page);
+        }
+    }
+
+    result = OE_OK;
+
+done:
+    return result;
+}
+
+oe_result_t __oe_release_heap_pages(const void* addr, size_t size)
+{
+    oe_result_t result = OE_UNEXPECTED;
+    oe_result_t retval = OE_UNEXPECTED;
+
+    if (!__oe_is_heap_dynamic() || !_is_within_heap(addr, size))
+        OE_RAISE(OE_INVALID_PARAMETER);
+
+    if (oe_sgx_trim_pages_ocall(
+            &retval, oe_get_enclave(), (uint64_t)addr, size) != OE_OK)
+        OE_RAISE(OE_FAILURE);
+
+    /* OE_UNSUPPORTED means the pages remain committed, which the caller
+     * handles by keeping them for later reuse */
+    result = retval;
+
+done:
+    return result;
+}
@@ -222,6 +222,12 @@ const void* __oe_get_heap_end()
     return (const uint8_t*)__oe_get_heap_base() + __oe_get_heap_size();
 }
 
+bool __oe_is_heap_dynamic(void)
+{
+    return oe_enclave_properties_sgx.config.flags &
+           OE_SGX_CONFIG_FLAGS_DYNAMIC_HEAP;
+}
+
 /*
 **==============================================================================
 **
@@ -198,6 +198,8 @@ static volatile uint64_t _tdata_align = 1;
 static volatile uint64_t _tbss_size = 0;
 static volatile uint64_t _tbss_align = 1;
 
+extern volatile const oe_sgx_enclave_properties_t oe_enclave_properties_sgx;
+
 // Number of thread-local relocations.
 static volatile bool _thread_locals_relocated = false;
 
@@ -226,17 +228,23 @@ static uint64_t _get_aligned_size(uint64_t size, uint64_t align)
 }
 
 /**
- * Return pointer to start of tls data.
- *    tls-data-start = %FS - (aligned .tdata size + aligned .tbss size)
+ * Return the size of the tls data, which is the same for all threads.
+ *    tls-data-size = aligned .tdata size + aligned .tbss size
+ * The layout is validated and computed on first use and then cached, since
+ * it is needed on every outermost ecall. Racing threads compute the same
+ * value, so no lock is needed.
  */
-static uint8_t* _get_thread_local_data_start(td_t* td)
+static uint64_t _get_thread_local_data_size(void)
 {
+    static volatile uint64_t _tls_data_size = OE_UINT64_MAX;
+    uint64_t alignment = 0;
+
+    if (_tls_data_size != OE_UINT64_MAX)
+        return _tls_data_size;
+
     // Check if this enclave has thread-local data.
     if (!_tdata_size && !_tbss_size)
-        return NULL;
-
-    uint8_t* fs = _get_fs_from_td(td);
-    uint64_t alignment = 0;
+        return _tls_data_size = 0;
 
     // Alignments must be non-zero.
     if (!_tdata_align || !_tbss_align)
@@ -262,10 +270,22 @@ static uint8_t* _get_thread_local_data_start(td_t* td)
         oe_abort();
 
     // Align both the sections.
-    fs -= _get_aligned_size(_tbss_size, alignment);
-    fs -= _get_aligned_size(_tdata_size, alignment);
+    return _tls_data_size = _get_aligned_size(_tbss_size, alignment) +
+                            _get_aligned_size(_tdata_size, alignment);
+}
 
-    return fs;
+/**
+ * Return pointer to start of tls data.
+ *    tls-data-start = %FS - tls-data-size
+ */
+static uint8_t* _get_thread_local_data_start(td_t* td)
+{
+    uint64_t tls_data_size = _get_thread_local_data_size();
+
+    if (!tls_data_size)
+        return NULL;
+
+    return _get_fs_from_td(td) - tls_data_size;
 }
 
 /**
@@ -290,17 +310,25 @@ oe_result_t oe_thread_local_init(td_t* td)
 
         uint64_t tls_data_size = (uint64_t)(fs - tls_start);
 
-        // Initialize the tls data to zero.
-        oe_memset_s(tls_start, tls_data_size, 0, tls_data_size);
-
         // Fetch the .tdata template.
         void* tdata = (uint8_t*)__oe_get_enclave_base() + _tdata_rva;
 
         // Copy the template
         oe_memcpy_s(tls_start, _tdata_size, tdata, _tdata_size);
 
-        // Perform thread-local relocations.
-        if (!_thread_locals_relocated)
+        // Initialize the rest of the tls data (the .tbss variables and the
+        // alignment padding) to zero. The template bytes are written once.
+        oe_memset_s(
+            tls_start + _tdata_size,
+            tls_data_size - _tdata_size,
+            0,
+            tls_data_size - _tdata_size);
+
+        // Perform thread-local relocations, unless the loader already
+        // resolved them when the image was measured.
+        if (!_thread_locals_relocated &&
+            !(oe_enclave_properties_sgx.config.flags &
+              OE_SGX_CONFIG_FLAGS_PRERELOCATE))
         {
             // Note: For an enclave, thread-local relocations always set the
             // value of the tpoff variables to a computed constant value. Hence
@@ -23,7 +23,9 @@ OE_CHECK_SIZE(OE_OFFSETOF(oe_sgx_enclave_properties_t, header), 0);
 OE_CHECK_SIZE(OE_OFFSETOF(oe_sgx_enclave_properties_t, config), 32);
 OE_CHECK_SIZE(OE_OFFSETOF(oe_sgx_enclave_properties_t, image_info), 56);
 OE_CHECK_SIZE(OE_OFFSETOF(oe_sgx_enclave_properties_t, sigstruct), 104);
-OE_CHECK_SIZE(sizeof(oe_sgx_enclave_properties_t), 1920);
+OE_CHECK_SIZE(OE_OFFSETOF(oe_sgx_enclave_properties_t, tcs_classes), 1912);
+OE_CHECK_SIZE(OE_OFFSETOF(oe_sgx_enclave_properties_t, end_marker), 1944);
+OE_CHECK_SIZE(sizeof(oe_sgx_enclave_properties_t), 1952);
 
 //
 // Declare an invalid oeinfo to ensure .oeinfo section exists
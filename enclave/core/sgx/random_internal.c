@@ -3,12 +3,51 @@
 
 #include <openenclave/corelibc/string.h>
 #include <openenclave/enclave.h>
+#include <openenclave/internal/aesni.h>
+#include <openenclave/internal/cpuid.h>
 #include <openenclave/internal/rdrand.h>
+#include <openenclave/internal/utils.h>
+#include "cpuid.h"
+
+/*
+**==============================================================================
+**
+** Random bytes:
+**
+**     RDRAND returns 8 bytes per instruction at a cost of hundreds of
+**     cycles. With AES-NI, random bytes are instead produced as an
+**     AES-128-CTR keystream under a key and counter drawn from RDRAND, at
+**     about one cycle per byte. The key is redrawn for every request and
+**     every KEYSTREAM_REKEY_BYTES, and wiped after use, so no generator
+**     state outlives a request. This is how the RDRAND hardware itself
+**     derives its output from its entropy source (CTR_DRBG).
+**
+**     Requests of up to SMALL_REQUEST_BYTES are served from a thread-local
+**     buffer of keystream, which is cleared as it is handed out.
+**
+**==============================================================================
+*/
 
 // The RDRAND generates 8-byte random value.
 #define RDRAND_BYTES 8
 
-oe_result_t oe_random_internal(void* data, size_t size)
+/* Draw a new key after this many bytes of keystream */
+#define KEYSTREAM_REKEY_BYTES (64 * 1024)
+
+#define SMALL_REQUEST_BYTES 32
+#define BUFFER_BYTES 128
+
+typedef long long v2di_t __attribute__((vector_size(16)));
+
+/* For unaligned stores, which memcpy() would turn into calls, as enclave
+ * code is built with -fno-builtin */
+typedef long long v2di_unaligned_t
+    __attribute__((vector_size(16), aligned(1), __may_alias__));
+
+static __thread uint8_t _buffer[BUFFER_BYTES];
+static __thread size_t _buffered;
+
+static void _rdrand_fill(void* data, size_t size)
 {
     for (size_t i = 0; i < size; i += RDRAND_BYTES)
     {
@@ -20,6 +59,123 @@ oe_result_t oe_random_internal(void* data, size_t size)
         uint64_t random_bytes = oe_rdrand();
         memcpy((void*)((uint8_t*)data + i), (void*)&random_bytes, request_size);
     }
+}
+
+static bool _has_aesni(void)
+{
+    static int _aesni = -1;
+    int aesni = __atomic_load_n(&_aesni, __ATOMIC_RELAXED);
+
+    if (aesni < 0)
+    {
+        uint64_t r[OE_CPUID_REG_COUNT] = {1, 0, 0, 0};
+
+        // The CPUID table is filled in when the enclave is initialized.
+        if (oe_emulate_cpuid(
+                &r[OE_CPUID_RAX],
+                &r[OE_CPUID_RBX],
+                &r[OE_CPUID_RCX],
+                &r[OE_CPUID_RDX]) != 0)
+            return false;
+
+        aesni = (r[OE_CPUID_RCX] & OE_CPUID_AESNI_FEATURE) != 0;
+        __atomic_store_n(&_aesni, aesni, __ATOMIC_RELAXED);
+    }
+
+    return aesni;
+}
+
+/* Write the keystream of ctr, ctr + 1, ... to data, four blocks at a time
+ * to keep the AES units busy */
+__attribute__((target("aes"))) static void _ctr_keystream(
+    const v2di_t rk[OE_AES_128_ROUNDS + 1],
+    v2di_t ctr,
+    uint8_t* data,
+    size_t size)
+{
+    v2di_t b[4];
+
+    while (size)
+    {
+        size_t n = size < sizeof(b) ? size : sizeof(b);
+
+        for (size_t j = 0; j < 4; j++)
+        {
+            b[j] = ctr ^ rk[0];
+            ctr[0]++;
+        }
+
+        for (size_t i = 1; i < OE_AES_128_ROUNDS; i++)
+        {
+            for (size_t j = 0; j < 4; j++)
+                b[j] = __builtin_ia32_aesenc128(b[j], rk[i]);
+        }
+
+        for (size_t j = 0; j < 4; j++)
+            b[j] = __builtin_ia32_aesenclast128(b[j], rk[OE_AES_128_ROUNDS]);
+
+        if (n == sizeof(b))
+        {
+            for (size_t j = 0; j < 4; j++)
+                ((v2di_unaligned_t*)data)[j] = b[j];
+        }
+        else
+            memcpy(data, b, n);
+
+        data += n;
+        size -= n;
+    }
+
+    oe_secure_zero_fill(b, sizeof(b));
+}
+
+static void _aesni_fill(uint8_t* data, size_t size)
+{
+    v2di_t rk[OE_AES_128_ROUNDS + 1];
+    v2di_t ctr;
+
+    while (size)
+    {
+        size_t n = size < KEYSTREAM_REKEY_BYTES ? size : KEYSTREAM_REKEY_BYTES;
+
+        rk[0] = (v2di_t){(long long)oe_rdrand(), (long long)oe_rdrand()};
+        ctr = (v2di_t){(long long)oe_rdrand(), (long long)oe_rdrand()};
+
+        oe_aesni_expand_key_128(rk);
+        _ctr_keystream(rk, ctr, data, n);
+
+        data += n;
+        size -= n;
+    }
+
+    oe_secure_zero_fill(rk, sizeof(rk));
+    oe_secure_zero_fill(&ctr, sizeof(ctr));
+}
+
+oe_result_t oe_random_internal(void* data, size_t size)
+{
+    if (!_has_aesni())
+    {
+        _rdrand_fill(data, size);
+        return OE_OK;
+    }
+
+    if (size > SMALL_REQUEST_BYTES)
+    {
+        _aesni_fill((uint8_t*)data, size);
+        return OE_OK;
+    }
+
+    if (_buffered < size)
+    {
+        _aesni_fill(_buffer, BUFFER_BYTES);
+        _buffered = BUFFER_BYTES;
+    }
+
+    // Hand out the end of the buffer and clear it.
+    _buffered -= size;
+    memcpy(data, _buffer + _buffered, size);
+    oe_secure_zero_fill(_buffer + _buffered, size);
 
     return OE_OK;
 }
@@ -12,6 +12,7 @@
 #include <openenclave/internal/report.h>
 #include <openenclave/internal/safecrt.h>
 #include <openenclave/internal/safemath.h>
+#include <openenclave/internal/thread.h>
 #include <openenclave/internal/utils.h>
 #include "sgx_t.h"
 
@@ -120,14 +121,89 @@ done:
     return result;
 }
 
-static oe_result_t _get_sgx_target_info(sgx_target_info_t* target_info)
+/*
+**==============================================================================
+**
+** Quoting Enclave (QE) information cache:
+**
+**     The QE target info and the size of the quotes that the QE produces are
+**     fetched from the host with a single ocall and cached, so that a remote
+**     report costs one EREPORT and one quote ocall. The cache is invalidated
+**     whenever the host fails to produce a quote, which is what happens when
+**     the QE changes (for example, after a platform software update) and the
+**     cached target info no longer matches it.
+**
+**==============================================================================
+*/
+
+static struct
 {
+    oe_spinlock_t lock;
+    bool valid;
+    sgx_target_info_t target_info;
+    size_t quote_size;
+} _qe_info = {OE_SPINLOCK_INITIALIZER};
+
+static oe_result_t _get_qe_info(
+    sgx_target_info_t* target_info,
+    size_t* quote_size)
+{
+    oe_result_t result = OE_UNEXPECTED;
     uint32_t retval;
+    bool valid;
+
+    oe_spin_lock(&_qe_info.lock);
+    {
+        valid = _qe_info.valid;
+
+        if (valid)
+        {
+            *target_info = _qe_info.target_info;
+            *quote_size = _qe_info.quote_size;
+        }
+    }
+    oe_spin_unlock(&_qe_info.lock);
 
-    if (oe_get_qetarget_info_ocall(&retval, target_info) != OE_OK)
-        return OE_FAILURE;
+    if (valid)
+    {
+        result = OE_OK;
+        goto done;
+    }
 
-    return (oe_result_t)retval;
+    /*
+     * OCall: Get target info and quote size from Quoting Enclave.
+     * This involves a call to host. The target provided by targetinfo does not
+     * need to be trusted because returning a report is not an operation that
+     * requires privacy. The trust decision is one of integrity verification
+     * on the part of the report recipient.
+     */
+    if (oe_get_qetarget_info_ocall(&retval, target_info, quote_size) != OE_OK)
+        OE_RAISE(OE_FAILURE);
+
+    OE_CHECK((oe_result_t)retval);
+
+    if (*quote_size < sizeof(sgx_quote_t) || *quote_size > OE_MAX_REPORT_SIZE)
+        OE_RAISE(OE_UNEXPECTED);
+
+    oe_spin_lock(&_qe_info.lock);
+    {
+        _qe_info.target_info = *target_info;
+        _qe_info.quote_size = *quote_size;
+        _qe_info.valid = true;
+    }
+    oe_spin_unlock(&_qe_info.lock);
+
+    result = OE_OK;
+
+done:
+    return result;
+}
+
+static void _invalidate_qe_info(void)
+{
+    oe_spin_lock(&_qe_info.lock);
+    _qe_info.valid = false;
+    oe_spin_unlock(&_qe_info.lock);
 }
 
 static oe_result_t _get_quote(
@@ -166,40 +242,57 @@ oe_result_t oe_get_remote_report(
     sgx_report_t sgx_report = {{{0}}};
     size_t sgx_report_size = sizeof(sgx_report);
     sgx_quote_t* sgx_quote = NULL;
+    size_t quote_size = 0;
 
     // For remote attestation, the Quoting Enclave's target info is used.
     // opt_params must not be supplied.
     if (opt_params != NULL || opt_params_size != 0)
         OE_RAISE(OE_INVALID_PARAMETER);
 
-    /*
-     * OCall: Get target info from Quoting Enclave.
-     * This involves a call to host. The target provided by targetinfo does not
-     * need to be trusted because returning a report is not an operation that
-     * requires privacy. The trust decision is one of integrity verification
-     * on the part of the report recipient.
-     */
-    OE_CHECK(_get_sgx_target_info(&sgx_target_info));
+    if (report_buffer_size == NULL)
+        OE_RAISE(OE_INVALID_PARAMETER);
 
-    /*
-     * Get enclave's local report passing in the quoting enclave's target info.
-     */
-    OE_CHECK(_get_local_report(
-        report_data,
-        report_data_size,
-        &sgx_target_info,
-        sizeof(sgx_target_info),
-        &sgx_report,
-        &sgx_report_size));
+    // Retry once with fresh QE information if the cached one is stale.
+    for (size_t attempt = 0;; attempt++)
+    {
+        OE_CHECK(_get_qe_info(&sgx_target_info, &quote_size));
 
-    /*
-     * OCall: Get the quote for the local report.
-     */
-    result = _get_quote(&sgx_report, report_buffer, report_buffer_size);
-    if (result == OE_BUFFER_TOO_SMALL)
-        OE_CHECK_NO_TRACE(result);
-    else
-        OE_CHECK(result);
+        // Size the buffer without asking the host for a quote.
+        if (report_buffer == NULL || *report_buffer_size < quote_size)
+        {
+            *report_buffer_size = quote_size;
+            OE_RAISE_NO_TRACE(OE_BUFFER_TOO_SMALL);
+        }
+
+        /*
+         * Get enclave's local report passing in the quoting enclave's target
+         * info.
+         */
+        OE_CHECK(_get_local_report(
+            report_data,
+            report_data_size,
+            &sgx_target_info,
+            sizeof(sgx_target_info),
+            &sgx_report,
+            &sgx_report_size));
+
+        /*
+         * OCall: Get the quote for the local report.
+         */
+        result = _get_quote(&sgx_report, report_buffer, report_buffer_size);
+
+        if (result == OE_OK)
+            break;
+
+        _invalidate_qe_info();
+
+        // The caller must retry with the larger size returned by the host.
+        if (result == OE_BUFFER_TOO_SMALL)
+            OE_CHECK_NO_TRACE(result);
+
+        if (attempt > 0)
+            OE_CHECK(result);
+    }
 
     /*
      * Check that the entire report body in the returned quote matches the local
@@ -318,40 +411,55 @@ oe_result_t oe_get_report_v2(
     *report_buffer = NULL;
     *report_buffer_size = 0;
 
-    result = _oe_get_report_internal(
-        flags,
-        report_data,
-        report_data_size,
-        opt_params,
-        opt_params_size,
-        NULL,
-        &tmp_buffer_size);
-    if (result != OE_BUFFER_TOO_SMALL)
+    /* The size probe costs no ocalls once the QE information is cached, and
+     * the report (and quote) is then generated in a single pass. The probe
+     * is repeated only if the quote size changed in between. */
+    for (size_t attempt = 0;; attempt++)
     {
-        result = (result == OE_OK) ? OE_UNEXPECTED : result;
-        OE_RAISE(result);
-    }
+        result = _oe_get_report_internal(
+            flags,
+            report_data,
+            report_data_size,
+            opt_params,
+            opt_params_size,
+            NULL,
+            &tmp_buffer_size);
+        if (result != OE_BUFFER_TOO_SMALL)
+        {
+            result = (result == OE_OK) ? OE_UNEXPECTED : result;
+            OE_RAISE(result);
+        }
 
-    tmp_buffer = oe_calloc(1, tmp_buffer_size);
-    if (tmp_buffer == NULL)
-    {
-        return OE_OUT_OF_MEMORY;
+        tmp_buffer = oe_calloc(1, tmp_buffer_size);
+        if (tmp_buffer == NULL)
+        {
+            return OE_OUT_OF_MEMORY;
+        }
+
+        out_buffer_size = tmp_buffer_size;
+        result = _oe_get_report_internal(
+            flags,
+            report_data,
+            report_data_size,
+            opt_params,
+            opt_params_size,
+            tmp_buffer,
+            &out_buffer_size);
+
+        if (result != OE_BUFFER_TOO_SMALL || attempt > 0)
+            break;
+
+        oe_free(tmp_buffer);
+        tmp_buffer = NULL;
     }
 
-    out_buffer_size = tmp_buffer_size;
-    OE_CHECK(_oe_get_report_internal(
-        flags,
-        report_data,
-        report_data_size,
-        opt_params,
-        opt_params_size,
-        tmp_buffer,
-        &out_buffer_size));
+    OE_CHECK(result);
 
-    if (out_buffer_size != tmp_buffer_size)
+    /* The quote may be smaller than the buffer sized for it */
+    if (out_buffer_size > tmp_buffer_size)
         OE_RAISE(OE_UNEXPECTED);
 
-    *report_buffer_size = tmp_buffer_size;
+    *report_buffer_size = out_buffer_size;
     *report_buffer = tmp_buffer;
     tmp_buffer = NULL;
 
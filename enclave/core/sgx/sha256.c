@@ -0,0 +1,281 @@
+// Copyright (c) Open Enclave SDK contributors.
+// Licensed under the MIT License.
+
+#include <openenclave/enclave.h>
+#include <openenclave/internal/cpuid.h>
+#include <openenclave/internal/sha256.h>
+#include "cpuid.h"
+
+/*
+**==============================================================================
+**
+** SHA-256 compression:
+**
+**     mbedTLS hands every 64-byte block to oe_sha256_compress()
+**     (MBEDTLS_SHA256_PROCESS_ALT), so all SHA-256 in the enclave, from
+**     oe_sha256_update() to certificate, quote and TLS hashing, uses it.
+**
+**     On CPUs with the SHA extensions, SHA256RNDS2 performs two rounds and
+**     SHA256MSG1/SHA256MSG2 the message schedule, with the state kept in
+**     two registers as ABEF and CDGH. This is about six times as fast as
+**     the portable implementation, which other CPUs use.
+**
+**==============================================================================
+*/
+
+#define SHA256_BLOCK_SIZE 64
+
+static const OE_ALIGNED(16) uint32_t _k[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1,
+    0x923f82a4, 0xab1c5ed5, 0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3,
+    0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174, 0xe49b69c1, 0xefbe4786,
+    0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147,
+    0x06ca6351, 0x14292967, 0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13,
+    0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85, 0xa2bfe8a1, 0xa81a664b,
+    0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a,
+    0x5b9cca4f, 0x682e6ff3, 0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208,
+    0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2};
+
+/* -1 until the CPUID table has been checked, then 0 or 1 */
+static int _use_sha_ni = -1;
+
+/*
+**==============================================================================
+**
+** Portable implementation (FIPS 180-4)
+**
+**==============================================================================
+*/
+
+OE_INLINE uint32_t _rotr(uint32_t x, unsigned int n)
+{
+    return (x >> n) | (x << (32 - n));
+}
+
+OE_INLINE uint32_t _load_be32(const uint8_t* p)
+{
+    return (uint32_t)p[0] << 24 | (uint32_t)p[1] << 16 | (uint32_t)p[2] << 8 |
+           (uint32_t)p[3];
+}
+
+static void _compress_portable(
+    uint32_t state[8],
+    const uint8_t* data,
+    size_t blocks)
+{
+    for (; blocks; blocks--, data += SHA256_BLOCK_SIZE)
+    {
+        uint32_t w[64];
+        uint32_t a = state[0];
+        uint32_t b = state[1];
+        uint32_t c = state[2];
+        uint32_t d = state[3];
+        uint32_t e = state[4];
+        uint32_t f = state[5];
+        uint32_t g = state[6];
+        uint32_t h = state[7];
+
+        for (size_t i = 0; i < 16; i++)
+            w[i] = _load_be32(data + 4 * i);
+
+        for (size_t i = 16; i < 64; i++)
+        {
+            uint32_t s0 = _rotr(w[i - 15], 7) ^ _rotr(w[i - 15], 18) ^
+                          (w[i - 15] >> 3);
+            uint32_t s1 = _rotr(w[i - 2], 17) ^ _rotr(w[i - 2], 19) ^
+                          (w[i - 2] >> 10);
+            w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+        }
+
+        for (size_t i = 0; i < 64; i++)
+        {
+            uint32_t s1 = _rotr(e, 6) ^ _rotr(e, 11) ^ _rotr(e, 25);
+            uint32_t ch = (e & f) ^ (~e & g);
+            uint32_t t1 = h + s1 + ch + _k[i] + w[i];
+            uint32_t s0 = _rotr(a, 2) ^ _rotr(a, 13) ^ _rotr(a, 22);
+            uint32_t maj = (a & b) ^ (a & c) ^ (b & c);
+            uint32_t t2 = s0 + maj;
+
+            h = g;
+            g = f;
+            f = e;
+            e = d + t1;
+            d = c;
+            c = b;
+            b = a;
+            a = t1 + t2;
+        }
+
+        state[0] += a;
+        state[1] += b;
+        state[2] += c;
+        state[3] += d;
+        state[4] += e;
+        state[5] += f;
+        state[6] += g;
+        state[7] += h;
+    }
+}
+
+/*
+**==============================================================================
+**
+** SHA extensions
+**
+**==============================================================================
+*/
+
+typedef int v4si_t __attribute__((vector_size(16)));
+typedef unsigned int v4su_t __attribute__((vector_size(16)));
+typedef char v16qi_t __attribute__((vector_size(16)));
+
+/* For unaligned loads, which memcpy() would turn into calls, as enclave code
+ * is built with -fno-builtin */
+typedef unsigned int v4su_unaligned_t
+    __attribute__((vector_size(16), aligned(1), __may_alias__));
+
+#define SHA_NI_TARGET __attribute__((target("sha,ssse3")))
+
+/* PSHUFB mask that converts four big-endian words to native order */
+#define BSWAP32_MASK \
+    (v16qi_t){3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12}
+
+SHA_NI_TARGET OE_INLINE v4su_t _load_words(const uint8_t* p)
+{
+    v4su_t x = *(const v4su_unaligned_t*)p;
+    return (v4su_t)__builtin_ia32_pshufb128((v16qi_t)x, BSWAP32_MASK);
+}
+
+/* Rounds 4 * I to 4 * I + 3 on the message words M */
+#define ROUNDS(I, M)                                   \
+    wk = M + ((const v4su_t*)_k)[I];                   \
+    cdgh = (v4su_t)__builtin_ia32_sha256rnds2(         \
+        (v4si_t)cdgh, (v4si_t)abef, (v4si_t)wk);       \
+    abef = (v4su_t)__builtin_ia32_sha256rnds2(         \
+        (v4si_t)abef,                                  \
+        (v4si_t)cdgh,                                  \
+        __builtin_ia32_pshufd((v4si_t)wk, 0x0e))
+
+#define MSG1(M0, M1) \
+    M0 = (v4su_t)__builtin_ia32_sha256msg1((v4si_t)M0, (v4si_t)M1)
+
+/* Schedule the message words of rounds 4 * I to 4 * I + 3, for I >= 4, into
+ * M0 from M0 = SHA256MSG1 of the words of round group I - 4 and I - 3, and
+ * the words M2 and M3 of round groups I - 2 and I - 1. Then apply
+ * SHA256MSG1 to M2 and M3, which M2 is next used with in round group I + 2.
+ */
+#define STEP(I, M0, M2, M3)                                     \
+    M0 = (v4su_t)__builtin_ia32_sha256msg2(                     \
+        (v4si_t)(M0 + (v4su_t){M2[1], M2[2], M2[3], M3[0]}),    \
+        (v4si_t)M3);                                            \
+    ROUNDS(I, M0);                                              \
+    if (I < 14)                                                 \
+        MSG1(M2, M3)
+
+SHA_NI_TARGET static void _compress_sha_ni(
+    uint32_t state[8],
+    const uint8_t* data,
+    size_t blocks)
+{
+    v4su_t abef = {state[5], state[4], state[1], state[0]};
+    v4su_t cdgh = {state[7], state[6], state[3], state[2]};
+
+    for (; blocks; blocks--, data += SHA256_BLOCK_SIZE)
+    {
+        const v4su_t abef_save = abef;
+        const v4su_t cdgh_save = cdgh;
+        v4su_t m0, m1, m2, m3, wk;
+
+        m0 = _load_words(data);
+        ROUNDS(0, m0);
+        m1 = _load_words(data + 16);
+        ROUNDS(1, m1);
+        MSG1(m0, m1);
+        m2 = _load_words(data + 32);
+        ROUNDS(2, m2);
+        MSG1(m1, m2);
+        m3 = _load_words(data + 48);
+        ROUNDS(3, m3);
+
+        STEP(4, m0, m2, m3);
+        STEP(5, m1, m3, m0);
+        STEP(6, m2, m0, m1);
+        STEP(7, m3, m1, m2);
+        STEP(8, m0, m2, m3);
+        STEP(9, m1, m3, m0);
+        STEP(10, m2, m0, m1);
+        STEP(11, m3, m1, m2);
+        STEP(12, m0, m2, m3);
+        STEP(13, m1, m3, m0);
+        STEP(14, m2, m0, m1);
+        STEP(15, m3, m1, m2);
+
+        abef += abef_save;
+        cdgh += cdgh_save;
+    }
+
+    state[0] = abef[3];
+    state[1] = abef[2];
+    state[2] = cdgh[3];
+    state[3] = cdgh[2];
+    state[4] = abef[1];
+    state[5] = abef[0];
+    state[6] = cdgh[1];
+    state[7] = cdgh[0];
+}
+
+#undef ROUNDS
+#undef MSG1
+#undef STEP
+
+static bool _has_sha_ni(void)
+{
+    uint64_t leaf1[OE_CPUID_REG_COUNT] = {1, 0, 0, 0};
+    uint64_t leaf7[OE_CPUID_REG_COUNT] = {7, 0, 0, 0};
+
+    // The CPUID table is filled in when the enclave is initialized.
+    if (oe_emulate_cpuid(
+            &leaf1[OE_CPUID_RAX],
+            &leaf1[OE_CPUID_RBX],
+            &leaf1[OE_CPUID_RCX],
+            &leaf1[OE_CPUID_RDX]) != 0 ||
+        oe_emulate_cpuid(
+            &leaf7[OE_CPUID_RAX],
+            &leaf7[OE_CPUID_RBX],
+            &leaf7[OE_CPUID_RCX],
+            &leaf7[OE_CPUID_RDX]) != 0)
+        return false;
+
+    return (leaf1[OE_CPUID_RCX] & OE_CPUID_SSSE3_FEATURE) &&
+           (leaf7[OE_CPUID_RBX] & OE_CPUID_SHA_FEATURE);
+}
+
+static bool _sha_ni_enabled(void)
+{
+    int use = __atomic_load_n(&_use_sha_ni, __ATOMIC_RELAXED);
+
+    if (use < 0)
+    {
+        use = _has_sha_ni();
+        __atomic_store_n(&_use_sha_ni, use, __ATOMIC_RELAXED);
+    }
+
+    return use;
+}
+
+void oe_sha256_compress(uint32_t state[8], const uint8_t* data, size_t blocks)
+{
+    if (_sha_ni_enabled())
+        _compress_sha_ni(state, data, blocks);
+    else
+        _compress_portable(state, data, blocks);
+}
+
+bool oe_sha256_set_hardware_enabled(bool enabled)
+{
+    int use = enabled && _has_sha_ni();
+    __atomic_store_n(&_use_sha_ni, use, __ATOMIC_RELAXED);
+    return use;
+}
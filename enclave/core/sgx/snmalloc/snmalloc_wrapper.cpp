@@ -113,6 +113,31 @@ extern "C" void oe_set_allocation_failure_callback(
     (void)function;
 }
 
+// snmalloc already allocates from per-thread allocators.
+extern "C" oe_result_t oe_set_malloc_thread_cache_enabled(bool enabled)
+{
+    (void)enabled;
+    return OE_UNSUPPORTED;
+}
+
+// The heap profiler hooks into the dlmalloc front end only.
+extern "C" oe_result_t oe_heap_profiler_start(uint64_t sampling_rate)
+{
+    (void)sampling_rate;
+    return OE_UNSUPPORTED;
+}
+
+extern "C" oe_result_t oe_heap_profiler_stop()
+{
+    return OE_UNSUPPORTED;
+}
+
+extern "C" oe_result_t oe_heap_profiler_dump(const char* name)
+{
+    (void)name;
+    return OE_UNSUPPORTED;
+}
+
 extern "C" void oe_memalign_free(void* ptr)
 {
     oe_free(ptr);
@@ -18,12 +18,14 @@
 #include <openenclave/internal/print.h>
 #include <openenclave/internal/raise.h>
 #include <openenclave/internal/safecrt.h>
+#include <openenclave/internal/safemath.h>
 #include <openenclave/internal/trace.h>
 #include <openenclave/internal/utils.h>
 #include <string.h>
 #include "crl.h"
 #include "ctr_drbg.h"
 #include "ec.h"
+#include "p256.h"
 #include "pem.h"
 #include "rsa.h"
 
@@ -47,6 +49,10 @@ typedef struct _referent
     /* The length of the certificate chain */
     size_t length;
 
+    /* The issuer of each certificate, found when the signatures of the chain
+     * were verified on reading it (NULL for the root) */
+    mbedtls_x509_crt** issuers;
+
     /* Reference count */
     volatile uint64_t refs;
 } Referent;
@@ -106,6 +112,7 @@ OE_INLINE void _referent_free(Referent* referent)
         /* Release the MBEDTLS certificate */
         mbedtls_x509_crt_free(referent->crt);
         mbedtls_free(referent->crt);
+        mbedtls_free(referent->issuers);
 
         /* Free the referent structure */
         memset(referent, 0, sizeof(Referent));
@@ -223,6 +230,72 @@ static bool _x509_buf_equal(
            memcmp(x->p, y->p, x->len) == 0;
 }
 
+/* Whether two byte strings are equal, ignoring the case of ASCII letters */
+static bool _x509_memcaseeq(const uint8_t* s1, const uint8_t* s2, size_t len)
+{
+    for (size_t i = 0; i < len; i++)
+    {
+        const uint8_t diff = s1[i] ^ s2[i];
+
+        if (diff == 0)
+            continue;
+
+        if (diff == 32 && ((s1[i] >= 'a' && s1[i] <= 'z') ||
+                           (s1[i] >= 'A' && s1[i] <= 'Z')))
+            continue;
+
+        return false;
+    }
+
+    return true;
+}
+
+static bool _x509_is_case_insensitive_string(int tag)
+{
+    return tag == MBEDTLS_ASN1_UTF8_STRING ||
+           tag == MBEDTLS_ASN1_PRINTABLE_STRING;
+}
+
+/* Whether two attribute values of X.509 names are equal. As in mbedtls,
+ * UTF8String and PrintableString values may differ in tag and case. */
+static bool _x509_string_equal(
+    const mbedtls_x509_buf* x,
+    const mbedtls_x509_buf* y)
+{
+    if (_x509_buf_equal(x, y))
+        return true;
+
+    return _x509_is_case_insensitive_string(x->tag) &&
+           _x509_is_case_insensitive_string(y->tag) && x->len == y->len &&
+           _x509_memcaseeq(x->p, y->p, x->len);
+}
+
+/* Whether two X.509 names are equal, as x509_name_cmp() of mbedtls decides
+ * when it matches a certificate or CRL to its issuer */
+static bool _x509_name_equal(
+    const mbedtls_x509_name* x,
+    const mbedtls_x509_name* y)
+{
+    while (x || y)
+    {
+        if (!x || !y)
+            return false;
+
+        if (!_x509_buf_equal(&x->oid, &y->oid) ||
+            !_x509_string_equal(&x->val, &y->val))
+            return false;
+
+        /* The names must also group their attributes into the same RDNs */
+        if (x->next_merged != y->next_merged)
+            return false;
+
+        x = x->next;
+        y = y->next;
+    }
+
+    return true;
+}
+
 // Find the last certificate in the chain and then verify that it's a
 // self-signed certificate (a root certificate).
 static mbedtls_x509_crt* _find_root_cert(mbedtls_x509_crt* chain)
@@ -243,20 +316,6 @@ static mbedtls_x509_crt* _find_root_cert(mbedtls_x509_crt* chain)
     return p;
 }
 
-/* Return true if the CRL list contains a CRL for this CA. */
-static mbedtls_x509_crl* _crl_list_find_issuer_for_cert(
-    mbedtls_x509_crl* crl_list,
-    mbedtls_x509_crt* crt)
-{
-    for (mbedtls_x509_crl* p = crl_list; p; p = p->next)
-    {
-        if (_x509_buf_equal(&p->issuer_raw, &crt->subject_raw))
-            return p;
-    }
-    OE_TRACE_ERROR("CRL list does not contains a CRL for this CA\n");
-    return NULL;
-}
-
 /**
  * Return true is time t1 is chronologically before or at time t2.
  */
@@ -326,25 +385,58 @@ static mbedtls_x509_crt* _sort_certs_by_issue_date(mbedtls_x509_crt* chain)
     return sorted;
 }
 
-/* Call mbedlts_x509_crt_verify and handle error logging */
+/* Map the flags of a failed verification to the result reported for it */
+static oe_result_t _verify_flags_to_result(uint32_t flags)
+{
+    if (flags & MBEDTLS_X509_BADCERT_REVOKED)
+        return OE_VERIFY_REVOKED;
+
+    if (flags & MBEDTLS_X509_BADCRL_EXPIRED)
+        return OE_VERIFY_CRL_EXPIRED;
+
+    return OE_VERIFY_FAILED;
+}
+
+/* Record the certificate at depth 1, the issuer of the verified one */
+static int _record_issuer(
+    void* issuer,
+    mbedtls_x509_crt* crt,
+    int depth,
+    uint32_t* flags)
+{
+    OE_UNUSED(flags);
+
+    if (depth == 1)
+        *(mbedtls_x509_crt**)issuer = crt;
+
+    return 0;
+}
+
+/* Call mbedlts_x509_crt_verify and handle error logging. Also return the
+ * issuer the certificate was verified with */
 static oe_result_t _mbedtls_x509_crt_verify(
     mbedtls_x509_crt* leaf_cert,
     mbedtls_x509_crt* ca_cert_chain,
-    mbedtls_x509_crl* ca_crls)
+    mbedtls_x509_crl* ca_crls,
+    mbedtls_x509_crt** issuer)
 {
     oe_result_t result = OE_UNEXPECTED;
     uint32_t flags = 0;
+
+    *issuer = NULL;
+
     if (mbedtls_x509_crt_verify(
-            leaf_cert, ca_cert_chain, ca_crls, NULL, &flags, NULL, NULL) != 0)
+            leaf_cert,
+            ca_cert_chain,
+            ca_crls,
+            NULL,
+            &flags,
+            _record_issuer,
+            issuer) != 0)
     {
         char error[1024] = {0};
         mbedtls_x509_crt_verify_info(error, sizeof(error), "", flags);
-        if (flags & MBEDTLS_X509_BADCERT_REVOKED)
-            result = OE_VERIFY_REVOKED;
-        else if (flags & MBEDTLS_X509_BADCRL_EXPIRED)
-            result = OE_VERIFY_CRL_EXPIRED;
-        else
-            result = OE_VERIFY_FAILED;
+        result = _verify_flags_to_result(flags);
 
         OE_RAISE_MSG(
             result,
@@ -359,11 +451,15 @@ done:
     return result;
 }
 
-/* Verify each certificate in the chain against its predecessors. */
-static oe_result_t _verify_whole_chain(mbedtls_x509_crt* chain)
+/* Verify each certificate in the chain against its predecessors, and store
+ * the issuer of each certificate in issuers. */
+static oe_result_t _verify_whole_chain(
+    mbedtls_x509_crt* chain,
+    mbedtls_x509_crt** issuers)
 {
     oe_result_t result = OE_UNEXPECTED;
     mbedtls_x509_crt* root;
+    size_t i = 0;
 
     if (!chain)
         OE_RAISE(OE_INVALID_PARAMETER);
@@ -374,13 +470,13 @@ static oe_result_t _verify_whole_chain(mbedtls_x509_crt* chain)
 
     // Verify each certificate in the chain against the following subchain.
     // For each i, verify chain[i] against chain[i+1:...].
-    for (mbedtls_x509_crt* p = chain; p && p->next; p = p->next)
+    for (mbedtls_x509_crt* p = chain; p && p->next; p = p->next, i++)
     {
         /* Pointer to subchain of certificates (predecessors) */
         mbedtls_x509_crt* subchain = p->next;
 
         /* Verify the next certificate against its following predecessors */
-        OE_CHECK(_mbedtls_x509_crt_verify(p, subchain, NULL));
+        OE_CHECK(_mbedtls_x509_crt_verify(p, subchain, NULL, &issuers[i]));
 
         /* If the final certificate is not the root */
         if (subchain->next == NULL && root != subchain)
@@ -395,6 +491,519 @@ done:
     return result;
 }
 
+/*
+**==============================================================================
+**
+** Single-pass chain verification:
+**
+**     oe_cert_verify() checks a certificate and every certificate of its
+**     chain, each with the CRLs of its issuer. Verifying each of them with
+**     mbedtls_x509_crt_verify() repeats the signature checks of the shared
+**     links and CRLs, and needs copies of the CRLs linked into a list.
+**     Instead, the issuer of each certificate is found once, the signature
+**     of each link and of each CRL is verified exactly once, and the CRLs are
+**     indexed by the chain certificate that issued them, without copying
+**     them or touching their list pointers.
+**
+**     The checks are those of mbedtls_x509_crt_verify() with the default
+**     profile and the chain as its trusted certificates: a self-issued chain
+**     certificate is a root, and the path of any other certificate ends at
+**     its issuer. As in mbedtls, names are compared with x509_name_cmp()
+**     semantics, the issuer is the first chain certificate that signed the
+**     certificate and is valid now (or else the first that signed it), and
+**     a CRL applies to every issuer with its issuer name.
+**
+**     The single pass only establishes that a certificate is valid. A
+**     certificate it rejects is verified again with
+**     mbedtls_x509_crt_verify(), so that failures report mbedtls's own flags
+**     and result.
+**
+**==============================================================================
+*/
+
+#define NO_CRL SIZE_MAX
+
+typedef struct _chain_node
+{
+    mbedtls_x509_crt* crt;
+
+    /* A self-issued certificate of the chain, or one equal to such */
+    bool trusted;
+
+    /* The issuer whose signature was verified when the chain was read */
+    const mbedtls_x509_crt* verified_issuer;
+
+    /* Index of the first chain node with the same subject name. The CRLs
+     * of all nodes with that name are indexed by it. */
+    size_t name_group;
+
+    /* Index of the first CRL whose issuer name is this node's subject name,
+     * when the node is the first of its name group, or NO_CRL */
+    size_t first_crl;
+
+    /* Whether one of the CRLs has exactly this node's subject as issuer */
+    bool has_crl;
+} ChainNode;
+
+typedef struct _chain_crl
+{
+    const mbedtls_x509_crl* crl;
+
+    /* Index of the next CRL with the same issuer name, or NO_CRL */
+    size_t next;
+
+    /* The issuer the CRL itself was last checked with, the resulting flags,
+     * and whether it can be used to check revocation */
+    const mbedtls_x509_crt* checked_with;
+    uint32_t flags;
+    bool usable;
+} ChainCrl;
+
+static bool _profile_allows_md(mbedtls_md_type_t md)
+{
+    const mbedtls_x509_crt_profile* profile = &mbedtls_x509_crt_profile_default;
+
+    return md != MBEDTLS_MD_NONE &&
+           (profile->allowed_mds & MBEDTLS_X509_ID_FLAG(md)) != 0;
+}
+
+static bool _profile_allows_pk(mbedtls_pk_type_t pk)
+{
+    const mbedtls_x509_crt_profile* profile = &mbedtls_x509_crt_profile_default;
+
+    return pk != MBEDTLS_PK_NONE &&
+           (profile->allowed_pks & MBEDTLS_X509_ID_FLAG(pk)) != 0;
+}
+
+static bool _profile_allows_key(const mbedtls_pk_context* pk)
+{
+    const mbedtls_x509_crt_profile* profile = &mbedtls_x509_crt_profile_default;
+    const mbedtls_pk_type_t type = mbedtls_pk_get_type(pk);
+
+    if (type == MBEDTLS_PK_RSA || type == MBEDTLS_PK_RSASSA_PSS)
+        return mbedtls_pk_get_bitlen(pk) >= profile->rsa_min_bitlen;
+
+    if (type == MBEDTLS_PK_ECDSA || type == MBEDTLS_PK_ECKEY ||
+        type == MBEDTLS_PK_ECKEY_DH)
+    {
+        const mbedtls_ecp_group_id id = mbedtls_pk_ec(*pk)->grp.id;
+
+        return id != MBEDTLS_ECP_DP_NONE &&
+               (profile->allowed_curves & MBEDTLS_X509_ID_FLAG(id)) != 0;
+    }
+
+    return false;
+}
+
+/* Verify the signature of a certificate or CRL with the issuer's key */
+static bool _verify_signed_data(
+    mbedtls_pk_context* issuer_key,
+    const mbedtls_x509_buf* tbs,
+    mbedtls_md_type_t sig_md,
+    mbedtls_pk_type_t sig_pk,
+    const void* sig_opts,
+    const mbedtls_x509_buf* sig)
+{
+    uint8_t hash[MBEDTLS_MD_MAX_SIZE];
+    const mbedtls_md_info_t* md_info = mbedtls_md_info_from_type(sig_md);
+
+    if (!md_info || mbedtls_md(md_info, tbs->p, tbs->len, hash) != 0)
+        return false;
+
+    if (!mbedtls_pk_can_do(issuer_key, sig_pk))
+        return false;
+
+    /* Most chains, like the Intel PCK certificate chain, use P-256 keys */
+    if (sig_pk == MBEDTLS_PK_ECDSA)
+    {
+        oe_result_t result = oe_p256_verify(
+            issuer_key,
+            hash,
+            mbedtls_md_get_size(md_info),
+            sig->p,
+            sig->len);
+
+        if (result == OE_OK || result == OE_VERIFY_FAILED)
+            return result == OE_OK;
+    }
+
+    return mbedtls_pk_verify_ext(
+               sig_pk,
+               sig_opts,
+               issuer_key,
+               sig_md,
+               hash,
+               mbedtls_md_get_size(md_info),
+               sig->p,
+               sig->len) == 0;
+}
+
+/* Whether a trusted certificate may issue the child certificate */
+static bool _can_issue(const mbedtls_x509_crt* child, mbedtls_x509_crt* issuer)
+{
+    if (!_x509_name_equal(&child->issuer, &issuer->subject))
+        return false;
+
+    /* Trusted v1 and v2 certificates need not be CA certificates */
+    if (issuer->version < 3)
+        return true;
+
+    return issuer->ca_istrue &&
+           mbedtls_x509_crt_check_key_usage(
+               issuer, MBEDTLS_X509_KU_KEY_CERT_SIGN) == 0;
+}
+
+static uint32_t _check_validity(const mbedtls_x509_crt* crt)
+{
+    uint32_t flags = 0;
+
+    if (mbedtls_x509_time_is_past(&crt->valid_to))
+        flags |= MBEDTLS_X509_BADCERT_EXPIRED;
+
+    if (mbedtls_x509_time_is_future(&crt->valid_from))
+        flags |= MBEDTLS_X509_BADCERT_FUTURE;
+
+    return flags;
+}
+
+/* The checks of a certificate that do not involve its issuer */
+static uint32_t _check_cert(const mbedtls_x509_crt* crt)
+{
+    uint32_t flags = _check_validity(crt);
+
+    if (!_profile_allows_md(crt->sig_md))
+        flags |= MBEDTLS_X509_BADCERT_BAD_MD;
+
+    if (!_profile_allows_pk(crt->sig_pk) ||
+        !_profile_allows_pk(mbedtls_pk_get_type(&crt->pk)))
+        flags |= MBEDTLS_X509_BADCERT_BAD_PK;
+
+    if (!_profile_allows_key(&crt->pk))
+        flags |= MBEDTLS_X509_BADCERT_BAD_KEY;
+
+    return flags;
+}
+
+/* The checks of a CRL itself, done once for all certificates of its issuer */
+static void _check_crl(ChainCrl* entry, mbedtls_x509_crt* issuer)
+{
+    const mbedtls_x509_crl* crl = entry->crl;
+
+    entry->checked_with = issuer;
+    entry->flags = 0;
+    entry->usable = false;
+
+    if (mbedtls_x509_crt_check_key_usage(issuer, MBEDTLS_X509_KU_CRL_SIGN))
+    {
+        entry->flags |= MBEDTLS_X509_BADCRL_NOT_TRUSTED;
+        return;
+    }
+
+    if (!_profile_allows_md(crl->sig_md))
+        entry->flags |= MBEDTLS_X509_BADCRL_BAD_MD;
+
+    if (!_profile_allows_pk(crl->sig_pk))
+        entry->flags |= MBEDTLS_X509_BADCRL_BAD_PK;
+
+    if (!_profile_allows_key(&issuer->pk))
+        entry->flags |= MBEDTLS_X509_BADCERT_BAD_KEY;
+
+    if (!_verify_signed_data(
+            &issuer->pk,
+            &crl->tbs,
+            crl->sig_md,
+            crl->sig_pk,
+            crl->sig_opts,
+            &crl->sig))
+    {
+        entry->flags |= MBEDTLS_X509_BADCRL_NOT_TRUSTED;
+        return;
+    }
+
+    if (mbedtls_x509_time_is_past(&crl->next_update))
+        entry->flags |= MBEDTLS_X509_BADCRL_EXPIRED;
+
+    if (mbedtls_x509_time_is_future(&crl->this_update))
+        entry->flags |= MBEDTLS_X509_BADCRL_FUTURE;
+
+    entry->usable = true;
+}
+
+/* Check a certificate against the CRLs with the name of its issuer. A CRL
+ * is checked again only if another issuer of that name uses it. */
+static uint32_t _check_revocation(
+    const mbedtls_x509_crt* crt,
+    const ChainNode* issuer,
+    const ChainNode* chain_nodes,
+    ChainCrl* crls)
+{
+    uint32_t flags = 0;
+    size_t first = chain_nodes[issuer->name_group].first_crl;
+
+    for (size_t i = first; i != NO_CRL; i = crls[i].next)
+    {
+        ChainCrl* entry = &crls[i];
+
+        if (entry->checked_with != issuer->crt)
+            _check_crl(entry, issuer->crt);
+
+        flags |= entry->flags;
+
+        if (!entry->usable)
+            break;
+
+        if (mbedtls_x509_crt_is_revoked(crt, entry->crl))
+        {
+            flags |= MBEDTLS_X509_BADCERT_REVOKED;
+            break;
+        }
+    }
+
+    return flags;
+}
+
+/* Find the issuer of an untrusted certificate among the chain nodes as
+ * mbedtls does among trusted certificates: the first one that signed it and
+ * is valid now, or else the first one that signed it. The signature of the
+ * issuer recorded when the chain was read is not verified again. */
+static uint32_t _check_issuer(
+    const ChainNode* node,
+    ChainNode* chain_nodes,
+    size_t chain_length,
+    ChainCrl* crls)
+{
+    const mbedtls_x509_crt* crt = node->crt;
+    const ChainNode* issuer = NULL;
+    const ChainNode* fallback = NULL;
+    uint32_t flags = 0;
+
+    for (size_t i = 0; i < chain_length && !issuer; i++)
+    {
+        const ChainNode* candidate = &chain_nodes[i];
+        bool valid_now = false;
+
+        if (candidate->crt == crt || !_can_issue(crt, candidate->crt))
+            continue;
+
+        valid_now = _check_validity(candidate->crt) == 0;
+
+        /* Only the first signer that is not valid now can be used */
+        if (!valid_now && fallback)
+            continue;
+
+        if (candidate->crt != node->verified_issuer &&
+            !_verify_signed_data(
+                &candidate->crt->pk,
+                &crt->tbs,
+                crt->sig_md,
+                crt->sig_pk,
+                crt->sig_opts,
+                &crt->sig))
+            continue;
+
+        if (valid_now)
+            issuer = candidate;
+        else
+            fallback = candidate;
+    }
+
+    if (!issuer && !(issuer = fallback))
+        return MBEDTLS_X509_BADCERT_NOT_TRUSTED;
+
+    if (!_profile_allows_key(&issuer->crt->pk))
+        flags |= MBEDTLS_X509_BADCERT_BAD_KEY;
+
+    flags |= _check_validity(issuer->crt);
+
+    return flags | _check_revocation(crt, issuer, chain_nodes, crls);
+}
+
+/* Verify a certificate the single pass rejected with
+ * mbedtls_x509_crt_verify(), which needs the CRLs linked into a list of
+ * copies */
+static oe_result_t _verify_with_mbedtls(
+    mbedtls_x509_crt* crt,
+    mbedtls_x509_crt* trusted,
+    const ChainCrl* crls,
+    size_t num_crls)
+{
+    oe_result_t result = OE_UNEXPECTED;
+    mbedtls_x509_crl* crl_list = NULL;
+    mbedtls_x509_crt* issuer = NULL;
+
+    if (num_crls && !(crl_list = (mbedtls_x509_crl*)calloc(
+                          num_crls, sizeof(mbedtls_x509_crl))))
+        OE_RAISE(OE_OUT_OF_MEMORY);
+
+    for (size_t i = 0; i < num_crls; i++)
+    {
+        crl_list[i] = *crls[i].crl;
+        crl_list[i].next = (i + 1 < num_crls) ? &crl_list[i + 1] : NULL;
+    }
+
+    OE_CHECK(_mbedtls_x509_crt_verify(crt, trusted, crl_list, &issuer));
+
+    result = OE_OK;
+
+done:
+    free(crl_list);
+
+    return result;
+}
+
+/* Check a certificate, and its link to its issuer unless it is trusted, as
+ * mbedtls_x509_crt_verify() would with the trusted certificates */
+static oe_result_t _check_node(
+    ChainNode* node,
+    ChainNode* chain_nodes,
+    size_t chain_length,
+    mbedtls_x509_crt* trusted,
+    ChainCrl* crls,
+    size_t num_crls)
+{
+    oe_result_t result = OE_UNEXPECTED;
+    uint32_t flags = _check_cert(node->crt);
+
+    if (!node->trusted)
+        flags |= _check_issuer(node, chain_nodes, chain_length, crls);
+
+    if (flags)
+        OE_CHECK(_verify_with_mbedtls(node->crt, trusted, crls, num_crls));
+
+    result = OE_OK;
+
+done:
+    return result;
+}
+
+/* Verify cert and every certificate of the chain (which may be NULL) in a
+ * single pass, with the CRLs of their issuers. Every certificate of the chain
+ * must have issued one of the CRLs when any are given */
+static oe_result_t _verify_cert_and_chain(
+    mbedtls_x509_crt* cert,
+    const Referent* chain_referent,
+    const oe_crl_t* const* crls,
+    size_t num_crls)
+{
+    oe_result_t result = OE_UNEXPECTED;
+    ChainNode* nodes = NULL;
+    ChainCrl* chain_crls = NULL;
+    size_t chain_length = 0;
+    size_t cert_node = SIZE_MAX;
+    size_t size = 0;
+    size_t i = 0;
+    mbedtls_x509_crt* chain = chain_referent ? chain_referent->crt : NULL;
+    mbedtls_x509_crt* trusted = chain ? chain : cert;
+
+    if (chain)
+        chain_length = chain_referent->length;
+
+    /* One allocation holds the nodes (the chain and cert) and the CRLs */
+    OE_CHECK(oe_safe_add_sizet(chain_length, 1, &size));
+    OE_CHECK(oe_safe_mul_sizet(size, sizeof(ChainNode), &size));
+    {
+        size_t crls_size = 0;
+
+        OE_CHECK(oe_safe_mul_sizet(num_crls, sizeof(ChainCrl), &crls_size));
+        OE_CHECK(oe_safe_add_sizet(size, crls_size, &size));
+    }
+
+    if (!(nodes = (ChainNode*)calloc(1, size)))
+        OE_RAISE(OE_OUT_OF_MEMORY);
+
+    chain_crls = (ChainCrl*)(nodes + chain_length + 1);
+
+    for (mbedtls_x509_crt* p = chain; p; p = p->next, i++)
+    {
+        nodes[i].crt = p;
+        nodes[i].trusted = _x509_name_equal(&p->subject, &p->issuer);
+        nodes[i].verified_issuer = chain_referent->issuers[i];
+        nodes[i].name_group = i;
+        nodes[i].first_crl = NO_CRL;
+
+        for (size_t j = 0; j < i; j++)
+        {
+            if (_x509_name_equal(&nodes[j].crt->subject, &p->subject))
+            {
+                nodes[i].name_group = j;
+                break;
+            }
+        }
+
+        /* cert is checked as the chain certificate it is equal to */
+        if (p == cert || (p->raw.len == cert->raw.len &&
+                          memcmp(p->raw.p, cert->raw.p, p->raw.len) == 0))
+            cert_node = i;
+    }
+
+    if (cert_node == SIZE_MAX)
+    {
+        cert_node = chain_length;
+        nodes[cert_node].crt = cert;
+        nodes[cert_node].first_crl = NO_CRL;
+
+        /* Without a chain, a self-issued cert is trusted by itself */
+        nodes[cert_node].trusted =
+            !chain && _x509_name_equal(&cert->subject, &cert->issuer);
+    }
+
+    /* Index the CRLs by the name group of their issuer. Pushing them in
+     * reverse keeps the CRLs of each group in the given order. */
+    for (i = num_crls; i-- > 0;)
+    {
+        const mbedtls_x509_crl* crl = ((const crl_t*)crls[i])->crl;
+        bool indexed = false;
+
+        chain_crls[i].crl = crl;
+        chain_crls[i].next = NO_CRL;
+
+        for (size_t j = 0; j < chain_length; j++)
+        {
+            if (_x509_buf_equal(&crl->issuer_raw, &nodes[j].crt->subject_raw))
+                nodes[j].has_crl = true;
+
+            /* The first node of a name is the first node of its group */
+            if (!indexed && crl->version != 0 &&
+                _x509_name_equal(&crl->issuer, &nodes[j].crt->subject))
+            {
+                chain_crls[i].next = nodes[j].first_crl;
+                nodes[j].first_crl = i;
+                indexed = true;
+            }
+        }
+    }
+
+    /* Check cert first, then every other certificate of the chain, each
+     * followed by the presence of its CRL when CRLs are given */
+    OE_CHECK(_check_node(
+        &nodes[cert_node],
+        nodes,
+        chain_length,
+        trusted,
+        chain_crls,
+        num_crls));
+
+    for (i = 0; i < chain_length; i++)
+    {
+        if (i != cert_node)
+            OE_CHECK(_check_node(
+                &nodes[i], nodes, chain_length, trusted, chain_crls, num_crls));
+
+        if (num_crls && !nodes[i].has_crl)
+        {
+            OE_RAISE_MSG(
+                OE_VERIFY_CRL_MISSING, "Unable to get certificate CRL", NULL);
+        }
+    }
+
+    result = OE_OK;
+
+done:
+    free(nodes);
+
+    return result;
+}
+
 /*
 **==============================================================================
 **
@@ -768,13 +1377,17 @@ oe_result_t oe_cert_chain_read_pem(
     /* Reorder certs in the chain to preferred order */
     referent->crt = _sort_certs_by_issue_date(referent->crt);
 
-    /* Verify the whole certificate chain */
-    OE_CHECK(_verify_whole_chain(referent->crt));
-
     /* Calculate the length of the certificate chain */
     for (mbedtls_x509_crt* p = referent->crt; p; p = p->next)
         referent->length++;
 
+    if (!(referent->issuers = (mbedtls_x509_crt**)mbedtls_calloc(
+              referent->length, sizeof(mbedtls_x509_crt*))))
+        OE_RAISE(OE_OUT_OF_MEMORY);
+
+    /* Verify the whole certificate chain */
+    OE_CHECK(_verify_whole_chain(referent->crt, referent->issuers));
+
     /* Initialize the implementation and increment reference count */
     OE_CHECK(_cert_chain_init(impl, referent));
 
@@ -819,7 +1432,6 @@ oe_result_t oe_cert_verify(
     oe_result_t result = OE_UNEXPECTED;
     Cert* cert_impl = (Cert*)cert;
     CertChain* chain_impl = (CertChain*)chain;
-    mbedtls_x509_crl* crl_list = NULL;
 
     /* Reject invalid certificate */
     if (!_cert_is_valid(cert_impl))
@@ -833,86 +1445,32 @@ oe_result_t oe_cert_verify(
         OE_RAISE_MSG(OE_INVALID_PARAMETER, "Invalid chain parameter", NULL);
     }
 
-    // Build the list of CRLS if any. Copy them onto auxiliary memory
-    // to avoid modifying them when putting them on the list.
+    /* Reject invalid CRLs. They are used in place, without copies. */
     if (crls && num_crls)
     {
-        mbedtls_x509_crl* last = NULL;
-
         for (size_t i = 0; i < num_crls; i++)
         {
-            const crl_t* crl_impl = (crl_t*)crls[i];
-            mbedtls_x509_crl* p;
-
-            if (!crl_is_valid(crl_impl))
+            if (!crl_is_valid((const crl_t*)crls[i]))
                 OE_RAISE_MSG(
                     OE_INVALID_PARAMETER, "Invalid crls parameter", NULL);
-
-            if (!(p = malloc(sizeof(mbedtls_x509_crl))))
-                OE_RAISE(OE_OUT_OF_MEMORY);
-
-            OE_CHECK(oe_memcpy_s(
-                p, sizeof(*p), crl_impl->crl, sizeof(mbedtls_x509_crl)));
-
-            /* Append to the linked-list */
-            {
-                p->next = NULL;
-
-                if (crl_list)
-                    last->next = p;
-                else
-                    crl_list = p;
-            }
-
-            last = p;
         }
     }
+    else
+    {
+        num_crls = 0;
+    }
 
-    /* Verify the certificate */
-    OE_CHECK(_mbedtls_x509_crt_verify(
+    /* Verify the certificate and every certificate in the chain */
+    OE_CHECK(_verify_cert_and_chain(
         cert_impl->cert,
-        (chain != NULL) ? chain_impl->referent->crt : cert_impl->cert,
-        crl_list));
+        (chain != NULL) ? chain_impl->referent : NULL,
+        crls,
+        num_crls));
 
-    if (chain)
-    {
-        /* Verify every certificate in the certificate chain. */
-        for (mbedtls_x509_crt* p = chain_impl->referent->crt; p; p = p->next)
-        {
-            /* Verify the current certificate in the chain. */
-            OE_CHECK(_mbedtls_x509_crt_verify(
-                p,
-                ((chain != NULL) ? chain_impl->referent->crt : NULL),
-                crl_list));
-
-            /* Verify that the CRL list has an issuer for this certificate. */
-            if (crl_list)
-            {
-                if (!_crl_list_find_issuer_for_cert(crl_list, p))
-                {
-                    OE_RAISE_MSG(
-                        OE_VERIFY_CRL_MISSING,
-                        "Unable to get certificate CRL",
-                        NULL);
-                }
-            }
-        }
-    }
     result = OE_OK;
 
 done:
 
-    if (crl_list)
-    {
-        /* Free the linked list of CRL objects */
-        for (mbedtls_x509_crl* p = crl_list; p;)
-        {
-            mbedtls_x509_crl* next = p->next;
-            free(p);
-            p = next;
-        }
-    }
-
     return result;
 }
 
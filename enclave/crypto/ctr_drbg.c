@@ -3,6 +3,7 @@
 
 #include "ctr_drbg.h"
 #include <mbedtls/entropy.h>
+#include <openenclave/corelibc/stdlib.h>
 #include <openenclave/enclave.h>
 #include <openenclave/internal/raise.h>
 #include <openenclave/internal/thread.h>
@@ -10,23 +11,86 @@
 /*
 **==============================================================================
 **
-** Local definitions
+** Per-thread CTR-DRBG instances:
+**
+**     oe_mbedtls_get_drbg() hands each thread a DRBG of its own, so that
+**     key generation and certificate signing on different threads do not
+**     contend on one context. The contexts are kept in a pool: a thread
+**     takes one on its first request in an ecall and returns it when its
+**     outermost ecall returns (through the destructor of a thread-specific
+**     key), so a context is seeded once and reused across ecalls.
+**
+**     Every context is seeded from the global entropy source, with its own
+**     address as personalization string, and is reseeded from it every
+**     DRBG_RESEED_INTERVAL requests. The global entropy context serializes
+**     only these (re)seeds.
 **
 **==============================================================================
 */
 
+/* Reseed more often than the mbedTLS default of 10000 requests, since each
+ * context lives for the lifetime of the enclave */
+#define DRBG_RESEED_INTERVAL 1024
+
+typedef struct _drbg_entry
+{
+    mbedtls_ctr_drbg_context drbg;
+    struct _drbg_entry* next;
+} drbg_entry_t;
+
 static mbedtls_ctr_drbg_context _drbg;
 static mbedtls_entropy_context _entropy;
+static oe_thread_key_t _drbg_key;
+static bool _have_drbg_key;
+
+static drbg_entry_t* _pool;
+static oe_spinlock_t _pool_lock = OE_SPINLOCK_INITIALIZER;
+
+static oe_result_t _seed_drbg(
+    mbedtls_ctr_drbg_context* drbg,
+    const void* personalization,
+    size_t personalization_size)
+{
+    oe_result_t result = OE_UNEXPECTED;
+
+    mbedtls_ctr_drbg_init(drbg);
+
+    OE_CHECK((oe_result_t)mbedtls_ctr_drbg_seed(
+        drbg,
+        mbedtls_entropy_func,
+        &_entropy,
+        (const unsigned char*)personalization,
+        personalization_size));
+
+    mbedtls_ctr_drbg_set_reseed_interval(drbg, DRBG_RESEED_INTERVAL);
+
+    result = OE_OK;
+
+done:
+    return result;
+}
+
+/* Return the DRBG of the calling thread to the pool */
+static void _release_drbg(void* value)
+{
+    drbg_entry_t* entry = (drbg_entry_t*)value;
+
+    oe_spin_lock(&_pool_lock);
+    entry->next = _pool;
+    _pool = entry;
+    oe_spin_unlock(&_pool_lock);
+}
 
 static oe_result_t _seed_entropy_source()
 {
     oe_result_t result = OE_UNEXPECTED;
 
-    mbedtls_ctr_drbg_init(&_drbg);
     mbedtls_entropy_init(&_entropy);
 
-    OE_CHECK((oe_result_t)mbedtls_ctr_drbg_seed(
-        &_drbg, mbedtls_entropy_func, &_entropy, NULL, 0));
+    /* The shared DRBG serves threads without thread-specific data */
+    OE_CHECK(_seed_drbg(&_drbg, NULL, 0));
+
+    _have_drbg_key = oe_thread_key_create(&_drbg_key, _release_drbg) == OE_OK;
 
     result = OE_OK;
 
@@ -43,8 +107,56 @@ static void _seed_entropy_source_once()
     _seed_result = _seed_entropy_source();
 }
 
+static drbg_entry_t* _acquire_drbg(void)
+{
+    drbg_entry_t* entry;
+
+    oe_spin_lock(&_pool_lock);
+
+    if ((entry = _pool))
+        _pool = entry->next;
+
+    oe_spin_unlock(&_pool_lock);
+
+    if (entry)
+        return entry;
+
+    if (!(entry = (drbg_entry_t*)oe_malloc(sizeof(drbg_entry_t))))
+        return NULL;
+
+    if (_seed_drbg(&entry->drbg, &entry, sizeof(entry)) != OE_OK)
+    {
+        mbedtls_ctr_drbg_free(&entry->drbg);
+        oe_free(entry);
+        return NULL;
+    }
+
+    return entry;
+}
+
 mbedtls_ctr_drbg_context* oe_mbedtls_get_drbg()
 {
+    drbg_entry_t* entry;
+
     oe_once(&_seed_once, _seed_entropy_source_once);
-    return (_seed_result == OE_OK) ? &_drbg : NULL;
+
+    if (_seed_result != OE_OK)
+        return NULL;
+
+    if (!_have_drbg_key)
+        return &_drbg;
+
+    if ((entry = (drbg_entry_t*)oe_thread_getspecific(_drbg_key)))
+        return &entry->drbg;
+
+    if (!(entry = _acquire_drbg()))
+        return &_drbg;
+
+    if (oe_thread_setspecific(_drbg_key, entry) != OE_OK)
+    {
+        _release_drbg(entry);
+        return &_drbg;
+    }
+
+    return &entry->drbg;
 }
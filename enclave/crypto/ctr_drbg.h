@@ -6,6 +6,8 @@
 
 #include <mbedtls/ctr_drbg.h>
 
+/* Return the DRBG of the calling thread, which is valid until its outermost
+ * ecall returns, or NULL if the entropy source cannot be seeded */
 mbedtls_ctr_drbg_context* oe_mbedtls_get_drbg();
 
 #endif /* _CRYPTO_ENCLAVE_CTR_DRBG_H */
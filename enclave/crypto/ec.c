@@ -11,8 +11,14 @@
 #include <openenclave/internal/utils.h>
 #include "ctr_drbg.h"
 #include "key.h"
+#include "p256.h"
 #include "pem.h"
 
+/* The number of nonces that oe_ec_private_key_sign_batch() inverts at once,
+ * and the number of nonces it tries for a signature, as mbedTLS does */
+#define SIGN_BATCH_SIZE 32
+#define SIGN_MAX_TRIES 10
+
 static uint64_t _PRIVATE_KEY_MAGIC = 0xf12c37bb02814eeb;
 static uint64_t _PUBLIC_KEY_MAGIC = 0xd7490a56f6504ee6;
 
@@ -199,6 +205,26 @@ oe_result_t oe_ec_public_key_free(oe_ec_public_key_t* public_key)
     return oe_public_key_free((oe_public_key_t*)public_key, _PUBLIC_KEY_MAGIC);
 }
 
+oe_result_t oe_ec_private_key_share(
+    const oe_ec_private_key_t* private_key,
+    oe_ec_private_key_t* shared)
+{
+    return oe_private_key_share(
+        (const oe_private_key_t*)private_key,
+        (oe_private_key_t*)shared,
+        _PRIVATE_KEY_MAGIC);
+}
+
+oe_result_t oe_ec_public_key_share(
+    const oe_ec_public_key_t* public_key,
+    oe_ec_public_key_t* shared)
+{
+    return oe_public_key_share(
+        (const oe_public_key_t*)public_key,
+        (oe_public_key_t*)shared,
+        _PUBLIC_KEY_MAGIC);
+}
+
 oe_result_t oe_ec_private_key_sign(
     const oe_ec_private_key_t* private_key,
     oe_hash_type_t hash_type,
@@ -225,8 +251,21 @@ oe_result_t oe_ec_public_key_verify(
     const uint8_t* signature,
     size_t signature_size)
 {
+    const oe_public_key_t* impl = (const oe_public_key_t*)public_key;
+    oe_result_t result = OE_UNSUPPORTED;
+
+    /* P-256 signatures are verified by p256.c, which caches tables for the
+     * keys that are used repeatedly */
+    if (oe_public_key_is_valid(impl, _PUBLIC_KEY_MAGIC) && hash_data &&
+        hash_size)
+        result = oe_p256_verify(
+            &impl->pk, hash_data, hash_size, signature, signature_size);
+
+    if (result == OE_OK || result == OE_VERIFY_FAILED)
+        return result;
+
     return oe_public_key_verify(
-        (oe_public_key_t*)public_key,
+        impl,
         hash_type,
         hash_data,
         hash_size,
@@ -299,9 +338,11 @@ oe_result_t oe_ec_generate_key_pair_from_private(
     if (mbedtls_result != 0)
         OE_RAISE_MSG(OE_CRYPTO_ERROR, "mbedtls error: 0x%x", mbedtls_result);
 
-    /* Export to OE structs. */
+    /* Export to OE structs. The private key takes over the context rather
+     * than copying it. */
     OE_CHECK(oe_ec_public_key_init(public_key, &key));
-    result = oe_ec_private_key_init(private_key, &key);
+    result = oe_private_key_init(
+        (oe_private_key_t*)private_key, NULL, NULL, _PRIVATE_KEY_MAGIC);
     if (result != OE_OK)
     {
         /* Need to free the public key before exiting. */
@@ -309,6 +350,9 @@ oe_result_t oe_ec_generate_key_pair_from_private(
         OE_RAISE(result);
     }
 
+    ((oe_private_key_t*)private_key)->pk = key;
+    mbedtls_pk_init(&key);
+
     result = OE_OK;
 
 done:
@@ -341,13 +385,12 @@ oe_result_t oe_ec_public_key_from_coordinates(
     if (public_key)
         oe_secure_zero_fill(public_key, sizeof(oe_ec_public_key_t));
 
-    if (impl)
-        mbedtls_pk_init(&impl->pk);
-
     /* Reject invalid parameters */
     if (!public_key || !x_data || !x_size || !y_data || !y_size)
         OE_RAISE(OE_INVALID_PARAMETER);
 
+    OE_CHECK(oe_public_key_init(impl, NULL, NULL, _PUBLIC_KEY_MAGIC));
+
     /* Lookup the info for this key type */
     if (!(info = mbedtls_pk_info_from_type(MBEDTLS_PK_ECKEY)))
         OE_RAISE(OE_PUBLIC_KEY_NOT_FOUND);
@@ -382,57 +425,32 @@ oe_result_t oe_ec_public_key_from_coordinates(
             OE_RAISE(OE_CRYPTO_ERROR);
     }
 
-    /* Set the magic number */
-    impl->magic = _PUBLIC_KEY_MAGIC;
-
     result = OE_OK;
 
 done:
 
-    if (result != OE_OK && impl)
-        mbedtls_pk_free(&impl->pk);
+    if (result != OE_OK)
+        oe_public_key_release(impl, _PUBLIC_KEY_MAGIC);
 
     return result;
 }
 
-oe_result_t oe_ecdsa_signature_write_der(
+/* Write the ECDSA signature (r, s) in DER format */
+static oe_result_t _write_signature(
     unsigned char* signature,
     size_t* signature_size,
-    const uint8_t* data,
-    size_t size,
-    const uint8_t* s_data,
-    size_t s_size)
+    const mbedtls_mpi* r,
+    const mbedtls_mpi* s)
 {
     oe_result_t result = OE_UNEXPECTED;
-    mbedtls_mpi r;
-    mbedtls_mpi s;
     unsigned char buf[MBEDTLS_ECDSA_MAX_LEN];
     unsigned char* p = buf + sizeof(buf);
     int n;
     size_t len = 0;
 
-    mbedtls_mpi_init(&r);
-    mbedtls_mpi_init(&s);
-
-    /* Reject invalid parameters */
-    if (!signature_size || !data || !size || !s_data || !s_size)
-        OE_RAISE(OE_INVALID_PARAMETER);
-
-    /* If signature is null, then signature_size must be zero */
-    if (!signature && *signature_size != 0)
-        OE_RAISE(OE_INVALID_PARAMETER);
-
-    /* Convert raw R data to big number */
-    if (mbedtls_mpi_read_binary(&r, data, size) != 0)
-        OE_RAISE(OE_CRYPTO_ERROR);
-
-    /* Convert raw S data to big number */
-    if (mbedtls_mpi_read_binary(&s, s_data, s_size) != 0)
-        OE_RAISE(OE_CRYPTO_ERROR);
-
     /* Write S to ASN.1 */
     {
-        if ((n = mbedtls_asn1_write_mpi(&p, buf, &s)) < 0)
+        if ((n = mbedtls_asn1_write_mpi(&p, buf, s)) < 0)
             OE_RAISE(OE_CRYPTO_ERROR);
 
         len += (size_t)n;
@@ -440,7 +458,7 @@ oe_result_t oe_ecdsa_signature_write_der(
 
     /* Write R to ASN.1 */
     {
-        if ((n = mbedtls_asn1_write_mpi(&p, buf, &r)) < 0)
+        if ((n = mbedtls_asn1_write_mpi(&p, buf, r)) < 0)
             OE_RAISE(OE_CRYPTO_ERROR);
 
         len += (size_t)n;
@@ -476,6 +494,43 @@ oe_result_t oe_ecdsa_signature_write_der(
 
     result = OE_OK;
 
+done:
+    return result;
+}
+
+oe_result_t oe_ecdsa_signature_write_der(
+    unsigned char* signature,
+    size_t* signature_size,
+    const uint8_t* data,
+    size_t size,
+    const uint8_t* s_data,
+    size_t s_size)
+{
+    oe_result_t result = OE_UNEXPECTED;
+    mbedtls_mpi r;
+    mbedtls_mpi s;
+
+    mbedtls_mpi_init(&r);
+    mbedtls_mpi_init(&s);
+
+    /* Reject invalid parameters */
+    if (!signature_size || !data || !size || !s_data || !s_size)
+        OE_RAISE(OE_INVALID_PARAMETER);
+
+    /* If signature is null, then signature_size must be zero */
+    if (!signature && *signature_size != 0)
+        OE_RAISE(OE_INVALID_PARAMETER);
+
+    /* Convert raw R data to big number */
+    if (mbedtls_mpi_read_binary(&r, data, size) != 0)
+        OE_RAISE(OE_CRYPTO_ERROR);
+
+    /* Convert raw S data to big number */
+    if (mbedtls_mpi_read_binary(&s, s_data, s_size) != 0)
+        OE_RAISE(OE_CRYPTO_ERROR);
+
+    result = _write_signature(signature, signature_size, &r, &s);
+
 done:
 
     mbedtls_mpi_free(&r);
@@ -484,6 +539,306 @@ done:
     return result;
 }
 
+/* r = a * b mod n */
+static int _mul_mod(
+    mbedtls_mpi* r,
+    const mbedtls_mpi* a,
+    const mbedtls_mpi* b,
+    const mbedtls_mpi* n)
+{
+    int rc = mbedtls_mpi_mul_mpi(r, a, b);
+    return rc ? rc : mbedtls_mpi_mod_mpi(r, r, n);
+}
+
+/* e = the leftmost bits of the hash, as many as n has, reduced mod n, as
+ * mbedtls_ecdsa_sign() computes it */
+static int _read_hash(
+    const mbedtls_ecp_group* grp,
+    mbedtls_mpi* e,
+    const uint8_t* hash,
+    size_t hash_size)
+{
+    size_t size = (grp->nbits + 7) / 8;
+    int rc;
+
+    if (size > hash_size)
+        size = hash_size;
+
+    if ((rc = mbedtls_mpi_read_binary(e, hash, size)) != 0)
+        return rc;
+
+    if (size * 8 > grp->nbits &&
+        (rc = mbedtls_mpi_shift_r(e, size * 8 - grp->nbits)) != 0)
+        return rc;
+
+    if (mbedtls_mpi_cmp_mpi(e, &grp->N) >= 0)
+        return mbedtls_mpi_sub_mpi(e, e, &grp->N);
+
+    return 0;
+}
+
+/*
+ * Sign hashes[i] for i < count <= SIGN_BATCH_SIZE with the private key d,
+ * leaving the signatures in (r[i], s[i]). Each signature takes a scalar
+ * multiplication k * G by mbedTLS, whose table of multiples of G is kept in
+ * grp, but the nonces k are inverted together (Montgomery's trick), with the
+ * products of the nonces in products[]. mbedtls_mpi_inv_mod() is not
+ * constant-time, so the product is blinded by a random b before it is
+ * inverted, as mbedtls_ecdsa_sign() blinds the nonce.
+ */
+static int _sign_batch(
+    mbedtls_ecp_group* grp,
+    const mbedtls_mpi* d,
+    mbedtls_ctr_drbg_context* drbg,
+    const void* const* hashes,
+    size_t hash_size,
+    size_t count,
+    mbedtls_mpi* r,
+    mbedtls_mpi* s,
+    mbedtls_mpi* products)
+{
+    int rc = 0;
+    mbedtls_ecp_point point;
+    mbedtls_mpi b;
+    mbedtls_mpi inv;
+    mbedtls_mpi t;
+
+    mbedtls_ecp_point_init(&point);
+    mbedtls_mpi_init(&b);
+    mbedtls_mpi_init(&inv);
+    mbedtls_mpi_init(&t);
+
+    /* s[i] = k, r[i] = x(k * G) mod n, products[i] = s[0] * ... * s[i] */
+    for (size_t i = 0; i < count; i++)
+    {
+        size_t tries = 0;
+
+        do
+        {
+            if (++tries > SIGN_MAX_TRIES)
+            {
+                rc = MBEDTLS_ERR_ECP_RANDOM_FAILED;
+                goto done;
+            }
+
+            if ((rc = mbedtls_ecp_gen_privkey(
+                     grp, &s[i], mbedtls_ctr_drbg_random, drbg)) != 0 ||
+                (rc = mbedtls_ecp_mul(
+                     grp,
+                     &point,
+                     &s[i],
+                     &grp->G,
+                     mbedtls_ctr_drbg_random,
+                     drbg)) != 0 ||
+                (rc = mbedtls_mpi_mod_mpi(&r[i], &point.X, &grp->N)) != 0)
+                goto done;
+        } while (mbedtls_mpi_cmp_int(&r[i], 0) == 0);
+
+        if (i)
+            rc = _mul_mod(&products[i], &products[i - 1], &s[i], &grp->N);
+        else
+            rc = mbedtls_mpi_copy(&products[0], &s[0]);
+
+        if (rc != 0)
+            goto done;
+    }
+
+    /* inv = 1 / products[count - 1] = b / (products[count - 1] * b) */
+    if ((rc = mbedtls_ecp_gen_privkey(
+             grp, &b, mbedtls_ctr_drbg_random, drbg)) != 0 ||
+        (rc = _mul_mod(&t, &products[count - 1], &b, &grp->N)) != 0 ||
+        (rc = mbedtls_mpi_inv_mod(&inv, &t, &grp->N)) != 0 ||
+        (rc = _mul_mod(&inv, &inv, &b, &grp->N)) != 0)
+        goto done;
+
+    /* s[i] = (e + r[i] * d) / k, where inv = 1 / products[i] as i goes
+     * down, and b is reused for e */
+    for (size_t i = count; i-- > 0;)
+    {
+        if (i)
+        {
+            if ((rc = _mul_mod(&t, &inv, &products[i - 1], &grp->N)) != 0 ||
+                (rc = _mul_mod(&inv, &inv, &s[i], &grp->N)) != 0)
+                goto done;
+        }
+        else if ((rc = mbedtls_mpi_copy(&t, &inv)) != 0)
+            goto done;
+
+        if ((rc = _read_hash(grp, &b, hashes[i], hash_size)) != 0 ||
+            (rc = _mul_mod(&s[i], &r[i], d, &grp->N)) != 0 ||
+            (rc = mbedtls_mpi_add_mpi(&s[i], &s[i], &b)) != 0 ||
+            (rc = _mul_mod(&s[i], &s[i], &t, &grp->N)) != 0)
+            goto done;
+
+        /* s = 0 happens with a chance of 1 / n, for which mbedTLS would
+         * choose another nonce */
+        if (mbedtls_mpi_cmp_int(&s[i], 0) == 0)
+        {
+            rc = MBEDTLS_ERR_ECP_RANDOM_FAILED;
+            goto done;
+        }
+    }
+
+done:
+    mbedtls_ecp_point_free(&point);
+    mbedtls_mpi_free(&b);
+    mbedtls_mpi_free(&inv);
+    mbedtls_mpi_free(&t);
+
+    return rc;
+}
+
+oe_result_t oe_ec_private_key_sign_batch(
+    const oe_ec_private_key_t* private_key,
+    oe_hash_type_t hash_type,
+    const void* const* hashes,
+    size_t hash_size,
+    uint8_t* const* signatures,
+    size_t* signature_sizes,
+    size_t count)
+{
+    oe_result_t result = OE_UNEXPECTED;
+    const oe_private_key_t* impl = (const oe_private_key_t*)private_key;
+    const mbedtls_ecp_keypair* ec;
+    mbedtls_ctr_drbg_context* drbg;
+    mbedtls_ecp_group grp;
+    mbedtls_mpi r[SIGN_BATCH_SIZE];
+    mbedtls_mpi s[SIGN_BATCH_SIZE];
+    mbedtls_mpi products[SIGN_BATCH_SIZE];
+    bool too_small = false;
+    int rc;
+
+    mbedtls_ecp_group_init(&grp);
+
+    for (size_t i = 0; i < SIGN_BATCH_SIZE; i++)
+    {
+        mbedtls_mpi_init(&r[i]);
+        mbedtls_mpi_init(&s[i]);
+        mbedtls_mpi_init(&products[i]);
+    }
+
+    /* Check parameters */
+    if (!oe_private_key_is_valid(impl, _PRIVATE_KEY_MAGIC) || !hash_size ||
+        (count && (!hashes || !signatures || !signature_sizes)))
+        OE_RAISE(OE_INVALID_PARAMETER);
+
+    if (hash_type != OE_HASH_TYPE_SHA256 && hash_type != OE_HASH_TYPE_SHA512)
+        OE_RAISE(OE_INVALID_PARAMETER);
+
+    /* If a signature buffer is null, then its size must be zero */
+    for (size_t i = 0; i < count; i++)
+    {
+        if (!hashes[i] || (!signatures[i] && signature_sizes[i] != 0))
+            OE_RAISE(OE_INVALID_PARAMETER);
+    }
+
+    if (!(ec = mbedtls_pk_ec(impl->pk)))
+        OE_RAISE(OE_INVALID_PARAMETER);
+
+    /* The batch has a group of its own, so that the threads signing with
+     * the same key do not share the table that mbedtls_ecp_mul() builds */
+    if ((rc = mbedtls_ecp_group_load(&grp, ec->grp.id)) != 0)
+        OE_RAISE_MSG(OE_CRYPTO_ERROR, "rc = 0x%x\n", rc);
+
+    if (!(drbg = oe_mbedtls_get_drbg()))
+        OE_RAISE(OE_CRYPTO_ERROR);
+
+    for (size_t i = 0; i < count; i += SIGN_BATCH_SIZE)
+    {
+        size_t batch_size = count - i;
+
+        if (batch_size > SIGN_BATCH_SIZE)
+            batch_size = SIGN_BATCH_SIZE;
+
+        if ((rc = _sign_batch(
+                 &grp,
+                 &ec->d,
+                 drbg,
+                 hashes + i,
+                 hash_size,
+                 batch_size,
+                 r,
+                 s,
+                 products)) != 0)
+            OE_RAISE_MSG(OE_CRYPTO_ERROR, "rc = 0x%x\n", rc);
+
+        /* Write all signatures that fit */
+        for (size_t j = 0; j < batch_size; j++)
+        {
+            result = _write_signature(
+                signatures[i + j], &signature_sizes[i + j], &r[j], &s[j]);
+
+            if (result == OE_BUFFER_TOO_SMALL)
+                too_small = true;
+            else if (result != OE_OK)
+                goto done;
+        }
+    }
+
+    if (too_small)
+        OE_RAISE(OE_BUFFER_TOO_SMALL);
+
+    result = OE_OK;
+
+done:
+
+    mbedtls_ecp_group_free(&grp);
+
+    for (size_t i = 0; i < SIGN_BATCH_SIZE; i++)
+    {
+        mbedtls_mpi_free(&r[i]);
+        mbedtls_mpi_free(&s[i]);
+        mbedtls_mpi_free(&products[i]);
+    }
+
+    return result;
+}
+
+oe_result_t oe_ec_public_key_verify_batch(
+    const oe_ec_public_key_t* public_key,
+    oe_hash_type_t hash_type,
+    const void* const* hashes,
+    size_t hash_size,
+    const uint8_t* const* signatures,
+    const size_t* signature_sizes,
+    size_t count)
+{
+    const oe_public_key_t* impl = (const oe_public_key_t*)public_key;
+    oe_result_t result = OE_UNEXPECTED;
+
+    /* Check parameters */
+    if (!oe_public_key_is_valid(impl, _PUBLIC_KEY_MAGIC) || !hash_size ||
+        (count && (!hashes || !signatures || !signature_sizes)))
+        OE_RAISE(OE_INVALID_PARAMETER);
+
+    /* P-256 signatures are verified together by p256.c */
+    result = oe_p256_verify_batch(
+        &impl->pk, hashes, hash_size, signatures, signature_sizes, count);
+
+    if (result != OE_UNSUPPORTED && result != OE_OUT_OF_MEMORY)
+        goto done;
+
+    for (size_t i = 0; i < count; i++)
+    {
+        result = oe_public_key_verify(
+            impl,
+            hash_type,
+            hashes[i],
+            hash_size,
+            signatures[i],
+            signature_sizes[i],
+            _PUBLIC_KEY_MAGIC);
+
+        if (result != OE_OK)
+            goto done;
+    }
+
+    result = OE_OK;
+
+done:
+    return result;
+}
+
 bool oe_ec_valid_raw_private_key(
     oe_ec_type_t type,
     const uint8_t* key,
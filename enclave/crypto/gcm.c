@@ -0,0 +1,522 @@
+// Copyright (c) Open Enclave SDK contributors.
+// Licensed under the MIT License.
+
+#include <mbedtls/aesni.h>
+#include <mbedtls/gcm.h>
+
+#include <openenclave/enclave.h>
+#include <openenclave/internal/aesni.h>
+#include <openenclave/internal/crypto/gcm.h>
+#include <openenclave/internal/raise.h>
+#include <openenclave/internal/utils.h>
+#include <string.h>
+
+/*
+**==============================================================================
+**
+** AES-128-GCM:
+**
+**     mbedTLS encrypts and hashes one block at a time, so every AESENC and
+**     PCLMULQDQ waits for the result of the one before it. On CPUs with
+**     AES-NI and PCLMULQDQ, this implementation instead encrypts
+**     PARALLEL_BLOCKS counter blocks at once and hashes as many ciphertext
+**     blocks with a single reduction, using the powers of H kept in the
+**     expanded key (Gueron and Kounavis, "Intel Carry-Less Multiplication
+**     Instruction and its Usage for Computing the GCM Mode").
+**
+**     GHASH operates on byte-reversed blocks, for which the carry-less
+**     product of two field elements is shifted left by one bit before the
+**     reduction.
+**
+**     Other CPUs, and other architectures, use mbedTLS.
+**
+**==============================================================================
+*/
+
+#if defined(MBEDTLS_AESNI_C) && defined(MBEDTLS_HAVE_X86_64)
+#define USE_AESNI
+#endif
+
+#define AES_128_KEY_SIZE 16
+#define AES_BLOCK_SIZE 16
+#define PARALLEL_BLOCKS 8
+
+/* Unrolled for PARALLEL_BLOCKS, so that the blocks stay in registers */
+#define FOR_EACH_BLOCK(OP) \
+    OP(0) OP(1) OP(2) OP(3) OP(4) OP(5) OP(6) OP(7)
+
+typedef long long v2di_t __attribute__((vector_size(16)));
+
+/* For unaligned loads and stores, which memcpy() would turn into calls, as
+ * enclave code is built with -fno-builtin */
+typedef long long v2di_unaligned_t
+    __attribute__((vector_size(16), aligned(1), __may_alias__));
+typedef unsigned int v4su_t __attribute__((vector_size(16)));
+typedef char v16qi_t __attribute__((vector_size(16)));
+
+typedef struct _gcm_key
+{
+    v2di_t rk[OE_AES_128_ROUNDS + 1];
+
+    /* H, H^2, ..., H^PARALLEL_BLOCKS, byte-reversed */
+    v2di_t h[PARALLEL_BLOCKS];
+
+    uint8_t key[AES_128_KEY_SIZE];
+    bool aesni;
+} gcm_key_t;
+
+OE_STATIC_ASSERT(sizeof(gcm_key_t) <= sizeof(oe_aes_gcm_key_t));
+
+#if defined(USE_AESNI)
+
+#define AESNI_TARGET __attribute__((target("aes,pclmul,ssse3")))
+
+static bool _has_aesni(void)
+{
+    /* mbedtls_aesni_has_support() caches the CPUID result */
+    return mbedtls_aesni_has_support(MBEDTLS_AESNI_AES) &&
+           mbedtls_aesni_has_support(MBEDTLS_AESNI_CLMUL);
+}
+
+OE_INLINE v2di_t _load(const uint8_t* p)
+{
+    return *(const v2di_unaligned_t*)p;
+}
+
+OE_INLINE void _store(uint8_t* p, v2di_t x)
+{
+    *(v2di_unaligned_t*)p = x;
+}
+
+/* PSHUFB masks; a byte with the top bit set selects zero */
+#define REVERSE_MASK \
+    (v16qi_t){15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0}
+#define SHIFT_LEFT_4_MASK \
+    (v16qi_t){-1, -1, -1, -1, 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11}
+#define SHIFT_RIGHT_4_MASK \
+    (v16qi_t){4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, -1, -1, -1, -1}
+#define SHIFT_RIGHT_12_MASK \
+    (v16qi_t){12, 13, 14, 15, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1}
+#define SHIFT_LEFT_12_MASK \
+    (v16qi_t){-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 0, 1, 2, 3}
+#define COUNTER_MASK \
+    (v16qi_t){0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 15, 14, 13, 12}
+#define SHUFFLE(X, MASK) \
+    (__typeof__(X))__builtin_ia32_pshufb128((v16qi_t)(X), MASK)
+
+AESNI_TARGET OE_INLINE v2di_t _reverse(v2di_t x)
+{
+    return SHUFFLE(x, REVERSE_MASK);
+}
+
+AESNI_TARGET OE_INLINE v2di_t
+_encrypt_block(const v2di_t rk[OE_AES_128_ROUNDS + 1], v2di_t b)
+{
+    b ^= rk[0];
+
+    for (size_t i = 1; i < OE_AES_128_ROUNDS; i++)
+        b = __builtin_ia32_aesenc128(b, rk[i]);
+
+    return __builtin_ia32_aesenclast128(b, rk[OE_AES_128_ROUNDS]);
+}
+
+/* Add the carry-less product of a and b to the partial products (lo, mid,
+ * hi), of which _combine() makes a 256-bit product */
+AESNI_TARGET OE_INLINE void _clmul_add(
+    v2di_t a,
+    v2di_t b,
+    v2di_t* lo,
+    v2di_t* mid,
+    v2di_t* hi)
+{
+    *lo ^= __builtin_ia32_pclmulqdq128(a, b, 0x00);
+    *mid ^= __builtin_ia32_pclmulqdq128(a, b, 0x10) ^
+            __builtin_ia32_pclmulqdq128(a, b, 0x01);
+    *hi ^= __builtin_ia32_pclmulqdq128(a, b, 0x11);
+}
+
+OE_INLINE void _combine(v2di_t* lo, v2di_t mid, v2di_t* hi)
+{
+    *lo ^= (v2di_t){0, mid[0]};
+    *hi ^= (v2di_t){mid[1], 0};
+}
+
+/* Shift the product (hi, lo) left by one bit and reduce it modulo
+ * x^128 + x^7 + x^2 + x + 1 */
+AESNI_TARGET OE_INLINE v2di_t _reduce(v2di_t lo, v2di_t hi)
+{
+    v4su_t l = (v4su_t)lo;
+    v4su_t h = (v4su_t)hi;
+    v4su_t lc = l >> 31;
+    v4su_t hc = h >> 31;
+    v4su_t t;
+
+    l = (l << 1) | SHUFFLE(lc, SHIFT_LEFT_4_MASK);
+    h = (h << 1) | SHUFFLE(hc, SHIFT_LEFT_4_MASK) |
+        SHUFFLE(lc, SHIFT_RIGHT_12_MASK);
+
+    t = (l << 31) ^ (l << 30) ^ (l << 25);
+    l ^= SHUFFLE(t, SHIFT_LEFT_12_MASK);
+    h ^= l ^ (l >> 1) ^ (l >> 2) ^ (l >> 7) ^ SHUFFLE(t, SHIFT_RIGHT_4_MASK);
+
+    return (v2di_t)h;
+}
+
+AESNI_TARGET OE_INLINE v2di_t _gfmul(v2di_t a, v2di_t b)
+{
+    v2di_t lo = {0, 0};
+    v2di_t mid = {0, 0};
+    v2di_t hi = {0, 0};
+
+    _clmul_add(a, b, &lo, &mid, &hi);
+    _combine(&lo, mid, &hi);
+    return _reduce(lo, hi);
+}
+
+/* Hash PARALLEL_BLOCKS blocks with a single reduction */
+AESNI_TARGET static v2di_t
+_ghash_parallel(const gcm_key_t* k, v2di_t y, const uint8_t* data)
+{
+    v2di_t x[PARALLEL_BLOCKS];
+    v2di_t lo = {0, 0};
+    v2di_t mid = {0, 0};
+    v2di_t hi = {0, 0};
+
+#define LOAD(J) x[J] = _reverse(_load(data + J * AES_BLOCK_SIZE));
+#define HASH(J) \
+    _clmul_add(x[J], k->h[PARALLEL_BLOCKS - 1 - J], &lo, &mid, &hi);
+
+    FOR_EACH_BLOCK(LOAD)
+    x[0] ^= y;
+    FOR_EACH_BLOCK(HASH)
+
+#undef LOAD
+#undef HASH
+
+    _combine(&lo, mid, &hi);
+    return _reduce(lo, hi);
+}
+
+/* Hash a block, of which only size bytes are given (zero-padded) */
+AESNI_TARGET OE_INLINE v2di_t
+_ghash_block(const gcm_key_t* k, v2di_t y, const uint8_t* data, size_t size)
+{
+    uint8_t block[AES_BLOCK_SIZE] = {0};
+
+    memcpy(block, data, size);
+    return _gfmul(y ^ _reverse(_load(block)), k->h[0]);
+}
+
+AESNI_TARGET static v2di_t
+_ghash(const gcm_key_t* k, v2di_t y, const uint8_t* data, size_t size)
+{
+    for (; size >= PARALLEL_BLOCKS * AES_BLOCK_SIZE;
+         data += PARALLEL_BLOCKS * AES_BLOCK_SIZE,
+         size -= PARALLEL_BLOCKS * AES_BLOCK_SIZE)
+        y = _ghash_parallel(k, y, data);
+
+    for (; size; data += AES_BLOCK_SIZE)
+    {
+        size_t n = size < AES_BLOCK_SIZE ? size : AES_BLOCK_SIZE;
+
+        y = _ghash_block(k, y, data, n);
+        size -= n;
+    }
+
+    return y;
+}
+
+/* The counter block of ctr, whose last word holds the 32-bit counter in
+ * native byte order so that it can be incremented as a vector */
+AESNI_TARGET OE_INLINE v2di_t _counter_block(v4su_t ctr)
+{
+    return (v2di_t)SHUFFLE(ctr, COUNTER_MASK);
+}
+
+/* XOR the keystream of the PARALLEL_BLOCKS counter blocks after ctr into
+ * output */
+AESNI_TARGET static void _ctr_parallel(
+    const gcm_key_t* k,
+    v4su_t ctr,
+    const uint8_t* input,
+    uint8_t* output)
+{
+    v2di_t b[PARALLEL_BLOCKS];
+
+#define START(J) \
+    b[J] = _counter_block(ctr + (v4su_t){0, 0, 0, J + 1}) ^ k->rk[0];
+#define ROUND(J) b[J] = __builtin_ia32_aesenc128(b[J], rk);
+#define FINISH(J)                                                          \
+    b[J] = __builtin_ia32_aesenclast128(b[J], k->rk[OE_AES_128_ROUNDS]) ^  \
+           _load(input + J * AES_BLOCK_SIZE);                             \
+    _store(output + J * AES_BLOCK_SIZE, b[J]);
+
+    FOR_EACH_BLOCK(START)
+
+    for (size_t i = 1; i < OE_AES_128_ROUNDS; i++)
+    {
+        v2di_t rk = k->rk[i];
+        FOR_EACH_BLOCK(ROUND)
+    }
+
+    FOR_EACH_BLOCK(FINISH)
+
+#undef START
+#undef ROUND
+#undef FINISH
+}
+
+AESNI_TARGET static void _aesni_init_key(gcm_key_t* k)
+{
+    v2di_t h;
+
+    k->rk[0] = _load(k->key);
+    oe_aesni_expand_key_128(k->rk);
+
+    h = _reverse(_encrypt_block(k->rk, (v2di_t){0, 0}));
+    k->h[0] = h;
+
+    for (size_t i = 1; i < PARALLEL_BLOCKS; i++)
+        k->h[i] = _gfmul(k->h[i - 1], h);
+}
+
+AESNI_TARGET static void _aesni_crypt(
+    const gcm_key_t* k,
+    const uint8_t* iv,
+    const uint8_t* aad,
+    size_t aad_size,
+    const uint8_t* input,
+    size_t size,
+    uint8_t* output,
+    bool encrypt,
+    uint8_t* tag)
+{
+    v4su_t ctr = {0, 0, 0, 1};
+    v2di_t j0;
+    v2di_t y = {0, 0};
+    v2di_t b;
+    const uint64_t aad_bits = (uint64_t)aad_size * 8;
+    const uint64_t bits = (uint64_t)size * 8;
+
+    memcpy(&ctr, iv, OE_GCM_IV_SIZE);
+    j0 = _counter_block(ctr);
+
+    if (aad_size)
+        y = _ghash(k, y, aad, aad_size);
+
+    /* Decryption hashes the ciphertext before it may be overwritten */
+    for (; size >= PARALLEL_BLOCKS * AES_BLOCK_SIZE;
+         input += PARALLEL_BLOCKS * AES_BLOCK_SIZE,
+         output += PARALLEL_BLOCKS * AES_BLOCK_SIZE,
+         size -= PARALLEL_BLOCKS * AES_BLOCK_SIZE)
+    {
+        if (!encrypt)
+            y = _ghash_parallel(k, y, input);
+
+        _ctr_parallel(k, ctr, input, output);
+        ctr += (v4su_t){0, 0, 0, PARALLEL_BLOCKS};
+
+        if (encrypt)
+            y = _ghash_parallel(k, y, output);
+    }
+
+    for (; size; input += AES_BLOCK_SIZE, output += AES_BLOCK_SIZE)
+    {
+        size_t n = size < AES_BLOCK_SIZE ? size : AES_BLOCK_SIZE;
+        uint8_t block[AES_BLOCK_SIZE] = {0};
+
+        if (!encrypt)
+            y = _ghash_block(k, y, input, n);
+
+        ctr += (v4su_t){0, 0, 0, 1};
+        memcpy(block, input, n);
+        b = _encrypt_block(k->rk, _counter_block(ctr)) ^ _load(block);
+        memcpy(output, &b, n);
+
+        if (encrypt)
+            y = _ghash_block(k, y, output, n);
+
+        size -= n;
+    }
+
+    /* The byte-reversed length block */
+    y = _gfmul(y ^ (v2di_t){(long long)bits, (long long)aad_bits}, k->h[0]);
+
+    b = _encrypt_block(k->rk, j0) ^ _reverse(y);
+    memcpy(tag, &b, OE_GCM_TAG_SIZE);
+
+    oe_secure_zero_fill(&b, sizeof(b));
+}
+
+#endif /* defined(USE_AESNI) */
+
+static oe_result_t _mbedtls_crypt(
+    const gcm_key_t* k,
+    const uint8_t* iv,
+    const uint8_t* aad,
+    size_t aad_size,
+    const uint8_t* input,
+    size_t size,
+    uint8_t* output,
+    bool encrypt,
+    uint8_t* tag)
+{
+    oe_result_t result = OE_UNEXPECTED;
+    mbedtls_gcm_context gcm;
+
+    mbedtls_gcm_init(&gcm);
+
+    if (mbedtls_gcm_setkey(
+            &gcm, MBEDTLS_CIPHER_ID_AES, k->key, AES_128_KEY_SIZE * 8) != 0)
+        OE_RAISE(OE_CRYPTO_ERROR);
+
+    /* In both directions, the tag is computed over the ciphertext */
+    if (mbedtls_gcm_crypt_and_tag(
+            &gcm,
+            encrypt ? MBEDTLS_GCM_ENCRYPT : MBEDTLS_GCM_DECRYPT,
+            size,
+            iv,
+            OE_GCM_IV_SIZE,
+            aad,
+            aad_size,
+            input,
+            output,
+            OE_GCM_TAG_SIZE,
+            tag) != 0)
+        OE_RAISE(OE_CRYPTO_ERROR);
+
+    result = OE_OK;
+
+done:
+    mbedtls_gcm_free(&gcm);
+    return result;
+}
+
+static oe_result_t _crypt(
+    const oe_aes_gcm_key_t* gcm_key,
+    const uint8_t* iv,
+    const uint8_t* aad,
+    size_t aad_size,
+    const uint8_t* input,
+    size_t size,
+    uint8_t* output,
+    bool encrypt,
+    uint8_t* tag)
+{
+    const gcm_key_t* k = (const gcm_key_t*)gcm_key->impl;
+
+    if (!iv || (!aad && aad_size) || (size && (!input || !output)) || !tag)
+        return OE_INVALID_PARAMETER;
+
+    /* At most 2^32 - 2 blocks per message */
+    if ((uint64_t)size > ((1ULL << 32) - 2) * AES_BLOCK_SIZE)
+        return OE_INVALID_PARAMETER;
+
+#if defined(USE_AESNI)
+    if (k->aesni)
+    {
+        _aesni_crypt(k, iv, aad, aad_size, input, size, output, encrypt, tag);
+        return OE_OK;
+    }
+#endif
+
+    return _mbedtls_crypt(
+        k, iv, aad, aad_size, input, size, output, encrypt, tag);
+}
+
+static oe_result_t _init_key(
+    const uint8_t* key,
+    size_t key_size,
+    bool aesni,
+    oe_aes_gcm_key_t* gcm_key)
+{
+    gcm_key_t* k;
+
+    if (!key || !gcm_key)
+        return OE_INVALID_PARAMETER;
+
+    if (key_size != AES_128_KEY_SIZE)
+        return OE_UNSUPPORTED;
+
+    oe_secure_zero_fill(gcm_key, sizeof(*gcm_key));
+    k = (gcm_key_t*)gcm_key->impl;
+    memcpy(k->key, key, AES_128_KEY_SIZE);
+
+#if defined(USE_AESNI)
+    if ((k->aesni = aesni && _has_aesni()))
+        _aesni_init_key(k);
+#else
+    OE_UNUSED(aesni);
+#endif
+
+    return OE_OK;
+}
+
+oe_result_t oe_aes_gcm_init_key(
+    const uint8_t* key,
+    size_t key_size,
+    oe_aes_gcm_key_t* gcm_key)
+{
+    return _init_key(key, key_size, true, gcm_key);
+}
+
+oe_result_t oe_aes_gcm_init_key_portable(
+    const uint8_t* key,
+    size_t key_size,
+    oe_aes_gcm_key_t* gcm_key)
+{
+    return _init_key(key, key_size, false, gcm_key);
+}
+
+void oe_aes_gcm_free_key(oe_aes_gcm_key_t* gcm_key)
+{
+    if (gcm_key)
+        oe_secure_zero_fill(gcm_key, sizeof(*gcm_key));
+}
+
+oe_result_t oe_aes_gcm_encrypt(
+    const oe_aes_gcm_key_t* gcm_key,
+    const uint8_t* iv,
+    const uint8_t* aad,
+    size_t aad_size,
+    const uint8_t* input,
+    size_t size,
+    uint8_t* output,
+    uint8_t* tag)
+{
+    if (!gcm_key)
+        return OE_INVALID_PARAMETER;
+
+    return _crypt(gcm_key, iv, aad, aad_size, input, size, output, true, tag);
+}
+
+oe_result_t oe_aes_gcm_decrypt(
+    const oe_aes_gcm_key_t* gcm_key,
+    const uint8_t* iv,
+    const uint8_t* aad,
+    size_t aad_size,
+    const uint8_t* input,
+    size_t size,
+    uint8_t* output,
+    const uint8_t* tag)
+{
+    oe_result_t result = OE_UNEXPECTED;
+    uint8_t computed[OE_GCM_TAG_SIZE];
+
+    if (!gcm_key || !tag)
+        OE_RAISE(OE_INVALID_PARAMETER);
+
+    OE_CHECK(_crypt(
+        gcm_key, iv, aad, aad_size, input, size, output, false, computed));
+
+    if (!oe_constant_time_mem_equal(computed, tag, sizeof(computed)))
+    {
+        oe_secure_zero_fill(output, size);
+        OE_RAISE_NO_TRACE(OE_CRYPTO_ERROR);
+    }
+
+    result = OE_OK;
+
+done:
+    return result;
+}
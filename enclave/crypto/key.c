@@ -2,6 +2,8 @@
 // Licensed under the MIT License.
 
 #include "key.h"
+#include <openenclave/corelibc/stdlib.h>
+#include <openenclave/internal/atomic.h>
 #include <openenclave/internal/crypto/hash.h>
 #include <openenclave/internal/raise.h>
 #include <openenclave/internal/safecrt.h>
@@ -14,6 +16,51 @@ typedef oe_result_t (*oe_copy_key)(
     const mbedtls_pk_context* src,
     bool copy_private_fields);
 
+/*
+**==============================================================================
+**
+** Referent:
+**     The parsed key shared by the handles of a key. A key is parsed (or
+**     copied) once when the first handle is initialized; further handles
+**     from oe_private_key_share() and oe_public_key_share() refer to the same
+**     mbedTLS context and only take a reference.
+**
+**==============================================================================
+*/
+
+static oe_key_referent_t* _referent_new(void)
+{
+    oe_key_referent_t* referent;
+
+    if (!(referent = (oe_key_referent_t*)oe_calloc(1, sizeof(*referent))))
+        return NULL;
+
+    if (oe_mutex_init(&referent->lock) != OE_OK)
+    {
+        oe_free(referent);
+        return NULL;
+    }
+
+    referent->refs = 1;
+
+    return referent;
+}
+
+/* Drop a reference and return whether it was the last one */
+static bool _referent_free(oe_key_referent_t* referent)
+{
+    if (!referent)
+        return true;
+
+    if (oe_atomic_decrement(&referent->refs) != 0)
+        return false;
+
+    oe_mutex_destroy(&referent->lock);
+    oe_free(referent);
+
+    return true;
+}
+
 bool oe_private_key_is_valid(
     const oe_private_key_t* private_key,
     uint64_t magic)
@@ -28,22 +75,29 @@ oe_result_t oe_private_key_init(
     uint64_t magic)
 {
     oe_result_t result = OE_UNEXPECTED;
+    oe_key_referent_t* referent = NULL;
 
     if (!private_key || (pk && !copy_key) || (copy_key && !pk))
         OE_RAISE(OE_INVALID_PARAMETER);
 
     private_key->magic = 0;
 
+    if (!(referent = _referent_new()))
+        OE_RAISE(OE_OUT_OF_MEMORY);
+
     if (pk && copy_key)
         OE_CHECK(copy_key(&private_key->pk, pk, true));
     else
         mbedtls_pk_init(&private_key->pk);
 
+    private_key->referent = referent;
     private_key->magic = magic;
+    referent = NULL;
 
     result = OE_OK;
 
 done:
+    _referent_free(referent);
     return result;
 }
 
@@ -51,11 +105,37 @@ void oe_private_key_release(oe_private_key_t* private_key, uint64_t magic)
 {
     if (oe_private_key_is_valid(private_key, magic))
     {
-        mbedtls_pk_free(&private_key->pk);
+        /* The last handle releases the key */
+        if (_referent_free(private_key->referent))
+            mbedtls_pk_free(&private_key->pk);
+
         oe_secure_zero_fill(private_key, sizeof(oe_private_key_t));
     }
 }
 
+oe_result_t oe_private_key_share(
+    const oe_private_key_t* private_key,
+    oe_private_key_t* shared,
+    uint64_t magic)
+{
+    oe_result_t result = OE_UNEXPECTED;
+
+    if (shared && shared != private_key)
+        oe_secure_zero_fill(shared, sizeof(oe_private_key_t));
+
+    if (!oe_private_key_is_valid(private_key, magic) || !shared ||
+        shared == private_key)
+        OE_RAISE(OE_INVALID_PARAMETER);
+
+    oe_atomic_increment(&private_key->referent->refs);
+    *shared = *private_key;
+
+    result = OE_OK;
+
+done:
+    return result;
+}
+
 bool oe_public_key_is_valid(const oe_public_key_t* public_key, uint64_t magic)
 {
     return public_key && public_key->magic == magic;
@@ -68,22 +148,29 @@ oe_result_t oe_public_key_init(
     uint64_t magic)
 {
     oe_result_t result = OE_UNEXPECTED;
+    oe_key_referent_t* referent = NULL;
 
     if (!public_key || (pk && !copy_key) || (copy_key && !pk))
         OE_RAISE(OE_INVALID_PARAMETER);
 
     public_key->magic = 0;
 
+    if (!(referent = _referent_new()))
+        OE_RAISE(OE_OUT_OF_MEMORY);
+
     if (pk && copy_key)
         OE_CHECK(copy_key(&public_key->pk, pk, false));
     else
         mbedtls_pk_init(&public_key->pk);
 
+    public_key->referent = referent;
     public_key->magic = magic;
+    referent = NULL;
 
     result = OE_OK;
 
 done:
+    _referent_free(referent);
     return result;
 }
 
@@ -91,11 +178,37 @@ void oe_public_key_release(oe_public_key_t* public_key, uint64_t magic)
 {
     if (oe_public_key_is_valid(public_key, magic))
     {
-        mbedtls_pk_free(&public_key->pk);
+        /* The last handle releases the key */
+        if (_referent_free(public_key->referent))
+            mbedtls_pk_free(&public_key->pk);
+
         oe_secure_zero_fill(public_key, sizeof(oe_public_key_t));
     }
 }
 
+oe_result_t oe_public_key_share(
+    const oe_public_key_t* public_key,
+    oe_public_key_t* shared,
+    uint64_t magic)
+{
+    oe_result_t result = OE_UNEXPECTED;
+
+    if (shared && shared != public_key)
+        oe_secure_zero_fill(shared, sizeof(oe_public_key_t));
+
+    if (!oe_public_key_is_valid(public_key, magic) || !shared ||
+        shared == public_key)
+        OE_RAISE(OE_INVALID_PARAMETER);
+
+    oe_atomic_increment(&public_key->referent->refs);
+    *shared = *public_key;
+
+    result = OE_OK;
+
+done:
+    return result;
+}
+
 /*
 **==============================================================================
 **
@@ -363,6 +476,7 @@ oe_result_t oe_private_key_sign(
 
     // Sign the message. Note that buffer_size is an output parameter only.
     // MEBEDTLS provides no way to determine the size of the buffer up front.
+    oe_mutex_lock(&private_key->referent->lock);
     rc = mbedtls_pk_sign(
         (mbedtls_pk_context*)&private_key->pk,
         type,
@@ -372,6 +486,7 @@ oe_result_t oe_private_key_sign(
         &buffer_size,
         NULL,
         NULL);
+    oe_mutex_unlock(&private_key->referent->lock);
     if (rc != 0)
         OE_RAISE_MSG(OE_CRYPTO_ERROR, "rc = 0x%x\n", rc);
 
@@ -412,6 +527,7 @@ oe_result_t oe_public_key_verify(
         OE_RAISE(OE_INVALID_PARAMETER);
 
     /* Verify the signature */
+    oe_mutex_lock(&public_key->referent->lock);
     rc = mbedtls_pk_verify(
         (mbedtls_pk_context*)&public_key->pk,
         type,
@@ -419,6 +535,7 @@ oe_result_t oe_public_key_verify(
         hash_size,
         signature,
         signature_size);
+    oe_mutex_unlock(&public_key->referent->lock);
     if (rc != 0)
         OE_RAISE_MSG(OE_VERIFY_FAILED, "rc = 0x%x", rc * (-1));
 
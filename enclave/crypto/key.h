@@ -9,17 +9,30 @@
 #include <openenclave/bits/result.h>
 #include <openenclave/bits/types.h>
 #include <openenclave/internal/crypto/hash.h>
+#include <openenclave/internal/thread.h>
+
+/* The parsed key shared by all handles of a key (see oe_public_key_share()).
+ * The key itself is never modified once it is initialized, but mbedTLS
+ * updates cached values in the key context while signing and verifying, so
+ * those calls are serialized by the lock. */
+typedef struct _oe_key_referent
+{
+    volatile uint64_t refs;
+    oe_mutex_t lock;
+} oe_key_referent_t;
 
 typedef struct _oe_private_key
 {
     uint64_t magic;
     mbedtls_pk_context pk;
+    oe_key_referent_t* referent;
 } oe_private_key_t;
 
 typedef struct _oe_public_key
 {
     uint64_t magic;
     mbedtls_pk_context pk;
+    oe_key_referent_t* referent;
 } oe_public_key_t;
 
 typedef oe_result_t (*oe_copy_key)(
@@ -39,6 +52,11 @@ oe_result_t oe_private_key_init(
 
 void oe_private_key_release(oe_private_key_t* private_key, uint64_t magic);
 
+oe_result_t oe_private_key_share(
+    const oe_private_key_t* private_key,
+    oe_private_key_t* shared,
+    uint64_t magic);
+
 bool oe_public_key_is_valid(const oe_public_key_t* public_key, uint64_t magic);
 
 oe_result_t oe_public_key_init(
@@ -49,6 +67,11 @@ oe_result_t oe_public_key_init(
 
 void oe_public_key_release(oe_public_key_t* public_key, uint64_t magic);
 
+oe_result_t oe_public_key_share(
+    const oe_public_key_t* public_key,
+    oe_public_key_t* shared,
+    uint64_t magic);
+
 oe_result_t oe_private_key_read_pem(
     const uint8_t* pem_data,
     size_t pem_size,
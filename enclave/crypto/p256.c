@@ -0,0 +1,1359 @@
+// Copyright (c) Open Enclave SDK contributors.
+// Licensed under the MIT License.
+
+#include "p256.h"
+#include <mbedtls/asn1.h>
+#include <mbedtls/ecp.h>
+#include <openenclave/corelibc/stdlib.h>
+#include <openenclave/enclave.h>
+#include <openenclave/internal/raise.h>
+#include <openenclave/internal/thread.h>
+#include <string.h>
+
+/*
+**==============================================================================
+**
+** Verify-only P-256 ECDSA:
+**
+**     Quote, TCB info and certificate chain verification verify a handful
+**     of P-256 signatures each, mostly with the same few keys (the Intel
+**     root and intermediate CA keys, the PCK and TCB signing keys). This
+**     file verifies them without mbedTLS:
+**
+**     - Field elements are four 64-bit limbs in Montgomery form, multiplied
+**       with 128-bit products. Points are Jacobian, with Z = 0 for the
+**       point at infinity.
+**
+**     - u1 * G is computed with a Lim-Lee comb: a table of the 255 sums of
+**       distinct multiples 2^(32 * j) * G (j < 8), so that the product
+**       takes 32 doublings and at most 32 additions. The table is built
+**       the first time a signature is verified.
+**
+**     - u2 * Q uses a comb table of Q too when Q is in the key cache,
+**       sharing the doublings with u1 * G. Otherwise it is a width-5 NAF
+**       multiplication, into which the comb of G is folded.
+**
+**     - A key is cached the second time it is seen (among the last
+**       CANDIDATE_COUNT keys seen once), so that one-off keys, such as leaf
+**       certificate keys, do not evict the keys worth caching. The least
+**       recently used key is evicted when the cache is full. A key is
+**       cached at once if a batch of at least BATCH_CACHE_COUNT signatures is
+**       verified with it.
+**
+**     - oe_p256_verify_batch() verifies the signatures of a batch in groups
+**       of VERIFY_BATCH_SIZE, computing the inverses of the s values of a
+**       group with a single inversion (Montgomery's trick).
+**
+**     All inputs are public, so the code is not constant-time.
+**
+**==============================================================================
+*/
+
+typedef unsigned __int128 uint128_t;
+
+typedef uint64_t fe_t[4];
+
+typedef struct _jacobian
+{
+    fe_t x;
+    fe_t y;
+    fe_t z;
+} jacobian_t;
+
+typedef struct _affine
+{
+    fe_t x;
+    fe_t y;
+} affine_t;
+
+#define COMB_TEETH 8
+#define COMB_SPACING 32
+#define COMB_POINTS ((1 << COMB_TEETH) - 1)
+
+/* comb.points[b - 1] = sum of 2^(COMB_SPACING * j) * P for the bits j of b */
+typedef struct _comb
+{
+    affine_t points[COMB_POINTS];
+} comb_t;
+
+#define WNAF_WIDTH 5
+#define WNAF_POINTS (1 << (WNAF_WIDTH - 2))
+#define WNAF_DIGITS 257
+
+#define CACHE_SIZE 8
+#define CANDIDATE_COUNT 16
+#define BATCH_CACHE_COUNT 8
+
+#define VERIFY_BATCH_SIZE 32
+
+typedef struct _cached_key
+{
+    uint8_t xy[2 * OE_P256_COORDINATE_SIZE];
+    uint64_t last_use;
+    size_t refs;
+    bool evicted;
+    comb_t comb;
+} cached_key_t;
+
+/* The field prime p = 2^256 - 2^224 + 2^192 + 2^96 - 1 */
+static const fe_t _p = {0xffffffffffffffff,
+                        0x00000000ffffffff,
+                        0x0000000000000000,
+                        0xffffffff00000001};
+
+static const fe_t _p_minus_2 = {0xfffffffffffffffd,
+                                0x00000000ffffffff,
+                                0x0000000000000000,
+                                0xffffffff00000001};
+
+/* 2^512 mod p, to convert to Montgomery form */
+static const fe_t _p_rr = {0x0000000000000003,
+                           0xfffffffbffffffff,
+                           0xfffffffffffffffe,
+                           0x00000004fffffffd};
+
+/* 1 and the curve coefficient b in Montgomery form */
+static const fe_t _one = {0x0000000000000001,
+                          0xffffffff00000000,
+                          0xffffffffffffffff,
+                          0x00000000fffffffe};
+
+static const fe_t _b = {0xd89cdf6229c4bddf,
+                        0xacf005cd78843090,
+                        0xe5a220abf7212ed6,
+                        0xdc30061d04874834};
+
+/* The base point G in Montgomery form */
+static const affine_t _g = {{0x79e730d418a9143c,
+                             0x75ba95fc5fedb601,
+                             0x79fb732b77622510,
+                             0x18905f76a53755c6},
+                            {0xddf25357ce95560a,
+                             0x8b4ab8e4ba19e45c,
+                             0xd2e88688dd21f325,
+                             0x8571ff1825885d85}};
+
+/* The group order n, and -1 / n mod 2^64 */
+static const fe_t _n = {0xf3b9cac2fc632551,
+                        0xbce6faada7179e84,
+                        0xffffffffffffffff,
+                        0xffffffff00000000};
+
+static const fe_t _n_minus_2 = {0xf3b9cac2fc63254f,
+                                0xbce6faada7179e84,
+                                0xffffffffffffffff,
+                                0xffffffff00000000};
+
+#define N_INV 0xccd1c8aaee00bc4f
+
+/* 2^512 mod n */
+static const fe_t _n_rr = {0x83244c95be79eea2,
+                           0x4699799c49bd6fa6,
+                           0x2845b2392b6bec59,
+                           0x66e12d94f3d95620};
+
+/* p - n, below which r + n is also a candidate x-coordinate */
+static const fe_t _p_minus_n = {0x0c46353d039cdaae,
+                                0x4319055358e8617b,
+                                0x0000000000000000,
+                                0x0000000000000000};
+
+static comb_t* _g_comb;
+static oe_spinlock_t _g_comb_lock = OE_SPINLOCK_INITIALIZER;
+
+static cached_key_t* _cache[CACHE_SIZE];
+static uint64_t _candidates[CANDIDATE_COUNT];
+static size_t _next_candidate;
+static uint64_t _clock;
+static oe_spinlock_t _cache_lock = OE_SPINLOCK_INITIALIZER;
+
+/*
+**==============================================================================
+**
+** Arithmetic modulo p and n
+**
+**==============================================================================
+*/
+
+static bool _is_zero(const fe_t a)
+{
+    return (a[0] | a[1] | a[2] | a[3]) == 0;
+}
+
+static bool _equal(const fe_t a, const fe_t b)
+{
+    return ((a[0] ^ b[0]) | (a[1] ^ b[1]) | (a[2] ^ b[2]) | (a[3] ^ b[3])) ==
+           0;
+}
+
+/* Whether a < b */
+static bool _less(const fe_t a, const fe_t b)
+{
+    for (size_t i = 4; i-- > 0;)
+    {
+        if (a[i] != b[i])
+            return a[i] < b[i];
+    }
+
+    return false;
+}
+
+OE_INLINE uint64_t _mac(uint64_t a, uint64_t b, uint64_t c, uint64_t* carry)
+{
+    uint128_t x = (uint128_t)a * b + c + *carry;
+    *carry = (uint64_t)(x >> 64);
+    return (uint64_t)x;
+}
+
+OE_INLINE uint64_t _adc(uint64_t a, uint64_t b, uint64_t* carry)
+{
+    uint128_t x = (uint128_t)a + b + *carry;
+    *carry = (uint64_t)(x >> 64);
+    return (uint64_t)x;
+}
+
+OE_INLINE uint64_t _sbb(uint64_t a, uint64_t b, uint64_t* borrow)
+{
+    uint128_t x = (uint128_t)a - b - *borrow;
+    *borrow = (uint64_t)(x >> 64) & 1;
+    return (uint64_t)x;
+}
+
+/* r = t - m if t + 2^256 * carry >= m, else r = t */
+OE_INLINE void _reduce_once(
+    fe_t r,
+    const uint64_t t[4],
+    uint64_t carry,
+    const fe_t m)
+{
+    uint64_t borrow = 0;
+    uint64_t d0 = _sbb(t[0], m[0], &borrow);
+    uint64_t d1 = _sbb(t[1], m[1], &borrow);
+    uint64_t d2 = _sbb(t[2], m[2], &borrow);
+    uint64_t d3 = _sbb(t[3], m[3], &borrow);
+
+    if (carry || !borrow)
+    {
+        r[0] = d0;
+        r[1] = d1;
+        r[2] = d2;
+        r[3] = d3;
+    }
+    else if (r != t)
+        memcpy(r, t, sizeof(fe_t));
+}
+
+/*
+ * The multiplications are written out, as compilers do not unroll the loops
+ * at -O2.
+ */
+
+/* t[0..4] = t[0..3] + a * b */
+OE_INLINE void _mul_row(uint64_t t[5], const fe_t a, uint64_t b)
+{
+    uint64_t c = 0;
+
+    t[0] = _mac(a[0], b, t[0], &c);
+    t[1] = _mac(a[1], b, t[1], &c);
+    t[2] = _mac(a[2], b, t[2], &c);
+    t[3] = _mac(a[3], b, t[3], &c);
+    t[4] = c;
+}
+
+/* t = a * b */
+OE_INLINE void _mul_256(uint64_t t[8], const fe_t a, const fe_t b)
+{
+    t[0] = t[1] = t[2] = t[3] = 0;
+    _mul_row(t, a, b[0]);
+    _mul_row(t + 1, a, b[1]);
+    _mul_row(t + 2, a, b[2]);
+    _mul_row(t + 3, a, b[3]);
+}
+
+/* t[0..1] += a^2 plus the carry, which is updated */
+OE_INLINE void _add_square(uint64_t t[2], uint64_t a, uint64_t* carry)
+{
+    uint64_t hi = 0;
+    uint64_t lo = _mac(a, a, 0, &hi);
+
+    t[0] = _adc(t[0], lo, carry);
+    t[1] = _adc(t[1], hi, carry);
+}
+
+/* t = a^2, with the products a[i] * a[j] for i < j computed once */
+OE_INLINE void _sqr_256(uint64_t t[8], const fe_t a)
+{
+    uint64_t c = 0;
+
+    t[1] = _mac(a[0], a[1], 0, &c);
+    t[2] = _mac(a[0], a[2], 0, &c);
+    t[3] = _mac(a[0], a[3], 0, &c);
+    t[4] = c;
+    c = 0;
+    t[3] = _mac(a[1], a[2], t[3], &c);
+    t[4] = _mac(a[1], a[3], t[4], &c);
+    t[5] = c;
+    c = 0;
+    t[5] = _mac(a[2], a[3], t[5], &c);
+    t[6] = c;
+
+    t[7] = t[6] >> 63;
+    t[6] = t[6] << 1 | t[5] >> 63;
+    t[5] = t[5] << 1 | t[4] >> 63;
+    t[4] = t[4] << 1 | t[3] >> 63;
+    t[3] = t[3] << 1 | t[2] >> 63;
+    t[2] = t[2] << 1 | t[1] >> 63;
+    t[1] <<= 1;
+
+    t[0] = 0;
+    c = 0;
+    _add_square(t, a[0], &c);
+    _add_square(t + 2, a[1], &c);
+    _add_square(t + 4, a[2], &c);
+    _add_square(t + 6, a[3], &c);
+}
+
+/*
+ * Montgomery reduction: r = t / 2^256 mod m, for t < m * 2^256. A round adds
+ * q * m to t[0..4], with q chosen so that t[0] becomes 0, and keeps the carry
+ * out of t[4] in t[0], which is added in once the rounds are done.
+ */
+
+/* A round modulo p, where q = t[0] and q * (2^64 - 1) + q * (2^32 - 1) * 2^64,
+ * from the two low limbs of p, is q * 2^96 */
+OE_INLINE void _fe_reduce_round(uint64_t t[5])
+{
+    uint64_t q = t[0];
+    uint64_t c = 0;
+
+    t[1] = _adc(t[1], q << 32, &c);
+    t[2] = _adc(t[2], q >> 32, &c);
+    t[3] = _mac(q, _p[3], t[3], &c);
+    t[4] = _adc(t[4], 0, &c);
+    t[0] = c;
+}
+
+OE_INLINE void _n_reduce_round(uint64_t t[5])
+{
+    uint64_t q = t[0] * N_INV;
+    uint64_t c = 0;
+
+    _mac(q, _n[0], t[0], &c);
+    t[1] = _mac(q, _n[1], t[1], &c);
+    t[2] = _mac(q, _n[2], t[2], &c);
+    t[3] = _mac(q, _n[3], t[3], &c);
+    t[4] = _adc(t[4], 0, &c);
+    t[0] = c;
+}
+
+OE_INLINE void _reduce_finish(fe_t r, uint64_t t[8], const fe_t m)
+{
+    uint64_t c = 0;
+
+    t[5] = _adc(t[5], t[0], &c);
+    t[6] = _adc(t[6], t[1], &c);
+    t[7] = _adc(t[7], t[2], &c);
+    _reduce_once(r, t + 4, t[3] + c, m);
+}
+
+OE_INLINE void _fe_reduce(fe_t r, uint64_t t[8])
+{
+    _fe_reduce_round(t);
+    _fe_reduce_round(t + 1);
+    _fe_reduce_round(t + 2);
+    _fe_reduce_round(t + 3);
+    _reduce_finish(r, t, _p);
+}
+
+/* r = a * b / 2^256 mod p */
+static void _fe_mul(fe_t r, const fe_t a, const fe_t b)
+{
+    uint64_t t[8];
+
+    _mul_256(t, a, b);
+    _fe_reduce(r, t);
+}
+
+/* r = a^2 / 2^256 mod p */
+static void _fe_sqr(fe_t r, const fe_t a)
+{
+    uint64_t t[8];
+
+    _sqr_256(t, a);
+    _fe_reduce(r, t);
+}
+
+/* r = a * b / 2^256 mod n */
+static void _n_mul(fe_t r, const fe_t a, const fe_t b)
+{
+    uint64_t t[8];
+
+    _mul_256(t, a, b);
+    _n_reduce_round(t);
+    _n_reduce_round(t + 1);
+    _n_reduce_round(t + 2);
+    _n_reduce_round(t + 3);
+    _reduce_finish(r, t, _n);
+}
+
+/* r = a^e in Montgomery form, with 4-bit windows, for e whose top 4 bits are
+ * not all zero */
+static void _pow(
+    fe_t r,
+    const fe_t a,
+    const fe_t e,
+    void (*mul)(fe_t, const fe_t, const fe_t))
+{
+    fe_t powers[16];
+    fe_t t;
+
+    memcpy(powers[1], a, sizeof(fe_t));
+
+    for (size_t i = 2; i < 16; i++)
+        mul(powers[i], powers[i - 1], a);
+
+    memcpy(t, powers[e[3] >> 60], sizeof(fe_t));
+
+    for (size_t i = 63; i-- > 0;)
+    {
+        size_t window = (size_t)(e[i / 16] >> (4 * (i % 16))) & 15;
+
+        mul(t, t, t);
+        mul(t, t, t);
+        mul(t, t, t);
+        mul(t, t, t);
+
+        if (window)
+            mul(t, t, powers[window]);
+    }
+
+    memcpy(r, t, sizeof(fe_t));
+}
+
+static void _fe_add(fe_t r, const fe_t a, const fe_t b)
+{
+    uint64_t t[4];
+    uint64_t carry = 0;
+
+    t[0] = _adc(a[0], b[0], &carry);
+    t[1] = _adc(a[1], b[1], &carry);
+    t[2] = _adc(a[2], b[2], &carry);
+    t[3] = _adc(a[3], b[3], &carry);
+
+    _reduce_once(r, t, carry, _p);
+}
+
+static void _fe_sub(fe_t r, const fe_t a, const fe_t b)
+{
+    uint64_t borrow = 0;
+    uint64_t t0 = _sbb(a[0], b[0], &borrow);
+    uint64_t t1 = _sbb(a[1], b[1], &borrow);
+    uint64_t t2 = _sbb(a[2], b[2], &borrow);
+    uint64_t t3 = _sbb(a[3], b[3], &borrow);
+    uint64_t mask = 0 - borrow;
+    uint64_t carry = 0;
+
+    /* Add p back if a < b */
+    r[0] = _adc(t0, _p[0] & mask, &carry);
+    r[1] = _adc(t1, _p[1] & mask, &carry);
+    r[2] = _adc(t2, _p[2] & mask, &carry);
+    r[3] = _adc(t3, _p[3] & mask, &carry);
+}
+
+static void _fe_inv(fe_t r, const fe_t a)
+{
+    _pow(r, a, _p_minus_2, _fe_mul);
+}
+
+/* Read a big-endian number, which must be below m */
+static bool _read(fe_t r, const uint8_t* data, size_t size, const fe_t m)
+{
+    memset(r, 0, sizeof(fe_t));
+
+    for (size_t i = 0; i < size; i++)
+    {
+        size_t bit = 8 * (size - 1 - i);
+        r[bit / 64] |= (uint64_t)data[i] << (bit % 64);
+    }
+
+    return _less(r, m);
+}
+
+/*
+**==============================================================================
+**
+** Points
+**
+**==============================================================================
+*/
+
+static void _set_affine(jacobian_t* r, const affine_t* a)
+{
+    memcpy(r->x, a->x, sizeof(fe_t));
+    memcpy(r->y, a->y, sizeof(fe_t));
+    memcpy(r->z, _one, sizeof(fe_t));
+}
+
+/* r = 2 * a (dbl-2001-b, for curves with a = -3) */
+static void _point_double(jacobian_t* r, const jacobian_t* a)
+{
+    fe_t delta, gamma, beta, alpha, t;
+
+    if (_is_zero(a->z))
+    {
+        *r = *a;
+        return;
+    }
+
+    _fe_sqr(delta, a->z);
+    _fe_sqr(gamma, a->y);
+    _fe_mul(beta, a->x, gamma);
+
+    /* alpha = 3 * (x - delta) * (x + delta) */
+    _fe_sub(t, a->x, delta);
+    _fe_add(alpha, a->x, delta);
+    _fe_mul(alpha, alpha, t);
+    _fe_add(t, alpha, alpha);
+    _fe_add(alpha, alpha, t);
+
+    /* z3 = (y + z)^2 - gamma - delta */
+    _fe_add(t, a->y, a->z);
+    _fe_sqr(t, t);
+    _fe_sub(t, t, gamma);
+    _fe_sub(r->z, t, delta);
+
+    /* x3 = alpha^2 - 8 * beta */
+    _fe_add(beta, beta, beta);
+    _fe_add(beta, beta, beta);
+    _fe_sqr(t, alpha);
+    _fe_sub(t, t, beta);
+    _fe_sub(r->x, t, beta);
+
+    /* y3 = alpha * (4 * beta - x3) - 8 * gamma^2 */
+    _fe_sub(t, beta, r->x);
+    _fe_mul(t, alpha, t);
+    _fe_sqr(gamma, gamma);
+    _fe_add(gamma, gamma, gamma);
+    _fe_add(gamma, gamma, gamma);
+    _fe_add(gamma, gamma, gamma);
+    _fe_sub(r->y, t, gamma);
+}
+
+/* r = a + b (madd-2007-bl) */
+static void _point_add_affine(
+    jacobian_t* r,
+    const jacobian_t* a,
+    const affine_t* b)
+{
+    fe_t z1z1, u2, s2, h, hh, i, j, rr, v, t;
+
+    if (_is_zero(a->z))
+    {
+        _set_affine(r, b);
+        return;
+    }
+
+    _fe_sqr(z1z1, a->z);
+    _fe_mul(u2, b->x, z1z1);
+    _fe_mul(s2, b->y, a->z);
+    _fe_mul(s2, s2, z1z1);
+    _fe_sub(h, u2, a->x);
+    _fe_sub(rr, s2, a->y);
+
+    if (_is_zero(h))
+    {
+        if (_is_zero(rr))
+            _point_double(r, a);
+        else
+            memset(r, 0, sizeof(*r));
+        return;
+    }
+
+    _fe_sqr(hh, h);
+    _fe_add(i, hh, hh);
+    _fe_add(i, i, i);
+    _fe_mul(j, h, i);
+    _fe_add(rr, rr, rr);
+    _fe_mul(v, a->x, i);
+
+    /* z3 = (z1 + h)^2 - z1z1 - hh */
+    _fe_add(t, a->z, h);
+    _fe_sqr(t, t);
+    _fe_sub(t, t, z1z1);
+    _fe_sub(r->z, t, hh);
+
+    /* y1 * j, before r->y is written */
+    _fe_mul(s2, a->y, j);
+    _fe_add(s2, s2, s2);
+
+    /* x3 = rr^2 - j - 2 * v */
+    _fe_sqr(t, rr);
+    _fe_sub(t, t, j);
+    _fe_sub(t, t, v);
+    _fe_sub(r->x, t, v);
+
+    /* y3 = rr * (v - x3) - 2 * y1 * j */
+    _fe_sub(t, v, r->x);
+    _fe_mul(t, rr, t);
+    _fe_sub(r->y, t, s2);
+}
+
+/* r = a + b (add-2007-bl) */
+static void _point_add(jacobian_t* r, const jacobian_t* a, const jacobian_t* b)
+{
+    fe_t z1z1, z2z2, u1, u2, s1, s2, h, i, j, rr, v, t;
+
+    if (_is_zero(a->z))
+    {
+        *r = *b;
+        return;
+    }
+
+    if (_is_zero(b->z))
+    {
+        *r = *a;
+        return;
+    }
+
+    _fe_sqr(z1z1, a->z);
+    _fe_sqr(z2z2, b->z);
+    _fe_mul(u1, a->x, z2z2);
+    _fe_mul(u2, b->x, z1z1);
+    _fe_mul(s1, a->y, b->z);
+    _fe_mul(s1, s1, z2z2);
+    _fe_mul(s2, b->y, a->z);
+    _fe_mul(s2, s2, z1z1);
+    _fe_sub(h, u2, u1);
+    _fe_sub(rr, s2, s1);
+
+    if (_is_zero(h))
+    {
+        if (_is_zero(rr))
+            _point_double(r, a);
+        else
+            memset(r, 0, sizeof(*r));
+        return;
+    }
+
+    _fe_add(i, h, h);
+    _fe_sqr(i, i);
+    _fe_mul(j, h, i);
+    _fe_add(rr, rr, rr);
+    _fe_mul(v, u1, i);
+
+    /* z3 = ((z1 + z2)^2 - z1z1 - z2z2) * h */
+    _fe_add(t, a->z, b->z);
+    _fe_sqr(t, t);
+    _fe_sub(t, t, z1z1);
+    _fe_sub(t, t, z2z2);
+    _fe_mul(r->z, t, h);
+
+    /* x3 = rr^2 - j - 2 * v */
+    _fe_sqr(t, rr);
+    _fe_sub(t, t, j);
+    _fe_sub(t, t, v);
+    _fe_sub(r->x, t, v);
+
+    /* y3 = rr * (v - x3) - 2 * s1 * j */
+    _fe_mul(s1, s1, j);
+    _fe_add(s1, s1, s1);
+    _fe_sub(t, v, r->x);
+    _fe_mul(t, rr, t);
+    _fe_sub(r->y, t, s1);
+}
+
+/* Whether y^2 = x^3 - 3 * x + b */
+static bool _is_on_curve(const affine_t* a)
+{
+    fe_t lhs, rhs, t;
+
+    _fe_sqr(lhs, a->y);
+
+    _fe_sqr(rhs, a->x);
+    _fe_mul(rhs, rhs, a->x);
+    _fe_add(t, a->x, a->x);
+    _fe_add(t, t, a->x);
+    _fe_sub(rhs, rhs, t);
+    _fe_add(rhs, rhs, _b);
+
+    return _equal(lhs, rhs);
+}
+
+/*
+**==============================================================================
+**
+** Scalar multiplication
+**
+**==============================================================================
+*/
+
+/* Build the comb table of p, with scratch space for COMB_POINTS points */
+static void _comb_build(comb_t* comb, const affine_t* p, jacobian_t* scratch)
+{
+    fe_t inv, z_inv, t;
+
+    _set_affine(&scratch[0], p);
+
+    for (size_t j = 1; j < COMB_TEETH; j++)
+    {
+        jacobian_t* q = &scratch[(1 << j) - 1];
+
+        *q = scratch[(1 << (j - 1)) - 1];
+
+        for (size_t i = 0; i < COMB_SPACING; i++)
+            _point_double(q, q);
+    }
+
+    for (size_t b = 3; b <= COMB_POINTS; b++)
+    {
+        size_t top = (size_t)1 << (63 - __builtin_clzll(b));
+
+        if (b != top)
+            _point_add(
+                &scratch[b - 1], &scratch[b - top - 1], &scratch[top - 1]);
+    }
+
+    /* Convert to affine with a single inversion (Montgomery's trick). The
+     * x-coordinates hold the running products of the z-coordinates until
+     * they are written. No point is at infinity, as 0 < b < n. */
+    memcpy(comb->points[0].x, scratch[0].z, sizeof(fe_t));
+
+    for (size_t i = 1; i < COMB_POINTS; i++)
+        _fe_mul(comb->points[i].x, comb->points[i - 1].x, scratch[i].z);
+
+    _fe_inv(inv, comb->points[COMB_POINTS - 1].x);
+
+    for (size_t i = COMB_POINTS; i-- > 0;)
+    {
+        if (i)
+        {
+            _fe_mul(z_inv, inv, comb->points[i - 1].x);
+            _fe_mul(inv, inv, scratch[i].z);
+        }
+        else
+            memcpy(z_inv, inv, sizeof(fe_t));
+
+        _fe_sqr(t, z_inv);
+        _fe_mul(comb->points[i].x, scratch[i].x, t);
+        _fe_mul(t, t, z_inv);
+        _fe_mul(comb->points[i].y, scratch[i].y, t);
+    }
+}
+
+/* The comb table index of column i of k */
+OE_INLINE size_t _comb_index(const fe_t k, size_t i)
+{
+    size_t index = 0;
+
+    for (size_t j = 0; j < COMB_TEETH; j++)
+    {
+        size_t bit = i + COMB_SPACING * j;
+        index |= (size_t)((k[bit / 64] >> (bit % 64)) & 1) << j;
+    }
+
+    return index;
+}
+
+/* Recode k into width-5 NAF digits, returning their count */
+static size_t _wnaf(int8_t digits[WNAF_DIGITS], const fe_t k)
+{
+    uint64_t t[5] = {k[0], k[1], k[2], k[3], 0};
+    size_t count = 0;
+
+    while (t[0] | t[1] | t[2] | t[3] | t[4])
+    {
+        int digit = 0;
+
+        if (t[0] & 1)
+        {
+            uint64_t carry;
+
+            digit = (int)(t[0] & ((1 << WNAF_WIDTH) - 1));
+
+            if (digit >= 1 << (WNAF_WIDTH - 1))
+                digit -= 1 << WNAF_WIDTH;
+
+            /* t -= digit, which clears the low WNAF_WIDTH bits */
+            if (digit > 0)
+            {
+                carry = t[0] < (uint64_t)digit;
+                t[0] -= (uint64_t)digit;
+                for (size_t i = 1; i < 5 && carry; i++)
+                    carry = t[i]-- == 0;
+            }
+            else
+            {
+                t[0] += (uint64_t)-digit;
+                carry = t[0] < (uint64_t)-digit;
+                for (size_t i = 1; i < 5 && carry; i++)
+                    carry = ++t[i] == 0;
+            }
+        }
+
+        digits[count++] = (int8_t)digit;
+
+        for (size_t i = 0; i < 4; i++)
+            t[i] = (t[i] >> 1) | (t[i + 1] << 63);
+        t[4] >>= 1;
+    }
+
+    return count;
+}
+
+/* r = u1 * G + u2 * q, with the comb table of q if q_comb is not NULL */
+static void _double_mul(
+    jacobian_t* r,
+    const comb_t* g_comb,
+    const fe_t u1,
+    const affine_t* q,
+    const comb_t* q_comb,
+    const fe_t u2)
+{
+    memset(r, 0, sizeof(*r));
+
+    if (q_comb)
+    {
+        for (size_t i = COMB_SPACING; i-- > 0;)
+        {
+            size_t index;
+
+            _point_double(r, r);
+
+            if ((index = _comb_index(u1, i)))
+                _point_add_affine(r, r, &g_comb->points[index - 1]);
+
+            if ((index = _comb_index(u2, i)))
+                _point_add_affine(r, r, &q_comb->points[index - 1]);
+        }
+    }
+    else
+    {
+        int8_t digits[WNAF_DIGITS];
+        jacobian_t odd[WNAF_POINTS];
+        jacobian_t q2;
+        size_t count = _wnaf(digits, u2);
+
+        /* odd[i] = (2 * i + 1) * q */
+        _set_affine(&odd[0], q);
+        _point_double(&q2, &odd[0]);
+
+        for (size_t i = 1; i < WNAF_POINTS; i++)
+            _point_add(&odd[i], &odd[i - 1], &q2);
+
+        for (size_t i = count > COMB_SPACING ? count : COMB_SPACING; i-- > 0;)
+        {
+            size_t index;
+
+            _point_double(r, r);
+
+            if (i < COMB_SPACING && (index = _comb_index(u1, i)))
+                _point_add_affine(r, r, &g_comb->points[index - 1]);
+
+            if (i < count && digits[i] > 0)
+            {
+                _point_add(r, r, &odd[digits[i] / 2]);
+            }
+            else if (i < count && digits[i] < 0)
+            {
+                jacobian_t neg = odd[-digits[i] / 2];
+
+                _fe_sub(neg.y, _p, neg.y);
+                _point_add(r, r, &neg);
+            }
+        }
+    }
+}
+
+/*
+**==============================================================================
+**
+** Tables
+**
+**==============================================================================
+*/
+
+static const comb_t* _get_g_comb(void)
+{
+    comb_t* comb = __atomic_load_n(&_g_comb, __ATOMIC_ACQUIRE);
+
+    if (comb)
+        return comb;
+
+    oe_spin_lock(&_g_comb_lock);
+
+    if (!(comb = _g_comb))
+    {
+        jacobian_t* scratch = oe_malloc(COMB_POINTS * sizeof(jacobian_t));
+
+        if (scratch && (comb = oe_malloc(sizeof(comb_t))))
+        {
+            _comb_build(comb, &_g, scratch);
+            __atomic_store_n(&_g_comb, comb, __ATOMIC_RELEASE);
+        }
+
+        oe_free(scratch);
+    }
+
+    oe_spin_unlock(&_g_comb_lock);
+
+    return comb;
+}
+
+static uint64_t _fingerprint(const uint8_t* xy)
+{
+    uint64_t fingerprint = 0;
+
+    for (size_t i = 0; i < sizeof(fingerprint); i++)
+        fingerprint = fingerprint << 8 | xy[i];
+
+    return fingerprint;
+}
+
+static cached_key_t* _find_key(const uint8_t* xy)
+{
+    for (size_t i = 0; i < CACHE_SIZE; i++)
+    {
+        cached_key_t* key = _cache[i];
+
+        if (key && memcmp(key->xy, xy, sizeof(key->xy)) == 0)
+        {
+            key->refs++;
+            key->last_use = ++_clock;
+            return key;
+        }
+    }
+
+    return NULL;
+}
+
+/* Whether the key was seen before (and should be cached), else remember it */
+static bool _check_candidate(const uint8_t* xy)
+{
+    uint64_t fingerprint = _fingerprint(xy);
+
+    for (size_t i = 0; i < CANDIDATE_COUNT; i++)
+    {
+        if (_candidates[i] == fingerprint)
+        {
+            _candidates[i] = 0;
+            return true;
+        }
+    }
+
+    _candidates[_next_candidate++ % CANDIDATE_COUNT] = fingerprint;
+    return false;
+}
+
+/* Get the cached table of the key, caching it if it was seen before or if
+ * cache is set, or return NULL. The key must be released with
+ * _release_key(). */
+static cached_key_t* _acquire_key(
+    const uint8_t* xy,
+    const affine_t* q,
+    bool cache)
+{
+    cached_key_t* key;
+    cached_key_t* evicted = NULL;
+    jacobian_t* scratch;
+
+    oe_spin_lock(&_cache_lock);
+    if (!(key = _find_key(xy)) && !cache)
+        cache = _check_candidate(xy);
+    oe_spin_unlock(&_cache_lock);
+
+    if (key || !cache)
+        return key;
+
+    /* Build the table without holding the lock */
+    if (!(scratch = oe_malloc(COMB_POINTS * sizeof(jacobian_t))))
+        return NULL;
+
+    if ((key = oe_malloc(sizeof(cached_key_t))))
+    {
+        memcpy(key->xy, xy, sizeof(key->xy));
+        key->refs = 1;
+        key->evicted = false;
+        _comb_build(&key->comb, q, scratch);
+    }
+
+    oe_free(scratch);
+
+    if (!key)
+        return NULL;
+
+    oe_spin_lock(&_cache_lock);
+    {
+        cached_key_t* found = _find_key(xy);
+
+        if (found)
+        {
+            /* Another thread cached the key meanwhile */
+            evicted = key;
+            key = found;
+        }
+        else
+        {
+            size_t slot = 0;
+
+            for (size_t i = 0; i < CACHE_SIZE; i++)
+            {
+                if (!_cache[i])
+                {
+                    slot = i;
+                    break;
+                }
+
+                if (_cache[i]->last_use < _cache[slot]->last_use)
+                    slot = i;
+            }
+
+            if ((evicted = _cache[slot]))
+            {
+                evicted->evicted = true;
+                if (evicted->refs)
+                    evicted = NULL;
+            }
+
+            key->last_use = ++_clock;
+            _cache[slot] = key;
+        }
+    }
+    oe_spin_unlock(&_cache_lock);
+
+    oe_free(evicted);
+
+    return key;
+}
+
+static void _release_key(cached_key_t* key)
+{
+    bool free_key;
+
+    oe_spin_lock(&_cache_lock);
+    free_key = --key->refs == 0 && key->evicted;
+    oe_spin_unlock(&_cache_lock);
+
+    if (free_key)
+        oe_free(key);
+}
+
+/*
+**==============================================================================
+**
+** Verification
+**
+**==============================================================================
+*/
+
+/* Read the key (x, y) into q, in Montgomery form, and xy */
+static bool _read_key(
+    affine_t* q,
+    uint8_t* xy,
+    const uint8_t* x,
+    const uint8_t* y)
+{
+    if (!_read(q->x, x, OE_P256_COORDINATE_SIZE, _p) ||
+        !_read(q->y, y, OE_P256_COORDINATE_SIZE, _p))
+        return false;
+
+    _fe_mul(q->x, q->x, _p_rr);
+    _fe_mul(q->y, q->y, _p_rr);
+
+    memcpy(xy, x, OE_P256_COORDINATE_SIZE);
+    memcpy(xy + OE_P256_COORDINATE_SIZE, y, OE_P256_COORDINATE_SIZE);
+
+    return _is_on_curve(q);
+}
+
+/* Read r and s, which must be 0 < r, s < n, and e, the leftmost 256 bits of
+ * the hash reduced mod n */
+static bool _read_signature(
+    fe_t e,
+    fe_t r_n,
+    fe_t s_n,
+    const uint8_t* hash,
+    size_t hash_size,
+    const uint8_t* r,
+    const uint8_t* s)
+{
+    if (!_read(r_n, r, OE_P256_COORDINATE_SIZE, _n) || _is_zero(r_n) ||
+        !_read(s_n, s, OE_P256_COORDINATE_SIZE, _n) || _is_zero(s_n))
+        return false;
+
+    if (hash_size > OE_P256_COORDINATE_SIZE)
+        hash_size = OE_P256_COORDINATE_SIZE;
+
+    if (!_read(e, hash, hash_size, _n))
+        _reduce_once(e, e, 0, _n);
+
+    return true;
+}
+
+/* Check the signature (r, s) of e with q, given w = 1 / s in Montgomery
+ * form */
+static bool _check_signature(
+    const comb_t* g_comb,
+    const affine_t* q,
+    const cached_key_t* key,
+    const fe_t e,
+    const fe_t r_n,
+    const fe_t w)
+{
+    jacobian_t point;
+    fe_t u1, u2, r_p, t;
+
+    /* u1 = e * w and u2 = r * w are not in Montgomery form */
+    _n_mul(u1, e, w);
+    _n_mul(u2, r_n, w);
+
+    /* Like mbedTLS, reject the signatures of e = 0 mod n, which anyone can
+     * forge */
+    if (_is_zero(u1))
+        return false;
+
+    _double_mul(&point, g_comb, u1, q, key ? &key->comb : NULL, u2);
+
+    if (_is_zero(point.z))
+        return false;
+
+    /* The signature is valid if the x-coordinate X / Z^2 of the point is r
+     * mod n, i.e. X = r * Z^2, or X = (r + n) * Z^2 if r + n < p */
+    _fe_sqr(point.z, point.z);
+    _fe_mul(t, r_n, _p_rr);
+    _fe_mul(t, t, point.z);
+
+    if (_equal(t, point.x))
+        return true;
+
+    if (!_less(r_n, _p_minus_n))
+        return false;
+
+    _fe_add(r_p, r_n, _n);
+    _fe_mul(t, r_p, _p_rr);
+    _fe_mul(t, t, point.z);
+
+    return _equal(t, point.x);
+}
+
+/* Verify the signatures (r[i], s[i]) of hashes[i], for 0 < count <=
+ * VERIFY_BATCH_SIZE, with the key (x, y), caching the key if cache is set */
+static oe_result_t _verify_batch(
+    const uint8_t* x,
+    const uint8_t* y,
+    const void* const* hashes,
+    size_t hash_size,
+    const uint8_t* const* r,
+    const uint8_t* const* s,
+    size_t count,
+    bool cache)
+{
+    oe_result_t result = OE_UNEXPECTED;
+    uint8_t xy[2 * OE_P256_COORDINATE_SIZE];
+    const comb_t* g_comb;
+    cached_key_t* key = NULL;
+    affine_t q;
+    fe_t e[VERIFY_BATCH_SIZE];
+    fe_t r_n[VERIFY_BATCH_SIZE];
+    fe_t w[VERIFY_BATCH_SIZE];
+    fe_t products[VERIFY_BATCH_SIZE];
+    fe_t inv, t;
+
+    if (!_read_key(&q, xy, x, y))
+        OE_RAISE(OE_INVALID_PARAMETER);
+
+    /* w[i] = s[i] and products[i] = s[0] * ... * s[i], in Montgomery form */
+    for (size_t i = 0; i < count; i++)
+    {
+        if (!_read_signature(
+                e[i], r_n[i], w[i], hashes[i], hash_size, r[i], s[i]))
+            OE_RAISE_NO_TRACE(OE_VERIFY_FAILED);
+
+        _n_mul(w[i], w[i], _n_rr);
+
+        if (i)
+            _n_mul(products[i], products[i - 1], w[i]);
+        else
+            memcpy(products[0], w[0], sizeof(fe_t));
+    }
+
+    if (!(g_comb = _get_g_comb()))
+        OE_RAISE(OE_OUT_OF_MEMORY);
+
+    /* w[i] = 1 / s[i], with a single inversion (Montgomery's trick): inv is
+     * 1 / products[i] as i goes down */
+    _pow(inv, products[count - 1], _n_minus_2, _n_mul);
+
+    for (size_t i = count; i-- > 1;)
+    {
+        _n_mul(t, inv, products[i - 1]);
+        _n_mul(inv, inv, w[i]);
+        memcpy(w[i], t, sizeof(fe_t));
+    }
+
+    memcpy(w[0], inv, sizeof(fe_t));
+
+    key = _acquire_key(xy, &q, cache);
+
+    for (size_t i = 0; i < count; i++)
+    {
+        if (!_check_signature(g_comb, &q, key, e[i], r_n[i], w[i]))
+            OE_RAISE_NO_TRACE(OE_VERIFY_FAILED);
+    }
+
+    result = OE_OK;
+
+done:
+
+    if (key)
+        _release_key(key);
+
+    return result;
+}
+
+oe_result_t oe_p256_verify_raw(
+    const uint8_t* x,
+    const uint8_t* y,
+    const uint8_t* hash,
+    size_t hash_size,
+    const uint8_t* r,
+    const uint8_t* s)
+{
+    oe_result_t result = OE_UNEXPECTED;
+    const void* hashes[] = {hash};
+
+    if (!x || !y || (!hash && hash_size) || !r || !s)
+        OE_RAISE(OE_INVALID_PARAMETER);
+
+    result = _verify_batch(x, y, hashes, hash_size, &r, &s, 1, false);
+
+done:
+    return result;
+}
+
+static bool _write_coordinate(uint8_t* buffer, const mbedtls_mpi* x)
+{
+    return mbedtls_mpi_write_binary(x, buffer, OE_P256_COORDINATE_SIZE) == 0;
+}
+
+/* Parse the signature as mbedtls_ecdsa_read_signature() does:
+ * SEQUENCE { INTEGER r, INTEGER s } with nothing following it */
+static bool _parse_signature(
+    const uint8_t* signature,
+    size_t signature_size,
+    uint8_t* r,
+    uint8_t* s,
+    mbedtls_mpi* mpi)
+{
+    unsigned char* p = (unsigned char*)signature;
+    const unsigned char* end = signature + signature_size;
+    size_t length;
+
+    if (mbedtls_asn1_get_tag(
+            &p,
+            end,
+            &length,
+            MBEDTLS_ASN1_CONSTRUCTED | MBEDTLS_ASN1_SEQUENCE) != 0 ||
+        p + length != end)
+        return false;
+
+    return mbedtls_asn1_get_mpi(&p, end, mpi) == 0 &&
+           _write_coordinate(r, mpi) &&
+           mbedtls_asn1_get_mpi(&p, end, mpi) == 0 &&
+           _write_coordinate(s, mpi) && p == end;
+}
+
+oe_result_t oe_p256_verify_batch(
+    const mbedtls_pk_context* pk,
+    const void* const* hashes,
+    size_t hash_size,
+    const uint8_t* const* signatures,
+    const size_t* signature_sizes,
+    size_t count)
+{
+    oe_result_t result = OE_UNEXPECTED;
+    const mbedtls_ecp_keypair* ec;
+    uint8_t x[OE_P256_COORDINATE_SIZE];
+    uint8_t y[OE_P256_COORDINATE_SIZE];
+    uint8_t r[VERIFY_BATCH_SIZE][OE_P256_COORDINATE_SIZE];
+    uint8_t s[VERIFY_BATCH_SIZE][OE_P256_COORDINATE_SIZE];
+    const uint8_t* r_list[VERIFY_BATCH_SIZE];
+    const uint8_t* s_list[VERIFY_BATCH_SIZE];
+    mbedtls_mpi mpi;
+
+    mbedtls_mpi_init(&mpi);
+
+    if (!pk || (!hashes && count) || (!signatures && count) ||
+        (!signature_sizes && count))
+        OE_RAISE(OE_INVALID_PARAMETER);
+
+    if (!mbedtls_pk_can_do(pk, MBEDTLS_PK_ECDSA))
+        OE_RAISE_NO_TRACE(OE_UNSUPPORTED);
+
+    ec = mbedtls_pk_ec(*pk);
+
+    if (ec->grp.id != MBEDTLS_ECP_DP_SECP256R1 ||
+        mbedtls_mpi_cmp_int(&ec->Q.Z, 1) != 0 ||
+        !_write_coordinate(x, &ec->Q.X) || !_write_coordinate(y, &ec->Q.Y))
+        OE_RAISE_NO_TRACE(OE_UNSUPPORTED);
+
+    for (size_t i = 0; i < count; i += VERIFY_BATCH_SIZE)
+    {
+        size_t batch_size = count - i;
+
+        if (batch_size > VERIFY_BATCH_SIZE)
+            batch_size = VERIFY_BATCH_SIZE;
+
+        for (size_t j = 0; j < batch_size; j++)
+        {
+            if (!signatures[i + j] || (!hashes[i + j] && hash_size))
+                OE_RAISE(OE_INVALID_PARAMETER);
+
+            if (!_parse_signature(
+                    signatures[i + j],
+                    signature_sizes[i + j],
+                    r[j],
+                    s[j],
+                    &mpi))
+                OE_RAISE_NO_TRACE(OE_VERIFY_FAILED);
+
+            r_list[j] = r[j];
+            s_list[j] = s[j];
+        }
+
+        result = _verify_batch(
+            x,
+            y,
+            hashes + i,
+            hash_size,
+            r_list,
+            s_list,
+            batch_size,
+            count >= BATCH_CACHE_COUNT);
+
+        /* mbedTLS has checked the key when it was loaded */
+        if (result == OE_INVALID_PARAMETER)
+            result = OE_VERIFY_FAILED;
+
+        if (result != OE_OK)
+            goto done;
+    }
+
+    result = OE_OK;
+
+done:
+    mbedtls_mpi_free(&mpi);
+    return result;
+}
+
+oe_result_t oe_p256_verify(
+    const mbedtls_pk_context* pk,
+    const uint8_t* hash,
+    size_t hash_size,
+    const uint8_t* signature,
+    size_t signature_size)
+{
+    const void* hashes[] = {hash};
+
+    return oe_p256_verify_batch(
+        pk, hashes, hash_size, &signature, &signature_size, 1);
+}
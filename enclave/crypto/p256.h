@@ -0,0 +1,72 @@
+// Copyright (c) Open Enclave SDK contributors.
+// Licensed under the MIT License.
+
+#ifndef _OE_ENCLAVE_P256_H
+#define _OE_ENCLAVE_P256_H
+
+#include <mbedtls/pk.h>
+
+#include <openenclave/bits/result.h>
+#include <openenclave/bits/types.h>
+
+#define OE_P256_COORDINATE_SIZE 32
+
+/**
+ * oe_p256_verify verifies an ECDSA signature made with a P-256 key. It
+ * computes what mbedtls_pk_verify() computes, with the verify-only P-256
+ * implementation of p256.c, which keeps precomputed tables for the keys that
+ * are used repeatedly.
+ *
+ * @param pk The public key.
+ * @param hash The hash of the signed data.
+ * @param hash_size The size of the hash in bytes.
+ * @param signature The DER-encoded signature.
+ * @param signature_size The size of the signature in bytes.
+ *
+ * @return OE_OK if the signature is valid.
+ * @return OE_VERIFY_FAILED if it is not.
+ * @return OE_UNSUPPORTED if pk is not a P-256 key.
+ * @return OE_OUT_OF_MEMORY if the table for the base point could not be
+ * built. The caller should then verify with mbedTLS.
+ */
+oe_result_t oe_p256_verify(
+    const mbedtls_pk_context* pk,
+    const uint8_t* hash,
+    size_t hash_size,
+    const uint8_t* signature,
+    size_t signature_size);
+
+/**
+ * oe_p256_verify_batch verifies count signatures made with the P-256 key pk,
+ * where signatures[i] of size signature_sizes[i] is the DER-encoded signature
+ * of hashes[i]. It computes the inverses of the signatures together, and
+ * caches the tables of pk if the batch is large enough to pay for them.
+ *
+ * @return OE_OK if all signatures are valid.
+ * @return OE_VERIFY_FAILED if any is not.
+ * @return The other return values of oe_p256_verify().
+ */
+oe_result_t oe_p256_verify_batch(
+    const mbedtls_pk_context* pk,
+    const void* const* hashes,
+    size_t hash_size,
+    const uint8_t* const* signatures,
+    const size_t* signature_sizes,
+    size_t count);
+
+/**
+ * oe_p256_verify_raw verifies the ECDSA signature (r, s) with the P-256 key
+ * whose affine coordinates are x and y. All numbers are big-endian and
+ * OE_P256_COORDINATE_SIZE bytes long. The return values are those of
+ * oe_p256_verify(), except that OE_INVALID_PARAMETER is returned if (x, y)
+ * is not on the curve.
+ */
+oe_result_t oe_p256_verify_raw(
+    const uint8_t* x,
+    const uint8_t* y,
+    const uint8_t* hash,
+    size_t hash_size,
+    const uint8_t* r,
+    const uint8_t* s);
+
+#endif /* _OE_ENCLAVE_P256_H */
@@ -251,6 +251,26 @@ oe_result_t oe_rsa_public_key_free(oe_rsa_public_key_t* public_key)
     return oe_public_key_free((oe_public_key_t*)public_key, _PUBLIC_KEY_MAGIC);
 }
 
+oe_result_t oe_rsa_private_key_share(
+    const oe_rsa_private_key_t* private_key,
+    oe_rsa_private_key_t* shared)
+{
+    return oe_private_key_share(
+        (const oe_private_key_t*)private_key,
+        (oe_private_key_t*)shared,
+        _PRIVATE_KEY_MAGIC);
+}
+
+oe_result_t oe_rsa_public_key_share(
+    const oe_rsa_public_key_t* public_key,
+    oe_rsa_public_key_t* shared)
+{
+    return oe_public_key_share(
+        (const oe_public_key_t*)public_key,
+        (oe_public_key_t*)shared,
+        _PUBLIC_KEY_MAGIC);
+}
+
 oe_result_t oe_rsa_private_key_sign(
     const oe_rsa_private_key_t* private_key,
     oe_hash_type_t hash_type,
@@ -0,0 +1,121 @@
+// Copyright (c) Open Enclave SDK contributors.
+// Licensed under the MIT License.
+
+#include <openenclave/enclave.h>
+
+oe_result_t oe_seal(
+    oe_seal_policy_t seal_policy,
+    const uint8_t* plaintext,
+    size_t plaintext_size,
+    const uint8_t* additional_data,
+    size_t additional_data_size,
+    uint8_t* blob,
+    size_t* blob_size)
+{
+    OE_UNUSED(seal_policy);
+    OE_UNUSED(plaintext);
+    OE_UNUSED(plaintext_size);
+    OE_UNUSED(additional_data);
+    OE_UNUSED(additional_data_size);
+    OE_UNUSED(blob);
+    OE_UNUSED(blob_size);
+
+    return OE_UNSUPPORTED;
+}
+
+oe_result_t oe_unseal(
+    const uint8_t* blob,
+    size_t blob_size,
+    const uint8_t* additional_data,
+    size_t additional_data_size,
+    uint8_t* plaintext,
+    size_t* plaintext_size)
+{
+    OE_UNUSED(blob);
+    OE_UNUSED(blob_size);
+    OE_UNUSED(additional_data);
+    OE_UNUSED(additional_data_size);
+    OE_UNUSED(plaintext);
+    OE_UNUSED(plaintext_size);
+
+    return OE_UNSUPPORTED;
+}
+
+oe_result_t oe_seal_stream_init(
+    oe_seal_policy_t seal_policy,
+    const uint8_t* additional_data,
+    size_t additional_data_size,
+    uint8_t* header,
+    size_t header_size,
+    oe_seal_stream_t** stream)
+{
+    OE_UNUSED(seal_policy);
+    OE_UNUSED(additional_data);
+    OE_UNUSED(additional_data_size);
+    OE_UNUSED(header);
+    OE_UNUSED(header_size);
+    OE_UNUSED(stream);
+
+    return OE_UNSUPPORTED;
+}
+
+oe_result_t oe_unseal_stream_init(
+    const uint8_t* header,
+    size_t header_size,
+    const uint8_t* additional_data,
+    size_t additional_data_size,
+    oe_seal_stream_t** stream)
+{
+    OE_UNUSED(header);
+    OE_UNUSED(header_size);
+    OE_UNUSED(additional_data);
+    OE_UNUSED(additional_data_size);
+    OE_UNUSED(stream);
+
+    return OE_UNSUPPORTED;
+}
+
+oe_result_t oe_seal_stream_chunk(
+    oe_seal_stream_t* stream,
+    bool last,
+    const uint8_t* plaintext,
+    size_t plaintext_size,
+    uint8_t* chunk,
+    size_t* chunk_size,
+    uint32_t* index)
+{
+    OE_UNUSED(stream);
+    OE_UNUSED(last);
+    OE_UNUSED(plaintext);
+    OE_UNUSED(plaintext_size);
+    OE_UNUSED(chunk);
+    OE_UNUSED(chunk_size);
+    OE_UNUSED(index);
+
+    return OE_UNSUPPORTED;
+}
+
+oe_result_t oe_unseal_stream_chunk(
+    const oe_seal_stream_t* stream,
+    uint32_t index,
+    bool last,
+    const uint8_t* chunk,
+    size_t chunk_size,
+    uint8_t* plaintext,
+    size_t* plaintext_size)
+{
+    OE_UNUSED(stream);
+    OE_UNUSED(index);
+    OE_UNUSED(last);
+    OE_UNUSED(chunk);
+    OE_UNUSED(chunk_size);
+    OE_UNUSED(plaintext);
+    OE_UNUSED(plaintext_size);
+
+    return OE_UNSUPPORTED;
+}
+
+void oe_seal_stream_free(oe_seal_stream_t* stream)
+{
+    OE_UNUSED(stream);
+}
@@ -26,8 +26,10 @@ oe_result_t oe_get_sgx_quote_verification_collateral(
     if (!args)
         OE_RAISE(OE_INVALID_PARAMETER);
 
-    /* fmspc */
+    /* fmspc and ca */
     memcpy(in.fmspc, args->fmspc, sizeof(in.fmspc));
+    memcpy(in.ca, args->ca, sizeof(in.ca));
+    in.ca[sizeof(in.ca) - 1] = '\0';
 
     for (;;)
     {
@@ -36,6 +38,7 @@ oe_result_t oe_get_sgx_quote_verification_collateral(
         if (oe_get_quote_verification_collateral_ocall(
                 &retval,
                 out.fmspc,
+                out.ca,
                 out.tcb_info,
                 out.tcb_info_size,
                 &out.tcb_info_size,
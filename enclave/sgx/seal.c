@@ -0,0 +1,694 @@
+// Copyright (c) Open Enclave SDK contributors.
+// Licensed under the MIT License.
+
+#include <openenclave/bits/sgx/sgxtypes.h>
+#include <openenclave/corelibc/stdlib.h>
+#include <openenclave/corelibc/string.h>
+#include <openenclave/enclave.h>
+#include <openenclave/internal/crypto/gcm.h>
+#include <openenclave/internal/crypto/sha.h>
+#include <openenclave/internal/kdf.h>
+#include <openenclave/internal/raise.h>
+#include <openenclave/internal/safecrt.h>
+#include <openenclave/internal/sgxkeys.h>
+#include <openenclave/internal/thread.h>
+#include <openenclave/internal/utils.h>
+
+/*
+**==============================================================================
+**
+** Sealing:
+**
+**     Sealed data is a header, the AES-128-GCM ciphertext and its tag. The
+**     header holds the SGX key request of the seal key and a random IV (or,
+**     for streams, a random salt). It is not authenticated itself: a
+**     modified key request yields another key, and a modified IV or salt
+**     another keystream, so both fail the tag check.
+**
+**     oe_seal() uses one key request per policy for the lifetime of the
+**     enclave, whose key ID is drawn at random on first use. The seal keys
+**     of up to SEAL_KEY_CACHE_SIZE key requests are kept, expanded for
+**     AES-GCM, so that sealing and unsealing need no EGETKEY. Keys are
+**     copied out of the cache under the lock.
+**
+**     The key requests of unsealed data come from outside the enclave, so
+**     their keys are cached only once they have unsealed data, and they
+**     take the place of the least recently used key. The keys of the
+**     enclave's own key requests are never replaced.
+**
+**     Random IVs under one key are safe for 2^32 messages (NIST SP 800-38D),
+**     which a single enclave instance is not expected to seal. Streams use
+**     a key of their own instead and number their chunks. The numbers are
+**     assigned by oe_seal_stream_chunk() from a counter in the stream, so
+**     no two chunks of a stream share an IV, and a stream opened for
+**     unsealing cannot seal.
+**
+**==============================================================================
+*/
+
+#define SEAL_MAGIC 0x4c414553        /* "SEAL" */
+#define SEAL_STREAM_MAGIC 0x4d525453 /* "STRM" */
+
+#define SEAL_KEY_CACHE_SIZE 8
+
+#define SEAL_STREAM_SALT_SIZE 16
+#define SEAL_STREAM_LABEL "oe_seal_stream"
+
+/* Set in oe_seal_stream_t.next_index once the last chunk is sealed */
+#define SEAL_STREAM_CLOSED ((uint64_t)1 << 63)
+
+typedef struct _seal_header
+{
+    uint32_t magic;
+    uint32_t reserved;
+
+    /* The IV of oe_seal() followed by zeros, or the salt of a stream */
+    uint8_t nonce[16];
+
+    sgx_key_request_t key_request;
+} seal_header_t;
+
+OE_STATIC_ASSERT(sizeof(seal_header_t) == OE_SEAL_HEADER_SIZE);
+OE_STATIC_ASSERT(OE_GCM_TAG_SIZE == OE_SEAL_TAG_SIZE);
+
+typedef struct _seal_key
+{
+    sgx_key_request_t key_request;
+    sgx_key_t key;
+    oe_aes_gcm_key_t gcm_key;
+} seal_key_t;
+
+typedef struct _seal_key_entry
+{
+    seal_key_t key;
+
+    /* Value of _clock when the entry was last used; 0 for a free entry */
+    uint64_t last_used;
+} seal_key_entry_t;
+
+struct _oe_seal_stream
+{
+    oe_aes_gcm_key_t gcm_key;
+
+    /* Whether the stream was started by oe_seal_stream_init() */
+    bool sealing;
+
+    /* The index of the next sealed chunk, or'ed with SEAL_STREAM_CLOSED */
+    uint64_t next_index;
+};
+
+static seal_key_entry_t _keys[SEAL_KEY_CACHE_SIZE];
+static uint64_t _clock;
+
+/* The key requests of OE_SEAL_POLICY_UNIQUE and OE_SEAL_POLICY_PRODUCT */
+static sgx_key_request_t _key_requests[2];
+static bool _have_key_request[2];
+
+static oe_spinlock_t _lock = OE_SPINLOCK_INITIALIZER;
+
+static oe_result_t _get_key_request(
+    oe_seal_policy_t seal_policy,
+    sgx_key_request_t* key_request)
+{
+    oe_result_t result = OE_UNEXPECTED;
+    size_t index;
+    bool found;
+    uint8_t* key = NULL;
+    size_t key_size = 0;
+    uint8_t* key_info = NULL;
+    size_t key_info_size = 0;
+
+    if (seal_policy != OE_SEAL_POLICY_UNIQUE &&
+        seal_policy != OE_SEAL_POLICY_PRODUCT)
+        OE_RAISE(OE_INVALID_PARAMETER);
+
+    index = seal_policy == OE_SEAL_POLICY_UNIQUE ? 0 : 1;
+
+    oe_spin_lock(&_lock);
+
+    if ((found = _have_key_request[index]))
+        *key_request = _key_requests[index];
+
+    oe_spin_unlock(&_lock);
+
+    if (found)
+    {
+        result = OE_OK;
+        goto done;
+    }
+
+    /* The default key request of the policy, with a random key ID */
+    OE_CHECK(oe_get_seal_key_by_policy_v2(
+        seal_policy, &key, &key_size, &key_info, &key_info_size));
+
+    if (key_info_size != sizeof(*key_request))
+        OE_RAISE(OE_UNEXPECTED);
+
+    OE_CHECK(oe_memcpy_s(
+        key_request, sizeof(*key_request), key_info, key_info_size));
+    OE_CHECK(oe_random(key_request->key_id, sizeof(key_request->key_id)));
+
+    /* Another thread may have drawn a key ID first */
+    oe_spin_lock(&_lock);
+
+    if (_have_key_request[index])
+        *key_request = _key_requests[index];
+    else
+    {
+        _key_requests[index] = *key_request;
+        _have_key_request[index] = true;
+    }
+
+    oe_spin_unlock(&_lock);
+
+    result = OE_OK;
+
+done:
+    oe_free_seal_key(key, key_info);
+    return result;
+}
+
+/* Called with _lock held */
+static seal_key_entry_t* _find_key(const sgx_key_request_t* key_request)
+{
+    for (size_t i = 0; i < OE_COUNTOF(_keys); i++)
+    {
+        if (_keys[i].last_used &&
+            !memcmp(
+                &_keys[i].key.key_request, key_request, sizeof(*key_request)))
+            return &_keys[i];
+    }
+
+    return NULL;
+}
+
+/* Called with _lock held */
+static bool _is_own_key_request(const sgx_key_request_t* key_request)
+{
+    for (size_t i = 0; i < OE_COUNTOF(_key_requests); i++)
+    {
+        if (_have_key_request[i] &&
+            !memcmp(&_key_requests[i], key_request, sizeof(*key_request)))
+            return true;
+    }
+
+    return false;
+}
+
+/* Get the seal key of key_request from the cache, or derive it. The caller
+ * wipes key. */
+static oe_result_t _get_key(
+    const sgx_key_request_t* key_request,
+    seal_key_t* key)
+{
+    oe_result_t result = OE_UNEXPECTED;
+    seal_key_entry_t* entry;
+
+    if (key_request->key_name != SGX_KEYSELECT_SEAL)
+        OE_RAISE(OE_INVALID_PARAMETER);
+
+    oe_spin_lock(&_lock);
+
+    if ((entry = _find_key(key_request)))
+    {
+        *key = entry->key;
+        entry->last_used = ++_clock;
+    }
+
+    oe_spin_unlock(&_lock);
+
+    if (entry)
+    {
+        result = OE_OK;
+        goto done;
+    }
+
+    key->key_request = *key_request;
+    OE_CHECK(oe_get_key(&key->key_request, &key->key));
+    OE_CHECK(oe_aes_gcm_init_key(
+        key->key.buf, sizeof(key->key.buf), &key->gcm_key));
+
+    result = OE_OK;
+
+done:
+    return result;
+}
+
+/* Add a key derived by _get_key() to the cache, in place of the least
+ * recently used key that is not of the enclave's own key requests */
+static void _cache_key(const seal_key_t* key)
+{
+    seal_key_entry_t* entry = NULL;
+
+    oe_spin_lock(&_lock);
+
+    if (_find_key(&key->key_request))
+        goto done;
+
+    for (size_t i = 0; i < OE_COUNTOF(_keys); i++)
+    {
+        if (!_keys[i].last_used)
+        {
+            entry = &_keys[i];
+            break;
+        }
+
+        if (_is_own_key_request(&_keys[i].key.key_request))
+            continue;
+
+        if (!entry || _keys[i].last_used < entry->last_used)
+            entry = &_keys[i];
+    }
+
+    if (entry)
+    {
+        entry->key = *key;
+        entry->last_used = ++_clock;
+    }
+
+done:
+    oe_spin_unlock(&_lock);
+}
+
+/* Copy and check the header of sealed data */
+static oe_result_t _read_header(
+    const uint8_t* data,
+    size_t size,
+    uint32_t magic,
+    seal_header_t* header)
+{
+    oe_result_t result = OE_UNEXPECTED;
+
+    if (size < sizeof(*header))
+        OE_RAISE(OE_INVALID_PARAMETER);
+
+    OE_CHECK(oe_memcpy_s(header, sizeof(*header), data, sizeof(*header)));
+
+    if (header->magic != magic || header->reserved != 0)
+        OE_RAISE(OE_INVALID_PARAMETER);
+
+    /* oe_seal() uses only the first OE_GCM_IV_SIZE bytes of the nonce. The
+     * header is not authenticated, so the rest must be zero, or the same
+     * sealed data would unseal under many headers */
+    if (magic == SEAL_MAGIC)
+    {
+        for (size_t i = OE_GCM_IV_SIZE; i < sizeof(header->nonce); i++)
+        {
+            if (header->nonce[i] != 0)
+                OE_RAISE(OE_INVALID_PARAMETER);
+        }
+    }
+
+    result = OE_OK;
+
+done:
+    return result;
+}
+
+oe_result_t oe_seal(
+    oe_seal_policy_t seal_policy,
+    const uint8_t* plaintext,
+    size_t plaintext_size,
+    const uint8_t* additional_data,
+    size_t additional_data_size,
+    uint8_t* blob,
+    size_t* blob_size)
+{
+    oe_result_t result = OE_UNEXPECTED;
+    seal_header_t header = {0};
+    seal_key_t key;
+    size_t size;
+
+    if ((!plaintext && plaintext_size) ||
+        (!additional_data && additional_data_size) || !blob_size)
+        OE_RAISE(OE_INVALID_PARAMETER);
+
+    if (plaintext_size > OE_SIZE_MAX - OE_SEALED_SIZE(0))
+        OE_RAISE(OE_INVALID_PARAMETER);
+
+    size = OE_SEALED_SIZE(plaintext_size);
+
+    if (!blob || *blob_size < size)
+    {
+        *blob_size = size;
+        OE_RAISE_NO_TRACE(OE_BUFFER_TOO_SMALL);
+    }
+
+    header.magic = SEAL_MAGIC;
+    OE_CHECK(_get_key_request(seal_policy, &header.key_request));
+    OE_CHECK(oe_random(header.nonce, OE_GCM_IV_SIZE));
+    OE_CHECK(_get_key(&header.key_request, &key));
+    _cache_key(&key);
+
+    OE_CHECK(oe_memcpy_s(blob, *blob_size, &header, sizeof(header)));
+    OE_CHECK(oe_aes_gcm_encrypt(
+        &key.gcm_key,
+        header.nonce,
+        additional_data,
+        additional_data_size,
+        plaintext,
+        plaintext_size,
+        blob + sizeof(header),
+        blob + sizeof(header) + plaintext_size));
+
+    *blob_size = size;
+    result = OE_OK;
+
+done:
+    oe_secure_zero_fill(&key, sizeof(key));
+    return result;
+}
+
+oe_result_t oe_unseal(
+    const uint8_t* blob,
+    size_t blob_size,
+    const uint8_t* additional_data,
+    size_t additional_data_size,
+    uint8_t* plaintext,
+    size_t* plaintext_size)
+{
+    oe_result_t result = OE_UNEXPECTED;
+    seal_header_t header;
+    seal_key_t key;
+    size_t size;
+
+    if (!blob || blob_size < OE_SEALED_SIZE(0) ||
+        (!additional_data && additional_data_size) || !plaintext_size)
+        OE_RAISE(OE_INVALID_PARAMETER);
+
+    OE_CHECK(_read_header(blob, blob_size, SEAL_MAGIC, &header));
+
+    size = blob_size - OE_SEALED_SIZE(0);
+
+    if (!plaintext || *plaintext_size < size)
+    {
+        *plaintext_size = size;
+        OE_RAISE_NO_TRACE(OE_BUFFER_TOO_SMALL);
+    }
+
+    OE_CHECK(_get_key(&header.key_request, &key));
+    OE_CHECK(oe_aes_gcm_decrypt(
+        &key.gcm_key,
+        header.nonce,
+        additional_data,
+        additional_data_size,
+        blob + sizeof(header),
+        size,
+        plaintext,
+        blob + sizeof(header) + size));
+
+    /* The key request is genuine: the key has authenticated the data */
+    _cache_key(&key);
+
+    *plaintext_size = size;
+    result = OE_OK;
+
+done:
+    oe_secure_zero_fill(&key, sizeof(key));
+    return result;
+}
+
+/* Derive the key of a stream from the seal key, the salt of the stream and
+ * the hash of its additional data (NIST SP 800-108) */
+static oe_result_t _init_stream(
+    const seal_header_t* header,
+    const uint8_t* additional_data,
+    size_t additional_data_size,
+    bool sealing,
+    oe_seal_stream_t** stream)
+{
+    oe_result_t result = OE_UNEXPECTED;
+    seal_key_t key;
+    oe_sha256_context_t context;
+    uint8_t salt_and_hash[SEAL_STREAM_SALT_SIZE + OE_SHA256_SIZE];
+    uint8_t* fixed_data = NULL;
+    size_t fixed_data_size = 0;
+    uint8_t stream_key[sizeof(key.key.buf)];
+    oe_seal_stream_t* s = NULL;
+
+    /* The key of a stream opened for unsealing is not cached, as no data has
+     * been authenticated with it yet */
+    OE_CHECK(_get_key(&header->key_request, &key));
+
+    if (sealing)
+        _cache_key(&key);
+
+    OE_CHECK(oe_memcpy_s(
+        salt_and_hash,
+        sizeof(salt_and_hash),
+        header->nonce,
+        SEAL_STREAM_SALT_SIZE));
+
+    OE_CHECK(oe_sha256_init(&context));
+
+    if (additional_data_size)
+        OE_CHECK(oe_sha256_update(
+            &context, additional_data, additional_data_size));
+
+    OE_CHECK(oe_sha256_final(
+        &context, (OE_SHA256*)(salt_and_hash + SEAL_STREAM_SALT_SIZE)));
+
+    OE_CHECK(oe_kdf_create_fixed_data(
+        (const uint8_t*)SEAL_STREAM_LABEL,
+        sizeof(SEAL_STREAM_LABEL) - 1,
+        salt_and_hash,
+        sizeof(salt_and_hash),
+        sizeof(stream_key),
+        &fixed_data,
+        &fixed_data_size));
+
+    OE_CHECK(oe_kdf_derive_key(
+        OE_KDF_HMAC_SHA256_CTR,
+        key.key.buf,
+        sizeof(key.key.buf),
+        fixed_data,
+        fixed_data_size,
+        stream_key,
+        sizeof(stream_key)));
+
+    if (!(s = (oe_seal_stream_t*)oe_memalign(16, sizeof(*s))))
+        OE_RAISE(OE_OUT_OF_MEMORY);
+
+    s->sealing = sealing;
+    s->next_index = 0;
+
+    OE_CHECK(oe_aes_gcm_init_key(stream_key, sizeof(stream_key), &s->gcm_key));
+
+    *stream = s;
+    s = NULL;
+    result = OE_OK;
+
+done:
+    oe_seal_stream_free(s);
+    oe_free(fixed_data);
+    oe_secure_zero_fill(stream_key, sizeof(stream_key));
+    oe_secure_zero_fill(&key, sizeof(key));
+    return result;
+}
+
+oe_result_t oe_seal_stream_init(
+    oe_seal_policy_t seal_policy,
+    const uint8_t* additional_data,
+    size_t additional_data_size,
+    uint8_t* header,
+    size_t header_size,
+    oe_seal_stream_t** stream)
+{
+    oe_result_t result = OE_UNEXPECTED;
+    seal_header_t h = {0};
+
+    if ((!additional_data && additional_data_size) || !header ||
+        header_size < sizeof(h) || !stream)
+        OE_RAISE(OE_INVALID_PARAMETER);
+
+    *stream = NULL;
+
+    h.magic = SEAL_STREAM_MAGIC;
+    OE_CHECK(_get_key_request(seal_policy, &h.key_request));
+    OE_CHECK(oe_random(h.nonce, SEAL_STREAM_SALT_SIZE));
+    OE_CHECK(
+        _init_stream(&h, additional_data, additional_data_size, true, stream));
+
+    OE_CHECK(oe_memcpy_s(header, header_size, &h, sizeof(h)));
+
+    result = OE_OK;
+
+done:
+    if (result != OE_OK && stream && *stream)
+    {
+        oe_seal_stream_free(*stream);
+        *stream = NULL;
+    }
+
+    return result;
+}
+
+oe_result_t oe_unseal_stream_init(
+    const uint8_t* header,
+    size_t header_size,
+    const uint8_t* additional_data,
+    size_t additional_data_size,
+    oe_seal_stream_t** stream)
+{
+    oe_result_t result = OE_UNEXPECTED;
+    seal_header_t h;
+
+    if (!header || (!additional_data && additional_data_size) || !stream)
+        OE_RAISE(OE_INVALID_PARAMETER);
+
+    *stream = NULL;
+
+    OE_CHECK(_read_header(header, header_size, SEAL_STREAM_MAGIC, &h));
+    OE_CHECK(
+        _init_stream(&h, additional_data, additional_data_size, false, stream));
+
+    result = OE_OK;
+
+done:
+    return result;
+}
+
+/* The IV of a chunk, which is unique within its stream */
+static void _chunk_iv(uint32_t index, bool last, uint8_t iv[OE_GCM_IV_SIZE])
+{
+    memset(iv, 0, OE_GCM_IV_SIZE);
+    iv[0] = (uint8_t)(index >> 24);
+    iv[1] = (uint8_t)(index >> 16);
+    iv[2] = (uint8_t)(index >> 8);
+    iv[3] = (uint8_t)index;
+    iv[4] = last;
+}
+
+/* Take the index of the next chunk of a stream, closing the stream if the
+ * chunk is the last one */
+static oe_result_t _take_chunk_index(
+    oe_seal_stream_t* stream,
+    bool last,
+    uint32_t* index)
+{
+    oe_result_t result = OE_UNEXPECTED;
+    uint64_t next = __atomic_load_n(&stream->next_index, __ATOMIC_RELAXED);
+    uint64_t desired;
+
+    do
+    {
+        if (next & SEAL_STREAM_CLOSED)
+            OE_RAISE_MSG(OE_UNEXPECTED, "the last chunk is sealed", NULL);
+
+        if (next > OE_UINT32_MAX)
+            OE_RAISE_MSG(OE_UNEXPECTED, "the chunk indices are used", NULL);
+
+        desired = (next + 1) | (last ? SEAL_STREAM_CLOSED : 0);
+    } while (!__atomic_compare_exchange_n(
+        &stream->next_index,
+        &next,
+        desired,
+        false,
+        __ATOMIC_RELAXED,
+        __ATOMIC_RELAXED));
+
+    *index = (uint32_t)next;
+    result = OE_OK;
+
+done:
+    return result;
+}
+
+oe_result_t oe_seal_stream_chunk(
+    oe_seal_stream_t* stream,
+    bool last,
+    const uint8_t* plaintext,
+    size_t plaintext_size,
+    uint8_t* chunk,
+    size_t* chunk_size,
+    uint32_t* index)
+{
+    oe_result_t result = OE_UNEXPECTED;
+    uint8_t iv[OE_GCM_IV_SIZE];
+    size_t size;
+
+    if (!stream || !stream->sealing || (!plaintext && plaintext_size) ||
+        !chunk_size || !index)
+        OE_RAISE(OE_INVALID_PARAMETER);
+
+    if (plaintext_size > OE_SIZE_MAX - OE_SEAL_TAG_SIZE)
+        OE_RAISE(OE_INVALID_PARAMETER);
+
+    size = plaintext_size + OE_SEAL_TAG_SIZE;
+
+    if (!chunk || *chunk_size < size)
+    {
+        *chunk_size = size;
+        OE_RAISE_NO_TRACE(OE_BUFFER_TOO_SMALL);
+    }
+
+    OE_CHECK(_take_chunk_index(stream, last, index));
+
+    _chunk_iv(*index, last, iv);
+    OE_CHECK(oe_aes_gcm_encrypt(
+        &stream->gcm_key,
+        iv,
+        NULL,
+        0,
+        plaintext,
+        plaintext_size,
+        chunk,
+        chunk + plaintext_size));
+
+    *chunk_size = size;
+    result = OE_OK;
+
+done:
+    return result;
+}
+
+oe_result_t oe_unseal_stream_chunk(
+    const oe_seal_stream_t* stream,
+    uint32_t index,
+    bool last,
+    const uint8_t* chunk,
+    size_t chunk_size,
+    uint8_t* plaintext,
+    size_t* plaintext_size)
+{
+    oe_result_t result = OE_UNEXPECTED;
+    uint8_t iv[OE_GCM_IV_SIZE];
+    size_t size;
+
+    if (!stream || !chunk || chunk_size < OE_SEAL_TAG_SIZE || !plaintext_size)
+        OE_RAISE(OE_INVALID_PARAMETER);
+
+    size = chunk_size - OE_SEAL_TAG_SIZE;
+
+    if (!plaintext || *plaintext_size < size)
+    {
+        *plaintext_size = size;
+        OE_RAISE_NO_TRACE(OE_BUFFER_TOO_SMALL);
+    }
+
+    _chunk_iv(index, last, iv);
+    OE_CHECK(oe_aes_gcm_decrypt(
+        &stream->gcm_key,
+        iv,
+        NULL,
+        0,
+        chunk,
+        size,
+        plaintext,
+        chunk + size));
+
+    *plaintext_size = size;
+    result = OE_OK;
+
+done:
+    return result;
+}
+
+void oe_seal_stream_free(oe_seal_stream_t* stream)
+{
+    if (stream)
+    {
+        oe_aes_gcm_free_key(&stream->gcm_key);
+        oe_memalign_free(stream);
+    }
+}
@@ -3,6 +3,7 @@
 
 #include <openenclave/bits/defs.h>
 #include <openenclave/bits/sgx/sgxtypes.h>
+#include <openenclave/corelibc/string.h>
 #include <openenclave/enclave.h>
 #include <openenclave/internal/cert.h>
 #include <openenclave/internal/crypto/sha.h>
@@ -10,6 +11,8 @@
 #include <openenclave/internal/raise.h>
 #include <openenclave/internal/report.h>
 #include <openenclave/internal/safecrt.h>
+#include <openenclave/internal/thread.h>
+#include <openenclave/internal/time.h>
 #include <openenclave/internal/utils.h>
 #include <stdio.h>
 
@@ -81,42 +84,22 @@ done:
     return result;
 }
 
-/**
- * oe_generate_attestation_certificate.
- *
- * This function generates a self-signed x.509 certificate with an embedded
- * quote from the underlying enclave.
- *
- * @param[in] subject_name a string contains an X.509 distinguished
- * name (DN) for customizing the generated certificate. This name is also used
- * as the issuer name because this is a self-signed certificate
- * See RFC5280 (https://tools.ietf.org/html/rfc5280) specification for details
- * Example value "CN=Open Enclave SDK,O=OESDK TLS,C=US"
- *
- * @param[in] private_key a private key used to sign this certificate
- * @param[in] private_key_size The size of the private_key buffer
- * @param[in] public_key a public key used as the certificate's subject key
- * @param[in] public_key_size The size of the public_key buffer.
- *
- * @param[out] output_cert a pointer to buffer pointer
- * @param[out] output_cert_size size of the buffer above
- *
- * @return OE_OK on success
- */
-oe_result_t oe_generate_attestation_certificate(
+static oe_result_t _generate_attestation_certificate(
     const unsigned char* subject_name,
     uint8_t* private_key,
     size_t private_key_size,
     uint8_t* public_key,
     size_t public_key_size,
     uint8_t** output_cert,
-    size_t* output_cert_size)
+    size_t* output_cert_size,
+    uint8_t cpusvn[SGX_CPUSVN_SIZE])
 {
     oe_result_t result = OE_FAILURE;
     oe_sha256_context_t sha256_ctx = {0};
     OE_SHA256 sha256 = {0};
     uint8_t* remote_report_buf = NULL;
     size_t remote_report_buf_size = OE_MAX_REPORT_SIZE;
+    oe_report_header_t* header = NULL;
 
     OE_TRACE_VERBOSE("Calling oe_generate_attestation_certificate");
 
@@ -147,6 +130,20 @@ oe_result_t oe_generate_attestation_certificate(
     OE_CHECK_MSG(
         result, "oe_get_report failed with %s\n", oe_result_str(result));
 
+    // Remember the CPU SVN the quote was generated with.
+    if (cpusvn)
+    {
+        header = (oe_report_header_t*)remote_report_buf;
+
+        if (header->report_type == OE_REPORT_TYPE_SGX_REMOTE &&
+            header->report_size >= sizeof(sgx_quote_t))
+            OE_CHECK(oe_memcpy_s(
+                cpusvn,
+                SGX_CPUSVN_SIZE,
+                ((sgx_quote_t*)header->report)->report_body.cpusvn,
+                SGX_CPUSVN_SIZE));
+    }
+
     result = generate_x509_self_signed_certificate(
         subject_name,
         private_key,
@@ -169,6 +166,48 @@ done:
     return result;
 }
 
+/**
+ * oe_generate_attestation_certificate.
+ *
+ * This function generates a self-signed x.509 certificate with an embedded
+ * quote from the underlying enclave.
+ *
+ * @param[in] subject_name a string contains an X.509 distinguished
+ * name (DN) for customizing the generated certificate. This name is also used
+ * as the issuer name because this is a self-signed certificate
+ * See RFC5280 (https://tools.ietf.org/html/rfc5280) specification for details
+ * Example value "CN=Open Enclave SDK,O=OESDK TLS,C=US"
+ *
+ * @param[in] private_key a private key used to sign this certificate
+ * @param[in] private_key_size The size of the private_key buffer
+ * @param[in] public_key a public key used as the certificate's subject key
+ * @param[in] public_key_size The size of the public_key buffer.
+ *
+ * @param[out] output_cert a pointer to buffer pointer
+ * @param[out] output_cert_size size of the buffer above
+ *
+ * @return OE_OK on success
+ */
+oe_result_t oe_generate_attestation_certificate(
+    const unsigned char* subject_name,
+    uint8_t* private_key,
+    size_t private_key_size,
+    uint8_t* public_key,
+    size_t public_key_size,
+    uint8_t** output_cert,
+    size_t* output_cert_size)
+{
+    return _generate_attestation_certificate(
+        subject_name,
+        private_key,
+        private_key_size,
+        public_key,
+        public_key_size,
+        output_cert,
+        output_cert_size,
+        NULL);
+}
+
 void oe_free_attestation_certificate(uint8_t* cert)
 {
     if (cert)
@@ -177,3 +216,391 @@ void oe_free_attestation_certificate(uint8_t* cert)
         oe_free(cert);
     }
 }
+
+/*
+**==============================================================================
+**
+** Attestation identities:
+**
+**     Generating an attestation certificate generates a quote, which takes an
+**     ocall to the host and the Quoting Enclave, and is by far the most
+**     expensive step of an attested TLS handshake. An attestation identity
+**     generates a key pair, a quote and the certificate once and hands out
+**     copies of the cached certificate and private key. Handing them out
+**     takes a spin lock only, never an ocall.
+**
+**     The cached material is immutable and reference counted, so that
+**     oe_attestation_identity_refresh() can replace it while other threads
+**     are copying it. Refreshing is meant to run in the background (for
+**     example from a periodic ecall). It regenerates the identity once it
+**     is older than the rotation interval, or when the CPU SVN in a local
+**     report differs from the one in the cached quote, which is the case
+**     after a TCB recovery.
+**
+**==============================================================================
+*/
+
+typedef struct _identity_state
+{
+    uint8_t* cert;
+    size_t cert_size;
+    uint8_t* private_key;
+    size_t private_key_size;
+    uint8_t cpusvn[SGX_CPUSVN_SIZE];
+
+    /* Milliseconds since the Epoch when the state was generated */
+    uint64_t generated_at;
+
+    /* Protected by the identity's lock */
+    uint64_t refs;
+} _identity_state_t;
+
+struct _oe_attestation_identity
+{
+    unsigned char* subject_name;
+    uint64_t rotation_interval;
+
+    /* Protects state and the reference counts of all states */
+    oe_spinlock_t lock;
+    _identity_state_t* state;
+
+    /* Serializes refreshes */
+    oe_mutex_t refresh_lock;
+};
+
+static void _free_identity_state(_identity_state_t* state)
+{
+    if (state)
+    {
+        oe_free(state->cert);
+        oe_free_key(state->private_key, state->private_key_size, NULL, 0);
+        oe_free(state);
+    }
+}
+
+static void _release_identity_state(
+    oe_attestation_identity_t* identity,
+    _identity_state_t* state)
+{
+    bool free_state;
+
+    oe_spin_lock(&identity->lock);
+    free_state = (--state->refs == 0);
+    oe_spin_unlock(&identity->lock);
+
+    if (free_state)
+        _free_identity_state(state);
+}
+
+static oe_result_t _generate_ec_key_pair(
+    uint8_t** private_key,
+    size_t* private_key_size,
+    uint8_t** public_key,
+    size_t* public_key_size)
+{
+    oe_result_t result = OE_UNEXPECTED;
+    uint8_t d[32];
+    oe_ec_private_key_t ec_private_key = {0};
+    oe_ec_public_key_t ec_public_key = {0};
+    bool have_keys = false;
+
+    *private_key = NULL;
+    *private_key_size = 0;
+    *public_key = NULL;
+
+    // A random scalar is a valid private key unless it is zero or not less
+    // than the group order, which is very unlikely.
+    for (size_t i = 0; i < 8 && !have_keys; i++)
+    {
+        OE_CHECK(oe_random(d, sizeof(d)));
+        have_keys = (oe_ec_generate_key_pair_from_private(
+                         OE_EC_TYPE_SECP256R1,
+                         d,
+                         sizeof(d),
+                         &ec_private_key,
+                         &ec_public_key) == OE_OK);
+    }
+
+    if (!have_keys)
+        OE_RAISE(OE_CRYPTO_ERROR);
+
+    *private_key_size = 0;
+    if (oe_ec_private_key_write_pem(
+            &ec_private_key, NULL, private_key_size) != OE_BUFFER_TOO_SMALL)
+        OE_RAISE(OE_CRYPTO_ERROR);
+    if (!(*private_key = (uint8_t*)oe_malloc(*private_key_size)))
+        OE_RAISE(OE_OUT_OF_MEMORY);
+    OE_CHECK(oe_ec_private_key_write_pem(
+        &ec_private_key, *private_key, private_key_size));
+
+    *public_key_size = 0;
+    if (oe_ec_public_key_write_pem(&ec_public_key, NULL, public_key_size) !=
+        OE_BUFFER_TOO_SMALL)
+        OE_RAISE(OE_CRYPTO_ERROR);
+    if (!(*public_key = (uint8_t*)oe_malloc(*public_key_size)))
+        OE_RAISE(OE_OUT_OF_MEMORY);
+    OE_CHECK(oe_ec_public_key_write_pem(
+        &ec_public_key, *public_key, public_key_size));
+
+    result = OE_OK;
+
+done:
+    if (have_keys)
+    {
+        oe_ec_private_key_free(&ec_private_key);
+        oe_ec_public_key_free(&ec_public_key);
+    }
+
+    if (result != OE_OK)
+    {
+        oe_free_key(*private_key, *private_key_size, NULL, 0);
+        oe_free(*public_key);
+        *private_key = NULL;
+        *public_key = NULL;
+    }
+
+    oe_secure_zero_fill(d, sizeof(d));
+
+    return result;
+}
+
+static oe_result_t _generate_identity_state(
+    const oe_attestation_identity_t* identity,
+    _identity_state_t** state_out)
+{
+    oe_result_t result = OE_UNEXPECTED;
+    _identity_state_t* state = NULL;
+    uint8_t* public_key = NULL;
+    size_t public_key_size = 0;
+
+    if (!(state = (_identity_state_t*)oe_calloc(1, sizeof(*state))))
+        OE_RAISE(OE_OUT_OF_MEMORY);
+
+    OE_CHECK(_generate_ec_key_pair(
+        &state->private_key,
+        &state->private_key_size,
+        &public_key,
+        &public_key_size));
+
+    OE_CHECK(_generate_attestation_certificate(
+        identity->subject_name,
+        state->private_key,
+        state->private_key_size,
+        public_key,
+        public_key_size,
+        &state->cert,
+        &state->cert_size,
+        state->cpusvn));
+
+    state->generated_at = oe_get_time();
+    state->refs = 1;
+
+    *state_out = state;
+    state = NULL;
+    result = OE_OK;
+
+done:
+    oe_free(public_key);
+    _free_identity_state(state);
+
+    return result;
+}
+
+/* Whether the TCB of the platform changed since the state was generated */
+static bool _tcb_changed(const _identity_state_t* state)
+{
+    bool changed = false;
+    uint8_t* report = NULL;
+    size_t report_size = 0;
+    oe_report_header_t* header = NULL;
+
+    // A local report for the enclave itself is an EREPORT, not an ocall.
+    if (oe_get_report(0, NULL, 0, NULL, 0, &report, &report_size) != OE_OK)
+        return false;
+
+    header = (oe_report_header_t*)report;
+
+    if (header->report_type == OE_REPORT_TYPE_SGX_LOCAL &&
+        header->report_size >= sizeof(sgx_report_t))
+    {
+        changed = memcmp(
+                      ((sgx_report_t*)header->report)->body.cpusvn,
+                      state->cpusvn,
+                      SGX_CPUSVN_SIZE) != 0;
+    }
+
+    oe_free_report(report);
+
+    return changed;
+}
+
+oe_result_t oe_attestation_identity_create(
+    const oe_attestation_identity_settings_t* settings,
+    oe_attestation_identity_t** identity_out)
+{
+    oe_result_t result = OE_UNEXPECTED;
+    oe_attestation_identity_t* identity = NULL;
+    const char* subject_name = SUBJECT_NAME;
+    size_t subject_name_size;
+
+    if (identity_out)
+        *identity_out = NULL;
+
+    if (!identity_out)
+        OE_RAISE(OE_INVALID_PARAMETER);
+
+    if (settings && settings->subject_name)
+        subject_name = (const char*)settings->subject_name;
+
+    if (!(identity = (oe_attestation_identity_t*)oe_calloc(
+              1, sizeof(*identity))))
+        OE_RAISE(OE_OUT_OF_MEMORY);
+
+    OE_CHECK(oe_mutex_init(&identity->refresh_lock));
+
+    subject_name_size = oe_strlen(subject_name) + 1;
+    identity->subject_name = (unsigned char*)oe_malloc(subject_name_size);
+    if (!identity->subject_name)
+        OE_RAISE(OE_OUT_OF_MEMORY);
+    OE_CHECK(oe_memcpy_s(
+        identity->subject_name,
+        subject_name_size,
+        subject_name,
+        subject_name_size));
+
+    identity->rotation_interval = settings ? settings->rotation_interval : 0;
+
+    OE_CHECK(_generate_identity_state(identity, &identity->state));
+
+    *identity_out = identity;
+    identity = NULL;
+    result = OE_OK;
+
+done:
+    oe_attestation_identity_free(identity);
+
+    return result;
+}
+
+oe_result_t oe_attestation_identity_get(
+    oe_attestation_identity_t* identity,
+    uint8_t** cert,
+    size_t* cert_size,
+    uint8_t** private_key,
+    size_t* private_key_size)
+{
+    oe_result_t result = OE_UNEXPECTED;
+    _identity_state_t* state = NULL;
+    uint8_t* cert_copy = NULL;
+    uint8_t* private_key_copy = NULL;
+
+    if (!identity || !cert || !cert_size || !private_key || !private_key_size)
+        OE_RAISE(OE_INVALID_PARAMETER);
+
+    oe_spin_lock(&identity->lock);
+    state = identity->state;
+    state->refs++;
+    oe_spin_unlock(&identity->lock);
+
+    if (!(cert_copy = (uint8_t*)oe_malloc(state->cert_size)) ||
+        !(private_key_copy = (uint8_t*)oe_malloc(state->private_key_size)))
+        OE_RAISE(OE_OUT_OF_MEMORY);
+
+    OE_CHECK(oe_memcpy_s(
+        cert_copy, state->cert_size, state->cert, state->cert_size));
+    OE_CHECK(oe_memcpy_s(
+        private_key_copy,
+        state->private_key_size,
+        state->private_key,
+        state->private_key_size));
+
+    *cert = cert_copy;
+    *cert_size = state->cert_size;
+    *private_key = private_key_copy;
+    *private_key_size = state->private_key_size;
+    cert_copy = NULL;
+    private_key_copy = NULL;
+    result = OE_OK;
+
+done:
+    if (state)
+    {
+        oe_free(cert_copy);
+        oe_free_key(private_key_copy, state->private_key_size, NULL, 0);
+        _release_identity_state(identity, state);
+    }
+
+    return result;
+}
+
+oe_result_t oe_attestation_identity_refresh(
+    oe_attestation_identity_t* identity,
+    bool force,
+    bool* rotated)
+{
+    oe_result_t result = OE_UNEXPECTED;
+    _identity_state_t* state = NULL;
+    _identity_state_t* old_state = NULL;
+    uint64_t now;
+    bool locked = false;
+
+    if (rotated)
+        *rotated = false;
+
+    if (!identity)
+        OE_RAISE(OE_INVALID_PARAMETER);
+
+    OE_CHECK(oe_mutex_lock(&identity->refresh_lock));
+    locked = true;
+
+    // Only refreshes replace the state, so it can be read without the spin
+    // lock here.
+    if (!force)
+    {
+        now = oe_get_time();
+        old_state = identity->state;
+
+        force = (identity->rotation_interval &&
+                 now != (uint64_t)-1 && now >= old_state->generated_at &&
+                 (now - old_state->generated_at) / 1000 >=
+                     identity->rotation_interval) ||
+                _tcb_changed(old_state);
+        old_state = NULL;
+    }
+
+    if (force)
+    {
+        OE_CHECK(_generate_identity_state(identity, &state));
+
+        oe_spin_lock(&identity->lock);
+        old_state = identity->state;
+        identity->state = state;
+        oe_spin_unlock(&identity->lock);
+
+        _release_identity_state(identity, old_state);
+
+        if (rotated)
+            *rotated = true;
+    }
+
+    result = OE_OK;
+
+done:
+    if (locked)
+        oe_mutex_unlock(&identity->refresh_lock);
+
+    return result;
+}
+
+void oe_attestation_identity_free(oe_attestation_identity_t* identity)
+{
+    if (identity)
+    {
+        if (identity->state)
+            _release_identity_state(identity, identity->state);
+
+        oe_mutex_destroy(&identity->refresh_lock);
+        oe_free(identity->subject_name);
+        oe_free(identity);
+    }
+}
@@ -0,0 +1,149 @@
+// Copyright (c) Open Enclave SDK contributors.
+// Licensed under the MIT License.
+
+#include <openenclave/attestation/plugin.h>
+#include <openenclave/internal/atomic.h>
+#include <openenclave/internal/raise.h>
+#include <stdlib.h>
+#include <string.h>
+#include "hostthread.h"
+
+#if defined(__linux__)
+#include <unistd.h>
+#elif defined(_WIN32)
+#include <windows.h>
+#endif
+
+/* Upper bound on the number of threads of one batch */
+#define MAX_BATCH_THREADS 64
+
+/*
+**==============================================================================
+**
+** oe_verify_evidence_batch():
+**
+**     The items are handed out to the workers one at a time through an
+**     atomic index, so a slow item (for example one whose collateral must be
+**     fetched) does not hold up the items behind it. Verification itself is
+**     oe_verify_evidence(); the sharing of collateral and issuer chains
+**     between quotes of the same platform comes from the SGX collateral and
+**     certificate chain caches, which are safe to use concurrently.
+**
+**==============================================================================
+*/
+
+typedef struct _batch
+{
+    oe_evidence_batch_item_t* items;
+    size_t items_count;
+    const oe_policy_t* policies;
+    size_t policies_size;
+
+    /* Number of items handed out so far */
+    volatile uint64_t next;
+} _batch_t;
+
+static size_t _get_processor_count(void)
+{
+#if defined(__linux__)
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    return n > 0 ? (size_t)n : 1;
+#elif defined(_WIN32)
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return info.dwNumberOfProcessors ? info.dwNumberOfProcessors : 1;
+#else
+    return 1;
+#endif
+}
+
+static void* _worker(void* arg)
+{
+    _batch_t* batch = (_batch_t*)arg;
+    uint64_t index;
+
+    while ((index = oe_atomic_increment(&batch->next) - 1) <
+           batch->items_count)
+    {
+        oe_evidence_batch_item_t* item = &batch->items[index];
+
+        item->result = oe_verify_evidence(
+            item->evidence_buffer,
+            item->evidence_buffer_size,
+            item->endorsements_buffer,
+            item->endorsements_buffer_size,
+            batch->policies,
+            batch->policies_size,
+            &item->claims,
+            &item->claims_length);
+
+        if (item->result != OE_OK)
+        {
+            item->claims = NULL;
+            item->claims_length = 0;
+        }
+    }
+
+    return NULL;
+}
+
+oe_result_t oe_verify_evidence_batch(
+    oe_evidence_batch_item_t* items,
+    size_t items_count,
+    const oe_policy_t* policies,
+    size_t policies_size,
+    size_t max_threads)
+{
+    oe_result_t result = OE_UNEXPECTED;
+    _batch_t batch = {0};
+    oe_thread_t* threads = NULL;
+    size_t num_threads;
+    size_t num_started = 0;
+
+    if ((!items && items_count) || (!policies && policies_size))
+        OE_RAISE(OE_INVALID_PARAMETER);
+
+    for (size_t i = 0; i < items_count; i++)
+    {
+        items[i].result = OE_UNEXPECTED;
+        items[i].claims = NULL;
+        items[i].claims_length = 0;
+    }
+
+    batch.items = items;
+    batch.items_count = items_count;
+    batch.policies = policies;
+    batch.policies_size = policies_size;
+
+    num_threads = max_threads ? max_threads : _get_processor_count();
+
+    if (num_threads > items_count)
+        num_threads = items_count;
+
+    if (num_threads > MAX_BATCH_THREADS)
+        num_threads = MAX_BATCH_THREADS;
+
+    // The calling thread is one of the workers. If the helper threads cannot
+    // be created, it verifies the remaining items by itself.
+    if (num_threads > 1 &&
+        (threads = (oe_thread_t*)calloc(num_threads - 1, sizeof(*threads))))
+    {
+        for (; num_started < num_threads - 1; num_started++)
+        {
+            if (oe_thread_create(&threads[num_started], _worker, &batch) != 0)
+                break;
+        }
+    }
+
+    _worker(&batch);
+
+    for (size_t i = 0; i < num_started; i++)
+        oe_thread_join(threads[i]);
+
+    result = OE_OK;
+
+done:
+    free(threads);
+
+    return result;
+}
@@ -561,3 +561,25 @@ oe_result_t oe_terminate_enclave(oe_enclave_t* enclave)
 done:
     return result;
 }
+
+oe_result_t oe_get_enclave_startup_trace(
+    oe_enclave_t* enclave,
+    oe_startup_phase_timing_t* timings,
+    size_t* count)
+{
+    OE_UNUSED(enclave);
+    OE_UNUSED(timings);
+    OE_UNUSED(count);
+
+    return OE_UNSUPPORTED;
+}
+
+oe_result_t oe_get_enclave_heap_stats(
+    oe_enclave_t* enclave,
+    oe_enclave_heap_stats_t* stats)
+{
+    OE_UNUSED(enclave);
+    OE_UNUSED(stats);
+
+    return OE_UNSUPPORTED;
+}
@@ -318,7 +318,8 @@ static const char* oe_ecall_str(oe_func_t ecall)
         "DESTRUCTOR",
         "INIT_ENCLAVE",
         "CALL_ENCLAVE_FUNCTION",
-        "VIRTUAL_EXCEPTION_HANDLER"
+        "VIRTUAL_EXCEPTION_HANDLER",
+        "GET_HEAP_STATS"
     };
     // clang-format on
 
@@ -656,3 +657,23 @@ done:
 
     return result;
 }
+
+oe_result_t oe_get_enclave_heap_stats(
+    oe_enclave_t* enclave,
+    oe_enclave_heap_stats_t* stats)
+{
+    oe_result_t result = OE_UNEXPECTED;
+    uint64_t arg_out = 0;
+
+    if (!enclave || enclave->magic != ENCLAVE_MAGIC || !stats)
+        OE_RAISE(OE_INVALID_PARAMETER);
+
+    OE_CHECK(oe_ecall(
+        enclave, OE_ECALL_GET_HEAP_STATS, (uint64_t)stats, &arg_out));
+    OE_CHECK((oe_result_t)arg_out);
+
+    result = OE_OK;
+
+done:
+    return result;
+}
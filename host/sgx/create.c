@@ -56,30 +56,66 @@ static char* get_fullpath(const char* path)
 #include "exception.h"
 #include "sgx_u.h"
 #include "sgxload.h"
+#include "startuptrace.h"
+
+/*
+** _trace_begin() / _trace_end()
+**
+** Time a phase of enclave creation if a startup trace was requested. The
+** measurement tool (OEHOSTMR) never records a trace.
+*/
+
+static uint64_t _trace_begin(const oe_enclave_t* enclave)
+{
+#if defined(OEHOSTMR)
+    OE_UNUSED(enclave);
+    return 0;
+#else
+    return enclave->startup_trace ? oe_startup_trace_now() : 0;
+#endif
+}
+
+static void _trace_end(
+    oe_enclave_t* enclave,
+    oe_startup_phase_t phase,
+    uint64_t start,
+    uint64_t num_pages)
+{
+#if defined(OEHOSTMR)
+    OE_UNUSED(enclave);
+    OE_UNUSED(phase);
+    OE_UNUSED(start);
+    OE_UNUSED(num_pages);
+#else
+    oe_startup_trace_record(enclave->startup_trace, phase, start, num_pages);
+#endif
+}
 
 #if !defined(OEHOSTMR)
 static oe_once_type _enclave_init_once;
 
-static void _initialize_exception_handling(void)
+static void _initialize_enclave_host_once(void)
 {
     oe_initialize_host_exception();
+    oe_register_switchless_ocall_function_table();
+    oe_register_tee_ocall_function_table();
+    oe_register_sgx_ocall_function_table();
+    oe_register_syscall_ocall_function_table();
 }
 
 /*
 **==============================================================================
 **
-** The per process enclave host side initialization.
+** The per process enclave host side initialization. The ocall tables are
+** process-wide and never change, so they are registered once rather than on
+** every enclave creation.
 **
 **==============================================================================
 */
 
 static void _initialize_enclave_host()
 {
-    oe_once(&_enclave_init_once, _initialize_exception_handling);
-    oe_register_switchless_ocall_function_table();
-    oe_register_tee_ocall_function_table();
-    oe_register_sgx_ocall_function_table();
-    oe_register_syscall_ocall_function_table();
+    oe_once(&_enclave_init_once, _initialize_enclave_host_once);
 }
 #endif // OEHOSTMR
 
@@ -140,11 +176,16 @@ static oe_result_t _add_stack_pages(
     oe_sgx_load_context_t* context,
     uint64_t enclave_addr,
     uint64_t* vaddr,
-    size_t npages)
+    size_t npages,
+    bool fill)
 {
-    const bool extend = true;
+    /* Unfilled stacks are not measured, like the heap. The host therefore
+     * controls their initial contents, which OE_SGX_CONFIG_FLAGS_NO_STACK_FILL
+     * documents as acceptable only if stack memory is written before it is
+     * read */
+    const bool extend = fill;
     return _add_filled_pages(
-        context, enclave_addr, vaddr, npages, 0xcccccccc, extend);
+        context, enclave_addr, vaddr, npages, fill ? 0xcccccccc : 0, extend);
 }
 
 static oe_result_t _add_heap_pages(
@@ -158,6 +199,31 @@ static oe_result_t _add_heap_pages(
     return _add_filled_pages(context, enclave_addr, vaddr, npages, 0, extend);
 }
 
+static oe_result_t _reserve_heap_pages(
+    oe_sgx_load_context_t* context,
+    uint64_t enclave_addr,
+    uint64_t* vaddr,
+    size_t npages)
+{
+    oe_result_t result = OE_UNEXPECTED;
+
+    if (!context || !enclave_addr || !vaddr)
+        OE_RAISE(OE_INVALID_PARAMETER);
+
+    /* The enclave commits these pages on demand (see oe_sbrk) */
+    if (npages)
+    {
+        OE_CHECK(oe_sgx_reserve_enclave_pages(
+            context, enclave_addr, enclave_addr + *vaddr, npages));
+        (*vaddr) += npages * OE_PAGE_SIZE;
+    }
+
+    result = OE_OK;
+
+done:
+    return result;
+}
+
 static oe_result_t _add_control_pages(
     oe_sgx_load_context_t* context,
     uint64_t enclave_addr,
@@ -280,6 +346,37 @@ done:
     return result;
 }
 
+/*
+**==============================================================================
+**
+** _get_tcs_class()
+**
+**     Get the number of TCSs and their stack pages for the given thread class:
+**     class 0 is the header.size_settings threads, and classes 1 through
+**     OE_SGX_MAX_TCS_CLASSES are the additional thread classes. The threads
+**     are laid out in this order.
+**
+**==============================================================================
+*/
+
+static void _get_tcs_class(
+    const oe_sgx_enclave_properties_t* props,
+    size_t index,
+    uint64_t* num_tcs,
+    uint64_t* num_stack_pages)
+{
+    if (index == 0)
+    {
+        *num_tcs = props->header.size_settings.num_tcs;
+        *num_stack_pages = props->header.size_settings.num_stack_pages;
+    }
+    else
+    {
+        *num_tcs = props->tcs_classes[index - 1].num_tcs;
+        *num_stack_pages = props->tcs_classes[index - 1].num_stack_pages;
+    }
+}
+
 static oe_result_t _calculate_enclave_size(
     size_t image_size,
     const oe_sgx_enclave_properties_t* props,
@@ -288,9 +385,8 @@ static oe_result_t _calculate_enclave_size(
 
 {
     oe_result_t result = OE_UNEXPECTED;
-    size_t heap_size;
-    size_t stack_size;
-    size_t control_size;
+    uint64_t heap_size;
+    uint64_t end;
     const oe_enclave_size_settings_t* size_settings;
 
     size_settings = &props->header.size_settings;
@@ -299,24 +395,37 @@ static oe_result_t _calculate_enclave_size(
     *enclave_end = 0;
 
     /* Compute size in bytes of the heap */
-    heap_size = size_settings->num_heap_pages * OE_PAGE_SIZE;
-
-    /* Compute size of the stack (one per TCS; include guard pages) */
-    stack_size = OE_PAGE_SIZE // guard page
-                 + (size_settings->num_stack_pages * OE_PAGE_SIZE) +
-                 OE_PAGE_SIZE; // guard page
+    OE_CHECK(oe_safe_mul_u64(
+        size_settings->num_heap_pages, OE_PAGE_SIZE, &heap_size));
+    OE_CHECK(oe_safe_add_u64(image_size, heap_size, &end));
 
-    /* Compute the control size in bytes (6 pages total) */
-    control_size = 6 * OE_PAGE_SIZE;
+    for (size_t i = 0; i <= OE_SGX_MAX_TCS_CLASSES; i++)
+    {
+        uint64_t num_tcs;
+        uint64_t num_stack_pages;
+        uint64_t thread_pages;
+        uint64_t thread_size;
+
+        _get_tcs_class(props, i, &num_tcs, &num_stack_pages);
+
+        /* Compute the pages of each thread: the stack with a guard page on
+         * either side, and 6 control pages */
+        OE_CHECK(oe_safe_add_u64(num_stack_pages, 2 + 6, &thread_pages));
+        OE_CHECK(oe_safe_mul_u64(thread_pages, OE_PAGE_SIZE, &thread_size));
+        OE_CHECK(oe_safe_mul_u64(thread_size, num_tcs, &thread_size));
+        OE_CHECK(oe_safe_add_u64(end, thread_size, &end));
+    }
 
     /* Compute end of the enclave */
-    *enclave_end = image_size + heap_size +
-                   (size_settings->num_tcs * (stack_size + control_size));
+    *enclave_end = end;
 
-    /* Calculate the total size of the enclave */
+    /* Calculate the total size of the enclave (SGX requires the size to be
+     * a power of two) */
     *enclave_size = oe_round_u64_to_pow2(*enclave_end);
 
     result = OE_OK;
+
+done:
     return result;
 }
 
@@ -331,29 +440,59 @@ static oe_result_t _add_data_pages(
     oe_result_t result = OE_UNEXPECTED;
     const oe_enclave_size_settings_t* size_settings =
         &props->header.size_settings;
-    size_t i;
+    const bool fill_stacks =
+        !(props->config.flags & OE_SGX_CONFIG_FLAGS_NO_STACK_FILL);
+    uint64_t start = _trace_begin(enclave);
+    uint64_t first_thread_vaddr;
+
+    /* Add the heap pages, or only reserve them for a dynamic heap */
+    if (props->config.flags & OE_SGX_CONFIG_FLAGS_DYNAMIC_HEAP)
+        OE_CHECK(_reserve_heap_pages(
+            context, enclave->addr, vaddr, size_settings->num_heap_pages));
+    else
+        OE_CHECK(_add_heap_pages(
+            context, enclave->addr, vaddr, size_settings->num_heap_pages));
 
-    /* Add the heap pages */
-    OE_CHECK(_add_heap_pages(
-        context, enclave->addr, vaddr, size_settings->num_heap_pages));
+    _trace_end(
+        enclave,
+        OE_STARTUP_PHASE_ADD_HEAP_PAGES,
+        start,
+        size_settings->num_heap_pages);
 
-    for (i = 0; i < size_settings->num_tcs; i++)
+    start = _trace_begin(enclave);
+    first_thread_vaddr = *vaddr;
+
+    for (size_t i = 0; i <= OE_SGX_MAX_TCS_CLASSES; i++)
     {
-        /* Add guard page */
-        *vaddr += OE_PAGE_SIZE;
+        uint64_t num_tcs;
+        uint64_t num_stack_pages;
+
+        _get_tcs_class(props, i, &num_tcs, &num_stack_pages);
 
-        /* Add the stack for this thread control structure */
-        OE_CHECK(_add_stack_pages(
-            context, enclave->addr, vaddr, size_settings->num_stack_pages));
+        for (uint64_t j = 0; j < num_tcs; j++)
+        {
+            /* Add guard page */
+            *vaddr += OE_PAGE_SIZE;
+
+            /* Add the stack for this thread control structure */
+            OE_CHECK(_add_stack_pages(
+                context, enclave->addr, vaddr, num_stack_pages, fill_stacks));
 
-        /* Add guard page */
-        *vaddr += OE_PAGE_SIZE;
+            /* Add guard page */
+            *vaddr += OE_PAGE_SIZE;
 
-        /* Add the "control" pages */
-        OE_CHECK(_add_control_pages(
-            context, enclave->addr, enclave->size, entry, vaddr, enclave));
+            /* Add the "control" pages */
+            OE_CHECK(_add_control_pages(
+                context, enclave->addr, enclave->size, entry, vaddr, enclave));
+        }
     }
 
+    _trace_end(
+        enclave,
+        OE_STARTUP_PHASE_ADD_THREAD_PAGES,
+        start,
+        (*vaddr - first_thread_vaddr) / OE_PAGE_SIZE);
+
     result = OE_OK;
 
 done:
@@ -389,6 +528,16 @@ oe_result_t oe_sgx_get_cpuid_table_ocall(
         leaf += OE_CPUID_REG_COUNT;
     }
 
+    /* The enclave requests the CPUID table once its runtime (relocations,
+     * thread data) is initialized and before it runs global constructors */
+    {
+        oe_thread_binding_t* binding = oe_get_thread_binding();
+
+        if (binding && binding->enclave && binding->enclave->startup_trace)
+            binding->enclave->startup_trace->cpuid_time =
+                oe_startup_trace_now();
+    }
+
     result = OE_OK;
 
 done:
@@ -410,10 +559,25 @@ static oe_result_t _initialize_enclave(oe_enclave_t* enclave)
 {
     oe_result_t result = OE_UNEXPECTED;
     uint64_t result_out = 0;
+    uint64_t start = _trace_begin(enclave);
 
     OE_CHECK(oe_ecall(
         enclave, OE_ECALL_INIT_ENCLAVE, (uint64_t)enclave, &result_out));
 
+    /* Split the first ecall at the point where it requested the CPUID
+     * table (see oe_sgx_get_cpuid_table_ocall()) */
+    if (enclave->startup_trace)
+    {
+        oe_startup_trace_t* trace = enclave->startup_trace;
+        uint64_t split = trace->cpuid_time >= start ? trace->cpuid_time
+                                                    : oe_startup_trace_now();
+
+        oe_startup_trace_record_span(
+            trace, OE_STARTUP_PHASE_INITIALIZE_ENCLAVE, start, split, 0);
+        oe_startup_trace_record(
+            trace, OE_STARTUP_PHASE_CALL_INIT_FUNCTIONS, split, 0);
+    }
+
     if (result_out > OE_UINT32_MAX)
         OE_RAISE(OE_FAILURE);
 
@@ -458,6 +622,9 @@ static oe_result_t _configure_enclave(
                     enclave, max_host_workers, max_enclave_workers));
                 break;
             }
+            // The startup trace is set up before the enclave is built.
+            case OE_ENCLAVE_SETTING_STARTUP_TRACE:
+                break;
             default:
                 OE_RAISE(OE_INVALID_PARAMETER);
         }
@@ -532,6 +699,28 @@ oe_result_t oe_sgx_validate_enclave_properties(
         goto done;
     }
 
+    if (!oe_sgx_is_valid_tcs_classes(properties))
+    {
+        if (field_name)
+            *field_name = "tcs_classes";
+        OE_TRACE_ERROR(
+            "oe_sgx_is_valid_tcs_classes failed: total num_tcs = %lx\n",
+            oe_sgx_get_total_num_tcs(properties));
+        result = OE_FAILURE;
+        goto done;
+    }
+
+    if (!oe_sgx_is_valid_config_flags(properties->config.flags))
+    {
+        if (field_name)
+            *field_name = "config.flags";
+        OE_TRACE_ERROR(
+            "oe_sgx_is_valid_config_flags failed: flags = %x\n",
+            properties->config.flags);
+        result = OE_FAILURE;
+        goto done;
+    }
+
     if (!oe_sgx_is_valid_product_id(properties->config.product_id))
     {
         if (field_name)
@@ -575,17 +764,24 @@ oe_result_t oe_sgx_build_enclave(
     size_t image_size;
     uint64_t vaddr = 0;
     oe_sgx_enclave_properties_t props;
+    oe_startup_trace_t* startup_trace;
+    uint64_t start;
 
     if (!enclave)
         OE_RAISE(OE_INVALID_PARAMETER);
 
     memset(&oeimage, 0, sizeof(oeimage));
 
-    /* Clear and initialize enclave structure */
+    /* Clear and initialize enclave structure, keeping the startup trace
+     * that oe_create_enclave() may have attached */
     {
+        startup_trace = enclave->startup_trace;
+
         if (enclave)
             memset(enclave, 0, sizeof(oe_enclave_t));
 
+        enclave->startup_trace = startup_trace;
+
         enclave->debug = oe_sgx_is_debug_load_context(context);
         enclave->simulate = oe_sgx_is_simulation_load_context(context);
     }
@@ -599,9 +795,13 @@ oe_result_t oe_sgx_build_enclave(
         OE_RAISE(OE_INVALID_PARAMETER);
 
     /* Load the elf object */
+    start = _trace_begin(enclave);
+
     if (oe_load_enclave_image(path, &oeimage) != OE_OK)
         OE_RAISE(OE_FAILURE);
 
+    _trace_end(enclave, OE_STARTUP_PHASE_LOAD_IMAGE, start, 0);
+
     // If the **properties** parameter is non-null, use those properties.
     // Else use the properties stored in the .oeinfo section.
     if (properties)
@@ -653,7 +853,10 @@ oe_result_t oe_sgx_build_enclave(
         image_size, &props, &enclave_end, &enclave_size));
 
     /* Perform the ECREATE operation */
+    start = _trace_begin(enclave);
     OE_CHECK(oe_sgx_create_enclave(context, enclave_size, &enclave_addr));
+    _trace_end(
+        enclave, OE_STARTUP_PHASE_ECREATE, start, enclave_size / OE_PAGE_SIZE);
 
     /* Save the enclave base address, size, and text address */
     enclave->addr = enclave_addr;
@@ -661,18 +864,25 @@ oe_result_t oe_sgx_build_enclave(
     enclave->text = enclave_addr + oeimage.text_rva;
 
     /* Patch image */
+    start = _trace_begin(enclave);
     OE_CHECK(oeimage.patch(&oeimage, enclave_end));
+    _trace_end(enclave, OE_STARTUP_PHASE_PATCH_IMAGE, start, 0);
 
     /* Add image to enclave */
+    start = _trace_begin(enclave);
     OE_CHECK(oeimage.add_pages(&oeimage, context, enclave, &vaddr));
+    _trace_end(
+        enclave, OE_STARTUP_PHASE_ADD_IMAGE_PAGES, start, vaddr / OE_PAGE_SIZE);
 
     /* Add data pages */
     OE_CHECK(
         _add_data_pages(context, enclave, &props, oeimage.entry_rva, &vaddr));
 
     /* Ask the platform to initialize the enclave and finalize the hash */
+    start = _trace_begin(enclave);
     OE_CHECK(oe_sgx_initialize_enclave(
         context, enclave_addr, &props, &enclave->hash));
+    _trace_end(enclave, OE_STARTUP_PHASE_EINIT, start, 0);
 
     /* Save full path of this enclave. When a debugger attaches to the host
      * process, it needs the fullpath so that it can load the image binary and
@@ -725,6 +935,9 @@ oe_result_t oe_create_enclave(
     oe_result_t result = OE_UNEXPECTED;
     oe_enclave_t* enclave = NULL;
     oe_sgx_load_context_t context;
+    const oe_enclave_setting_startup_trace_t* trace_setting = NULL;
+    oe_startup_trace_t* startup_trace = NULL;
+    uint64_t start;
 
     _initialize_enclave_host();
 
@@ -747,10 +960,26 @@ oe_result_t oe_create_enclave(
         (flags & OE_ENCLAVE_FLAG_RESERVED))
         OE_RAISE(OE_INVALID_PARAMETER);
 
+    /* Start the startup trace, if requested, before any enclave work */
+    for (uint32_t i = 0; i < setting_count; i++)
+    {
+        if (settings[i].setting_type == OE_ENCLAVE_SETTING_STARTUP_TRACE)
+        {
+            if (!(trace_setting = settings[i].u.startup_trace_setting))
+                OE_RAISE(OE_INVALID_PARAMETER);
+
+            if (!startup_trace &&
+                !(startup_trace = oe_startup_trace_create()))
+                OE_RAISE(OE_OUT_OF_MEMORY);
+        }
+    }
+
     /* Allocate and zero-fill the enclave structure */
     if (!(enclave = (oe_enclave_t*)calloc(1, sizeof(oe_enclave_t))))
         OE_RAISE(OE_OUT_OF_MEMORY);
 
+    enclave->startup_trace = startup_trace;
+
 #if defined(_WIN32)
     /* Create Windows events for each TCS binding. Enclaves use
      * this event when calling into the host to handle waits/wakes
@@ -830,18 +1059,34 @@ oe_result_t oe_create_enclave(
     OE_CHECK(_initialize_enclave(enclave));
 
     /* Apply the list of settings to the enclave */
+    start = _trace_begin(enclave);
     OE_CHECK(_configure_enclave(enclave, settings, setting_count));
+    _trace_end(enclave, OE_STARTUP_PHASE_CONFIGURE_ENCLAVE, start, 0);
 
     /* Setup logging configuration */
     oe_log_enclave_init(enclave);
 
+    if (startup_trace)
+    {
+        oe_startup_trace_record(
+            startup_trace,
+            OE_STARTUP_PHASE_CREATE_ENCLAVE,
+            startup_trace->origin,
+            enclave->size / OE_PAGE_SIZE);
+
+        if (trace_setting->chrome_trace_path)
+            OE_CHECK(oe_startup_trace_write_chrome_json(
+                startup_trace, trace_setting->chrome_trace_path));
+    }
+
     *enclave_out = enclave;
     result = OE_OK;
 
 done:
 
-    if (result != OE_OK && enclave)
+    if (result != OE_OK)
     {
+        oe_startup_trace_free(startup_trace);
         free(enclave);
     }
 
@@ -900,6 +1145,8 @@ oe_result_t oe_terminate_enclave(oe_enclave_t* enclave)
 
         /* Free the path name of the enclave image file */
         free(enclave->path);
+
+        oe_startup_trace_free(enclave->startup_trace);
     }
     /* Release and destroy the mutex object */
     oe_mutex_unlock(&enclave->lock);
@@ -912,6 +1159,36 @@ oe_result_t oe_terminate_enclave(oe_enclave_t* enclave)
     /* Free the enclave structure */
     free(enclave);
 
+done:
+    return result;
+}
+
+oe_result_t oe_get_enclave_startup_trace(
+    oe_enclave_t* enclave,
+    oe_startup_phase_timing_t* timings,
+    size_t* count)
+{
+    oe_result_t result = OE_UNEXPECTED;
+    const oe_startup_trace_t* trace;
+
+    if (!enclave || enclave->magic != ENCLAVE_MAGIC || !count ||
+        (*count && !timings))
+        OE_RAISE(OE_INVALID_PARAMETER);
+
+    if (!(trace = enclave->startup_trace))
+        OE_RAISE_NO_TRACE(OE_NOT_FOUND);
+
+    if (*count < trace->num_phases)
+    {
+        *count = trace->num_phases;
+        OE_RAISE_NO_TRACE(OE_BUFFER_TOO_SMALL);
+    }
+
+    memcpy(timings, trace->phases, trace->num_phases * sizeof(*timings));
+    *count = trace->num_phases;
+
+    result = OE_OK;
+
 done:
     return result;
 }
@@ -14,6 +14,7 @@
 #include <stdbool.h>
 #include "../hostthread.h"
 #include "asmdefs.h"
+#include "startuptrace.h"
 
 #if defined(_WIN32)
 #include <windows.h>
@@ -130,6 +131,9 @@ struct _oe_enclave
 
     /* Manager for switchless calls */
     oe_switchless_call_manager_t* switchless_manager;
+
+    /* Phase timings of oe_create_enclave(), if a trace was requested */
+    oe_startup_trace_t* startup_trace;
 };
 
 /* Get the event for the given TCS */
@@ -3,25 +3,100 @@
 
 #include <assert.h>
 #include <openenclave/host.h>
-#include <openenclave/internal/queue.h>
+#include <openenclave/internal/atomic.h>
 #include <openenclave/internal/trace.h>
 #include "enclave.h"
 
-static OE_LIST_HEAD(EnclaveListHead, _enclave_entry) oe_enclave_list_head;
-static oe_mutex oe_enclave_list_lock = OE_H_MUTEX_INITIALIZER;
+/*
+**==============================================================================
+**
+** Enclave registry:
+**
+**     The registry maps addresses inside an enclave (such as the TCS that a
+**     host thread was running on when an exception occurred) to the owning
+**     enclave. Each enclave owns the disjoint range [addr, addr + size), so
+**     the range alone identifies the enclave and the thread bindings never
+**     need to be inspected.
+**
+**     The registry is a fixed array of slots that is updated with atomic
+**     compare-and-swap operations and read without locks:
+**
+**         - Registering claims the first empty slot.
+**         - Unregistering clears the enclave's slot.
+**         - Lookups scan the slots below the high-water mark.
+**
+**     Each slot keeps its own copy of the enclave's range, so a lookup never
+**     dereferences an enclave that another thread may be terminating. A slot
+**     is guarded by a sequence number that is odd while the slot is being
+**     written; readers skip slots that are being written and retry slots
+**     whose sequence number changed while they were read. Readers never
+**     wait for a writer, so the exception path cannot deadlock against a
+**     registration that it interrupted on the same thread.
+**
+**     Creating and terminating enclaves from many threads therefore never
+**     serializes on a global lock, and the exception path never blocks.
+**
+**==============================================================================
+*/
+
+#define OE_MAX_ENCLAVE_INSTANCES 4096
+
+typedef struct _registry_slot
+{
+    /* Odd while a writer owns the slot */
+    volatile uint64_t sequence;
+    volatile uint64_t enclave;
+    volatile uint64_t addr;
+    volatile uint64_t size;
+} registry_slot_t;
+
+static registry_slot_t _registry[OE_MAX_ENCLAVE_INSTANCES];
+
+/* One past the highest slot that has ever been used */
+static volatile uint64_t _registry_end;
+
+static oe_enclave_t* _load_slot(size_t i)
+{
+    return (oe_enclave_t*)oe_atomic_load(&_registry[i].enclave);
+}
+
+/* Take ownership of the slot if no other writer owns it */
+static bool _try_lock_slot(registry_slot_t* slot)
+{
+    uint64_t sequence = oe_atomic_load(&slot->sequence);
+
+    return !(sequence & 1) &&
+           oe_atomic_compare_and_swap(
+               (volatile int64_t*)&slot->sequence,
+               (int64_t)sequence,
+               (int64_t)(sequence + 1));
+}
+
+static void _unlock_slot(registry_slot_t* slot)
+{
+    oe_atomic_increment(&slot->sequence);
+}
 
-typedef struct _enclave_entry
+static void _raise_registry_end(uint64_t end)
 {
-    OE_LIST_ENTRY(_enclave_entry) next_entry;
-    oe_enclave_t* enclave;
-} EnclaveEntry;
+    uint64_t current;
+
+    while ((current = oe_atomic_load(&_registry_end)) < end)
+    {
+        if (oe_atomic_compare_and_swap(
+                (volatile int64_t*)&_registry_end,
+                (int64_t)current,
+                (int64_t)end))
+            break;
+    }
+}
 
 /*
 **==============================================================================
 **
 ** oe_push_enclave_instance()
 **
-**     Push the enclave to the head of the global enclave list.
+**     Add the enclave to the global enclave registry.
 **     Return 0 if success.
 **
 **==============================================================================
@@ -30,55 +105,50 @@ typedef struct _enclave_entry
 uint32_t oe_push_enclave_instance(oe_enclave_t* enclave)
 {
     uint32_t ret = 1;
-    bool locked = false;
-    EnclaveEntry* new_entry = NULL;
+    size_t end = (size_t)oe_atomic_load(&_registry_end);
 
-    // Take the lock.
-    if (oe_mutex_lock(&oe_enclave_list_lock) != 0)
-    {
+    if (!enclave)
         goto cleanup;
-    }
 
-    locked = true;
-
-    // Return error if the enclave is already in global list.
+    // Return error if the enclave is already in the registry.
+    for (size_t i = 0; i < end; i++)
     {
-        EnclaveEntry* tmp;
-        OE_LIST_FOREACH(tmp, &oe_enclave_list_head, next_entry)
+        if (_load_slot(i) == enclave)
         {
-            if (tmp->enclave == enclave)
-            {
-                OE_TRACE_ERROR("The enclave is already in global list\n");
-                goto cleanup;
-            }
+            OE_TRACE_ERROR("The enclave is already in global list\n");
+            goto cleanup;
         }
     }
 
-    // Allocate new entry.
-    new_entry = (EnclaveEntry*)calloc(1, sizeof(EnclaveEntry));
-    if (new_entry == NULL)
+    // Claim the first empty slot. The range is written before the enclave
+    // pointer, and both before the slot is unlocked.
+    for (size_t i = 0; i < OE_MAX_ENCLAVE_INSTANCES; i++)
     {
-        OE_TRACE_ERROR("calloc for EnclaveEntry failed\n");
-        goto cleanup;
-    }
-
-    new_entry->enclave = enclave;
-
-    // Insert to the beginning of the list.
-    OE_LIST_INSERT_HEAD(&oe_enclave_list_head, new_entry, next_entry);
+        registry_slot_t* slot = &_registry[i];
 
-    // Return success.
-    ret = 0;
+        if (_load_slot(i) || !_try_lock_slot(slot))
+            continue;
 
-cleanup:
-    if (locked)
-    {
-        // Release the lock if it is taken.
-        if (oe_mutex_unlock(&oe_enclave_list_lock) != 0)
+        if (_load_slot(i))
         {
-            abort();
+            _unlock_slot(slot);
+            continue;
         }
+
+        slot->addr = enclave->addr;
+        slot->size = enclave->size;
+        slot->enclave = (uint64_t)enclave;
+        _unlock_slot(slot);
+
+        _raise_registry_end(i + 1);
+        ret = 0;
+        goto cleanup;
     }
+
+    OE_TRACE_ERROR(
+        "Too many enclave instances (max=%d)\n", OE_MAX_ENCLAVE_INSTANCES);
+
+cleanup:
     if (ret)
         OE_TRACE_ERROR("enclave=0x%x\n", enclave);
 
@@ -90,7 +160,7 @@ cleanup:
 **
 ** oe_remove_enclave_instance()
 **
-**     Remove the enclave from the global enclave list.
+**     Remove the enclave from the global enclave registry.
 **     Return 0 if success.
 **
 **==============================================================================
@@ -99,41 +169,32 @@ cleanup:
 uint32_t oe_remove_enclave_instance(oe_enclave_t* enclave)
 {
     uint32_t ret = 1;
-    bool locked = false;
+    size_t end = (size_t)oe_atomic_load(&_registry_end);
 
-    // Take the lock.
-    if (oe_mutex_lock(&oe_enclave_list_lock) != 0)
+    for (size_t i = 0; enclave && i < end; i++)
     {
-        OE_TRACE_ERROR("oe_mutex_lock failed\n");
-        goto cleanup;
-    }
+        registry_slot_t* slot = &_registry[i];
 
-    locked = true;
+        if (_load_slot(i) != enclave)
+            continue;
 
-    // Enumerate the enclave list, remove the target entry if find it.
-    {
-        EnclaveEntry* tmp;
-        OE_LIST_FOREACH(tmp, &oe_enclave_list_head, next_entry)
-        {
-            if (tmp->enclave == enclave)
-            {
-                OE_LIST_REMOVE(tmp, next_entry);
-                free(tmp);
-                ret = 0;
-                break;
-            }
-        }
-    }
+        // Only a registration that lost the race for this slot can own it
+        // now, and it releases the slot without waiting on anything.
+        while (!_try_lock_slot(slot))
+            oe_yield_cpu();
 
-cleanup:
-    if (locked)
-    {
-        // Release the lock if it is taken.
-        if (oe_mutex_unlock(&oe_enclave_list_lock) != 0)
+        if (_load_slot(i) == enclave)
         {
-            OE_TRACE_ERROR("oe_mutex_unlock failed and calling abort...\n");
-            abort();
+            slot->enclave = 0;
+            slot->addr = 0;
+            slot->size = 0;
+            ret = 0;
         }
+
+        _unlock_slot(slot);
+
+        if (ret == 0)
+            break;
     }
 
     if (ret)
@@ -147,7 +208,9 @@ cleanup:
 **
 ** oe_query_enclave_instance()
 **
-**     Query the owner enclave for the given TCS.
+**     Query the owner enclave for the given TCS, which is the enclave whose
+**     address range contains the TCS. Only the registry's copies of the
+**     ranges are read, never the enclaves themselves.
 **     Return the owner enclave if success, otherwise return NULL.
 **
 **==============================================================================
@@ -156,48 +219,36 @@ cleanup:
 oe_enclave_t* oe_query_enclave_instance(void* tcs)
 {
     oe_enclave_t* ret = NULL;
-    bool locked = false;
+    size_t end = (size_t)oe_atomic_load(&_registry_end);
 
-    // Take the lock.
-    if (oe_mutex_lock(&oe_enclave_list_lock) != 0)
+    for (size_t i = 0; !ret && i < end; i++)
     {
-        OE_TRACE_ERROR("oe_mutex_lock failed\n");
-        goto cleanup;
-    }
-
-    locked = true;
+        registry_slot_t* slot = &_registry[i];
+        uint64_t sequence;
+        uint64_t enclave;
+        uint64_t addr;
+        uint64_t size;
 
-    // Enumerate the enclave list, find which enclave owns the TCS.
-    {
-        EnclaveEntry* tmp;
-        OE_LIST_FOREACH(tmp, &oe_enclave_list_head, next_entry)
+        do
         {
-            oe_enclave_t* enclave = tmp->enclave;
+            // A slot that is being written belongs to an enclave that is
+            // being created or terminated, which cannot own a running TCS.
+            sequence = oe_atomic_load(&slot->sequence);
+            if (sequence & 1)
+                break;
 
-            oe_mutex_lock(&enclave->lock);
+            enclave = oe_atomic_load(&slot->enclave);
+            addr = oe_atomic_load(&slot->addr);
+            size = oe_atomic_load(&slot->size);
 
-            for (uint32_t i = 0; i < OE_COUNTOF(enclave->bindings); i++)
-            {
-                if (enclave->bindings[i].tcs == (uint64_t)tcs)
-                {
-                    ret = enclave;
-                    break;
-                }
-            }
+            if (oe_atomic_load(&slot->sequence) != sequence)
+                continue;
 
-            oe_mutex_unlock(&enclave->lock);
-        }
-    }
+            if (enclave && (uint64_t)tcs >= addr && (uint64_t)tcs - addr < size)
+                ret = (oe_enclave_t*)enclave;
 
-cleanup:
-    if (locked)
-    {
-        // Release the lock if it is taken.
-        if (oe_mutex_unlock(&oe_enclave_list_lock) != 0)
-        {
-            OE_TRACE_ERROR("oe_mutex_unlock failed\n");
-            abort();
-        }
+            break;
+        } while (true);
     }
 
     if (!ret)
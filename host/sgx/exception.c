@@ -34,8 +34,15 @@ uint64_t oe_host_handle_exception(oe_host_exception_context_t* context)
             abort();
         }
 
-        // Call-in enclave to handle the exception.
-        oe_enclave_t* enclave = oe_query_enclave_instance((void*)tcs_address);
+        // Call-in enclave to handle the exception. The thread binding
+        // normally identifies the enclave already; fall back to the registry
+        // otherwise.
+        oe_enclave_t* enclave = NULL;
+        if (thread_data->tcs == tcs_address)
+            enclave = thread_data->enclave;
+        else
+            enclave = oe_query_enclave_instance((void*)tcs_address);
+
         if (enclave == NULL)
         {
             abort();
@@ -645,6 +645,94 @@ done:
     return result;
 }
 
+static int _compare_relocs(const void* lhs, const void* rhs)
+{
+    const elf64_rela_t* a = (const elf64_rela_t*)lhs;
+    const elf64_rela_t* b = (const elf64_rela_t*)rhs;
+
+    if (a->r_offset < b->r_offset)
+        return -1;
+
+    return a->r_offset > b->r_offset;
+}
+
+/*
+**==============================================================================
+**
+** _prerelocate()
+**
+**     Apply the relocations that do not depend on the enclave base address
+**     to the image before it is measured:
+**
+**         (1) Each R_X86_64_TPOFF64 relocation sets a tpoff variable to the
+**             offset of a thread-local variable from the FS register, which
+**             depends only on the sizes and alignments of .tdata and .tbss
+**             (see enclave/core/sgx/linux/threadlocal.c).
+**
+**         (2) The remaining R_X86_64_RELATIVE relocations are compacted and
+**             sorted by offset, so that oe_apply_relocations() touches the
+**             image in address order on the first ecall.
+**
+**     R_X86_64_RELATIVE relocations cannot be applied here since MRENCLAVE
+**     must not depend on where the host happens to load the enclave.
+**
+**==============================================================================
+*/
+
+static oe_result_t _prerelocate(oe_enclave_image_t* image)
+{
+    oe_result_t result = OE_UNEXPECTED;
+    elf64_rela_t* relocs = (elf64_rela_t*)image->u.elf.reloc_data;
+    size_t nrelocs = image->reloc_size / sizeof(elf64_rela_t);
+    uint64_t tdata_align = image->tdata_size ? image->tdata_align : 1;
+    uint64_t tbss_align = image->tbss_size ? image->tbss_align : 1;
+    uint64_t alignment;
+    uint64_t tls_size;
+    size_t n = 0;
+
+    if (!tdata_align || !tbss_align)
+        OE_RAISE(OE_UNSUPPORTED_ENCLAVE_IMAGE);
+
+    /* Same layout as _get_thread_local_data_start() in the enclave */
+    alignment = tdata_align >= tbss_align ? tdata_align : tbss_align;
+    tls_size = oe_round_up_to_multiple(image->tdata_size, alignment) +
+               oe_round_up_to_multiple(image->tbss_size, alignment);
+
+    for (size_t i = 0; i < nrelocs; i++)
+    {
+        const elf64_rela_t* p = &relocs[i];
+
+        /* If zero-padded bytes reached */
+        if (p->r_offset == 0)
+            break;
+
+        if (ELF64_R_TYPE(p->r_info) == R_X86_64_TPOFF64)
+        {
+            int64_t* tpoff;
+
+            if (!tls_size || p->r_offset > image->image_size - sizeof(*tpoff))
+                OE_RAISE(OE_UNSUPPORTED_ENCLAVE_IMAGE);
+
+            /* tpoff = tls-start + sh-value - FS */
+            tpoff = (int64_t*)(image->image_base + p->r_offset);
+            *tpoff = p->r_addend - (int64_t)tls_size;
+            continue;
+        }
+
+        relocs[n++] = *p;
+    }
+
+    /* Zero-fill the entries vacated by the thread-local relocations */
+    memset(&relocs[n], 0, (nrelocs - n) * sizeof(elf64_rela_t));
+
+    qsort(relocs, n, sizeof(elf64_rela_t), _compare_relocs);
+
+    result = OE_OK;
+
+done:
+    return result;
+}
+
 static oe_result_t _patch(oe_enclave_image_t* image, size_t enclave_end)
 {
     oe_result_t result = OE_UNEXPECTED;
@@ -719,6 +807,9 @@ static oe_result_t _patch(oe_enclave_image_t* image, size_t enclave_end)
         OE_RAISE(OE_FAILURE);
     }
 
+    if (oeprops->config.flags & OE_SGX_CONFIG_FLAGS_PRERELOCATE)
+        OE_CHECK(_prerelocate(image));
+
     /* Clear the hash when taking the measure */
     memset(oeprops->sigstruct, 0, sizeof(oeprops->sigstruct));
 
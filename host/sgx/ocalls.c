@@ -3,6 +3,7 @@
 
 #include <assert.h>
 #include <stdio.h>
+#include <string.h>
 
 #if defined(__linux__)
 #include <linux/futex.h>
@@ -26,11 +27,14 @@
 #include <openenclave/internal/thread.h>
 #include <openenclave/internal/trace.h>
 #include <openenclave/internal/utils.h>
+#include "../dupenv.h"
+#include "../fopen.h"
 #include "../ocalls.h"
 #include "enclave.h"
 #include "ocalls.h"
 #include "quote.h"
 #include "sgx_u.h"
+#include "sgxload.h"
 #include "sgxquoteprovider.h"
 
 void HandleThreadWait(oe_enclave_t* enclave, uint64_t arg_in)
@@ -98,6 +102,22 @@ void oe_sgx_thread_wake_wait_ocall(
     HandleThreadWait(enclave, self_tcs);
 }
 
+oe_result_t oe_sgx_commit_pages_ocall(
+    oe_enclave_t* enclave,
+    uint64_t addr,
+    uint64_t size)
+{
+    return oe_sgx_commit_enclave_pages(enclave, addr, size);
+}
+
+oe_result_t oe_sgx_trim_pages_ocall(
+    oe_enclave_t* enclave,
+    uint64_t addr,
+    uint64_t size)
+{
+    return oe_sgx_trim_enclave_pages(enclave, addr, size);
+}
+
 oe_result_t oe_get_quote_ocall(
     const sgx_report_t* sgx_report,
     void* quote,
@@ -145,6 +165,7 @@ done:
 
 oe_result_t oe_get_quote_verification_collateral_ocall(
     uint8_t fmspc[6],
+    const char* ca,
     void* tcb_info,
     size_t tcb_info_size,
     size_t* tcb_info_size_out,
@@ -171,9 +192,14 @@ oe_result_t oe_get_quote_verification_collateral_ocall(
     oe_get_sgx_quote_verification_collateral_args_t args = {0};
     bool buffer_too_small = false;
 
-    /* fmspc */
+    /* fmspc and ca */
     memcpy(args.fmspc, fmspc, sizeof(args.fmspc));
 
+    if (!ca || strlen(ca) >= sizeof(args.ca))
+        OE_RAISE(OE_INVALID_PARAMETER);
+
+    memcpy(args.ca, ca, strlen(ca) + 1);
+
     /* Populate the output fields. */
     OE_CHECK(oe_get_sgx_quote_verification_collateral(&args));
 
@@ -249,6 +275,7 @@ done:
 
 oe_result_t oe_get_quote_verification_collateral_ocall(
     uint8_t fmspc[6],
+    const char* ca,
     void* tcb_info,
     size_t tcb_info_size,
     size_t* tcb_info_size_out,
@@ -272,6 +299,7 @@ oe_result_t oe_get_quote_verification_collateral_ocall(
     size_t* qe_identity_issuer_chain_size_out)
 {
     OE_UNUSED(fmspc);
+    OE_UNUSED(ca);
     OE_UNUSED(tcb_info);
     OE_UNUSED(tcb_info_size);
     OE_UNUSED(tcb_info_size_out);
@@ -299,9 +327,21 @@ oe_result_t oe_get_quote_verification_collateral_ocall(
 
 #endif /* !defined(OE_LINK_SGX_DCAP_QL) */
 
-oe_result_t oe_get_qetarget_info_ocall(sgx_target_info_t* target_info)
+oe_result_t oe_get_qetarget_info_ocall(
+    sgx_target_info_t* target_info,
+    size_t* quote_size)
 {
-    return sgx_get_qetarget_info(target_info);
+    oe_result_t result = OE_UNEXPECTED;
+
+    /* Return the quote size along with the target info so that the enclave
+     * can size its report buffer without another round trip */
+    OE_CHECK(sgx_get_qetarget_info(target_info));
+    OE_CHECK(sgx_get_quote_size(quote_size));
+
+    result = OE_OK;
+
+done:
+    return result;
 }
 
 static char** _backtrace_symbols(
@@ -427,3 +467,73 @@ done:
 
     return result;
 }
+
+/* Whether name is a file name without any directory part */
+static bool _is_plain_file_name(const char* name)
+{
+    if (!*name || strcmp(name, ".") == 0 || strcmp(name, "..") == 0)
+        return false;
+
+    return strpbrk(name, "/\\:") == NULL;
+}
+
+oe_result_t oe_sgx_write_heap_profile_ocall(
+    oe_enclave_t* oe_enclave,
+    const char* name,
+    const void* profile,
+    size_t profile_size)
+{
+    oe_result_t result = OE_UNEXPECTED;
+    char* dir = NULL;
+    char* path = NULL;
+    size_t path_size;
+    FILE* file = NULL;
+
+    if (!oe_enclave || !name || (!profile && profile_size))
+        OE_RAISE(OE_INVALID_PARAMETER);
+
+    /* The enclave only names the file. It is written to the directory the
+     * host chose, or not at all. */
+    if (!_is_plain_file_name(name))
+        OE_RAISE_MSG(OE_INVALID_PARAMETER, "invalid profile name %s", name);
+
+    if (!(dir = oe_dupenv("OE_HEAP_PROFILE_DIR")) || !*dir)
+        OE_RAISE_MSG(OE_UNSUPPORTED, "OE_HEAP_PROFILE_DIR is not set", NULL);
+
+    path_size = strlen(dir) + strlen(name) + 2;
+
+    if (!(path = (char*)malloc(path_size)))
+        OE_RAISE(OE_OUT_OF_MEMORY);
+
+    snprintf(path, path_size, "%s/%s", dir, name);
+
+    if (oe_fopen(&file, path, "w") != 0)
+        OE_RAISE_MSG(OE_FAILURE, "cannot open %s", path);
+
+    if (fwrite(profile, 1, profile_size, file) != profile_size)
+        OE_RAISE(OE_FAILURE);
+
+    /* pprof maps the sampled addresses to the symbols of the enclave image
+     * through the mapping of its text segment. */
+    if (fprintf(
+            file,
+            "\nMAPPED_LIBRARIES:\n%016llx-%016llx r-xp 00000000 00:00 0 %s\n",
+            (unsigned long long)oe_enclave->addr,
+            (unsigned long long)(oe_enclave->addr + oe_enclave->size),
+            oe_enclave->path) < 0)
+    {
+        OE_RAISE(OE_FAILURE);
+    }
+
+    result = OE_OK;
+
+done:
+
+    if (file && fclose(file) != 0 && result == OE_OK)
+        result = OE_FAILURE;
+
+    free(path);
+    free(dir);
+
+    return result;
+}
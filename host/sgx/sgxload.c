@@ -707,6 +707,111 @@ done:
     return result;
 }
 
+#if !defined(OEHOSTMR)
+/* Whether the CPU supports the SGX2 instructions (EAUG, EACCEPT, ...) */
+/* Change the protection of a range of simulated enclave pages */
+static oe_result_t _protect_simulated_pages(
+    uint64_t addr,
+    uint64_t size,
+    bool accessible)
+{
+    oe_result_t result = OE_UNEXPECTED;
+
+#if defined(__linux__)
+    int prot = accessible ? (PROT_READ | PROT_WRITE) : PROT_NONE;
+
+    if (!accessible)
+    {
+        /* Release the backing store so that the pages read as zero when
+         * they are committed again. Failure is not fatal since the pages
+         * are made inaccessible below. */
+        madvise((void*)addr, size, MADV_REMOVE);
+    }
+
+    if (mprotect((void*)addr, size, prot) != 0)
+        OE_RAISE_MSG(
+            OE_FAILURE, "mprotect failed (addr=%#x, prot=%#x)", addr, prot);
+#elif defined(_WIN32)
+    if (accessible)
+    {
+        if (!VirtualAlloc((LPVOID)addr, size, MEM_COMMIT, PAGE_READWRITE))
+            OE_RAISE_MSG(
+                OE_FAILURE, "VirtualAlloc failed (addr=%#x)", addr);
+    }
+    else
+    {
+        if (!VirtualFree((LPVOID)addr, size, MEM_DECOMMIT))
+            OE_RAISE_MSG(
+                OE_FAILURE, "VirtualFree failed (addr=%#x)", addr);
+    }
+#endif
+
+    result = OE_OK;
+
+done:
+    return result;
+}
+#endif // OEHOSTMR
+
+oe_result_t oe_sgx_reserve_enclave_pages(
+    oe_sgx_load_context_t* context,
+    uint64_t base,
+    uint64_t addr,
+    size_t npages)
+{
+    oe_result_t result = OE_UNEXPECTED;
+    uint64_t size;
+
+    if (!context || !base || !addr || !npages)
+        OE_RAISE(OE_INVALID_PARAMETER);
+
+    if (context->state != OE_SGX_LOAD_STATE_ENCLAVE_CREATED)
+        OE_RAISE(OE_INVALID_PARAMETER);
+
+    /* addr must be page aligned */
+    if (addr % OE_PAGE_SIZE)
+        OE_RAISE(OE_INVALID_PARAMETER);
+
+    OE_CHECK(oe_safe_mul_u64(npages, OE_PAGE_SIZE, &size));
+
+    if (context->type == OE_SGX_LOAD_TYPE_MEASURE)
+    {
+        /* Reserved pages are never EADDed, so there is nothing to measure */
+        result = OE_OK;
+        goto done;
+    }
+#if !defined(OEHOSTMR)
+    else if (oe_sgx_is_simulation_load_context(context))
+    {
+        /* Verify that the range is within enclave boundaries */
+        if ((void*)addr < context->sim.addr ||
+            size > context->sim.size ||
+            (uint8_t*)addr >
+                (uint8_t*)context->sim.addr + context->sim.size - size)
+            OE_RAISE_MSG(
+                OE_FAILURE, "Pages are NOT within enclave boundaries", NULL);
+
+        /* Make the pages inaccessible until the enclave commits them */
+        OE_CHECK(_protect_simulated_pages(addr, size, false));
+    }
+    else
+    {
+        /* The platform library creates SGX1 enclaves and cannot add (EAUG)
+         * pages to them or trim them, so the enclave could never accept its
+         * heap pages */
+        OE_RAISE_MSG(
+            OE_UNSUPPORTED,
+            "Enclave dynamic heap is only supported in simulation mode",
+            NULL);
+    }
+#endif // OEHOSTMR
+
+    result = OE_OK;
+
+done:
+    return result;
+}
+
 oe_result_t oe_sgx_initialize_enclave(
     oe_sgx_load_context_t* context,
     uint64_t addr,
@@ -770,4 +875,66 @@ oe_result_t oe_sgx_delete_enclave(oe_enclave_t* enclave)
 done:
     return result;
 }
+
+static bool _is_enclave_range(
+    const oe_enclave_t* enclave,
+    uint64_t addr,
+    uint64_t size)
+{
+    uint64_t end;
+
+    if (addr % OE_PAGE_SIZE || size % OE_PAGE_SIZE || size == 0)
+        return false;
+
+    if (oe_safe_add_u64(addr, size, &end) != OE_OK)
+        return false;
+
+    return addr >= enclave->addr && end <= enclave->addr + enclave->size;
+}
+
+oe_result_t oe_sgx_commit_enclave_pages(
+    oe_enclave_t* enclave,
+    uint64_t addr,
+    uint64_t size)
+{
+    oe_result_t result = OE_UNEXPECTED;
+
+    if (!enclave || !_is_enclave_range(enclave, addr, size))
+        OE_RAISE(OE_INVALID_PARAMETER);
+
+    /* Enclaves with a dynamic heap are only created in simulation mode (see
+     * oe_sgx_reserve_enclave_pages()) */
+    if (!enclave->simulate)
+        OE_RAISE(OE_UNSUPPORTED);
+
+    OE_CHECK(_protect_simulated_pages(addr, size, true));
+
+    result = OE_OK;
+
+done:
+    return result;
+}
+
+oe_result_t oe_sgx_trim_enclave_pages(
+    oe_enclave_t* enclave,
+    uint64_t addr,
+    uint64_t size)
+{
+    oe_result_t result = OE_UNEXPECTED;
+
+    if (!enclave || !_is_enclave_range(enclave, addr, size))
+        OE_RAISE(OE_INVALID_PARAMETER);
+
+    /* Enclaves with a dynamic heap are only created in simulation mode (see
+     * oe_sgx_reserve_enclave_pages()) */
+    if (!enclave->simulate)
+        OE_RAISE(OE_UNSUPPORTED);
+
+    OE_CHECK(_protect_simulated_pages(addr, size, false));
+
+    result = OE_OK;
+
+done:
+    return result;
+}
 #endif // OEHOSTMR
@@ -37,6 +37,14 @@ oe_result_t oe_sgx_load_enclave_data(
     uint64_t flags,
     bool extend);
 
+/* Reserve enclave pages that are committed later by the enclave. Only
+ * supported in simulation mode. */
+oe_result_t oe_sgx_reserve_enclave_pages(
+    oe_sgx_load_context_t* context,
+    uint64_t base,
+    uint64_t addr,
+    size_t npages);
+
 oe_result_t oe_sgx_initialize_enclave(
     oe_sgx_load_context_t* context,
     uint64_t addr,
@@ -45,6 +53,18 @@ oe_result_t oe_sgx_initialize_enclave(
 
 oe_result_t oe_sgx_delete_enclave(oe_enclave_t* enclave);
 
+/* Make reserved enclave pages available to the enclave */
+oe_result_t oe_sgx_commit_enclave_pages(
+    oe_enclave_t* enclave,
+    uint64_t addr,
+    uint64_t size);
+
+/* Return committed enclave pages to the reserved state */
+oe_result_t oe_sgx_trim_enclave_pages(
+    oe_enclave_t* enclave,
+    uint64_t addr,
+    uint64_t size);
+
 OE_EXTERNC_END
 
 #endif /* _OE_SGXLOAD_H */
@@ -12,8 +12,8 @@
 #include "../hostthread.h"
 #include "sgxquoteprovider.h"
 
-// Define the name of CA
-static uint8_t CRL_CA_PROCESSOR[] = "processor";
+// Define the name of the CA used when the caller does not name one
+static char CRL_CA_PROCESSOR[] = "processor";
 
 /**
  * This file manages the dcap_quoteprov shared library.
@@ -66,6 +66,10 @@ oe_result_t oe_get_sgx_quote_verification_collateral(
 
     uint8_t* fmspc = args->fmspc;
     uint16_t fmspc_size = sizeof(args->fmspc);
+    char* ca = args->ca[0] ? args->ca : CRL_CA_PROCESSOR;
+
+    if (strnlen(args->ca, sizeof(args->ca)) == sizeof(args->ca))
+        OE_RAISE(OE_INVALID_PARAMETER);
 
     OE_CHECK(oe_initialize_quote_provider());
 
@@ -80,7 +84,7 @@ oe_result_t oe_get_sgx_quote_verification_collateral(
 
     // fetch collateral information
     r = provider.get_sgx_quote_verification_collateral(
-        fmspc, fmspc_size, (char*)CRL_CA_PROCESSOR, &collateral);
+        fmspc, fmspc_size, ca, &collateral);
     if (r != SGX_PLAT_ERROR_OK || collateral == NULL)
     {
         OE_RAISE(OE_QUOTE_PROVIDER_CALL_ERROR);
@@ -0,0 +1,163 @@
+// Copyright (c) Open Enclave SDK contributors.
+// Licensed under the MIT License.
+
+#include "startuptrace.h"
+#include <openenclave/internal/defs.h>
+#include <openenclave/internal/raise.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "../fopen.h"
+
+#if defined(__linux__)
+#include <time.h>
+#include <unistd.h>
+#define get_process_id() ((uint64_t)getpid())
+#elif defined(_WIN32)
+#include <windows.h>
+#define get_process_id() ((uint64_t)GetCurrentProcessId())
+#endif
+
+static const char* _phase_names[] = {
+    "load_image",
+    "ecreate",
+    "patch_image",
+    "add_image_pages",
+    "add_heap_pages",
+    "add_thread_pages",
+    "einit",
+    "initialize_enclave",
+    "call_init_functions",
+    "configure_enclave",
+    "oe_create_enclave",
+};
+
+OE_STATIC_ASSERT(OE_COUNTOF(_phase_names) == OE_STARTUP_PHASE_COUNT);
+
+uint64_t oe_startup_trace_now(void)
+{
+#if defined(__linux__)
+    struct timespec ts;
+
+    if (clock_gettime(CLOCK_MONOTONIC, &ts) != 0)
+        return 0;
+
+    return (uint64_t)ts.tv_sec * 1000000000UL + (uint64_t)ts.tv_nsec;
+#elif defined(_WIN32)
+    static LARGE_INTEGER frequency;
+    LARGE_INTEGER counter;
+
+    if (!frequency.QuadPart)
+        QueryPerformanceFrequency(&frequency);
+
+    QueryPerformanceCounter(&counter);
+
+    /* Split the conversion to avoid overflowing the multiplication */
+    return (uint64_t)(counter.QuadPart / frequency.QuadPart) * 1000000000UL +
+           (uint64_t)(counter.QuadPart % frequency.QuadPart) * 1000000000UL /
+               (uint64_t)frequency.QuadPart;
+#endif
+}
+
+oe_startup_trace_t* oe_startup_trace_create(void)
+{
+    oe_startup_trace_t* trace = calloc(1, sizeof(oe_startup_trace_t));
+
+    if (trace)
+        trace->origin = oe_startup_trace_now();
+
+    return trace;
+}
+
+void oe_startup_trace_free(oe_startup_trace_t* trace)
+{
+    free(trace);
+}
+
+void oe_startup_trace_record_span(
+    oe_startup_trace_t* trace,
+    oe_startup_phase_t phase,
+    uint64_t start,
+    uint64_t end,
+    uint64_t num_pages)
+{
+    oe_startup_phase_timing_t* timing;
+
+    if (!trace || phase >= OE_STARTUP_PHASE_COUNT ||
+        trace->num_phases == OE_STARTUP_PHASE_COUNT)
+        return;
+
+    /* Clamp rather than underflow if the clock is unavailable */
+    if (start < trace->origin)
+        start = trace->origin;
+
+    if (end < start)
+        end = start;
+
+    timing = &trace->phases[trace->num_phases++];
+    timing->phase = phase;
+    timing->name = _phase_names[phase];
+    timing->start_ns = start - trace->origin;
+    timing->duration_ns = end - start;
+    timing->num_pages = num_pages;
+}
+
+void oe_startup_trace_record(
+    oe_startup_trace_t* trace,
+    oe_startup_phase_t phase,
+    uint64_t start,
+    uint64_t num_pages)
+{
+    if (trace)
+        oe_startup_trace_record_span(
+            trace, phase, start, oe_startup_trace_now(), num_pages);
+}
+
+oe_result_t oe_startup_trace_write_chrome_json(
+    const oe_startup_trace_t* trace,
+    const char* path)
+{
+    oe_result_t result = OE_UNEXPECTED;
+    FILE* stream = NULL;
+    uint64_t pid = get_process_id();
+
+    if (!trace || !path)
+        OE_RAISE(OE_INVALID_PARAMETER);
+
+    if (oe_fopen(&stream, path, "w") != 0)
+        OE_RAISE_MSG(OE_FAILURE, "failed to open %s", path);
+
+    /* Complete ("X") events; timestamps are in microseconds */
+    fprintf(stream, "{\"traceEvents\":[");
+
+    for (size_t i = 0; i < trace->num_phases; i++)
+    {
+        const oe_startup_phase_timing_t* timing = &trace->phases[i];
+
+        fprintf(
+            stream,
+            "%s\n{\"name\":\"%s\",\"cat\":\"oe_startup\",\"ph\":\"X\","
+            "\"ts\":%llu.%03llu,\"dur\":%llu.%03llu,\"pid\":%llu,\"tid\":1,"
+            "\"args\":{\"pages\":%llu}}",
+            i ? "," : "",
+            timing->name,
+            (unsigned long long)(timing->start_ns / 1000),
+            (unsigned long long)(timing->start_ns % 1000),
+            (unsigned long long)(timing->duration_ns / 1000),
+            (unsigned long long)(timing->duration_ns % 1000),
+            (unsigned long long)pid,
+            (unsigned long long)timing->num_pages);
+    }
+
+    fprintf(stream, "\n],\"displayTimeUnit\":\"ms\"}\n");
+
+    if (ferror(stream))
+        OE_RAISE_MSG(OE_FAILURE, "failed to write %s", path);
+
+    result = OE_OK;
+
+done:
+    if (stream)
+        fclose(stream);
+
+    return result;
+}
@@ -0,0 +1,64 @@
+// Copyright (c) Open Enclave SDK contributors.
+// Licensed under the MIT License.
+
+#ifndef _OE_HOST_SGX_STARTUPTRACE_H
+#define _OE_HOST_SGX_STARTUPTRACE_H
+
+#include <openenclave/host.h>
+
+/*
+**==============================================================================
+**
+** oe_startup_trace_t:
+**
+**     Per-phase timings of oe_create_enclave(), recorded when the enclave is
+**     created with OE_ENCLAVE_SETTING_STARTUP_TRACE. All times are taken
+**     from a monotonic clock and are in nanoseconds.
+**
+**==============================================================================
+*/
+
+typedef struct _oe_startup_trace
+{
+    /* Time at which oe_create_enclave() started */
+    uint64_t origin;
+
+    /* Time at which the enclave requested the CPUID table during its first
+     * ecall, which separates the runtime initialization from the global
+     * constructors (zero if no such request was seen) */
+    uint64_t cpuid_time;
+
+    /* The completed phases, in order of completion */
+    oe_startup_phase_timing_t phases[OE_STARTUP_PHASE_COUNT];
+    size_t num_phases;
+} oe_startup_trace_t;
+
+/* Allocate a trace whose origin is the current time */
+oe_startup_trace_t* oe_startup_trace_create(void);
+
+void oe_startup_trace_free(oe_startup_trace_t* trace);
+
+/* Return the current monotonic time in nanoseconds */
+uint64_t oe_startup_trace_now(void);
+
+/* Record a phase that ran from 'start' to 'end' */
+void oe_startup_trace_record_span(
+    oe_startup_trace_t* trace,
+    oe_startup_phase_t phase,
+    uint64_t start,
+    uint64_t end,
+    uint64_t num_pages);
+
+/* Record a phase that started at 'start' and ends now */
+void oe_startup_trace_record(
+    oe_startup_trace_t* trace,
+    oe_startup_phase_t phase,
+    uint64_t start,
+    uint64_t num_pages);
+
+/* Write the trace to 'path' in the Chrome trace-event JSON format */
+oe_result_t oe_startup_trace_write_chrome_json(
+    const oe_startup_trace_t* trace,
+    const char* path);
+
+#endif /* _OE_HOST_SGX_STARTUPTRACE_H */
@@ -425,6 +425,66 @@ oe_result_t oe_verify_evidence(
  */
 oe_result_t oe_free_claims_list(oe_claim_t* claims, size_t claims_length);
 
+/**
+ * An item of a batch passed to oe_verify_evidence_batch().
+ */
+typedef struct _oe_evidence_batch_item
+{
+    /** [in] The evidence buffer. */
+    const uint8_t* evidence_buffer;
+
+    /** [in] The size of evidence_buffer in bytes. */
+    size_t evidence_buffer_size;
+
+    /** [in] The optional endorsements buffer. */
+    const uint8_t* endorsements_buffer;
+
+    /** [in] The size of endorsements_buffer in bytes. */
+    size_t endorsements_buffer_size;
+
+    /** [out] The result of oe_verify_evidence() for this item. */
+    oe_result_t result;
+
+    /** [out] The claims if result is OE_OK, to be freed with
+     * oe_free_claims_list(). NULL otherwise. */
+    oe_claim_t* claims;
+
+    /** [out] The length of the claims list. */
+    size_t claims_length;
+} oe_evidence_batch_item_t;
+
+/**
+ * oe_verify_evidence_batch
+ *
+ * Verifies a batch of attestation evidence in parallel. Each item is
+ * verified as if by oe_verify_evidence() with the given policies, and the
+ * result and claims are stored in the item. This function is only available
+ * on the host.
+ *
+ * The items are distributed over a pool of worker threads that lives for the
+ * duration of the call; the calling thread is one of the workers. Quotes from
+ * the same platform share their verification collateral and issuer
+ * certificate chains, which are fetched and verified once.
+ *
+ * Verifiers must not be registered or unregistered while this function runs.
+ *
+ * @param[in,out] items The items to verify.
+ * @param[in] items_count The number of items.
+ * @param[in] policies An optional list of policies applied to every item.
+ * @param[in] policies_size The size of the policy list.
+ * @param[in] max_threads The maximum number of threads to verify with, or 0
+ * to use one thread per processor.
+ * @retval OE_OK All items were processed. The result of each item is in its
+ * **result** field.
+ * @retval OE_INVALID_PARAMETER At least one of the parameters is invalid.
+ */
+oe_result_t oe_verify_evidence_batch(
+    oe_evidence_batch_item_t* items,
+    size_t items_count,
+    const oe_policy_t* policies,
+    size_t policies_size,
+    size_t max_threads);
+
 OE_EXTERNC_END
 
 #endif /* _OE_ATTESTATION_PLUGIN_H */
@@ -0,0 +1,67 @@
+// Copyright (c) Open Enclave SDK contributors.
+// Licensed under the MIT License.
+
+/**
+ * @file heapstats.h
+ *
+ * This file defines the enclave heap statistics that the host can read with
+ * **oe_get_enclave_heap_stats**.
+ *
+ */
+#ifndef _OE_BITS_HEAPSTATS_H
+#define _OE_BITS_HEAPSTATS_H
+
+#include <openenclave/bits/defs.h>
+#include <openenclave/bits/types.h>
+
+OE_EXTERNC_BEGIN
+
+/**
+ * The number of allocation size classes in **oe_enclave_heap_stats_t**.
+ */
+#define OE_HEAP_STATS_NUM_SIZE_CLASSES 16
+
+/**
+ * Statistics of the heap of an enclave.
+ *
+ * The allocation counters are kept by the default allocator (dlmalloc, with
+ * or without the debug allocator on top) and stay zero in enclaves that use
+ * snmalloc. Blocks are classified by their usable size: class 0 holds the
+ * blocks of up to 16 bytes, class i the blocks of up to 16 << i bytes and the
+ * last class all larger blocks.
+ *
+ * The counters are updated without locks, so a snapshot taken while other
+ * threads allocate may be slightly inconsistent.
+ */
+typedef struct _oe_enclave_heap_stats
+{
+    /** The size of the heap in bytes, from its base to __oe_get_heap_end() */
+    uint64_t heap_size;
+
+    /** The bytes of the heap that the allocator obtained through sbrk */
+    uint64_t heap_used_bytes;
+
+    /** The high-water mark of **heap_used_bytes** */
+    uint64_t heap_peak_used_bytes;
+
+    /** The bytes of the heap that are committed. This is **heap_size**
+     * unless the enclave has a dynamic heap */
+    uint64_t heap_committed_bytes;
+
+    /** The number of times the allocator grew the heap through sbrk */
+    uint64_t heap_grow_count;
+
+    /** The usable bytes of the blocks that are allocated. Together with
+     * **heap_used_bytes** it tells how fragmented the heap is */
+    uint64_t in_use_bytes;
+
+    /** The number of allocations per size class */
+    uint64_t alloc_count[OE_HEAP_STATS_NUM_SIZE_CLASSES];
+
+    /** The number of frees per size class */
+    uint64_t free_count[OE_HEAP_STATS_NUM_SIZE_CLASSES];
+} oe_enclave_heap_stats_t;
+
+OE_EXTERNC_END
+
+#endif /* _OE_BITS_HEAPSTATS_H */
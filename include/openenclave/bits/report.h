@@ -182,7 +182,6 @@ extern const char* OE_OPTIONAL_CLAIMS[OE_OPTIONAL_CLAIMS_COUNT];
 
 /**
  * Supported policies for validation by the verifier attestation plugin.
- * Only time is supported for now.
  */
 typedef enum _oe_policy_type
 {
@@ -192,7 +191,18 @@ typedef enum _oe_policy_type
      *
      * The policy will be in the form of `oe_datetime_t`.
      */
-    OE_POLICY_ENDORSEMENTS_TIME = 1
+    OE_POLICY_ENDORSEMENTS_TIME = 1,
+
+    /**
+     * Requests that the claims list is returned as a single allocation
+     * rather than one allocation per claim name and value. The names of the
+     * known claims then point at constant strings and must not be modified.
+     * The list is still freed with oe_free_claims_list().
+     *
+     * The policy has no data: `policy` is NULL and `policy_size` is 0.
+     * Verifiers that do not support it ignore it.
+     */
+    OE_POLICY_CONTIGUOUS_CLAIMS = 2
 } oe_policy_type_t;
 
 /**
@@ -205,6 +215,19 @@ typedef struct _oe_policy
     size_t policy_size;
 } oe_policy_t;
 
+/**
+ * Counters of the verification result cache, see
+ * oe_set_verification_result_cache_size().
+ */
+typedef struct _oe_verification_result_cache_stats
+{
+    /** Number of verifications answered from the cache */
+    uint64_t hits;
+
+    /** Number of verifications that were not in the cache */
+    uint64_t misses;
+} oe_verification_result_cache_stats_t;
+
 OE_EXTERNC_END
 
 #endif /* _OE_BITS_REPORT_H */
@@ -26,20 +26,53 @@ typedef struct _oe_sgx_enclave_image_info_t
 } oe_sgx_enclave_image_info_t;
 
 /* Max number of threads in an enclave supported */
-#define OE_SGX_MAX_TCS 32
+#define OE_SGX_MAX_TCS 256
+
+/* Max number of additional thread classes (oe_sgx_enclave_properties_t) */
+#define OE_SGX_MAX_TCS_CLASSES 4
+
+/* Threads added after the header.size_settings.num_tcs threads, each with a
+ * stack of num_stack_pages pages */
+typedef struct _oe_sgx_tcs_class
+{
+    uint32_t num_tcs;
+    uint32_t num_stack_pages;
+} oe_sgx_tcs_class_t;
 
 // oe_sgx_enclave_properties_t SGX enclave properties derived type
 #define OE_SGX_FLAGS_DEBUG 0x0000000000000002ULL
 #define OE_SGX_FLAGS_MODE64BIT 0x0000000000000004ULL
 #define OE_SGX_SIGSTRUCT_SIZE 1808
 
+/* oe_sgx_enclave_config_t.flags */
+
+/* Reserve the heap at creation time and commit its pages on demand. Only
+ * supported in simulation mode: enclaves with this flag cannot be created
+ * on hardware (OE_UNSUPPORTED). */
+#define OE_SGX_CONFIG_FLAGS_DYNAMIC_HEAP 0x00000001U
+
+/* Resolve thread-local relocations when the image is measured and leave only
+ * sorted base-relative relocations for the enclave to apply */
+#define OE_SGX_CONFIG_FLAGS_PRERELOCATE 0x00000002U
+
+/* Add stack pages zero-filled and without measuring their contents instead
+ * of filling them with the 0xcccccccc pattern used to gauge stack usage when
+ * debugging. This makes enclave creation faster.
+ *
+ * Because the pages are not measured, MRENCLAVE does not cover their initial
+ * contents and the host decides what they hold when the enclave starts, as it
+ * already does for the heap. Only set this flag for enclaves that never read
+ * stack memory before writing it; in particular, code that reads
+ * uninitialized locals may then observe host-chosen values. */
+#define OE_SGX_CONFIG_FLAGS_NO_STACK_FILL 0x00000004U
+
 typedef struct oe_sgx_enclave_config_t
 {
     uint16_t product_id;
     uint16_t security_version;
 
-    /* Padding to make packed and unpacked size the same */
-    uint32_t padding;
+    /* (OE_SGX_CONFIG_FLAGS_*). Also keeps packed and unpacked size the same */
+    uint32_t flags;
 
     /* (OE_SGX_FLAGS_DEBUG | OE_SGX_FLAGS_MODE64BIT) */
     uint64_t attributes;
@@ -57,13 +90,17 @@ typedef struct _oe_sgx_enclave_properties
     /* (32) */
     oe_sgx_enclave_config_t config;
 
-    /* (48) */
+    /* (56) */
     oe_sgx_enclave_image_info_t image_info;
 
-    /* (96)  */
+    /* (104)  */
     uint8_t sigstruct[OE_SGX_SIGSTRUCT_SIZE];
 
-    /* (1904) end-marker to make sure 0-filled signstruct doesn't get omitted */
+    /* (1912) Additional threads with their own stack sizes (zero-filled
+     * entries are unused) */
+    oe_sgx_tcs_class_t tcs_classes[OE_SGX_MAX_TCS_CLASSES];
+
+    /* (1944) end-marker to make sure 0-filled signstruct doesn't get omitted */
     uint64_t end_marker;
 } oe_sgx_enclave_properties_t;
 
@@ -123,7 +160,7 @@ typedef struct _oe_sgx_enclave_properties
         {                                                                 \
             .product_id = PRODUCT_ID,                                     \
             .security_version = SECURITY_VERSION,                         \
-            .padding = 0,                                                 \
+            .flags = 0,                                                   \
             .attributes = OE_MAKE_ATTRIBUTES(ALLOW_DEBUG)                 \
         },                                                                \
         .image_info =                                                     \
@@ -134,6 +171,10 @@ typedef struct _oe_sgx_enclave_properties
         {                                                                 \
             0                                                             \
         },                                                                \
+        .tcs_classes =                                                    \
+        {                                                                 \
+            {0, 0}                                                        \
+        },                                                                \
         .end_marker = 0xecececececececec,                                 \
     };                                                                    \
     OE_INFO_SECTION_END
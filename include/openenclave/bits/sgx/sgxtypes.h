@@ -45,6 +45,12 @@ OE_EXTERNC_BEGIN
 #define SGX_SECINFO_SECS 0x0000000000000000000
 #define SGX_SECINFO_TCS 0x0000000000000000100
 #define SGX_SECINFO_REG 0x0000000000000000200
+#define SGX_SECINFO_TRIM 0x0000000000000000400
+
+/* SGX2 page states reported to and checked by EACCEPT */
+#define SGX_SECINFO_PENDING 0x0000000000000000008
+#define SGX_SECINFO_MODIFIED 0x0000000000000000010
+#define SGX_SECINFO_PR 0x0000000000000000020
 
 #define SGX_SE_EPID_SIG_RL_VERSION 0x200
 #define SGX_SE_EPID_SIG_RL_ID 0xE00
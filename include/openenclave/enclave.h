@@ -546,6 +546,28 @@ void oe_free_key(
     uint8_t* key_info,
     size_t key_info_size);
 
+/**
+ * Enable, resize or disable the cache of derived asymmetric keys.
+ *
+ * oe_get_public_key_by_policy(), oe_get_private_key_by_policy(),
+ * oe_get_public_key() and oe_get_private_key() derive the key from the seal
+ * key on every call. With the cache enabled, the derived key pairs are kept
+ * inside the enclave, keyed by the seal policy or key info and the key
+ * parameters, and requesting a key again only writes it to **key_buffer**.
+ * The keys of a seal policy are those of the CPU and ISV SVNs when the key
+ * was first derived, until the cache is resized. Evicted keys are zeroed, as
+ * are all cached keys when the cache is resized or the enclave terminates.
+ * The cache is disabled by default.
+ *
+ * @param[in] max_entries The maximum number of cached key pairs, at most 64.
+ * Zero disables the cache.
+ *
+ * @retval OE_OK The cache size was set.
+ * @retval OE_INVALID_PARAMETER **max_entries** is too large.
+ * @retval OE_OUT_OF_MEMORY Failed to allocate the cache.
+ */
+oe_result_t oe_set_asymmetric_key_cache_size(size_t max_entries);
+
 /**
  * Get a symmetric encryption key from the enclave platform using existing key
  * information.
@@ -579,6 +601,223 @@ oe_result_t oe_get_seal_key_v2(
  */
 void oe_free_seal_key(uint8_t* key_buffer, uint8_t* key_info);
 
+/**
+ * The size of the header of sealed data, which holds the key information and
+ * the IV or salt needed to unseal it.
+ */
+#define OE_SEAL_HEADER_SIZE 536
+
+/**
+ * The size of the authentication tag of sealed data.
+ */
+#define OE_SEAL_TAG_SIZE 16
+
+/**
+ * The size of the data that **oe_seal()** makes of **SIZE** bytes.
+ */
+#define OE_SEALED_SIZE(SIZE) (OE_SEAL_HEADER_SIZE + (SIZE) + OE_SEAL_TAG_SIZE)
+
+/**
+ * Seal data to the enclave.
+ *
+ * The data is encrypted and authenticated with AES-128-GCM under the seal key
+ * of the given policy. The seal key is derived once per policy and kept for
+ * the lifetime of the enclave, so sealing costs no EGETKEY. Every call uses
+ * a new random IV.
+ *
+ * @param[in] seal_policy The policy for the identity properties used to derive
+ * the seal key.
+ * @param[in] plaintext The data to seal.
+ * @param[in] plaintext_size The size of **plaintext** in bytes.
+ * @param[in] additional_data Optional data that is authenticated but not
+ * encrypted. The same data must be passed to **oe_unseal()**.
+ * @param[in] additional_data_size The size of **additional_data** in bytes.
+ * @param[out] blob The buffer where the sealed data is written to.
+ * @param[in,out] blob_size On input, the size of **blob**. On output, the
+ * size of the sealed data, OE_SEALED_SIZE(**plaintext_size**).
+ *
+ * @retval OE_OK The data was sealed.
+ * @retval OE_BUFFER_TOO_SMALL **blob** is NULL or smaller than
+ * **blob_size** on output.
+ * @retval OE_INVALID_PARAMETER At least one parameter is invalid.
+ * @retval OE_UNSUPPORTED Sealing is not supported on this platform.
+ */
+oe_result_t oe_seal(
+    oe_seal_policy_t seal_policy,
+    const uint8_t* plaintext,
+    size_t plaintext_size,
+    const uint8_t* additional_data,
+    size_t additional_data_size,
+    uint8_t* blob,
+    size_t* blob_size);
+
+/**
+ * Unseal data sealed by **oe_seal()**.
+ *
+ * The seal keys of the key information of data that was unsealed are kept
+ * as well, up to a small number of them, replacing the least recently used
+ * ones. The seal keys used by **oe_seal()** are never replaced.
+ *
+ * @param[in] blob The sealed data.
+ * @param[in] blob_size The size of **blob** in bytes.
+ * @param[in] additional_data The additional data passed to **oe_seal()**.
+ * @param[in] additional_data_size The size of **additional_data** in bytes.
+ * @param[out] plaintext The buffer where the unsealed data is written to.
+ * @param[in,out] plaintext_size On input, the size of **plaintext**. On
+ * output, the size of the unsealed data.
+ *
+ * @retval OE_OK The data was unsealed.
+ * @retval OE_BUFFER_TOO_SMALL **plaintext** is NULL or smaller than
+ * **plaintext_size** on output.
+ * @retval OE_CRYPTO_ERROR The data or the additional data was modified, or
+ * was sealed by another enclave.
+ * @retval OE_INVALID_PARAMETER At least one parameter is invalid.
+ * @retval OE_INVALID_CPUSVN The key information has an invalid CPUSVN.
+ * @retval OE_INVALID_ISVSVN The key information has an invalid ISVSVN.
+ * @retval OE_UNSUPPORTED Sealing is not supported on this platform.
+ */
+oe_result_t oe_unseal(
+    const uint8_t* blob,
+    size_t blob_size,
+    const uint8_t* additional_data,
+    size_t additional_data_size,
+    uint8_t* plaintext,
+    size_t* plaintext_size);
+
+/**
+ * A stream of sealed chunks, for sealing data too large to hold at once or
+ * sealing parts of large data on several threads.
+ *
+ * Every stream has a key of its own, derived from the seal key, a random
+ * salt and the additional data. The chunks of a stream are numbered in the
+ * order they are sealed, and a chunk unseals only with the number, and the
+ * marking as last chunk, it was sealed with. A reader therefore detects
+ * chunks that were reordered, dropped or appended, as long as it expects the
+ * chunks it reads in order and expects the last one to be marked. The
+ * chunks may have any size.
+ */
+typedef struct _oe_seal_stream oe_seal_stream_t;
+
+/**
+ * Start a stream of sealed chunks.
+ *
+ * @param[in] seal_policy The policy for the identity properties used to derive
+ * the seal key.
+ * @param[in] additional_data Optional data that is authenticated by every
+ * chunk but not encrypted.
+ * @param[in] additional_data_size The size of **additional_data** in bytes.
+ * @param[out] header The buffer where the header of the stream is written to,
+ * which must be passed to **oe_unseal_stream_init()** to unseal the chunks.
+ * @param[in] header_size The size of **header**, at least
+ * OE_SEAL_HEADER_SIZE.
+ * @param[out] stream The stream, freed by **oe_seal_stream_free()**.
+ *
+ * @retval OE_OK The stream was started.
+ * @retval OE_INVALID_PARAMETER At least one parameter is invalid.
+ * @retval OE_OUT_OF_MEMORY Failed to allocate memory.
+ * @retval OE_UNSUPPORTED Sealing is not supported on this platform.
+ */
+oe_result_t oe_seal_stream_init(
+    oe_seal_policy_t seal_policy,
+    const uint8_t* additional_data,
+    size_t additional_data_size,
+    uint8_t* header,
+    size_t header_size,
+    oe_seal_stream_t** stream);
+
+/**
+ * Open a stream of sealed chunks for unsealing.
+ *
+ * @param[in] header The header written by **oe_seal_stream_init()**.
+ * @param[in] header_size The size of **header** in bytes.
+ * @param[in] additional_data The additional data of the stream.
+ * @param[in] additional_data_size The size of **additional_data** in bytes.
+ * @param[out] stream The stream, freed by **oe_seal_stream_free()**.
+ *
+ * @retval OE_OK The stream was opened.
+ * @retval OE_INVALID_PARAMETER At least one parameter is invalid.
+ * @retval OE_OUT_OF_MEMORY Failed to allocate memory.
+ * @retval OE_UNSUPPORTED Sealing is not supported on this platform.
+ */
+oe_result_t oe_unseal_stream_init(
+    const uint8_t* header,
+    size_t header_size,
+    const uint8_t* additional_data,
+    size_t additional_data_size,
+    oe_seal_stream_t** stream);
+
+/**
+ * Seal a chunk of a stream.
+ *
+ * The chunk is given the next number of the stream, starting at 0, which
+ * must be passed to **oe_unseal_stream_chunk()** to unseal it. Numbers are
+ * never reused, so several threads may seal chunks of the same stream at
+ * once. No chunk can be sealed after the last one.
+ *
+ * @param[in] stream The stream, started by **oe_seal_stream_init()**.
+ * @param[in] last Whether this is the last chunk of the stream.
+ * @param[in] plaintext The data of the chunk.
+ * @param[in] plaintext_size The size of **plaintext** in bytes.
+ * @param[out] chunk The buffer where the sealed chunk is written to.
+ * @param[in,out] chunk_size On input, the size of **chunk**. On output, the
+ * size of the sealed chunk, **plaintext_size** + OE_SEAL_TAG_SIZE.
+ * @param[out] index The number of the chunk.
+ *
+ * @retval OE_OK The chunk was sealed.
+ * @retval OE_BUFFER_TOO_SMALL **chunk** is NULL or smaller than
+ * **chunk_size** on output. No number is used.
+ * @retval OE_INVALID_PARAMETER At least one parameter is invalid, or
+ * **stream** was opened by **oe_unseal_stream_init()**.
+ * @retval OE_UNEXPECTED The last chunk of the stream was sealed, or all
+ * 2^32 numbers of the stream are used.
+ */
+oe_result_t oe_seal_stream_chunk(
+    oe_seal_stream_t* stream,
+    bool last,
+    const uint8_t* plaintext,
+    size_t plaintext_size,
+    uint8_t* chunk,
+    size_t* chunk_size,
+    uint32_t* index);
+
+/**
+ * Unseal a chunk of a stream.
+ *
+ * A stream is not modified by unsealing chunks, so several threads may
+ * unseal chunks of the same stream at once.
+ *
+ * @param[in] stream The stream.
+ * @param[in] index The number of the chunk.
+ * @param[in] last Whether this chunk is expected to be the last one.
+ * @param[in] chunk The sealed chunk.
+ * @param[in] chunk_size The size of **chunk** in bytes.
+ * @param[out] plaintext The buffer where the data of the chunk is written to.
+ * @param[in,out] plaintext_size On input, the size of **plaintext**. On
+ * output, the size of the data, **chunk_size** - OE_SEAL_TAG_SIZE.
+ *
+ * @retval OE_OK The chunk was unsealed.
+ * @retval OE_BUFFER_TOO_SMALL **plaintext** is NULL or smaller than
+ * **plaintext_size** on output.
+ * @retval OE_CRYPTO_ERROR The chunk was modified or was not sealed as chunk
+ * **index** of the stream, with the same **last**.
+ * @retval OE_INVALID_PARAMETER At least one parameter is invalid.
+ */
+oe_result_t oe_unseal_stream_chunk(
+    const oe_seal_stream_t* stream,
+    uint32_t index,
+    bool last,
+    const uint8_t* chunk,
+    size_t chunk_size,
+    uint8_t* plaintext,
+    size_t* plaintext_size);
+
+/**
+ * Free a stream of sealed chunks, wiping its key.
+ *
+ * @param[in] stream If not NULL, the stream to free.
+ */
+void oe_seal_stream_free(oe_seal_stream_t* stream);
+
 /**
  * Obtains the enclave handle.
  *
@@ -642,6 +881,102 @@ oe_result_t oe_generate_attestation_certificate(
  */
 void oe_free_attestation_certificate(uint8_t* cert);
 
+/**
+ * Settings of an attestation identity, see oe_attestation_identity_create().
+ */
+typedef struct _oe_attestation_identity_settings
+{
+    /**
+     * The X.509 distinguished name of the certificate, which is also its
+     * issuer name. Defaults to "CN=Open Enclave SDK,O=OESDK TLS,C=US" if
+     * NULL.
+     */
+    const unsigned char* subject_name;
+
+    /**
+     * The age in seconds after which oe_attestation_identity_refresh()
+     * generates a new key pair, quote and certificate. Zero disables
+     * rotation by age.
+     */
+    uint64_t rotation_interval;
+} oe_attestation_identity_settings_t;
+
+/**
+ * An attestation identity: an EC (secp256r1) key pair and the self-signed
+ * attestation certificate that embeds a quote for it, cached for reuse
+ * across TLS connections.
+ */
+typedef struct _oe_attestation_identity oe_attestation_identity_t;
+
+/**
+ * oe_attestation_identity_create
+ *
+ * Create an attestation identity. This generates a key pair and, like
+ * oe_generate_attestation_certificate(), a quote and the certificate.
+ *
+ * @param[in] settings Optional settings, see
+ * oe_attestation_identity_settings_t.
+ * @param[out] identity The new identity. Free it with
+ * oe_attestation_identity_free().
+ *
+ * @return OE_OK on success
+ */
+oe_result_t oe_attestation_identity_create(
+    const oe_attestation_identity_settings_t* settings,
+    oe_attestation_identity_t** identity);
+
+/**
+ * oe_attestation_identity_get
+ *
+ * Get copies of the current certificate (DER) and private key (PEM) of an
+ * attestation identity, for example to set up a TLS connection. This makes
+ * no ocalls and does not generate a quote.
+ *
+ * @param[in] identity The attestation identity.
+ * @param[out] cert The certificate. Free it with
+ * oe_free_attestation_certificate().
+ * @param[out] cert_size The size of **cert**.
+ * @param[out] private_key The private key. Free it with oe_free_key().
+ * @param[out] private_key_size The size of **private_key**.
+ *
+ * @return OE_OK on success
+ */
+oe_result_t oe_attestation_identity_get(
+    oe_attestation_identity_t* identity,
+    uint8_t** cert,
+    size_t* cert_size,
+    uint8_t** private_key,
+    size_t* private_key_size);
+
+/**
+ * oe_attestation_identity_refresh
+ *
+ * Generate a new key pair, quote and certificate for an attestation identity
+ * if **force** is true, if the identity is older than its rotation interval,
+ * or if the TCB of the platform changed (its CPU SVN differs from the one in
+ * the current quote). This gets the time from the host and takes a local
+ * report, and refreshes are serialized, so call it periodically, for example
+ * from an ecall that the host makes from a background thread, rather than
+ * before every connection. Connections set up concurrently keep using the
+ * current certificate until the new one is in place.
+ *
+ * @param[in] identity The attestation identity.
+ * @param[in] force Whether to regenerate unconditionally.
+ * @param[out] rotated Optional, set to whether the identity was regenerated.
+ *
+ * @return OE_OK on success
+ */
+oe_result_t oe_attestation_identity_refresh(
+    oe_attestation_identity_t* identity,
+    bool force,
+    bool* rotated);
+
+/**
+ * Free an attestation identity.
+ * @param[in] identity If not NULL, the identity to free.
+ */
+void oe_attestation_identity_free(oe_attestation_identity_t* identity);
+
 /**
  * identity validation callback type
  * @param[in] identity a pointer to an enclave's identity information
@@ -677,6 +1012,39 @@ oe_result_t oe_verify_attestation_certificate(
     oe_identity_verify_callback_t enclave_identity_callback,
     void* arg);
 
+/**
+ * oe_set_verification_result_cache_size
+ *
+ * Enable, resize or disable the cache of successful quote verifications.
+ *
+ * Peers usually present the same attestation certificate, and so the same
+ * quote, on every TLS handshake. With the cache enabled, verifying a quote
+ * again with the same endorsements (as oe_verify_attestation_certificate()
+ * and oe_verify_report() do) only looks up the earlier result. A result is
+ * reused only for validation times within the validity period of the quote's
+ * endorsements, and is dropped once that period has ended. The cache is
+ * disabled by default. Resizing it discards the cached results.
+ *
+ * @param[in] max_entries The maximum number of cached results, at most 4096.
+ * Zero disables the cache.
+ * @retval OE_OK The cache size was set.
+ * @retval OE_INVALID_PARAMETER **max_entries** is too large.
+ * @retval OE_OUT_OF_MEMORY Failed to allocate the cache.
+ */
+oe_result_t oe_set_verification_result_cache_size(size_t max_entries);
+
+/**
+ * oe_get_verification_result_cache_stats
+ *
+ * Get the hit and miss counters of the verification result cache.
+ *
+ * @param[out] stats The counters.
+ * @retval OE_OK The counters were returned.
+ * @retval OE_INVALID_PARAMETER **stats** is null.
+ */
+oe_result_t oe_get_verification_result_cache_stats(
+    oe_verification_result_cache_stats_t* stats);
+
 OE_EXTERNC_END
 
 #endif /* _OE_ENCLAVE_H */
@@ -22,6 +22,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include "bits/defs.h"
+#include "bits/heapstats.h"
 #include "bits/report.h"
 #include "bits/result.h"
 #include "bits/types.h"
@@ -90,6 +91,7 @@ typedef void (*oe_ocall_func_t)(
 typedef enum _oe_enclave_setting_type
 {
     OE_ENCLAVE_SETTING_CONTEXT_SWITCHLESS = 0xdc73a628,
+    OE_ENCLAVE_SETTING_STARTUP_TRACE = 0x5b3e91c4,
 } oe_enclave_setting_type_t;
 
 /**
@@ -110,6 +112,23 @@ typedef struct _oe_enclave_setting_context_switchless
     size_t max_enclave_workers;
 } oe_enclave_setting_context_switchless_t;
 
+/**
+ * The setting for recording a startup trace of **oe_create_enclave**.
+ *
+ * When this setting is present, the time spent in each phase of enclave
+ * creation is recorded and can be retrieved with
+ * **oe_get_enclave_startup_trace**.
+ */
+typedef struct _oe_enclave_setting_startup_trace
+{
+    /**
+     * If not NULL, the trace is also written to this file in the Chrome
+     * trace-event JSON format (viewable in chrome://tracing or Perfetto)
+     * once the enclave has been created.
+     */
+    const char* chrome_trace_path;
+} oe_enclave_setting_startup_trace_t;
+
 /**
  * The uniform structure type containing a specific type of enclave
  * setting.
@@ -127,6 +146,7 @@ typedef struct _oe_enclave_setting
     union {
         const oe_enclave_setting_context_switchless_t*
             context_switchless_setting;
+        const oe_enclave_setting_startup_trace_t* startup_trace_setting;
         /* Add new setting types here. */
     } u;
 } oe_enclave_setting_t;
@@ -189,6 +209,107 @@ oe_result_t oe_create_enclave(
  */
 oe_result_t oe_terminate_enclave(oe_enclave_t* enclave);
 
+/**
+ * Phases of enclave creation recorded by the startup trace, in the order in
+ * which they complete.
+ */
+typedef enum _oe_startup_phase
+{
+    /** Reading the enclave image file and its ELF segments */
+    OE_STARTUP_PHASE_LOAD_IMAGE,
+    /** Creating the enclave (ECREATE) */
+    OE_STARTUP_PHASE_ECREATE,
+    /** Patching the image (enclave layout, relocations) */
+    OE_STARTUP_PHASE_PATCH_IMAGE,
+    /** Adding and measuring the image pages (EADD/EEXTEND) */
+    OE_STARTUP_PHASE_ADD_IMAGE_PAGES,
+    /** Adding and measuring the heap pages */
+    OE_STARTUP_PHASE_ADD_HEAP_PAGES,
+    /** Adding and measuring the stack and thread control pages */
+    OE_STARTUP_PHASE_ADD_THREAD_PAGES,
+    /** Initializing the enclave (EINIT) */
+    OE_STARTUP_PHASE_EINIT,
+    /** First ecall up to the CPUID table request (relocations, TLS) */
+    OE_STARTUP_PHASE_INITIALIZE_ENCLAVE,
+    /** Remainder of the first ecall (global constructors) */
+    OE_STARTUP_PHASE_CALL_INIT_FUNCTIONS,
+    /** Applying the enclave settings (such as switchless workers) */
+    OE_STARTUP_PHASE_CONFIGURE_ENCLAVE,
+    /** The whole oe_create_enclave() call */
+    OE_STARTUP_PHASE_CREATE_ENCLAVE,
+    OE_STARTUP_PHASE_COUNT,
+    __OE_STARTUP_PHASE_MAX = OE_ENUM_MAX,
+} oe_startup_phase_t;
+
+/**
+ * The timing of one phase of enclave creation.
+ */
+typedef struct _oe_startup_phase_timing
+{
+    /** The phase */
+    oe_startup_phase_t phase;
+
+    /** A short, static name for the phase */
+    const char* name;
+
+    /** Start of the phase in nanoseconds since oe_create_enclave() began */
+    uint64_t start_ns;
+
+    /** Duration of the phase in nanoseconds */
+    uint64_t duration_ns;
+
+    /** Number of enclave pages laid out by the phase (including guard
+     * pages), or 0 for phases that do not lay out pages */
+    uint64_t num_pages;
+} oe_startup_phase_timing_t;
+
+/**
+ * Get the startup trace recorded while creating an enclave.
+ *
+ * The enclave must have been created with the
+ * OE_ENCLAVE_SETTING_STARTUP_TRACE setting. Phases are returned in the
+ * order in which they completed.
+ *
+ * @param[in] enclave The enclave instance.
+ * @param[out] timings The buffer that receives the phase timings. May be
+ * NULL if **count** is 0.
+ * @param[in,out] count On input, the number of elements in **timings**. On
+ * output, the number of recorded phases.
+ *
+ * @retval OE_OK The timings were copied into **timings**.
+ * @retval OE_INVALID_PARAMETER At least one parameter is invalid.
+ * @retval OE_BUFFER_TOO_SMALL **timings** is too small; **count** is set to
+ * the required number of elements.
+ * @retval OE_NOT_FOUND The enclave was created without a startup trace.
+ * @retval OE_UNSUPPORTED The enclave type does not support startup traces.
+ *
+ */
+oe_result_t oe_get_enclave_startup_trace(
+    oe_enclave_t* enclave,
+    oe_startup_phase_timing_t* timings,
+    size_t* count);
+
+/**
+ * Get the heap statistics of an enclave.
+ *
+ * The statistics are read through a builtin ecall that copies a snapshot of
+ * lock-free counters without marshalling, so they can be polled while the
+ * enclave runs. See **oe_enclave_heap_stats_t**.
+ *
+ * @param[in] enclave The enclave instance.
+ * @param[out] stats The heap statistics of the enclave.
+ *
+ * @retval OE_OK The statistics were copied into **stats**.
+ * @retval OE_INVALID_PARAMETER At least one parameter is invalid.
+ * @retval OE_NOT_FOUND The enclave was built with an SDK that does not keep
+ * heap statistics.
+ * @retval OE_UNSUPPORTED The enclave type does not support heap statistics.
+ *
+ */
+oe_result_t oe_get_enclave_heap_stats(
+    oe_enclave_t* enclave,
+    oe_enclave_heap_stats_t* stats);
+
 #if (OE_API_VERSION < 2)
 #error "Only OE_API_VERSION of 2 is supported"
 #else
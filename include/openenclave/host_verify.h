@@ -83,6 +83,39 @@ oe_result_t oe_verify_attestation_certificate(
     oe_identity_verify_callback_t enclave_identity_callback,
     void* arg);
 
+/**
+ * oe_set_verification_result_cache_size
+ *
+ * Enable, resize or disable the cache of successful quote verifications.
+ *
+ * Peers usually present the same attestation certificate, and so the same
+ * quote, on every TLS handshake. With the cache enabled, verifying a quote
+ * again with the same endorsements (as oe_verify_attestation_certificate()
+ * and oe_verify_report() do) only looks up the earlier result. A result is
+ * reused only for validation times within the validity period of the quote's
+ * endorsements, and is dropped once that period has ended. The cache is
+ * disabled by default. Resizing it discards the cached results.
+ *
+ * @param[in] max_entries The maximum number of cached results, at most 4096.
+ * Zero disables the cache.
+ * @retval OE_OK The cache size was set.
+ * @retval OE_INVALID_PARAMETER **max_entries** is too large.
+ * @retval OE_OUT_OF_MEMORY Failed to allocate the cache.
+ */
+oe_result_t oe_set_verification_result_cache_size(size_t max_entries);
+
+/**
+ * oe_get_verification_result_cache_stats
+ *
+ * Get the hit and miss counters of the verification result cache.
+ *
+ * @param[out] stats The counters.
+ * @retval OE_OK The counters were returned.
+ * @retval OE_INVALID_PARAMETER **stats** is null.
+ */
+oe_result_t oe_get_verification_result_cache_stats(
+    oe_verification_result_cache_stats_t* stats);
+
 OE_EXTERNC_END
 
 #endif
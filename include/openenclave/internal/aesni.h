@@ -0,0 +1,68 @@
+// Copyright (c) Open Enclave SDK contributors.
+// Licensed under the MIT License.
+
+#ifndef _OE_AESNI_H
+#define _OE_AESNI_H
+
+#include <openenclave/bits/defs.h>
+#include <openenclave/bits/types.h>
+
+OE_EXTERNC_BEGIN
+
+#define OE_AES_128_ROUNDS 10
+
+#if defined(__x86_64__) && defined(__GNUC__)
+
+/* An AES block or round key, as held in an XMM register */
+typedef long long oe_aesni_block_t __attribute__((vector_size(16)));
+
+typedef unsigned int oe_aesni_words_t __attribute__((vector_size(16)));
+
+/* Compute round key i + 1 from round key i, where assist is the
+ * AESKEYGENASSIST of round key i with the round constant of round i + 1 */
+OE_INLINE oe_aesni_block_t
+_oe_aesni_next_round_key(oe_aesni_block_t key, oe_aesni_block_t assist)
+{
+    oe_aesni_words_t k = (oe_aesni_words_t)key;
+    uint32_t t = ((oe_aesni_words_t)assist)[3];
+    uint32_t w0 = k[0] ^ t;
+    uint32_t w1 = k[1] ^ w0;
+    uint32_t w2 = k[2] ^ w1;
+    uint32_t w3 = k[3] ^ w2;
+
+    return (oe_aesni_block_t)(oe_aesni_words_t){w0, w1, w2, w3};
+}
+
+#define _OE_AESNI_EXPAND(I, RCON)                                 \
+    rk[I] = _oe_aesni_next_round_key(                         \
+        rk[I - 1], __builtin_ia32_aeskeygenassist128(rk[I - 1], RCON))
+
+/**
+ * Expand an AES-128 key into its round keys with AES-NI.
+ *
+ * The caller must have checked that the CPU supports AES-NI.
+ *
+ * @param rk The key in rk[0], followed by room for the round keys.
+ */
+__attribute__((target("aes"))) OE_INLINE void oe_aesni_expand_key_128(
+    oe_aesni_block_t rk[OE_AES_128_ROUNDS + 1])
+{
+    _OE_AESNI_EXPAND(1, 0x01);
+    _OE_AESNI_EXPAND(2, 0x02);
+    _OE_AESNI_EXPAND(3, 0x04);
+    _OE_AESNI_EXPAND(4, 0x08);
+    _OE_AESNI_EXPAND(5, 0x10);
+    _OE_AESNI_EXPAND(6, 0x20);
+    _OE_AESNI_EXPAND(7, 0x40);
+    _OE_AESNI_EXPAND(8, 0x80);
+    _OE_AESNI_EXPAND(9, 0x1b);
+    _OE_AESNI_EXPAND(10, 0x36);
+}
+
+#undef _OE_AESNI_EXPAND
+
+#endif /* defined(__x86_64__) && defined(__GNUC__) */
+
+OE_EXTERNC_END
+
+#endif /* _OE_AESNI_H */
@@ -126,6 +126,115 @@ oe_result_t oe_ec_private_key_free(oe_ec_private_key_t* private_key);
  */
 oe_result_t oe_ec_public_key_free(oe_ec_public_key_t* public_key);
 
+#ifdef OE_BUILD_ENCLAVE
+
+/**
+ * Shares a private EC key
+ *
+ * This function initializes a second handle of the given key without parsing
+ * or copying the key: both handles refer to the same key, which is released
+ * when the last handle is passed to oe_ec_private_key_free(). The handles
+ * may be used by several threads at once.
+ *
+ * @param private_key key to be shared
+ * @param shared new handle of the key upon return
+ *
+ * @return OE_OK upon success
+ * @return OE_INVALID_PARAMETER a parameter is invalid
+ */
+oe_result_t oe_ec_private_key_share(
+    const oe_ec_private_key_t* private_key,
+    oe_ec_private_key_t* shared);
+
+/**
+ * Shares a public EC key
+ *
+ * This function initializes a second handle of the given key without parsing
+ * or copying the key: both handles refer to the same key, which is released
+ * when the last handle is passed to oe_ec_public_key_free(). The handles
+ * may be used by several threads at once.
+ *
+ * @param public_key key to be shared
+ * @param shared new handle of the key upon return
+ *
+ * @return OE_OK upon success
+ * @return OE_INVALID_PARAMETER a parameter is invalid
+ */
+oe_result_t oe_ec_public_key_share(
+    const oe_ec_public_key_t* public_key,
+    oe_ec_public_key_t* shared);
+
+/**
+ * Digitally signs a batch of hashes with a private EC key
+ *
+ * This function signs hashes[i] into signatures[i] for i < count, as
+ * oe_ec_private_key_sign() would one at a time, but loads the curve, looks
+ * up the random number generator and inverts the nonces once for many
+ * signatures. The nonces are random, so, unlike those of
+ * oe_ec_private_key_sign(), the signatures differ from one call to the next.
+ *
+ * Several threads may sign batches with the same key at once, so a batch can
+ * be split between enclave threads.
+ *
+ * @param private_key EC private key of the signer
+ * @param hash_type type of the hashes
+ * @param hashes the hashes to be signed
+ * @param hash_size size of each hash in bytes
+ * @param signatures the signature buffers
+ * @param signature_sizes the sizes of the signature buffers upon entry, and
+ *        of the signatures upon return
+ * @param count the number of hashes
+ *
+ * @return OE_OK upon success
+ * @return OE_BUFFER_TOO_SMALL a signature buffer is too small, in which case
+ *         its size is set to the size required and the other signatures
+ *         are written
+ * @return OE_INVALID_PARAMETER a parameter is invalid
+ */
+oe_result_t oe_ec_private_key_sign_batch(
+    const oe_ec_private_key_t* private_key,
+    oe_hash_type_t hash_type,
+    const void* const* hashes,
+    size_t hash_size,
+    uint8_t* const* signatures,
+    size_t* signature_sizes,
+    size_t count);
+
+/**
+ * Verifies a batch of signatures made with a public EC key
+ *
+ * This function verifies that signatures[i] is a signature of hashes[i] for
+ * i < count, as oe_ec_public_key_verify() would one at a time, but parses
+ * the key and computes the inverses of P-256 signatures together. A batch of
+ * many signatures also caches the tables of the key.
+ *
+ * Several threads may verify batches with the same key at once, so a batch
+ * can be split between enclave threads.
+ *
+ * @param public_key EC public key of the signer
+ * @param hash_type type of the hashes
+ * @param hashes the hashes of the signed data
+ * @param hash_size size of each hash in bytes
+ * @param signatures the signatures
+ * @param signature_sizes the sizes of the signatures in bytes
+ * @param count the number of signatures
+ *
+ * @return OE_OK if all signatures are valid
+ * @return OE_VERIFY_FAILED if any signature is not valid, without telling
+ *         which: oe_ec_public_key_verify() tells whether one is
+ * @return OE_INVALID_PARAMETER a parameter is invalid
+ */
+oe_result_t oe_ec_public_key_verify_batch(
+    const oe_ec_public_key_t* public_key,
+    oe_hash_type_t hash_type,
+    const void* const* hashes,
+    size_t hash_size,
+    const uint8_t* const* signatures,
+    const size_t* signature_sizes,
+    size_t count);
+
+#endif
+
 /**
  * Verifies that a message was signed by an EC key
  *
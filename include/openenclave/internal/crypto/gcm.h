@@ -0,0 +1,97 @@
+// Copyright (c) Open Enclave SDK contributors.
+// Licensed under the MIT License.
+
+#ifndef _OE_GCM_H
+#define _OE_GCM_H
+
+#include <openenclave/bits/result.h>
+#include <openenclave/bits/types.h>
+
+OE_EXTERNC_BEGIN
+
+#define OE_GCM_IV_SIZE 12
+#define OE_GCM_TAG_SIZE 16
+
+/* Opaque representation of an expanded AES-128-GCM key */
+typedef struct _oe_aes_gcm_key
+{
+    /* Internal implementation */
+    OE_ALIGNED(16) uint64_t impl[42];
+} oe_aes_gcm_key_t;
+
+/**
+ * oe_aes_gcm_init_key expands an AES-GCM key. The expanded key is not
+ * modified by encryption and decryption, so several threads may use it at
+ * once. It should be wiped with oe_aes_gcm_free_key() after use.
+ *
+ * @param key The key.
+ * @param key_size The size of the key in bytes. Only 16 is supported.
+ * @param gcm_key Output parameter where the expanded key will be written to.
+ */
+oe_result_t oe_aes_gcm_init_key(
+    const uint8_t* key,
+    size_t key_size,
+    oe_aes_gcm_key_t* gcm_key);
+
+/**
+ * oe_aes_gcm_init_key_portable expands an AES-GCM key like
+ * oe_aes_gcm_init_key(), but the key is always used with mbedTLS, as on CPUs
+ * without AES-NI and PCLMULQDQ. It lets tests check that both
+ * implementations agree.
+ */
+oe_result_t oe_aes_gcm_init_key_portable(
+    const uint8_t* key,
+    size_t key_size,
+    oe_aes_gcm_key_t* gcm_key);
+
+/**
+ * oe_aes_gcm_free_key wipes an expanded AES-GCM key.
+ */
+void oe_aes_gcm_free_key(oe_aes_gcm_key_t* gcm_key);
+
+/**
+ * oe_aes_gcm_encrypt encrypts and authenticates a message with AES-GCM.
+ *
+ * @param gcm_key The expanded key.
+ * @param iv The OE_GCM_IV_SIZE-byte IV, which must never be reused with the
+ * same key.
+ * @param aad The additional data to authenticate, or NULL if aad_size is 0.
+ * @param aad_size The size of the additional data in bytes.
+ * @param input The plaintext.
+ * @param size The size of the plaintext in bytes.
+ * @param output Output parameter of size bytes where the ciphertext will be
+ * written to. It may be the same as input.
+ * @param tag Output parameter where the OE_GCM_TAG_SIZE-byte tag will be
+ * written to.
+ */
+oe_result_t oe_aes_gcm_encrypt(
+    const oe_aes_gcm_key_t* gcm_key,
+    const uint8_t* iv,
+    const uint8_t* aad,
+    size_t aad_size,
+    const uint8_t* input,
+    size_t size,
+    uint8_t* output,
+    uint8_t* tag);
+
+/**
+ * oe_aes_gcm_decrypt authenticates and decrypts a message encrypted with
+ * oe_aes_gcm_encrypt(). If the tag does not match, the output is wiped and
+ * OE_CRYPTO_ERROR is returned.
+ *
+ * The parameters are those of oe_aes_gcm_encrypt(), with input being the
+ * ciphertext and tag the expected tag.
+ */
+oe_result_t oe_aes_gcm_decrypt(
+    const oe_aes_gcm_key_t* gcm_key,
+    const uint8_t* iv,
+    const uint8_t* aad,
+    size_t aad_size,
+    const uint8_t* input,
+    size_t size,
+    uint8_t* output,
+    const uint8_t* tag);
+
+OE_EXTERNC_END
+
+#endif /* _OE_GCM_H */
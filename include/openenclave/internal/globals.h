@@ -5,6 +5,7 @@
 #define _OE_GLOBALS_H
 
 #include <openenclave/bits/defs.h>
+#include <openenclave/bits/result.h>
 #include <openenclave/bits/types.h>
 #include <openenclave/internal/types.h>
 
@@ -25,6 +26,11 @@ const void* __oe_get_heap_base(void);
 const void* __oe_get_heap_end(void);
 size_t __oe_get_heap_size(void);
 
+/* Dynamic heap: pages between the heap base and end are committed on demand */
+bool __oe_is_heap_dynamic(void);
+oe_result_t __oe_commit_heap_pages(const void* addr, size_t size);
+oe_result_t __oe_release_heap_pages(const void* addr, size_t size);
+
 /* The enclave handle passed by host during initialization */
 extern oe_enclave_t* oe_enclave;
 
@@ -37,6 +37,8 @@ typedef struct _oe_malloc_stats
  *     - the current system bytes allocated
  *     - the number of bytes in use
  *
+ * Blocks held in the per-thread allocation caches count as in use.
+ *
  * @param stats[output] the malloc statistics
  *
  * @return 0 success
@@ -44,6 +46,68 @@ typedef struct _oe_malloc_stats
  */
 oe_result_t oe_get_malloc_stats(oe_malloc_stats_t* stats);
 
+/**
+ * Enables or disables the per-thread allocation caches of the default
+ * allocator.
+ *
+ * Small blocks are allocated from and freed to a cache of the calling thread,
+ * so that most small allocations do not take the global lock of dlmalloc.
+ * The caches are enabled by default. Disabling them sends all later calls
+ * to dlmalloc; blocks that are already cached are returned to dlmalloc when
+ * the outermost ecall of their thread returns. Mainly for benchmarks.
+ *
+ * @param enabled Whether small blocks are cached.
+ *
+ * @return OE_OK success
+ * @return OE_UNSUPPORTED the enclave uses the debug allocator or snmalloc,
+ * which have no such cache to switch
+ */
+oe_result_t oe_set_malloc_thread_cache_enabled(bool enabled);
+
+/**
+ * Starts the sampling heap profiler.
+ *
+ * The profiler records the call stack of one allocation for every
+ * **sampling_rate** allocated bytes on average and keeps the samples of the
+ * blocks that are still in use, at a fraction of the cost of the debug
+ * allocator, which records every block. Samples of an earlier run are
+ * discarded.
+ *
+ * @param sampling_rate The mean number of bytes between samples, such as
+ * 512 KiB. Smaller rates give more precise profiles at a higher cost.
+ *
+ * @return OE_OK success
+ * @return OE_INVALID_PARAMETER **sampling_rate** is 0 or above 2^40
+ * @return OE_UNSUPPORTED the enclave uses snmalloc
+ */
+oe_result_t oe_heap_profiler_start(uint64_t sampling_rate);
+
+/**
+ * Stops the heap profiler and discards its samples.
+ */
+oe_result_t oe_heap_profiler_stop(void);
+
+/**
+ * Writes the samples of the blocks in use to a file on the host.
+ *
+ * The profile has the legacy pprof heap profile format (heap_v2) followed by
+ * the memory map of the enclave, so that it can be viewed with
+ * "pprof ENCLAVE_PATH PROFILE_PATH". pprof scales the samples to estimate the
+ * bytes in use per call stack.
+ *
+ * The host writes profiles only to the directory named by its
+ * OE_HEAP_PROFILE_DIR environment variable.
+ *
+ * @param name The name of the file in that directory, without any directory
+ * part.
+ *
+ * @return OE_OK success
+ * @return OE_UNEXPECTED the profiler is not running
+ * @return OE_INVALID_PARAMETER **name** is not a plain file name
+ * @return OE_UNSUPPORTED the host has not set OE_HEAP_PROFILE_DIR
+ */
+oe_result_t oe_heap_profiler_dump(const char* name);
+
 /* Dump the list of all in-use allocations */
 void oe_debug_malloc_dump(void);
 
@@ -160,6 +160,46 @@ oe_result_t oe_rsa_private_key_free(oe_rsa_private_key_t* private_key);
  */
 oe_result_t oe_rsa_public_key_free(oe_rsa_public_key_t* public_key);
 
+#ifdef OE_BUILD_ENCLAVE
+
+/**
+ * Shares a private RSA key
+ *
+ * This function initializes a second handle of the given key without parsing
+ * or copying the key: both handles refer to the same key, which is released
+ * when the last handle is passed to oe_rsa_private_key_free(). The handles
+ * may be used by several threads at once.
+ *
+ * @param private_key key to be shared
+ * @param shared new handle of the key upon return
+ *
+ * @return OE_OK upon success
+ * @return OE_INVALID_PARAMETER a parameter is invalid
+ */
+oe_result_t oe_rsa_private_key_share(
+    const oe_rsa_private_key_t* private_key,
+    oe_rsa_private_key_t* shared);
+
+/**
+ * Shares a public RSA key
+ *
+ * This function initializes a second handle of the given key without parsing
+ * or copying the key: both handles refer to the same key, which is released
+ * when the last handle is passed to oe_rsa_public_key_free(). The handles
+ * may be used by several threads at once.
+ *
+ * @param public_key key to be shared
+ * @param shared new handle of the key upon return
+ *
+ * @return OE_OK upon success
+ * @return OE_INVALID_PARAMETER a parameter is invalid
+ */
+oe_result_t oe_rsa_public_key_share(
+    const oe_rsa_public_key_t* public_key,
+    oe_rsa_public_key_t* shared);
+
+#endif
+
 /**
  * Digitally signs a message with a private RSA key
  *
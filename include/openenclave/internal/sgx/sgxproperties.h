@@ -42,4 +42,43 @@ OE_INLINE bool oe_sgx_is_valid_attributes(uint64_t x)
     return true;
 }
 
+OE_INLINE bool oe_sgx_is_valid_config_flags(uint32_t x)
+{
+    const uint32_t valid = OE_SGX_CONFIG_FLAGS_DYNAMIC_HEAP |
+                           OE_SGX_CONFIG_FLAGS_PRERELOCATE |
+                           OE_SGX_CONFIG_FLAGS_NO_STACK_FILL;
+
+    /* Check for illegal bits */
+    return !(x & ~valid);
+}
+
+/* Total number of TCSs, including the additional thread classes */
+OE_INLINE uint64_t oe_sgx_get_total_num_tcs(
+    const oe_sgx_enclave_properties_t* properties)
+{
+    uint64_t n = properties->header.size_settings.num_tcs;
+
+    for (size_t i = 0; i < OE_SGX_MAX_TCS_CLASSES; i++)
+        n += properties->tcs_classes[i].num_tcs;
+
+    return n;
+}
+
+OE_INLINE bool oe_sgx_is_valid_tcs_classes(
+    const oe_sgx_enclave_properties_t* properties)
+{
+    for (size_t i = 0; i < OE_SGX_MAX_TCS_CLASSES; i++)
+    {
+        const oe_sgx_tcs_class_t* tcs_class = &properties->tcs_classes[i];
+
+        /* Reject threads without a stack */
+        if (tcs_class->num_tcs && !tcs_class->num_stack_pages)
+            return false;
+    }
+
+    /* The individual counts cannot overflow when added up */
+    return oe_sgx_is_valid_num_tcs(properties->header.size_settings.num_tcs) &&
+           oe_sgx_get_total_num_tcs(properties) <= OE_SGX_MAX_TCS;
+}
+
 #endif /* _OE_INTERNAL_SGX_PROPERTIES_H */
@@ -71,6 +71,10 @@ oe_result_t oe_sgx_initialize_load_context(
 
 void oe_sgx_cleanup_load_context(oe_sgx_load_context_t* context);
 
+/* Build the enclave into **enclave**, which is cleared first except for
+ * enclave->startup_trace. The caller must set that field to NULL or to a
+ * trace created by oe_startup_trace_create(), for example by zeroing the
+ * structure. */
 oe_result_t oe_sgx_build_enclave(
     oe_sgx_load_context_t* context,
     const char* path,
@@ -88,6 +92,7 @@ oe_result_t oe_sgx_build_enclave(
  *     - num_stack_pages
  *     - num_heap_pages
  *     - num_tcs
+ *     - config.flags
  *
  * If not the **field_name** output parameter points to the name of the first
  * field with an invalid value.
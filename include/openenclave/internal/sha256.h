@@ -0,0 +1,37 @@
+// Copyright (c) Open Enclave SDK contributors.
+// Licensed under the MIT License.
+
+#ifndef _OE_INTERNAL_SHA256_H
+#define _OE_INTERNAL_SHA256_H
+
+#include <openenclave/bits/types.h>
+
+OE_EXTERNC_BEGIN
+
+/**
+ * Apply the SHA-256 compression function to consecutive 64-byte blocks
+ *
+ * This is the block function behind all SHA-256 in the enclave, including
+ * mbedTLS. It uses the SHA extensions of the CPU when they are available.
+ *
+ * @param state the eight words of the hash state, updated in place
+ * @param data the blocks
+ * @param blocks the number of blocks
+ */
+void oe_sha256_compress(uint32_t state[8], const uint8_t* data, size_t blocks);
+
+/**
+ * Select the implementation of oe_sha256_compress()
+ *
+ * The SHA extensions are used by default when the CPU has them. This lets
+ * tests and benchmarks compare them with the portable implementation.
+ *
+ * @param enabled whether to use the SHA extensions if the CPU has them
+ *
+ * @return true if the SHA extensions are now in use
+ */
+bool oe_sha256_set_hardware_enabled(bool enabled);
+
+OE_EXTERNC_END
+
+#endif /* _OE_INTERNAL_SHA256_H */
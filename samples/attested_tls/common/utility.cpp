@@ -4,65 +4,11 @@
 // clang-format off
 #include <openenclave/enclave.h>
 #include <stdio.h>
+#include <atomic>
+#include <mutex>
 #include "utility.h"
 // clang-format on
 
-// input: input_data and input_data_len
-// output: key, key_size
-oe_result_t generate_key_pair(
-    uint8_t** public_key,
-    size_t* public_key_size,
-    uint8_t** private_key,
-    size_t* private_key_size)
-{
-    oe_result_t result = OE_FAILURE;
-    oe_asymmetric_key_params_t params;
-    char user_data[] = "test user data!";
-    size_t user_data_size = sizeof(user_data) - 1;
-
-    // Call oe_get_public_key_by_policy() to generate key pair derived from an
-    // enclave's seal key If an enclave does not want to have this key pair tied
-    // to enclave instance, it can generate its own key pair using any chosen
-    // crypto API
-
-    params.type = OE_ASYMMETRIC_KEY_EC_SECP256P1; // MBEDTLS_ECP_DP_SECP256R1
-    params.format = OE_ASYMMETRIC_KEY_PEM;
-    params.user_data = user_data;
-    params.user_data_size = user_data_size;
-    result = oe_get_public_key_by_policy(
-        OE_SEAL_POLICY_UNIQUE,
-        &params,
-        public_key,
-        public_key_size,
-        NULL,
-        NULL);
-    if (result != OE_OK)
-    {
-        printf(
-            "oe_get_public_key_by_policy(OE_SEAL_POLICY_UNIQUE) = %s",
-            oe_result_str(result));
-        goto done;
-    }
-
-    result = oe_get_private_key_by_policy(
-        OE_SEAL_POLICY_UNIQUE,
-        &params,
-        private_key,
-        private_key_size,
-        NULL,
-        NULL);
-    if (result != OE_OK)
-    {
-        printf(
-            "oe_get_private_key_by_policy(OE_SEAL_POLICY_UNIQUE) = %s",
-            oe_result_str(result));
-        goto done;
-    }
-
-done:
-    return result;
-}
-
 // Compute the sha256 hash of given data.
 static int sha256(const uint8_t* data, size_t data_size, uint8_t sha256[32])
 {
@@ -88,6 +34,50 @@ exit:
     return ret;
 }
 
+// The attestation identity of this enclave: a key pair and the attestation
+// certificate (with an embedded quote) for it. Generating a quote is the most
+// expensive step of a TLS handshake, so the identity is created once and its
+// certificate is reused for every connection. g_identity_lock makes sure that
+// concurrent first handshakes create only one identity; once it exists,
+// handshakes read g_identity without taking the lock.
+static std::atomic<oe_attestation_identity_t*> g_identity(NULL);
+static std::mutex g_identity_lock;
+
+static oe_result_t get_identity(oe_attestation_identity_t** identity)
+{
+    oe_result_t result = OE_OK;
+    oe_attestation_identity_settings_t settings = {
+        (const unsigned char*)"CN=Open Enclave SDK,O=OESDK TLS,C=US",
+        24 * 60 * 60};
+
+    if ((*identity = g_identity.load()) != NULL)
+        return OE_OK;
+
+    std::lock_guard<std::mutex> lock(g_identity_lock);
+
+    if ((*identity = g_identity.load()) == NULL)
+    {
+        result = oe_attestation_identity_create(&settings, identity);
+        if (result == OE_OK)
+            g_identity.store(*identity);
+    }
+
+    return result;
+}
+
+oe_result_t refresh_identity(void)
+{
+    oe_attestation_identity_t* identity = g_identity.load();
+
+    // Rotate the key pair and certificate once they are a day old, or after
+    // a TCB recovery. This makes an ocall for the time and takes a local
+    // report, so it is called periodically by the host, not per handshake.
+    if (identity == NULL)
+        return OE_OK;
+
+    return oe_attestation_identity_refresh(identity, false, NULL);
+}
+
 // Consider to move this function into a shared directory
 oe_result_t generate_certificate_and_pkey(
     mbedtls_x509_crt* cert,
@@ -98,32 +88,24 @@ oe_result_t generate_certificate_and_pkey(
     size_t output_cert_size = 0;
     uint8_t* private_key_buf = NULL;
     size_t private_key_buf_size = 0;
-    uint8_t* public_key_buf = NULL;
-    size_t public_key_buf_size = 0;
+    oe_attestation_identity_t* identity = NULL;
     int ret = 0;
 
-    result = generate_key_pair(
-        &public_key_buf,
-        &public_key_buf_size,
-        &private_key_buf,
-        &private_key_buf_size);
+    result = get_identity(&identity);
     if (result != OE_OK)
     {
         printf(" failed with %s\n", oe_result_str(result));
         goto exit;
     }
 
-    printf("public key used:\n[%s]", public_key_buf);
-
-    // both ec key such ASYMMETRIC_KEY_EC_SECP256P1 or RSA key work
-    result = oe_generate_attestation_certificate(
-        (const unsigned char*)"CN=Open Enclave SDK,O=OESDK TLS,C=US",
-        private_key_buf,
-        private_key_buf_size,
-        public_key_buf,
-        public_key_buf_size,
+    // Handing out the cached certificate does not leave the enclave and does
+    // not wait for refresh_identity().
+    result = oe_attestation_identity_get(
+        identity,
         &output_cert,
-        &output_cert_size);
+        &output_cert_size,
+        &private_key_buf,
+        &private_key_buf_size);
     if (result != OE_OK)
     {
         printf(" failed with %s\n", oe_result_str(result));
@@ -155,7 +137,6 @@ oe_result_t generate_certificate_and_pkey(
 
 exit:
     oe_free_key(private_key_buf, private_key_buf_size, NULL, 0);
-    oe_free_key(public_key_buf, public_key_buf_size, NULL, 0);
     oe_free_attestation_certificate(output_cert);
     return result;
 }
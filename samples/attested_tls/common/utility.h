@@ -11,6 +11,8 @@ oe_result_t generate_certificate_and_pkey(
     mbedtls_x509_crt* cert,
     mbedtls_pk_context* private_key);
 
+oe_result_t refresh_identity(void);
+
 bool verify_mrsigner(
     char* siging_public_key_buf,
     size_t siging_public_key_buf_size,
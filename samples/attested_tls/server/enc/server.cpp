@@ -385,3 +385,20 @@ exit:
     fflush(stdout);
     return (ret);
 }
+
+// Called periodically by the host, on another thread than setup_tls_server(),
+// to rotate the server's certificate in the background.
+int refresh_tls_identity()
+{
+    oe_result_t result = refresh_identity();
+
+    if (result != OE_OK)
+    {
+        printf(
+            TLS_SERVER "refresh_identity failed with %s\n",
+            oe_result_str(result));
+        return 1;
+    }
+
+    return 0;
+}
@@ -3,8 +3,35 @@
 
 #include <openenclave/host.h>
 #include <stdio.h>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
 #include "tls_server_u.h"
 
+// The enclave rotates its attestation identity when refresh_tls_identity() is
+// called, which this thread does every hour while the server runs, so that
+// TLS handshakes never wait for it.
+static std::mutex g_refresh_lock;
+static std::condition_variable g_refresh_stop;
+static bool g_stopping = false;
+
+static void refresh_identity_periodically(oe_enclave_t* enclave)
+{
+    std::unique_lock<std::mutex> lock(g_refresh_lock);
+
+    while (!g_refresh_stop.wait_for(
+        lock, std::chrono::hours(1), [] { return g_stopping; }))
+    {
+        int ret = 1;
+
+        lock.unlock();
+        if (refresh_tls_identity(enclave, &ret) != OE_OK || ret != 0)
+            printf("Host: refresh_tls_identity failed\n");
+        lock.lock();
+    }
+}
+
 oe_enclave_t* create_enclave(const char* enclave_path)
 {
     oe_enclave_t* enclave = NULL;
@@ -43,6 +70,7 @@ int main(int argc, const char* argv[])
     oe_result_t result = OE_OK;
     int ret = 1;
     char* server_port = NULL;
+    std::thread refresher;
 
     /* Check argument count */
     if (argc != 3)
@@ -76,6 +104,8 @@ int main(int argc, const char* argv[])
         goto exit;
     }
 
+    refresher = std::thread(refresh_identity_periodically, enclave);
+
     printf("Host: calling setup_tls_server\n");
     ret = setup_tls_server(enclave, &ret, server_port);
     if (ret != 0)
@@ -86,6 +116,16 @@ int main(int argc, const char* argv[])
 
 exit:
 
+    if (refresher.joinable())
+    {
+        {
+            std::lock_guard<std::mutex> lock(g_refresh_lock);
+            g_stopping = true;
+        }
+        g_refresh_stop.notify_one();
+        refresher.join();
+    }
+
     printf("Host: Terminating enclaves\n");
     if (enclave)
         terminate_enclave(enclave);
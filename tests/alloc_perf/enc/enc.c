@@ -0,0 +1,140 @@
+// Copyright (c) Open Enclave SDK contributors.
+// Licensed under the MIT License.
+
+#include <openenclave/enclave.h>
+#include <openenclave/internal/malloc.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "alloc_perf_t.h"
+
+/* The number of blocks the working set workload keeps allocated */
+#define WORKING_SET_SIZE 256
+
+static uint64_t _next(uint64_t* state)
+{
+    /* xorshift64 */
+    uint64_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    return *state = x;
+}
+
+/* Tag the first and last byte of a block, so that blocks handed out twice
+ * are detected when they are freed */
+static void _tag(uint8_t* block, size_t size, uint8_t tag)
+{
+    block[0] = tag;
+    block[size - 1] = tag;
+}
+
+static bool _check_tag(const uint8_t* block, size_t size, uint8_t tag)
+{
+    return block[0] == tag && block[size - 1] == tag;
+}
+
+/* Allocate and free blocks of 16 to 256 bytes right away */
+static oe_result_t _run_pairs(uint64_t iterations, uint64_t seed)
+{
+    for (uint64_t i = 0; i < iterations; i++)
+    {
+        size_t size = 16 + (size_t)(_next(&seed) % 241);
+        uint8_t* block = (uint8_t*)malloc(size);
+
+        if (!block)
+            return OE_OUT_OF_MEMORY;
+
+        _tag(block, size, (uint8_t)i);
+
+        if (!_check_tag(block, size, (uint8_t)i))
+            return OE_FAILURE;
+
+        free(block);
+    }
+
+    return OE_OK;
+}
+
+/* Keep WORKING_SET_SIZE blocks allocated and replace a random one in every
+ * iteration. Most blocks are small, one in eight is up to 4 KB */
+static oe_result_t _run_working_set(uint64_t iterations, uint64_t seed)
+{
+    oe_result_t result = OE_OK;
+    uint8_t* blocks[WORKING_SET_SIZE] = {0};
+    size_t sizes[WORKING_SET_SIZE] = {0};
+
+    for (uint64_t i = 0; i < iterations; i++)
+    {
+        uint64_t r = _next(&seed);
+        size_t slot = (size_t)(r % WORKING_SET_SIZE);
+        size_t size = 1 + (size_t)((r >> 16) % ((r >> 8) % 8 ? 512 : 4096));
+        uint8_t tag = (uint8_t)slot;
+
+        if (blocks[slot])
+        {
+            if (!_check_tag(blocks[slot], sizes[slot], tag))
+            {
+                result = OE_FAILURE;
+                goto done;
+            }
+
+            free(blocks[slot]);
+        }
+
+        if (!(blocks[slot] = (uint8_t*)malloc(size)))
+        {
+            result = OE_OUT_OF_MEMORY;
+            goto done;
+        }
+
+        sizes[slot] = size;
+        _tag(blocks[slot], size, tag);
+    }
+
+done:
+    for (size_t i = 0; i < WORKING_SET_SIZE; i++)
+        free(blocks[i]);
+
+    return result;
+}
+
+allocator_t enc_get_allocator(void)
+{
+#if defined(OE_USE_SNMALLOC)
+    return ALLOCATOR_SNMALLOC;
+#elif defined(OE_USE_DEBUG_MALLOC)
+    return ALLOCATOR_DEBUG_MALLOC;
+#else
+    return ALLOCATOR_DLMALLOC;
+#endif
+}
+
+oe_result_t enc_set_thread_cache(bool enabled)
+{
+    return oe_set_malloc_thread_cache_enabled(enabled);
+}
+
+oe_result_t enc_run(workload_t workload, uint64_t iterations, uint64_t seed)
+{
+    // xorshift64 must not start from zero.
+    seed |= 1;
+
+    switch (workload)
+    {
+        case WORKLOAD_PAIRS:
+            return _run_pairs(iterations, seed);
+        case WORKLOAD_WORKING_SET:
+            return _run_working_set(iterations, seed);
+    }
+
+    return OE_INVALID_PARAMETER;
+}
+
+OE_SET_ENCLAVE_SGX(
+    1,    /* ProductID */
+    1,    /* SecurityVersion */
+    true, /* AllowDebug */
+    8192, /* HeapPageCount */
+    64,   /* StackPageCount */
+    16);  /* TCSCount */
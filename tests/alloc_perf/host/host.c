@@ -0,0 +1,194 @@
+// Copyright (c) Open Enclave SDK contributors.
+// Licensed under the MIT License.
+
+#include <openenclave/host.h>
+#include <openenclave/internal/tests.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "alloc_perf_u.h"
+
+#define DEFAULT_THREADS 4
+#define DEFAULT_ITERATIONS 200000
+
+/* Must not exceed the TCSCount of the enclave */
+#define MAX_THREADS 16
+
+/*
+**==============================================================================
+**
+** Enclave allocator benchmark:
+**
+**     alloc_perf_host ENCLAVE [THREADS] [ITERATIONS]
+**
+**         Runs each workload in the enclave on 1, 2, 4, ... up to THREADS
+**         threads at once, every thread making ITERATIONS allocations in a
+**         single ecall, and reports the allocations per second of all
+**         threads together.
+**
+**         With dlmalloc, the SDK's default allocator, every workload runs
+**         with and without the per-thread allocation caches. An SDK built
+**         with USE_SNMALLOC or USE_DEBUG_MALLOC runs every workload once with
+**         that allocator.
+**
+**==============================================================================
+*/
+
+typedef struct _thread_args
+{
+    workload_t workload;
+    uint64_t seed;
+    oe_result_t result;
+} thread_args_t;
+
+static oe_enclave_t* _enclave;
+static uint64_t _iterations = DEFAULT_ITERATIONS;
+
+static const workload_t _workloads[] = {
+    WORKLOAD_PAIRS,
+    WORKLOAD_WORKING_SET,
+};
+
+static const char* _workload_names[] = {
+    "malloc/free pairs (16-256 B)",
+    "working set (256 blocks, 1-4096 B)",
+};
+
+static double _get_time_in_seconds(void)
+{
+    struct timespec current_time;
+    clock_gettime(CLOCK_MONOTONIC, &current_time);
+    return (double)current_time.tv_sec + (double)current_time.tv_nsec / 1e9;
+}
+
+static void* _thread(void* arg)
+{
+    thread_args_t* args = (thread_args_t*)arg;
+    oe_result_t result = enc_run(
+        _enclave, &args->result, args->workload, _iterations, args->seed);
+
+    if (result != OE_OK)
+        args->result = result;
+
+    return NULL;
+}
+
+static void _run(const char* allocator, workload_t workload, size_t threads)
+{
+    pthread_t ids[MAX_THREADS];
+    thread_args_t args[MAX_THREADS];
+    double start;
+    double elapsed;
+
+    start = _get_time_in_seconds();
+
+    for (size_t i = 0; i < threads; i++)
+    {
+        args[i].workload = workload;
+        args[i].seed = i + 1;
+        args[i].result = OE_UNEXPECTED;
+        OE_TEST(pthread_create(&ids[i], NULL, _thread, &args[i]) == 0);
+    }
+
+    for (size_t i = 0; i < threads; i++)
+    {
+        pthread_join(ids[i], NULL);
+        OE_TEST(args[i].result == OE_OK);
+    }
+
+    elapsed = _get_time_in_seconds() - start;
+
+    printf(
+        "%-36s %-24s %7zu %12.0f\n",
+        _workload_names[workload],
+        allocator,
+        threads,
+        (double)threads * (double)_iterations / elapsed);
+}
+
+static void _run_all(const char* allocator, workload_t workload, size_t threads)
+{
+    for (size_t n = 1; n < threads; n *= 2)
+        _run(allocator, workload, n);
+
+    _run(allocator, workload, threads);
+}
+
+int main(int argc, const char* argv[])
+{
+    oe_result_t result;
+    size_t threads = DEFAULT_THREADS;
+    allocator_t allocator = ALLOCATOR_DLMALLOC;
+
+    if (argc < 2 || argc > 4)
+    {
+        fprintf(stderr, "Usage: %s ENCLAVE [THREADS] [ITERATIONS]\n", argv[0]);
+        return 1;
+    }
+
+    if (argc > 2)
+        threads = strtoul(argv[2], NULL, 10);
+
+    if (argc > 3)
+        _iterations = strtoull(argv[3], NULL, 10);
+
+    if (threads < 1 || threads > MAX_THREADS || !_iterations)
+    {
+        fprintf(
+            stderr,
+            "%s: THREADS must be 1 to %d, ITERATIONS at least 1\n",
+            argv[0],
+            MAX_THREADS);
+        return 1;
+    }
+
+    result = oe_create_alloc_perf_enclave(
+        argv[1],
+        OE_ENCLAVE_TYPE_AUTO,
+        oe_get_create_flags(),
+        NULL,
+        0,
+        &_enclave);
+    OE_TEST(result == OE_OK);
+
+    OE_TEST(enc_get_allocator(_enclave, &allocator) == OE_OK);
+
+    printf(
+        "%-36s %-24s %7s %12s\n",
+        "workload",
+        "allocator",
+        "threads",
+        "allocs/s");
+
+    for (size_t i = 0; i < OE_COUNTOF(_workloads); i++)
+    {
+        workload_t w = _workloads[i];
+
+        if (allocator == ALLOCATOR_DLMALLOC)
+        {
+            OE_TEST(enc_set_thread_cache(_enclave, &result, false) == OE_OK);
+            OE_TEST(result == OE_OK);
+            _run_all("dlmalloc", w, threads);
+
+            OE_TEST(enc_set_thread_cache(_enclave, &result, true) == OE_OK);
+            OE_TEST(result == OE_OK);
+            _run_all("dlmalloc + thread cache", w, threads);
+        }
+        else if (allocator == ALLOCATOR_SNMALLOC)
+        {
+            _run_all("snmalloc", w, threads);
+        }
+        else
+        {
+            _run_all("debug malloc", w, threads);
+        }
+    }
+
+    OE_TEST(oe_terminate_enclave(_enclave) == OE_OK);
+
+    printf("=== passed all tests (alloc_perf)\n");
+
+    return 0;
+}
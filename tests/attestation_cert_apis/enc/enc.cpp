@@ -304,6 +304,74 @@ oe_result_t get_tls_cert_signed_with_rsa_key(
     return get_tls_cert_signed_with_key(MBEDTLS_PK_RSA, cert, cert_size);
 }
 
+// Verify that an attestation identity hands out the same certificate until
+// it is rotated, and that its certificates verify.
+oe_result_t test_attestation_identity()
+{
+    oe_attestation_identity_settings_t settings = {
+        (const unsigned char*)"CN=Open Enclave SDK,O=OESDK TLS,C=US", 0};
+    oe_attestation_identity_t* identity = NULL;
+    uint8_t* cert[3] = {NULL, NULL, NULL};
+    size_t cert_size[3] = {0, 0, 0};
+    uint8_t* private_key[3] = {NULL, NULL, NULL};
+    size_t private_key_size[3] = {0, 0, 0};
+    bool rotated = true;
+
+    OE_TEST(oe_attestation_identity_create(&settings, &identity) == OE_OK);
+
+    for (size_t i = 0; i < 2; i++)
+        OE_TEST(
+            oe_attestation_identity_get(
+                identity,
+                &cert[i],
+                &cert_size[i],
+                &private_key[i],
+                &private_key_size[i]) == OE_OK);
+
+    OE_TEST(cert_size[0] == cert_size[1]);
+    OE_TEST(memcmp(cert[0], cert[1], cert_size[0]) == 0);
+    OE_TEST(private_key_size[0] == private_key_size[1]);
+    OE_TEST(memcmp(private_key[0], private_key[1], private_key_size[0]) == 0);
+    OE_TEST(
+        oe_verify_attestation_certificate(
+            cert[0], cert_size[0], enclave_identity_verifier, NULL) == OE_OK);
+
+    // Without a rotation interval and with an unchanged TCB, refreshing keeps
+    // the identity.
+    OE_TEST(
+        oe_attestation_identity_refresh(identity, false, &rotated) == OE_OK);
+    OE_TEST(!rotated);
+
+    OE_TEST(oe_attestation_identity_refresh(identity, true, &rotated) == OE_OK);
+    OE_TEST(rotated);
+    OE_TEST(
+        oe_attestation_identity_get(
+            identity,
+            &cert[2],
+            &cert_size[2],
+            &private_key[2],
+            &private_key_size[2]) == OE_OK);
+    OE_TEST(
+        cert_size[2] != cert_size[0] ||
+        memcmp(cert[2], cert[0], cert_size[0]) != 0);
+    OE_TEST(
+        private_key_size[2] != private_key_size[0] ||
+        memcmp(private_key[2], private_key[0], private_key_size[0]) != 0);
+    OE_TEST(
+        oe_verify_attestation_certificate(
+            cert[2], cert_size[2], enclave_identity_verifier, NULL) == OE_OK);
+
+    for (size_t i = 0; i < 3; i++)
+    {
+        oe_free_attestation_certificate(cert[i]);
+        oe_free_key(private_key[i], private_key_size[i], NULL, 0);
+    }
+
+    oe_attestation_identity_free(identity);
+
+    return OE_OK;
+}
+
 OE_SET_ENCLAVE_SGX(
     1,    /* ProductID */
     1,    /* SecurityVersion */
@@ -9,6 +9,8 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <chrono>
+#include <thread>
 #include "tls_u.h"
 
 #if defined(_WIN32)
@@ -124,6 +126,32 @@ void run_test(oe_enclave_t* enclave, int test_type)
     fflush(stdout);
     OE_TEST(result == OE_OK);
 
+    // With the verification result cache enabled, the quote in a certificate
+    // that is presented again is not verified again, even once the
+    // endorsements fetched for it have a later creation datetime.
+    {
+        oe_verification_result_cache_stats_t before = {0};
+        oe_verification_result_cache_stats_t after = {0};
+
+        OE_TEST(oe_set_verification_result_cache_size(16) == OE_OK);
+        OE_TEST(oe_get_verification_result_cache_stats(&before) == OE_OK);
+
+        for (int i = 0; i < 3; i++)
+        {
+            if (i == 2)
+                std::this_thread::sleep_for(std::chrono::milliseconds(1100));
+
+            OE_TEST(
+                oe_verify_attestation_certificate(
+                    cert, cert_size, enclave_identity_verifier, NULL) == OE_OK);
+        }
+
+        OE_TEST(oe_get_verification_result_cache_stats(&after) == OE_OK);
+        OE_TEST(after.misses == before.misses + 1);
+        OE_TEST(after.hits == before.hits + 2);
+        OE_TEST(oe_set_verification_result_cache_size(0) == OE_OK);
+    }
+
     OE_TRACE_INFO("free cert 0xx%p\n", cert);
     free(cert);
 }
@@ -191,6 +219,12 @@ int main(int argc, const char* argv[])
     run_test(enclave, TEST_EC_KEY);
     run_test(enclave, TEST_RSA_KEY);
 
+    {
+        oe_result_t ecall_result;
+        OE_TEST(test_attestation_identity(enclave, &ecall_result) == OE_OK);
+        OE_TEST(ecall_result == OE_OK);
+    }
+
     result = oe_terminate_enclave(enclave);
     OE_TEST(result == OE_OK);
     OE_TRACE_INFO("=== passed all tests (tls)\n");
@@ -0,0 +1,225 @@
+// Copyright (c) Open Enclave SDK contributors.
+// Licensed under the MIT License.
+
+#include <openenclave/attestation/plugin.h>
+#include <openenclave/attestation/sgx/attester.h>
+#include <openenclave/enclave.h>
+#include <openenclave/internal/cert.h>
+#include <openenclave/internal/crypto/crl.h>
+#include <openenclave/internal/raise.h>
+#include <openenclave/internal/report.h>
+#include <string.h>
+#include "../../../common/sgx/certchaincache.h"
+#include "../../../common/sgx/endorsements.h"
+#include "../../../common/sgx/quote.h"
+#include "attestation_perf_t.h"
+
+static const unsigned char _subject_name[] =
+    "CN=Open Enclave SDK,O=OESDK TLS,C=US";
+
+static oe_attester_t* _attester;
+static oe_attestation_identity_t* _identity;
+
+static oe_result_t _copy_to_host(
+    const uint8_t* data,
+    size_t size,
+    uint8_t** host_data,
+    size_t* host_size)
+{
+    *host_data = NULL;
+    *host_size = 0;
+
+    if (!data)
+        return OE_OK;
+
+    if (!(*host_data = (uint8_t*)oe_host_malloc(size)))
+        return OE_OUT_OF_MEMORY;
+
+    memcpy(*host_data, data, size);
+    *host_size = size;
+    return OE_OK;
+}
+
+oe_result_t enc_get_evidence(
+    bool with_endorsements,
+    uint8_t** evidence,
+    size_t* evidence_size,
+    uint8_t** endorsements,
+    size_t* endorsements_size)
+{
+    oe_result_t result = OE_UNEXPECTED;
+    uint8_t* local_evidence = NULL;
+    size_t local_evidence_size = 0;
+    uint8_t* local_endorsements = NULL;
+    size_t local_endorsements_size = 0;
+
+    *evidence = NULL;
+    *endorsements = NULL;
+
+    if (!_attester)
+    {
+        _attester = oe_sgx_plugin_attester();
+        OE_CHECK(oe_register_attester(_attester, NULL, 0));
+    }
+
+    OE_CHECK(oe_get_evidence(
+        &_attester->base.format_id,
+        OE_REPORT_FLAGS_REMOTE_ATTESTATION,
+        NULL,
+        0,
+        NULL,
+        0,
+        &local_evidence,
+        &local_evidence_size,
+        with_endorsements ? &local_endorsements : NULL,
+        with_endorsements ? &local_endorsements_size : NULL));
+
+    OE_CHECK(_copy_to_host(
+        local_evidence, local_evidence_size, evidence, evidence_size));
+    OE_CHECK(_copy_to_host(
+        local_endorsements,
+        local_endorsements_size,
+        endorsements,
+        endorsements_size));
+
+    result = OE_OK;
+
+done:
+    if (result != OE_OK)
+    {
+        oe_host_free(*evidence);
+        *evidence = NULL;
+    }
+
+    oe_free_evidence(local_evidence);
+    oe_free_endorsements(local_endorsements);
+    return result;
+}
+
+static oe_result_t _get_identity(void)
+{
+    oe_attestation_identity_settings_t settings = {_subject_name, 0};
+
+    if (_identity)
+        return OE_OK;
+
+    return oe_attestation_identity_create(&settings, &_identity);
+}
+
+oe_result_t enc_get_attestation_certificate(uint8_t** cert, size_t* cert_size)
+{
+    oe_result_t result = OE_UNEXPECTED;
+    uint8_t* local_cert = NULL;
+    size_t local_cert_size = 0;
+    uint8_t* private_key = NULL;
+    size_t private_key_size = 0;
+
+    *cert = NULL;
+
+    OE_CHECK(_get_identity());
+    OE_CHECK(oe_attestation_identity_get(
+        _identity,
+        &local_cert,
+        &local_cert_size,
+        &private_key,
+        &private_key_size));
+    OE_CHECK(_copy_to_host(local_cert, local_cert_size, cert, cert_size));
+
+    result = OE_OK;
+
+done:
+    oe_free_attestation_certificate(local_cert);
+    oe_free_key(private_key, private_key_size, NULL, 0);
+    return result;
+}
+
+oe_result_t enc_refresh_attestation_certificate(void)
+{
+    oe_result_t result = OE_UNEXPECTED;
+
+    OE_CHECK(_get_identity());
+    OE_CHECK(oe_attestation_identity_refresh(_identity, true, NULL));
+
+    result = OE_OK;
+
+done:
+    return result;
+}
+
+/* The PCK certificate of a quote with the chain and CRLs its revocation is
+ * checked with, and the TCB signing certificate with its chain */
+static oe_cert_t _pck_cert;
+static oe_cert_chain_t _pck_chain;
+static oe_crl_t _crls[OE_SGX_ENDORSEMENTS_CRL_COUNT];
+static oe_cert_t _tcb_cert;
+static oe_cert_chain_t _tcb_chain;
+static bool _cert_chains_loaded;
+
+oe_result_t enc_load_cert_chains(
+    const uint8_t* evidence,
+    size_t evidence_size,
+    const uint8_t* endorsements,
+    size_t endorsements_size)
+{
+    oe_result_t result = OE_UNEXPECTED;
+    const oe_report_header_t* header = (const oe_report_header_t*)evidence;
+    oe_sgx_cert_chain_t issuer_chain = {0};
+    oe_sgx_endorsements_t sgx_endorsements;
+    const oe_sgx_endorsement_item* item;
+
+    if (_cert_chains_loaded || evidence_size < sizeof(*header) ||
+        header->report_size > evidence_size - sizeof(*header))
+        OE_RAISE(OE_INVALID_PARAMETER);
+
+    OE_CHECK(oe_get_quote_pck_cert_internal(
+        header->report, header->report_size, &_pck_cert, &issuer_chain));
+    OE_CHECK(oe_parse_sgx_endorsements(
+        (const oe_endorsements_t*)endorsements,
+        endorsements_size,
+        &sgx_endorsements));
+
+    // Like oe_validate_revocation_list(), check the PCK certificate with the
+    // issuer chain of its CRL.
+    item = &sgx_endorsements
+                .items[OE_SGX_ENDORSEMENT_FIELD_CRL_ISSUER_CHAIN_PCK_CERT];
+    OE_CHECK(oe_cert_chain_read_pem(&_pck_chain, item->data, item->size));
+
+    for (size_t i = 0; i < OE_COUNTOF(_crls); i++)
+    {
+        item =
+            &sgx_endorsements.items[OE_SGX_ENDORSEMENT_FIELD_CRL_PCK_CERT + i];
+        OE_CHECK(oe_crl_read_pem(&_crls[i], item->data, item->size));
+    }
+
+    item = &sgx_endorsements.items[OE_SGX_ENDORSEMENT_FIELD_TCB_ISSUER_CHAIN];
+    OE_CHECK(oe_cert_chain_read_pem(&_tcb_chain, item->data, item->size));
+    OE_CHECK(oe_cert_chain_get_leaf_cert(&_tcb_chain, &_tcb_cert));
+
+    _cert_chains_loaded = true;
+    result = OE_OK;
+
+done:
+    oe_sgx_free_cert_chain(&issuer_chain);
+    return result;
+}
+
+oe_result_t enc_verify_pck_cert_chain(void)
+{
+    const oe_crl_t* crls[OE_COUNTOF(_crls)];
+
+    if (!_cert_chains_loaded)
+        return OE_INVALID_PARAMETER;
+
+    for (size_t i = 0; i < OE_COUNTOF(_crls); i++)
+        crls[i] = &_crls[i];
+
+    return oe_cert_verify(&_pck_cert, &_pck_chain, crls, OE_COUNTOF(crls));
+}
+
+oe_result_t enc_verify_tcb_cert_chain(void)
+{
+    if (!_cert_chains_loaded)
+        return OE_INVALID_PARAMETER;
+
+    return oe_cert_verify(&_tcb_cert, &_tcb_chain, NULL, 0);
+}
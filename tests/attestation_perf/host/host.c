@@ -0,0 +1,563 @@
+// Copyright (c) Open Enclave SDK contributors.
+// Licensed under the MIT License.
+
+#include <dlfcn.h>
+#include <errno.h>
+#include <openenclave/attestation/plugin.h>
+#include <openenclave/attestation/sgx/verifier.h>
+#include <openenclave/host.h>
+#include <openenclave/internal/datetime.h>
+#include <openenclave/internal/raise.h>
+#include <openenclave/internal/report.h>
+#include <openenclave/internal/tests.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+
+#include "../../../common/sgx/certchaincache.h"
+#include "../../../common/sgx/collateralcache.h"
+#include "../../../common/sgx/endorsements.h"
+#include "../../../common/sgx/tcbinfo.h"
+#include "../../../common/sgx/tcbinfocache.h"
+#include "../quoteprov/quoteprov.h"
+#include "attestation_perf_u.h"
+
+#define SKIP_RETURN_CODE 2
+
+#define DEFAULT_ITERATIONS 100
+
+#define EVIDENCE_FILE "evidence.bin"
+#define ENDORSEMENTS_FILE "endorsements.bin"
+#define CERTIFICATE_FILE "certificate.der"
+
+/*
+**==============================================================================
+**
+** Attestation benchmark:
+**
+**     attestation_perf_host ENCLAVE DIR [ITERATIONS]
+**
+**         Measures the stages that run in the enclave (evidence and
+**         attestation certificate generation, and verification of the PCK
+**         and TCB certificate chains) and records evidence with its
+**         endorsements, and an attestation certificate, into DIR. This needs
+**         SGX hardware and the platform's quote provider.
+**
+**     attestation_perf_host --replay DIR QUOTE_PROVIDER [ITERATIONS]
+**
+**         Measures the host stages (collateral retrieval and parsing, evidence
+**         and certificate verification) against a recording. QUOTE_PROVIDER
+**         is the stub libdcap_quoteprov.so, which serves the recorded
+**         collateral, so the results do not depend on the network or the
+**         PCCS and no enclave is needed.
+**
+**     Every stage reports its throughput and latency percentiles. Stages
+**     marked "cold" clear the SGX collateral, certificate chain and TCB info
+**     caches before each iteration (outside of the measurement).
+**
+**==============================================================================
+*/
+
+typedef struct _stage
+{
+    const char* name;
+    oe_result_t (*run)(void);
+    bool cold;
+} stage_t;
+
+static size_t _iterations = DEFAULT_ITERATIONS;
+static oe_enclave_t* _enclave;
+
+static uint8_t* _evidence;
+static size_t _evidence_size;
+static uint8_t* _endorsements;
+static size_t _endorsements_size;
+static uint8_t* _certificate;
+static size_t _certificate_size;
+
+/* The creation time of the recorded endorsements, which evidence is verified
+ * for, so that a recording remains usable after its collateral expired */
+static oe_datetime_t _endorsements_time;
+
+static double _get_time_in_seconds(void)
+{
+    struct timespec current_time;
+    clock_gettime(CLOCK_MONOTONIC, &current_time);
+    return (double)current_time.tv_sec + (double)current_time.tv_nsec / 1e9;
+}
+
+static int _compare_doubles(const void* a, const void* b)
+{
+    double x = *(const double*)a;
+    double y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+static double _percentile(const double* sorted, size_t count, double p)
+{
+    size_t index = (size_t)(p * (double)count + 0.999999);
+    return sorted[index ? index - 1 : 0];
+}
+
+static void _clear_caches(void)
+{
+    oe_sgx_collateral_cache_clear();
+    oe_sgx_cert_chain_cache_clear();
+    oe_sgx_tcb_info_cache_clear();
+}
+
+static void _run_stage(const stage_t* stage)
+{
+    double* latencies = (double*)calloc(_iterations, sizeof(*latencies));
+    double total = 0;
+
+    OE_TEST(latencies != NULL);
+
+    for (size_t i = 0; i < _iterations; i++)
+    {
+        oe_result_t result;
+        double start;
+
+        if (stage->cold)
+            _clear_caches();
+
+        start = _get_time_in_seconds();
+        result = stage->run();
+        latencies[i] = _get_time_in_seconds() - start;
+        total += latencies[i];
+
+        if (result != OE_OK)
+        {
+            fprintf(
+                stderr,
+                "%s failed: %s (%u)\n",
+                stage->name,
+                oe_result_str(result),
+                result);
+            exit(1);
+        }
+    }
+
+    qsort(latencies, _iterations, sizeof(*latencies), _compare_doubles);
+
+    printf(
+        "%-40s %10.1f ops/s  p50 %9.1f us  p90 %9.1f us  p99 %9.1f us  "
+        "max %9.1f us\n",
+        stage->name,
+        total > 0 ? (double)_iterations / total : 0,
+        _percentile(latencies, _iterations, 0.50) * 1e6,
+        _percentile(latencies, _iterations, 0.90) * 1e6,
+        _percentile(latencies, _iterations, 0.99) * 1e6,
+        latencies[_iterations - 1] * 1e6);
+    fflush(stdout);
+
+    free(latencies);
+}
+
+static void _join_path(
+    char* path,
+    size_t size,
+    const char* dir,
+    const char* name)
+{
+    OE_TEST((size_t)snprintf(path, size, "%s/%s", dir, name) < size);
+}
+
+static void _write_file(
+    const char* dir,
+    const char* name,
+    const uint8_t* data,
+    size_t size)
+{
+    char path[1024];
+    FILE* file;
+
+    _join_path(path, sizeof(path), dir, name);
+    OE_TEST((file = fopen(path, "wb")) != NULL);
+    OE_TEST(fwrite(data, 1, size, file) == size);
+    OE_TEST(fclose(file) == 0);
+}
+
+static bool _read_file(
+    const char* dir,
+    const char* name,
+    uint8_t** data,
+    size_t* size)
+{
+    char path[1024];
+    FILE* file;
+    long length;
+
+    _join_path(path, sizeof(path), dir, name);
+    if (!(file = fopen(path, "rb")))
+        return false;
+
+    OE_TEST(fseek(file, 0, SEEK_END) == 0);
+    OE_TEST((length = ftell(file)) > 0);
+    OE_TEST(fseek(file, 0, SEEK_SET) == 0);
+    OE_TEST((*data = (uint8_t*)malloc((size_t)length)) != NULL);
+    OE_TEST(fread(*data, 1, (size_t)length, file) == (size_t)length);
+    fclose(file);
+
+    *size = (size_t)length;
+    return true;
+}
+
+/*
+**==============================================================================
+**
+** Enclave stages
+**
+**==============================================================================
+*/
+
+static oe_result_t _call_get_evidence(bool with_endorsements)
+{
+    oe_result_t result = OE_UNEXPECTED;
+    oe_result_t ecall_result = OE_UNEXPECTED;
+    uint8_t* evidence = NULL;
+    size_t evidence_size = 0;
+    uint8_t* endorsements = NULL;
+    size_t endorsements_size = 0;
+
+    result = enc_get_evidence(
+        _enclave,
+        &ecall_result,
+        with_endorsements,
+        &evidence,
+        &evidence_size,
+        &endorsements,
+        &endorsements_size);
+
+    free(evidence);
+    free(endorsements);
+    return result != OE_OK ? result : ecall_result;
+}
+
+static oe_result_t _get_evidence(void)
+{
+    return _call_get_evidence(false);
+}
+
+static oe_result_t _get_evidence_with_endorsements(void)
+{
+    return _call_get_evidence(true);
+}
+
+static oe_result_t _refresh_attestation_certificate(void)
+{
+    oe_result_t result = OE_UNEXPECTED;
+    oe_result_t ecall_result = OE_UNEXPECTED;
+
+    result = enc_refresh_attestation_certificate(_enclave, &ecall_result);
+    return result != OE_OK ? result : ecall_result;
+}
+
+static oe_result_t _verify_pck_cert_chain(void)
+{
+    oe_result_t result = OE_UNEXPECTED;
+    oe_result_t ecall_result = OE_UNEXPECTED;
+
+    result = enc_verify_pck_cert_chain(_enclave, &ecall_result);
+    return result != OE_OK ? result : ecall_result;
+}
+
+static oe_result_t _verify_tcb_cert_chain(void)
+{
+    oe_result_t result = OE_UNEXPECTED;
+    oe_result_t ecall_result = OE_UNEXPECTED;
+
+    result = enc_verify_tcb_cert_chain(_enclave, &ecall_result);
+    return result != OE_OK ? result : ecall_result;
+}
+
+static int _record(const char* enclave_path, const char* dir)
+{
+    const uint32_t flags = oe_get_create_flags();
+    oe_result_t ecall_result = OE_UNEXPECTED;
+    const stage_t stages[] = {
+        {"oe_get_evidence (enclave)", _get_evidence, false},
+        {"oe_get_evidence + endorsements (enclave)",
+         _get_evidence_with_endorsements,
+         false},
+        {"attestation certificate (enclave)",
+         _refresh_attestation_certificate,
+         false},
+    };
+    const stage_t cert_chain_stages[] = {
+        {"PCK cert chain + CRLs (enclave)", _verify_pck_cert_chain, false},
+        {"TCB signing cert chain (enclave)", _verify_tcb_cert_chain, false},
+    };
+
+    // Remote attestation needs SGX hardware.
+    if ((flags & OE_ENCLAVE_FLAG_SIMULATE) != 0)
+        return SKIP_RETURN_CODE;
+
+    OE_TEST(mkdir(dir, 0755) == 0 || errno == EEXIST);
+
+    OE_TEST(
+        oe_create_attestation_perf_enclave(
+            enclave_path, OE_ENCLAVE_TYPE_AUTO, flags, NULL, 0, &_enclave) ==
+        OE_OK);
+
+    for (size_t i = 0; i < OE_COUNTOF(stages); i++)
+        _run_stage(&stages[i]);
+
+    // Record evidence with endorsements and an attestation certificate.
+    OE_TEST(
+        enc_get_evidence(
+            _enclave,
+            &ecall_result,
+            true,
+            &_evidence,
+            &_evidence_size,
+            &_endorsements,
+            &_endorsements_size) == OE_OK);
+    OE_TEST(ecall_result == OE_OK && _endorsements != NULL);
+
+    // Verify the certificate chains of the recorded quote and endorsements
+    // with oe_cert_verify() in the enclave.
+    OE_TEST(
+        enc_load_cert_chains(
+            _enclave,
+            &ecall_result,
+            _evidence,
+            _evidence_size,
+            _endorsements,
+            _endorsements_size) == OE_OK);
+    OE_TEST(ecall_result == OE_OK);
+
+    for (size_t i = 0; i < OE_COUNTOF(cert_chain_stages); i++)
+        _run_stage(&cert_chain_stages[i]);
+
+    OE_TEST(
+        enc_get_attestation_certificate(
+            _enclave, &ecall_result, &_certificate, &_certificate_size) ==
+        OE_OK);
+    OE_TEST(ecall_result == OE_OK);
+
+    _write_file(dir, EVIDENCE_FILE, _evidence, _evidence_size);
+    _write_file(dir, ENDORSEMENTS_FILE, _endorsements, _endorsements_size);
+    _write_file(dir, CERTIFICATE_FILE, _certificate, _certificate_size);
+    printf("Recorded evidence, endorsements and certificate in %s\n", dir);
+
+    OE_TEST(oe_terminate_enclave(_enclave) == OE_OK);
+    return 0;
+}
+
+/*
+**==============================================================================
+**
+** Host stages
+**
+**==============================================================================
+*/
+
+static oe_result_t _parse_collateral(void)
+{
+    oe_result_t result = OE_UNEXPECTED;
+    oe_sgx_endorsements_t sgx_endorsements;
+    oe_compiled_tcb_info_t tcb_info = {0};
+    oe_compiled_qe_identity_info_t qe_identity_info = {0};
+    const oe_sgx_endorsement_item* item;
+
+    OE_CHECK(oe_parse_sgx_endorsements(
+        (const oe_endorsements_t*)_endorsements,
+        _endorsements_size,
+        &sgx_endorsements));
+
+    item = &sgx_endorsements.items[OE_SGX_ENDORSEMENT_FIELD_TCB_INFO];
+    OE_CHECK(oe_compile_tcb_info_json(item->data, item->size, &tcb_info));
+
+    item = &sgx_endorsements.items[OE_SGX_ENDORSEMENT_FIELD_QE_ID_INFO];
+    OE_CHECK(oe_compile_qe_identity_info_json(
+        item->data, item->size, &qe_identity_info));
+
+    result = OE_OK;
+
+done:
+    oe_free_compiled_tcb_info(&tcb_info);
+    oe_free_compiled_qe_identity_info(&qe_identity_info);
+    return result;
+}
+
+static oe_result_t _get_endorsements(void)
+{
+    oe_result_t result = OE_UNEXPECTED;
+    oe_report_header_t* header = (oe_report_header_t*)_evidence;
+    uint8_t* endorsements = NULL;
+    size_t endorsements_size = 0;
+
+    // The evidence is an oe_report_header_t followed by the quote and the
+    // claims.
+    OE_CHECK(oe_get_sgx_endorsements(
+        header->report,
+        header->report_size,
+        &endorsements,
+        &endorsements_size));
+
+    result = OE_OK;
+
+done:
+    oe_free_sgx_endorsements(endorsements);
+    return result;
+}
+
+static oe_result_t _verify(const uint8_t* endorsements, size_t size)
+{
+    oe_result_t result = OE_UNEXPECTED;
+    oe_policy_t policy = {OE_POLICY_ENDORSEMENTS_TIME,
+                          &_endorsements_time,
+                          sizeof(_endorsements_time)};
+    oe_claim_t* claims = NULL;
+    size_t claims_length = 0;
+
+    OE_CHECK(oe_verify_evidence(
+        _evidence,
+        _evidence_size,
+        endorsements,
+        size,
+        &policy,
+        1,
+        &claims,
+        &claims_length));
+
+    result = OE_OK;
+
+done:
+    oe_free_claims_list(claims, claims_length);
+    return result;
+}
+
+static oe_result_t _verify_evidence(void)
+{
+    return _verify(_endorsements, _endorsements_size);
+}
+
+static oe_result_t _verify_evidence_fetch_endorsements(void)
+{
+    return _verify(NULL, 0);
+}
+
+static oe_result_t _verify_attestation_certificate(void)
+{
+    return oe_verify_attestation_certificate(
+        _certificate, _certificate_size, NULL, NULL);
+}
+
+static int _replay(const char* dir, const char* quote_provider_path)
+{
+    void* quote_provider = NULL;
+    perf_quote_provider_set_endorsements_t set_endorsements;
+    perf_quote_provider_get_call_count_t get_call_count;
+    oe_sgx_endorsements_t sgx_endorsements;
+    const oe_sgx_endorsement_item* item;
+    uint64_t call_count;
+    const stage_t stages[] = {
+        {"parse collateral", _parse_collateral, false},
+        {"oe_get_sgx_endorsements (cold)", _get_endorsements, true},
+        {"oe_get_sgx_endorsements", _get_endorsements, false},
+        {"oe_verify_evidence (cold)", _verify_evidence, true},
+        {"oe_verify_evidence", _verify_evidence, false},
+        {"oe_verify_evidence, fetch endorsements",
+         _verify_evidence_fetch_endorsements,
+         false},
+        {"oe_verify_attestation_certificate (cold)",
+         _verify_attestation_certificate,
+         true},
+        {"oe_verify_attestation_certificate",
+         _verify_attestation_certificate,
+         false},
+    };
+
+    if (!_read_file(dir, EVIDENCE_FILE, &_evidence, &_evidence_size) ||
+        !_read_file(
+            dir, ENDORSEMENTS_FILE, &_endorsements, &_endorsements_size) ||
+        !_read_file(dir, CERTIFICATE_FILE, &_certificate, &_certificate_size))
+    {
+        printf("No recording in %s, skipped\n", dir);
+        return SKIP_RETURN_CODE;
+    }
+
+    // Load the stub before the SDK loads the quote provider, which then
+    // finds it by its soname.
+    quote_provider = dlopen(quote_provider_path, RTLD_NOW | RTLD_GLOBAL);
+    if (!quote_provider)
+    {
+        fprintf(stderr, "%s\n", dlerror());
+        return 1;
+    }
+
+    set_endorsements = (perf_quote_provider_set_endorsements_t)dlsym(
+        quote_provider, "perf_quote_provider_set_endorsements");
+    get_call_count = (perf_quote_provider_get_call_count_t)dlsym(
+        quote_provider, "perf_quote_provider_get_call_count");
+    OE_TEST(set_endorsements != NULL && get_call_count != NULL);
+    OE_TEST(set_endorsements(_endorsements, _endorsements_size) == 0);
+
+    OE_TEST(
+        oe_parse_sgx_endorsements(
+            (const oe_endorsements_t*)_endorsements,
+            _endorsements_size,
+            &sgx_endorsements) == OE_OK);
+    item =
+        &sgx_endorsements.items[OE_SGX_ENDORSEMENT_FIELD_CREATION_DATETIME];
+    OE_TEST(
+        oe_datetime_from_string(
+            (const char*)item->data, item->size, &_endorsements_time) ==
+        OE_OK);
+
+    OE_TEST(oe_register_verifier(oe_sgx_plugin_verifier(), NULL, 0) == OE_OK);
+
+    for (size_t i = 0; i < OE_COUNTOF(stages); i++)
+    {
+        call_count = get_call_count();
+        _run_stage(&stages[i]);
+        printf(
+            "%-40s %llu quote provider calls\n",
+            "",
+            (unsigned long long)(get_call_count() - call_count));
+    }
+
+    OE_TEST(oe_unregister_verifier(oe_sgx_plugin_verifier()) == OE_OK);
+    return 0;
+}
+
+int main(int argc, const char* argv[])
+{
+    bool replay = argc > 1 && strcmp(argv[1], "--replay") == 0;
+    int iterations_arg = replay ? 4 : 3;
+
+    if (argc != iterations_arg && argc != iterations_arg + 1)
+    {
+        fprintf(
+            stderr,
+            "Usage: %s ENCLAVE DIR [ITERATIONS]\n"
+            "       %s --replay DIR QUOTE_PROVIDER [ITERATIONS]\n",
+            argv[0],
+            argv[0]);
+        return 1;
+    }
+
+#ifndef OE_LINK_SGX_DCAP_QL
+    // The benchmark needs the quote provider.
+    printf("=== benchmark skipped when built with HAS_QUOTE_PROVIDER=OFF\n");
+    return SKIP_RETURN_CODE;
+#endif
+
+    if (argc == iterations_arg + 1)
+        _iterations = strtoul(argv[iterations_arg], NULL, 10);
+
+    if (_iterations == 0)
+    {
+        fprintf(stderr, "ITERATIONS must be positive\n");
+        return 1;
+    }
+
+    if (replay)
+        return _replay(argv[2], argv[3]);
+
+    return _record(argv[1], argv[2]);
+}
@@ -0,0 +1,148 @@
+// Copyright (c) Open Enclave SDK contributors.
+// Licensed under the MIT License.
+
+#include <openenclave/bits/attestation.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../../../host/sgx/platformquoteprovider.h"
+#include "quoteprov.h"
+
+/*
+**==============================================================================
+**
+** Stand-in for libdcap_quoteprov.so:
+**
+**     Serves the collateral of a recorded oe_endorsements_t for every
+**     platform, so that the benchmark measures the SDK rather than the
+**     network and the PCCS. Only the functions that the SDK looks up are
+**     provided.
+**
+**==============================================================================
+*/
+
+/* Size of the offsets that precede the data of oe_endorsements_t */
+#define OFFSETS_SIZE ((uint32_t)(OE_SGX_ENDORSEMENT_COUNT * sizeof(uint32_t)))
+
+static uint8_t* _endorsements;
+static size_t _endorsements_size;
+static uint64_t _call_count;
+
+int perf_quote_provider_set_endorsements(const uint8_t* data, size_t size)
+{
+    const oe_endorsements_t* header = (const oe_endorsements_t*)data;
+    uint8_t* copy = NULL;
+
+    if (!data || size < sizeof(*header) ||
+        header->num_elements != OE_SGX_ENDORSEMENT_COUNT ||
+        header->buffer_size > size - sizeof(*header) ||
+        header->buffer_size <= OFFSETS_SIZE)
+        return -1;
+
+    if (!(copy = (uint8_t*)malloc(size)))
+        return -1;
+
+    memcpy(copy, data, size);
+    free(_endorsements);
+    _endorsements = copy;
+    _endorsements_size = size;
+    return 0;
+}
+
+uint64_t perf_quote_provider_get_call_count(void)
+{
+    return __atomic_load_n(&_call_count, __ATOMIC_SEQ_CST);
+}
+
+/* Get a field of the recorded endorsements, see oe_parse_sgx_endorsements() */
+static int _get_item(int field, char** data, uint32_t* size)
+{
+    const oe_endorsements_t* header = (const oe_endorsements_t*)_endorsements;
+    const uint32_t* offsets = (const uint32_t*)header->buffer;
+    uint32_t data_size = header->buffer_size - OFFSETS_SIZE;
+    uint8_t* start = (uint8_t*)header->buffer + OFFSETS_SIZE;
+    uint32_t end =
+        field + 1 < OE_SGX_ENDORSEMENT_COUNT ? offsets[field + 1] : data_size;
+
+    if (offsets[field] > end || end > data_size)
+        return -1;
+
+    *data = (char*)start + offsets[field];
+    *size = end - offsets[field];
+    return 0;
+}
+
+sgx_plat_error_t sgx_ql_get_quote_verification_collateral(
+    const uint8_t* fmspc,
+    const uint16_t fmspc_size,
+    const char* pck_ca,
+    sgx_ql_qve_collateral_t** pp_qve_collateral)
+{
+    sgx_ql_qve_collateral_t* collateral = NULL;
+
+    (void)fmspc;
+    (void)fmspc_size;
+    (void)pck_ca;
+
+    __atomic_add_fetch(&_call_count, 1, __ATOMIC_SEQ_CST);
+
+    if (!pp_qve_collateral)
+        return SGX_PLAT_ERROR_INVALID_PARAMETER;
+
+    if (!_endorsements)
+        return SGX_PLAT_NO_DATA_FOUND;
+
+    collateral = (sgx_ql_qve_collateral_t*)calloc(1, sizeof(*collateral));
+    if (!collateral)
+        return SGX_PLAT_ERROR_OUT_OF_MEMORY;
+
+    collateral->version = 1;
+
+    // The collateral points into the recording, the SDK copies it.
+    if (_get_item(
+            OE_SGX_ENDORSEMENT_FIELD_CRL_ISSUER_CHAIN_PCK_CERT,
+            &collateral->pck_crl_issuer_chain,
+            &collateral->pck_crl_issuer_chain_size) != 0 ||
+        _get_item(
+            OE_SGX_ENDORSEMENT_FIELD_CRL_PCK_PROC_CA,
+            &collateral->root_ca_crl,
+            &collateral->root_ca_crl_size) != 0 ||
+        _get_item(
+            OE_SGX_ENDORSEMENT_FIELD_CRL_PCK_CERT,
+            &collateral->pck_crl,
+            &collateral->pck_crl_size) != 0 ||
+        _get_item(
+            OE_SGX_ENDORSEMENT_FIELD_TCB_ISSUER_CHAIN,
+            &collateral->tcb_info_issuer_chain,
+            &collateral->tcb_info_issuer_chain_size) != 0 ||
+        _get_item(
+            OE_SGX_ENDORSEMENT_FIELD_TCB_INFO,
+            &collateral->tcb_info,
+            &collateral->tcb_info_size) != 0 ||
+        _get_item(
+            OE_SGX_ENDORSEMENT_FIELD_QE_ID_ISSUER_CHAIN,
+            &collateral->qe_identity_issuer_chain,
+            &collateral->qe_identity_issuer_chain_size) != 0 ||
+        _get_item(
+            OE_SGX_ENDORSEMENT_FIELD_QE_ID_INFO,
+            &collateral->qe_identity,
+            &collateral->qe_identity_size) != 0)
+    {
+        free(collateral);
+        return SGX_PLAT_ERROR_UNEXPECTED_SERVER_RESPONSE;
+    }
+
+    *pp_qve_collateral = collateral;
+    return SGX_PLAT_ERROR_OK;
+}
+
+void sgx_ql_free_quote_verification_collateral(
+    sgx_ql_qve_collateral_t* p_qve_collateral)
+{
+    free(p_qve_collateral);
+}
+
+sgx_plat_error_t sgx_ql_set_logging_function(sgx_ql_logging_function_t logger)
+{
+    (void)logger;
+    return SGX_PLAT_ERROR_OK;
+}
@@ -0,0 +1,25 @@
+// Copyright (c) Open Enclave SDK contributors.
+// Licensed under the MIT License.
+
+#ifndef _ATTESTATION_PERF_QUOTEPROV_H
+#define _ATTESTATION_PERF_QUOTEPROV_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* Functions of the stub quote provider used by the benchmark, which looks
+ * them up with dlsym() */
+
+/* Set the recorded oe_endorsements_t whose collateral is served. Returns 0
+ * on success */
+typedef int (*perf_quote_provider_set_endorsements_t)(
+    const uint8_t* data,
+    size_t size);
+
+/* The number of sgx_ql_get_quote_verification_collateral() calls so far */
+typedef uint64_t (*perf_quote_provider_get_call_count_t)(void);
+
+int perf_quote_provider_set_endorsements(const uint8_t* data, size_t size);
+uint64_t perf_quote_provider_get_call_count(void);
+
+#endif // _ATTESTATION_PERF_QUOTEPROV_H
@@ -4,10 +4,13 @@
 #include <openenclave/host.h>
 #include <openenclave/internal/tests.h>
 #include <stdio.h>
+#include <stdlib.h>
 
 #if defined(_WIN32)
 #include <ShlObj.h>
 #include <Windows.h>
+#else
+#include <time.h>
 #endif
 
 #include "../../../host/sgx/quote.h"
@@ -16,6 +19,74 @@
 
 #define SKIP_RETURN_CODE 2
 
+#define BENCHMARK_BATCH_SIZE 256
+
+static double _get_time_in_seconds(void)
+{
+#if defined(_WIN32)
+    LARGE_INTEGER frequency;
+    LARGE_INTEGER current_time;
+    QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&current_time);
+    return (double)current_time.QuadPart / (double)frequency.QuadPart;
+#else
+    struct timespec current_time;
+    clock_gettime(CLOCK_MONOTONIC, &current_time);
+    return (double)current_time.tv_sec + (double)current_time.tv_nsec / 1e9;
+#endif
+}
+
+// Measure the throughput of oe_verify_evidence_batch() over a burst of copies
+// of the evidence, serially and with one thread per processor.
+static void _benchmark_verify_evidence_batch(
+    const uint8_t* evidence,
+    size_t evidence_size,
+    const uint8_t* endorsements,
+    size_t endorsements_size)
+{
+    const size_t thread_counts[] = {1, 0};
+    oe_evidence_batch_item_t* items = (oe_evidence_batch_item_t*)calloc(
+        BENCHMARK_BATCH_SIZE, sizeof(*items));
+
+    OE_TEST(items != NULL);
+
+    for (size_t i = 0; i < BENCHMARK_BATCH_SIZE; i++)
+    {
+        items[i].evidence_buffer = evidence;
+        items[i].evidence_buffer_size = evidence_size;
+        items[i].endorsements_buffer = endorsements;
+        items[i].endorsements_buffer_size = endorsements_size;
+    }
+
+    for (size_t t = 0; t < OE_COUNTOF(thread_counts); t++)
+    {
+        double start = _get_time_in_seconds();
+        OE_TEST(
+            oe_verify_evidence_batch(
+                items, BENCHMARK_BATCH_SIZE, NULL, 0, thread_counts[t]) ==
+            OE_OK);
+        double elapsed = _get_time_in_seconds() - start;
+
+        for (size_t i = 0; i < BENCHMARK_BATCH_SIZE; i++)
+        {
+            OE_TEST(items[i].result == OE_OK);
+            OE_TEST(
+                oe_free_claims_list(items[i].claims, items[i].claims_length) ==
+                OE_OK);
+        }
+
+        printf(
+            "oe_verify_evidence_batch(threads=%s): %d items in %.3f s "
+            "(%.1f items/s)\n",
+            thread_counts[t] ? "1" : "auto",
+            BENCHMARK_BATCH_SIZE,
+            elapsed,
+            elapsed > 0 ? BENCHMARK_BATCH_SIZE / elapsed : 0);
+    }
+
+    free(items);
+}
+
 void host_verify(
     uint8_t* evidence,
     size_t evidence_size,
@@ -31,6 +102,9 @@ void host_verify(
         test_claims,
         NUM_TEST_CLAIMS,
         false);
+
+    _benchmark_verify_evidence_batch(
+        evidence, evidence_size, endorsements, endorsements_size);
 }
 
 int main(int argc, const char* argv[])
@@ -292,6 +292,130 @@ static void _test_verify_evidence_fail()
     OE_TEST(oe_free_endorsements(endorsements) == OE_OK);
 }
 
+#ifndef OE_BUILD_ENCLAVE
+
+#define BATCH_SIZE 64
+
+static void _run_verify_evidence_batch(
+    oe_evidence_batch_item_t* items,
+    size_t max_threads)
+{
+    OE_TEST(
+        oe_verify_evidence_batch(items, BATCH_SIZE, NULL, 0, max_threads) ==
+        OE_OK);
+
+    for (size_t i = 0; i < BATCH_SIZE; i++)
+    {
+        switch (i % 4)
+        {
+            case 0:
+            case 1:
+                OE_TEST(items[i].result == OE_OK);
+                OE_TEST(_check_claims(items[i].claims, items[i].claims_length));
+                OE_TEST(
+                    oe_free_claims_list(
+                        items[i].claims, items[i].claims_length) == OE_OK);
+                break;
+            case 2:
+                OE_TEST(items[i].result == OE_CONSTRAINT_FAILED);
+                OE_TEST(items[i].claims == NULL);
+                break;
+            case 3:
+                OE_TEST(items[i].result == OE_INVALID_PARAMETER);
+                OE_TEST(items[i].claims == NULL);
+                break;
+        }
+    }
+}
+
+static void _test_verify_evidence_batch()
+{
+    printf("====== running _test_verify_evidence_batch\n");
+
+    uint8_t* evidence1;
+    size_t evidence1_size;
+    uint8_t* endorsements1;
+    size_t endorsements1_size;
+    uint8_t* evidence2;
+    size_t evidence2_size;
+    oe_evidence_batch_item_t items[BATCH_SIZE];
+
+    OE_TEST(
+        oe_get_evidence(
+            &mock_attester1.base.format_id,
+            0,
+            NULL,
+            0,
+            NULL,
+            0,
+            &evidence1,
+            &evidence1_size,
+            &endorsements1,
+            &endorsements1_size) == OE_OK);
+
+    OE_TEST(
+        oe_get_evidence(
+            &mock_attester2.base.format_id,
+            0,
+            NULL,
+            0,
+            NULL,
+            0,
+            &evidence2,
+            &evidence2_size,
+            NULL,
+            NULL) == OE_OK);
+
+    // Interleave valid evidence, with and without endorsements, with
+    // evidence that does not match its endorsements and with evidence of
+    // the wrong size.
+    memset(items, 0, sizeof(items));
+    for (size_t i = 0; i < BATCH_SIZE; i++)
+    {
+        switch (i % 4)
+        {
+            case 0:
+                items[i].evidence_buffer = evidence1;
+                items[i].evidence_buffer_size = evidence1_size;
+                items[i].endorsements_buffer = endorsements1;
+                items[i].endorsements_buffer_size = endorsements1_size;
+                break;
+            case 1:
+                items[i].evidence_buffer = evidence2;
+                items[i].evidence_buffer_size = evidence2_size;
+                break;
+            case 2:
+                items[i].evidence_buffer = evidence2;
+                items[i].evidence_buffer_size = evidence2_size;
+                items[i].endorsements_buffer = endorsements1;
+                items[i].endorsements_buffer_size = endorsements1_size;
+                break;
+            case 3:
+                items[i].evidence_buffer = evidence1;
+                items[i].evidence_buffer_size = 0;
+                break;
+        }
+    }
+
+    // Serially, with a few threads and with one thread per processor.
+    _run_verify_evidence_batch(items, 1);
+    _run_verify_evidence_batch(items, 4);
+    _run_verify_evidence_batch(items, 0);
+
+    OE_TEST(oe_verify_evidence_batch(NULL, 0, NULL, 0, 0) == OE_OK);
+    OE_TEST(
+        oe_verify_evidence_batch(NULL, 1, NULL, 0, 0) == OE_INVALID_PARAMETER);
+    OE_TEST(
+        oe_verify_evidence_batch(items, BATCH_SIZE, NULL, 1, 0) ==
+        OE_INVALID_PARAMETER);
+
+    OE_TEST(oe_free_evidence(evidence1) == OE_OK);
+    OE_TEST(oe_free_endorsements(endorsements1) == OE_OK);
+    OE_TEST(oe_free_evidence(evidence2) == OE_OK);
+}
+
+#endif // !OE_BUILD_ENCLAVE
+
 void test_runtime()
 {
     printf("====== running test_runtime\n");
@@ -311,6 +435,11 @@ void test_runtime()
     _test_get_evidence_fail();
     _test_verify_evidence_fail();
 
+#ifndef OE_BUILD_ENCLAVE
+    // Test batch verification, which is only available on the host.
+    _test_verify_evidence_batch();
+#endif
+
     // Test unregister functions
     _test_and_unregister_attester();
     _test_and_unregister_verifier();
@@ -458,6 +587,68 @@ static void _test_time_policy(
             &claims_size) == OE_VERIFY_FAILED_TO_FIND_VALIDITY_PERIOD);
 }
 
+static void _test_contiguous_claims(
+    const uint8_t* evidence,
+    size_t evidence_size,
+    const uint8_t* endorsements,
+    size_t endorsements_size,
+    const oe_claim_t* expected_claims,
+    size_t expected_claims_size)
+{
+    oe_policy_t policy = {OE_POLICY_CONTIGUOUS_CLAIMS, NULL, 0};
+    oe_claim_t* claims = NULL;
+    size_t claims_size = 0;
+    const uint8_t* next = NULL;
+
+    printf("====== running _test_contiguous_claims\n");
+
+    OE_TEST(
+        oe_verify_evidence(
+            evidence,
+            evidence_size,
+            endorsements,
+            endorsements_size,
+            &policy,
+            1,
+            &claims,
+            &claims_size) == OE_OK);
+
+    // The claims are the same as those returned by default. Their values
+    // follow the claims array one after another, separated at most by the
+    // copied name and the alignment.
+    OE_TEST(claims_size == expected_claims_size);
+    next = (const uint8_t*)(claims + claims_size);
+    for (size_t i = 0; i < claims_size; i++)
+    {
+        OE_TEST(strcmp(claims[i].name, expected_claims[i].name) == 0);
+        OE_TEST(claims[i].value_size == expected_claims[i].value_size);
+        OE_TEST(
+            memcmp(
+                claims[i].value,
+                expected_claims[i].value,
+                claims[i].value_size) == 0);
+        OE_TEST(
+            claims[i].value >= next &&
+            claims[i].value <= next + strlen(claims[i].name) + 8);
+        next = claims[i].value + claims[i].value_size;
+    }
+
+    OE_TEST(oe_free_claims_list(claims, claims_size) == OE_OK);
+
+    // The policy has no data.
+    policy.policy_size = 1;
+    OE_TEST(
+        oe_verify_evidence(
+            evidence,
+            evidence_size,
+            endorsements,
+            endorsements_size,
+            &policy,
+            1,
+            &claims,
+            &claims_size) == OE_INVALID_PARAMETER);
+}
+
 void verify_sgx_evidence(
     const uint8_t* evidence,
     size_t evidence_size,
@@ -589,6 +780,15 @@ void verify_sgx_evidence(
                                      custom_claims[i].value_size) == 0);
         }
     }
+
+    _test_contiguous_claims(
+        evidence,
+        evidence_size,
+        endorsements,
+        endorsements_size,
+        claims,
+        claims_size);
+
     OE_TEST(oe_free_claims_list(claims, claims_size) == OE_OK);
 
     // Test sgx_remote_evidence with tampered claims in evidence
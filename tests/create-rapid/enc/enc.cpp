@@ -9,6 +9,38 @@ int test(int arg)
     return arg * 2;
 }
 
+#if defined(__x86_64__)
+static uint64_t _illegal_instruction_handler(oe_exception_record_t* record)
+{
+    if (record->code != OE_EXCEPTION_ILLEGAL_INSTRUCTION)
+        return OE_EXCEPTION_CONTINUE_SEARCH;
+
+    // Skip the ud2 instruction.
+    record->context->rip += 2;
+    return OE_EXCEPTION_CONTINUE_EXECUTION;
+}
+#endif
+
+// Raise and handle count illegal instruction exceptions. Returns the number
+// of exceptions handled, or -1 on failure.
+int raise_exceptions(int count)
+{
+#if defined(__x86_64__)
+    if (oe_add_vectored_exception_handler(
+            false, _illegal_instruction_handler) != OE_OK)
+        return -1;
+
+    for (int i = 0; i < count; i++)
+        asm volatile("ud2" ::: "memory");
+
+    if (oe_remove_vectored_exception_handler(_illegal_instruction_handler) !=
+        OE_OK)
+        return -1;
+#endif
+
+    return count;
+}
+
 OE_SET_ENCLAVE_SGX(
     1,    /* ProductID */
     1,    /* SecurityVersion */
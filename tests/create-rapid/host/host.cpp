@@ -5,7 +5,9 @@
 #include <openenclave/internal/calls.h>
 #include <openenclave/internal/error.h>
 #include <openenclave/internal/tests.h>
+#include <chrono>
 #include <cstdio>
+#include <atomic>
 #include <cstdlib>
 #include <thread>
 #include <vector>
@@ -14,6 +16,11 @@
 #define MAX_ENCLAVES 200
 #define MAX_SIMULTANEOUS_ENCLAVES 16
 #define MAX_THREADS 8
+#define STRESS_THREADS 16
+#define STRESS_ENCLAVES_PER_THREAD 8
+#define STRESS_ROUNDS 4
+#define EXCEPTION_ENCLAVES 4
+#define EXCEPTIONS_PER_CALL 64
 
 static void _launch_enclave(const char* path, uint32_t flags, bool call_enclave)
 {
@@ -140,6 +147,122 @@ static void _test_multithreaded(
         thread.join();
 }
 
+static void _stress_thread(const char* path, uint32_t flags)
+{
+    oe_enclave_t* enclaves[STRESS_ENCLAVES_PER_THREAD];
+
+    for (int round = 0; round < STRESS_ROUNDS; round++)
+    {
+        for (int i = 0; i < STRESS_ENCLAVES_PER_THREAD; i++)
+        {
+            oe_result_t result = oe_create_create_rapid_enclave(
+                path, OE_ENCLAVE_TYPE_SGX, flags, NULL, 0, &enclaves[i]);
+
+            if (result != OE_OK)
+                oe_put_err(
+                    "oe_create_create_rapid_enclave(): result=%u", result);
+        }
+
+        for (int i = 0; i < STRESS_ENCLAVES_PER_THREAD; i++)
+        {
+            int return_value;
+            OE_TEST(test(enclaves[i], &return_value, i) == OE_OK);
+            OE_TEST(return_value == 2 * i);
+        }
+
+        for (int i = 0; i < STRESS_ENCLAVES_PER_THREAD; i++)
+            OE_TEST(oe_terminate_enclave(enclaves[i]) == OE_OK);
+    }
+}
+
+// Create, call and terminate enclaves from many threads at once, with up to
+// STRESS_THREADS * STRESS_ENCLAVES_PER_THREAD enclaves alive in the process,
+// and report the creation throughput.
+static void _test_concurrent_stress(const char* path, uint32_t flags)
+{
+    std::vector<std::thread> threads;
+    const int total =
+        STRESS_THREADS * STRESS_ENCLAVES_PER_THREAD * STRESS_ROUNDS;
+    auto start = std::chrono::steady_clock::now();
+
+    for (int i = 0; i < STRESS_THREADS; i++)
+        threads.emplace_back(std::thread(_stress_thread, path, flags));
+
+    for (auto& thread : threads)
+        thread.join();
+
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+                       std::chrono::steady_clock::now() - start)
+                       .count();
+
+    printf(
+        "Created and terminated %d enclaves from %d threads in %lld ms\n",
+        total,
+        STRESS_THREADS,
+        (long long)elapsed);
+}
+
+static void _exception_thread(
+    oe_enclave_t* enclave,
+    const std::atomic<bool>* done)
+{
+    int calls = 0;
+
+    // Run at least one call even if the churn threads finish first.
+    while (!calls++ || !done->load())
+    {
+        int return_value;
+        OE_TEST(
+            raise_exceptions(enclave, &return_value, EXCEPTIONS_PER_CALL) ==
+            OE_OK);
+        OE_TEST(return_value == EXCEPTIONS_PER_CALL);
+    }
+}
+
+// Raise and handle enclave exceptions continuously while other threads create
+// and terminate enclaves, so that the host exception handler looks up the
+// faulting enclave while registry entries are being added and removed.
+static void _test_terminate_during_exception(const char* path, uint32_t flags)
+{
+    oe_enclave_t* enclaves[EXCEPTION_ENCLAVES];
+    std::vector<std::thread> exception_threads;
+    std::vector<std::thread> churn_threads;
+    std::atomic<bool> done(false);
+
+    if (flags & OE_ENCLAVE_FLAG_SIMULATE)
+    {
+        printf("Skipped terminate-during-exception test in simulation mode\n");
+        return;
+    }
+
+    for (int i = 0; i < EXCEPTION_ENCLAVES; i++)
+    {
+        oe_result_t result = oe_create_create_rapid_enclave(
+            path, OE_ENCLAVE_TYPE_SGX, flags, NULL, 0, &enclaves[i]);
+
+        if (result != OE_OK)
+            oe_put_err("oe_create_create_rapid_enclave(): result=%u", result);
+    }
+
+    for (int i = 0; i < EXCEPTION_ENCLAVES; i++)
+        exception_threads.emplace_back(
+            std::thread(_exception_thread, enclaves[i], &done));
+
+    for (int i = 0; i < STRESS_THREADS; i++)
+        churn_threads.emplace_back(std::thread(_stress_thread, path, flags));
+
+    for (auto& thread : churn_threads)
+        thread.join();
+
+    done = true;
+
+    for (auto& thread : exception_threads)
+        thread.join();
+
+    for (int i = 0; i < EXCEPTION_ENCLAVES; i++)
+        OE_TEST(oe_terminate_enclave(enclaves[i]) == OE_OK);
+}
+
 int main(int argc, const char* argv[])
 {
     if (argc != 2)
@@ -162,5 +285,11 @@ int main(int argc, const char* argv[])
     _test_multithreaded(argv[1], flags, false);
     _test_multithreaded(argv[1], flags, true);
 
+    // Stress concurrent enclave creation and termination.
+    _test_concurrent_stress(argv[1], flags);
+
+    // Stress enclave exceptions during concurrent creation and termination.
+    _test_terminate_during_exception(argv[1], flags);
+
     return 0;
 }
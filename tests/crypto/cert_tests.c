@@ -0,0 +1,212 @@
+// Copyright (c) Open Enclave SDK contributors.
+// Licensed under the MIT License.
+
+#if defined(OE_BUILD_ENCLAVE)
+#include <openenclave/enclave.h>
+#endif
+
+#include <openenclave/internal/cert.h>
+#include <openenclave/internal/crypto/crl.h>
+#include <openenclave/internal/tests.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "readfile.h"
+#include "tests.h"
+
+/* _CHAIN loads verify_ca_a.cert.pem, verify_ca_b.cert.pem and
+ *     verify_root.cert.pem. Both intermediate CAs have the same name.
+ * _EXPIRED_CHAIN loads verify_expired.cert.pem, an expired root CA
+ * _LEAF loads verify_leaf.cert.pem, issued by verify_ca_b
+ * _REVOKED loads verify_revoked.cert.pem, issued by verify_ca_b
+ * _FORGED loads verify_forged.cert.pem, issued under the name of the
+ *     intermediate CAs with a key that is not in the chain
+ * _UPPER loads verify_upper.cert.pem, issued by verify_ca_a under its name
+ *     in upper case PrintableString
+ * _SPACED loads verify_spaced.cert.pem, issued by verify_ca_a under its name
+ *     with a doubled space
+ * _WEAK loads verify_weak.cert.pem, a 1024-bit RSA key issued by verify_ca_a
+ * _SHA1 loads verify_sha1.cert.pem, signed by verify_ca_a with SHA-1
+ * _EXPIRED_LEAF loads verify_expired_leaf.cert.pem, issued by the expired CA
+ * _ROOT_CRL loads verify_root.crl.der, which revokes nothing
+ * _CA_B_CRL loads verify_ca_b.crl.der, which revokes verify_revoked.cert.pem
+ */
+
+static char _CHAIN[max_cert_chains_size];
+static char _EXPIRED_CHAIN[max_cert_size];
+static char _LEAF[max_cert_size];
+static char _REVOKED[max_cert_size];
+static char _FORGED[max_cert_size];
+static char _UPPER[max_cert_size];
+static char _SPACED[max_cert_size];
+static char _WEAK[max_cert_size];
+static char _SHA1[max_cert_size];
+static char _EXPIRED_LEAF[max_cert_size];
+static uint8_t _ROOT_CRL[max_cert_size];
+static uint8_t _CA_B_CRL[max_cert_size];
+static size_t _root_crl_size;
+static size_t _ca_b_crl_size;
+
+/* Verify cert_pem against chain_pem with the CRLs of the root CA and of
+ * verify_ca_b when with_crls is true */
+static oe_result_t _verify(
+    const char* cert_pem,
+    const char* chain_pem,
+    bool with_crls)
+{
+    oe_result_t r;
+    oe_cert_t cert;
+    oe_cert_chain_t chain;
+    oe_crl_t root_crl;
+    oe_crl_t ca_crl;
+    const oe_crl_t* crls[] = {&ca_crl, &root_crl};
+
+    r = oe_cert_read_pem(&cert, cert_pem, strlen(cert_pem) + 1);
+    OE_TEST(r == OE_OK);
+
+    r = oe_cert_chain_read_pem(&chain, chain_pem, strlen(chain_pem) + 1);
+    OE_TEST(r == OE_OK);
+
+    OE_TEST(oe_crl_read_der(&root_crl, _ROOT_CRL, _root_crl_size) == OE_OK);
+    OE_TEST(oe_crl_read_der(&ca_crl, _CA_B_CRL, _ca_b_crl_size) == OE_OK);
+
+    r = oe_cert_verify(
+        &cert, &chain, with_crls ? crls : NULL, with_crls ? 2 : 0);
+
+    OE_TEST(oe_crl_free(&ca_crl) == OE_OK);
+    OE_TEST(oe_crl_free(&root_crl) == OE_OK);
+    oe_cert_chain_free(&chain);
+    oe_cert_free(&cert);
+
+    return r;
+}
+
+static void _test_verify_issuer_by_signature(void)
+{
+    printf("=== begin %s()\n", __FUNCTION__);
+
+    /* verify_ca_a comes first in the chain and has the issuer's name, but
+     * did not sign the leaf */
+    OE_TEST(_verify(_LEAF, _CHAIN, false) == OE_OK);
+    OE_TEST(_verify(_LEAF, _CHAIN, true) == OE_OK);
+
+    printf("=== passed %s()\n", __FUNCTION__);
+}
+
+static void _test_verify_revoked(void)
+{
+    printf("=== begin %s()\n", __FUNCTION__);
+
+    OE_TEST(_verify(_REVOKED, _CHAIN, false) == OE_OK);
+    OE_TEST(_verify(_REVOKED, _CHAIN, true) == OE_VERIFY_REVOKED);
+
+    printf("=== passed %s()\n", __FUNCTION__);
+}
+
+static void _test_verify_forged(void)
+{
+    printf("=== begin %s()\n", __FUNCTION__);
+
+    OE_TEST(_verify(_FORGED, _CHAIN, false) == OE_VERIFY_FAILED);
+    OE_TEST(_verify(_FORGED, _CHAIN, true) == OE_VERIFY_FAILED);
+
+    printf("=== passed %s()\n", __FUNCTION__);
+}
+
+static void _test_verify_expired_issuer(void)
+{
+    printf("=== begin %s()\n", __FUNCTION__);
+
+    oe_result_t r;
+    oe_cert_t cert;
+    oe_cert_chain_t chain;
+
+    OE_TEST(
+        oe_cert_read_pem(&cert, _EXPIRED_LEAF, strlen(_EXPIRED_LEAF) + 1) ==
+        OE_OK);
+
+    r = oe_cert_chain_read_pem(
+        &chain, _EXPIRED_CHAIN, strlen(_EXPIRED_CHAIN) + 1);
+
+    /* The host rejects the expired root when the chain is read, the enclave
+     * when a certificate is verified with it */
+#if defined(OE_BUILD_ENCLAVE)
+    OE_TEST(r == OE_OK);
+    OE_TEST(oe_cert_verify(&cert, &chain, NULL, 0) == OE_VERIFY_FAILED);
+    oe_cert_chain_free(&chain);
+#else
+    OE_TEST(r == OE_VERIFY_FAILED);
+#endif
+
+    oe_cert_free(&cert);
+
+    printf("=== passed %s()\n", __FUNCTION__);
+}
+
+static void _test_verify_issuer_name_encodings(void)
+{
+    printf("=== begin %s()\n", __FUNCTION__);
+
+    /* UTF8String and PrintableString names match regardless of case */
+    OE_TEST(_verify(_UPPER, _CHAIN, false) == OE_OK);
+
+#if defined(OE_BUILD_ENCLAVE)
+    /* Like mbedtls, the enclave does not fold spaces in names, which
+     * OpenSSL on the host does */
+    OE_TEST(_verify(_SPACED, _CHAIN, false) == OE_VERIFY_FAILED);
+#endif
+
+    printf("=== passed %s()\n", __FUNCTION__);
+}
+
+#if defined(OE_BUILD_ENCLAVE)
+/* The enclave accepts what the default profile of mbedtls does. The host
+ * follows the security level of OpenSSL, which depends on its version. */
+static void _test_verify_profile(void)
+{
+    printf("=== begin %s()\n", __FUNCTION__);
+
+    OE_TEST(_verify(_WEAK, _CHAIN, false) == OE_VERIFY_FAILED);
+    OE_TEST(_verify(_SHA1, _CHAIN, false) == OE_VERIFY_FAILED);
+
+    printf("=== passed %s()\n", __FUNCTION__);
+}
+#endif
+
+void TestCertVerify(void)
+{
+    OE_TEST(
+        read_chains(
+            "../data/verify_ca_a.cert.pem",
+            "../data/verify_ca_b.cert.pem",
+            "../data/verify_root.cert.pem",
+            _CHAIN,
+            OE_COUNTOF(_CHAIN)) == OE_OK);
+    OE_TEST(
+        read_cert("../data/verify_expired.cert.pem", _EXPIRED_CHAIN) == OE_OK);
+    OE_TEST(read_cert("../data/verify_leaf.cert.pem", _LEAF) == OE_OK);
+    OE_TEST(read_cert("../data/verify_revoked.cert.pem", _REVOKED) == OE_OK);
+    OE_TEST(read_cert("../data/verify_forged.cert.pem", _FORGED) == OE_OK);
+    OE_TEST(read_cert("../data/verify_upper.cert.pem", _UPPER) == OE_OK);
+    OE_TEST(read_cert("../data/verify_spaced.cert.pem", _SPACED) == OE_OK);
+    OE_TEST(read_cert("../data/verify_weak.cert.pem", _WEAK) == OE_OK);
+    OE_TEST(read_cert("../data/verify_sha1.cert.pem", _SHA1) == OE_OK);
+    OE_TEST(
+        read_cert("../data/verify_expired_leaf.cert.pem", _EXPIRED_LEAF) ==
+        OE_OK);
+    OE_TEST(
+        read_crl("../data/verify_root.crl.der", _ROOT_CRL, &_root_crl_size) ==
+        OE_OK);
+    OE_TEST(
+        read_crl("../data/verify_ca_b.crl.der", _CA_B_CRL, &_ca_b_crl_size) ==
+        OE_OK);
+
+    _test_verify_issuer_by_signature();
+    _test_verify_revoked();
+    _test_verify_forged();
+    _test_verify_expired_issuer();
+    _test_verify_issuer_name_encodings();
+#if defined(OE_BUILD_ENCLAVE)
+    _test_verify_profile();
+#endif
+}
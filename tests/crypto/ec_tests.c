@@ -172,6 +172,498 @@ static void _test_sign_and_verify()
     printf("=== passed %s()\n", __FUNCTION__);
 }
 
+/* Verify the signature of ALPHABET_HASH, and check that a changed hash or
+ * signature is rejected */
+static void _verify_and_tamper(
+    const oe_ec_public_key_t* key,
+    const uint8_t* signature,
+    size_t signature_size)
+{
+    OE_SHA256 hash = ALPHABET_HASH;
+    uint8_t tampered[max_sign_size + 1];
+    oe_result_t r;
+
+    OE_TEST(signature_size < sizeof(tampered));
+
+    r = oe_ec_public_key_verify(
+        key,
+        OE_HASH_TYPE_SHA256,
+        &hash,
+        sizeof(hash),
+        signature,
+        signature_size);
+    OE_TEST(r == OE_OK);
+
+    hash.buf[sizeof(hash) - 1] ^= 1;
+    r = oe_ec_public_key_verify(
+        key,
+        OE_HASH_TYPE_SHA256,
+        &hash,
+        sizeof(hash),
+        signature,
+        signature_size);
+    OE_TEST(r == OE_VERIFY_FAILED);
+    hash.buf[sizeof(hash) - 1] ^= 1;
+
+    /* Change the last byte of s */
+    memcpy(tampered, signature, signature_size);
+    tampered[signature_size - 1] ^= 1;
+    r = oe_ec_public_key_verify(
+        key,
+        OE_HASH_TYPE_SHA256,
+        &hash,
+        sizeof(hash),
+        tampered,
+        signature_size);
+    OE_TEST(r == OE_VERIFY_FAILED);
+
+    /* Append a byte */
+    tampered[signature_size - 1] ^= 1;
+    tampered[signature_size] = 0;
+    r = oe_ec_public_key_verify(
+        key,
+        OE_HASH_TYPE_SHA256,
+        &hash,
+        sizeof(hash),
+        tampered,
+        signature_size + 1);
+    OE_TEST(r == OE_VERIFY_FAILED);
+}
+
+// Verify with the same keys repeatedly, which the enclave verifies with the
+// cached P-256 tables after the first time, and with more keys than it caches.
+static void _test_verify_repeated()
+{
+    printf("=== begin %s()\n", __FUNCTION__);
+
+    oe_result_t r;
+
+    {
+        oe_ec_public_key_t key = {0};
+        const uint8_t R[] = {1};
+        uint8_t signature[max_sign_size];
+        size_t signature_size = sizeof(signature);
+
+        r = oe_ec_public_key_read_pem(
+            &key, (const uint8_t*)_PUBLIC_KEY, strlen(_PUBLIC_KEY) + 1);
+        OE_TEST(r == OE_OK);
+
+        for (size_t i = 0; i < 4; i++)
+            _verify_and_tamper(&key, _SIGNATURE, sign_size);
+
+        /* s must be below the group order */
+        r = oe_ecdsa_signature_write_der(
+            signature,
+            &signature_size,
+            R,
+            sizeof(R),
+            _P256_GROUP_ORDER,
+            sizeof(_P256_GROUP_ORDER));
+        OE_TEST(r == OE_OK);
+
+        r = oe_ec_public_key_verify(
+            &key,
+            OE_HASH_TYPE_SHA256,
+            &ALPHABET_HASH,
+            sizeof(ALPHABET_HASH),
+            signature,
+            signature_size);
+        OE_TEST(r == OE_VERIFY_FAILED);
+
+        oe_ec_public_key_free(&key);
+    }
+
+    for (size_t i = 0; i < 12; i++)
+    {
+        oe_ec_private_key_t private_key = {0};
+        oe_ec_public_key_t public_key = {0};
+        uint8_t private_raw[32];
+        uint8_t signature[max_sign_size];
+        size_t signature_size = sizeof(signature);
+
+        r = oe_random_internal(private_raw, sizeof(private_raw));
+        OE_TEST(r == OE_OK);
+        private_raw[0] &= 0x7F;
+
+        r = oe_ec_generate_key_pair_from_private(
+            OE_EC_TYPE_SECP256R1,
+            private_raw,
+            sizeof(private_raw),
+            &private_key,
+            &public_key);
+        OE_TEST(r == OE_OK);
+
+        r = oe_ec_private_key_sign(
+            &private_key,
+            OE_HASH_TYPE_SHA256,
+            &ALPHABET_HASH,
+            sizeof(ALPHABET_HASH),
+            signature,
+            &signature_size);
+        OE_TEST(r == OE_OK);
+
+        for (size_t j = 0; j < 3; j++)
+            _verify_and_tamper(&public_key, signature, signature_size);
+
+        oe_ec_private_key_free(&private_key);
+        oe_ec_public_key_free(&public_key);
+    }
+
+    printf("=== passed %s()\n", __FUNCTION__);
+}
+
+typedef struct _ecdsa_vector
+{
+    const char* comment;
+    const char* x;
+    const char* y;
+    const char* hash;
+    const char* r;
+    const char* s;
+    bool valid;
+} ecdsa_vector_t;
+
+/* P-256 ECDSA signatures of hashes, which are not SHA-256 hashes of a message
+ * but chosen to reach the edge cases of verification: r and s at and around
+ * their bounds, u1 = e / s and u2 = r / s at 1, n - 1, small or with few bits
+ * set, u1 * G = u2 * Q, partial sums of u1 * G and u2 * Q that add equal or
+ * opposite points, u1 * G + u2 * Q at infinity or with its x-coordinate in
+ * [n, p) so that it is r + n, and hashes that are not below n. They were
+ * generated for these cases, as the Wycheproof vectors are, and checked with
+ * OpenSSL and mbedTLS.
+ */
+static const ecdsa_vector_t _ECDSA_VECTORS[] = {
+    {"valid",
+     "ee50a4435525e8aa58367ad4e5135e3fe9530b355a9bc1c96153302092db9903",
+     "14331ba620e7231b4e86a96c63e1bb39a2a62d7f546c3bc481bac56f7e4bcd31",
+     "cad08becf72fcc47f15179064388d4eb00290f121a3a8beef515f5fb060e9291",
+     "11f5081613b0bf7bc7b34c888252add6a8a251cf79d99dab1da37cd8b62f6b40",
+     "ca68fcae52a474c62f7313e6b111d380a0f5c9391751ca2a2f93681542c16c21",
+     true},
+    {"s replaced by n - s",
+     "ee50a4435525e8aa58367ad4e5135e3fe9530b355a9bc1c96153302092db9903",
+     "14331ba620e7231b4e86a96c63e1bb39a2a62d7f546c3bc481bac56f7e4bcd31",
+     "cad08becf72fcc47f15179064388d4eb00290f121a3a8beef515f5fb060e9291",
+     "11f5081613b0bf7bc7b34c888252add6a8a251cf79d99dab1da37cd8b62f6b40",
+     "35970350ad5b8b3ad08cec194eee2c7f1bf131748fc5d45ac42662adb9a1b930",
+     true},
+    {"hash modified",
+     "ee50a4435525e8aa58367ad4e5135e3fe9530b355a9bc1c96153302092db9903",
+     "14331ba620e7231b4e86a96c63e1bb39a2a62d7f546c3bc481bac56f7e4bcd31",
+     "cad08becf72fcc47f15179064388d4eb00290f121a3a8beef515f5fb060e9290",
+     "11f5081613b0bf7bc7b34c888252add6a8a251cf79d99dab1da37cd8b62f6b40",
+     "ca68fcae52a474c62f7313e6b111d380a0f5c9391751ca2a2f93681542c16c21",
+     false},
+    {"r = 0",
+     "ee50a4435525e8aa58367ad4e5135e3fe9530b355a9bc1c96153302092db9903",
+     "14331ba620e7231b4e86a96c63e1bb39a2a62d7f546c3bc481bac56f7e4bcd31",
+     "cad08becf72fcc47f15179064388d4eb00290f121a3a8beef515f5fb060e9291",
+     "0000000000000000000000000000000000000000000000000000000000000000",
+     "ca68fcae52a474c62f7313e6b111d380a0f5c9391751ca2a2f93681542c16c21",
+     false},
+    {"s = 0",
+     "ee50a4435525e8aa58367ad4e5135e3fe9530b355a9bc1c96153302092db9903",
+     "14331ba620e7231b4e86a96c63e1bb39a2a62d7f546c3bc481bac56f7e4bcd31",
+     "cad08becf72fcc47f15179064388d4eb00290f121a3a8beef515f5fb060e9291",
+     "11f5081613b0bf7bc7b34c888252add6a8a251cf79d99dab1da37cd8b62f6b40",
+     "0000000000000000000000000000000000000000000000000000000000000000",
+     false},
+    {"r = n",
+     "ee50a4435525e8aa58367ad4e5135e3fe9530b355a9bc1c96153302092db9903",
+     "14331ba620e7231b4e86a96c63e1bb39a2a62d7f546c3bc481bac56f7e4bcd31",
+     "cad08becf72fcc47f15179064388d4eb00290f121a3a8beef515f5fb060e9291",
+     "ffffffff00000000ffffffffffffffffbce6faada7179e84f3b9cac2fc632551",
+     "ca68fcae52a474c62f7313e6b111d380a0f5c9391751ca2a2f93681542c16c21",
+     false},
+    {"s = n",
+     "ee50a4435525e8aa58367ad4e5135e3fe9530b355a9bc1c96153302092db9903",
+     "14331ba620e7231b4e86a96c63e1bb39a2a62d7f546c3bc481bac56f7e4bcd31",
+     "cad08becf72fcc47f15179064388d4eb00290f121a3a8beef515f5fb060e9291",
+     "11f5081613b0bf7bc7b34c888252add6a8a251cf79d99dab1da37cd8b62f6b40",
+     "ffffffff00000000ffffffffffffffffbce6faada7179e84f3b9cac2fc632551",
+     false},
+    {"r = 2^256 - 1",
+     "ee50a4435525e8aa58367ad4e5135e3fe9530b355a9bc1c96153302092db9903",
+     "14331ba620e7231b4e86a96c63e1bb39a2a62d7f546c3bc481bac56f7e4bcd31",
+     "cad08becf72fcc47f15179064388d4eb00290f121a3a8beef515f5fb060e9291",
+     "ffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffff",
+     "ca68fcae52a474c62f7313e6b111d380a0f5c9391751ca2a2f93681542c16c21",
+     false},
+    {"s = 2^256 + s (33 bytes)",
+     "ee50a4435525e8aa58367ad4e5135e3fe9530b355a9bc1c96153302092db9903",
+     "14331ba620e7231b4e86a96c63e1bb39a2a62d7f546c3bc481bac56f7e4bcd31",
+     "cad08becf72fcc47f15179064388d4eb00290f121a3a8beef515f5fb060e9291",
+     "11f5081613b0bf7bc7b34c888252add6a8a251cf79d99dab1da37cd8b62f6b40",
+     "01"
+     "ca68fcae52a474c62f7313e6b111d380a0f5c9391751ca2a2f93681542c16c21",
+     false},
+    {"u1 = 1",
+     "e93f201daf8ababed7f61f0f0017e9e542ae071211d4dc82a685065dffd1c9e1",
+     "de66e3a7b8690eae48d0e61cf2203431547e8376a08a019448f63f20fdb62ec4",
+     "1f15df27634dac82b047a75faf4e60bd7b9c0fae2a31536f0e725390146ff9e0",
+     "c9b9f4d52be1376f915c8e06295da80462f70ce06eaf64ec0591ee83dc75126b",
+     "1f15df27634dac82b047a75faf4e60bd7b9c0fae2a31536f0e725390146ff9e0",
+     true},
+    {"u2 = 1",
+     "77969abbe61cf0221ba4dc2a37397310e6522c9ed592cfba2208446c2e7b3ba8",
+     "9faf1bc92e06e7ae07d3ae305b7f6a9123c94140da949218061bedbd8aa40a5c",
+     "58f59efeb57f07534204b9fac5c008faa1d4e2ebe4062786bade448ed09cf3da",
+     "c12ba17b747bd905d5a4efc8d8caeeaeb50652e5abe438c9750b8d2472ec6f6b",
+     "c12ba17b747bd905d5a4efc8d8caeeaeb50652e5abe438c9750b8d2472ec6f6b",
+     true},
+    {"u1 = n - 1",
+     "84e50ade0e811ccbaafb5d653c21397282a6714bc725e36230acf593d41149c5",
+     "db88c63ef61123f0f06aaa933e5b624cee632791eb81e0d9bc5b923e60607f47",
+     "742cf676614aaa33b28593aaec22698ee1a9d26f5492422f9f739dab595f8d0d",
+     "670afc6b257ff2bb28a37fe7cebad2465bd9e3c3fff37f61c235014f14731b47",
+     "8bd309889eb555cd4d7a6c5513dd9670db3d283e52855c5554462d17a3039844",
+     true},
+    {"u2 = n - 1",
+     "99624c5db53c5c0f8c1ac81e0366f71d868982ff9fcbfecbc84b5932277e4b7c",
+     "bc11daa3fb011c79a14c3b139ab93430559d50a00e2d7f1fa3f132cba58acfc8",
+     "d0a8b58c6b05e49d8f2c6d30b87ef7f235e0c9d6454df528a9cd0828bda29430",
+     "28f4956638b9703cdff9f04608a7042bcaf024c077db8f5bd71a1815b52baa8d",
+     "d70b6a98c7468fc420060fb9f758fbd3f1f6d5ed2f3c0f291c9fb2ad47377ac4",
+     true},
+    {"u1 = u2 = 1",
+     "5cb76b54f11ca99ec212de352d7e97f5d062e7cc7b254806d7435505916f5f15",
+     "eaeacdf0f4e9e2a950a02a454215422f0803202b04971ccfc03172217549f2d7",
+     "d0c55ca04435a9a9d601aec5f650ec598f18cbb44a8f589bc0f579d588cce88d",
+     "d0c55ca04435a9a9d601aec5f650ec598f18cbb44a8f589bc0f579d588cce88d",
+     "d0c55ca04435a9a9d601aec5f650ec598f18cbb44a8f589bc0f579d588cce88d",
+     true},
+    {"u1 = u2 = n - 1",
+     "0569982f242ebd33fcf73be0b2a6532af116281dd920c8e2c8f7a7a95a2d3e13",
+     "3bcbabdbfb36662b9e13dc83640ed7373b7988d7fc6ca1d8873040008caa2fa0",
+     "3082b302b090cd218ffd95ac92d8693f5d5bebffa44d570dd5b15ef4aa15308d",
+     "3082b302b090cd218ffd95ac92d8693f5d5bebffa44d570dd5b15ef4aa15308d",
+     "cf7d4cfc4f6f32df70026a536d2796c05f8b0eae02ca47771e086bce524df4c4",
+     true},
+    {"small u1",
+     "2411b0ab50d410269a16265d053f753e01a76d6c685a210c1ec95242b012f8b9",
+     "6c56ffca1534a386def48d401b8f62ad637dd02f75a8451734c8356a9c2ee095",
+     "a4e28814a805cfb084b93c5fa6cd6a2e3a9a78e712a6d2e28fbc3203f8baa873",
+     "4215e11937131ccb5b016be8de5f54096b853a6452386d6ced5da9a997600af9",
+     "a94ac2d40dd32c7d7534c72792fd13da971c7b92d589a9f34f1933f08bf2b41f",
+     true},
+    {"small u2",
+     "259a65cedf014e03933f9ff6e926360e5f6a5f7594ef5915cf84a6412c768e39",
+     "af342903ff7d4d694aa1063c58c40fdcb4356a003e1542ccb5555701a2cdae24",
+     "fa45639a9d1504c44c3fd1a5ef18a50db6a325d2fbe362f605383fd7c87d1421",
+     "e021acaf09acbce24db580267daf721a52b05c601a036786937fc55019838bce",
+     "e45ebdae05e30f99f992cd15edc19d8d6fe38940259726a1c081c27d8facedae",
+     true},
+    {"u1 = 2^255",
+     "a7a6c9efe7551bd8a4d6364af09847b62eceeefd2b67048f1b8519989c55a193",
+     "d68ebfa0444f7f18b0ee6a8d931905a0411dd8f6067d890c1d24837d90ab5d4c",
+     "38197b19f6e879095ec689e2dc00dacf6f4fe60c41eaf01cfdbd988d436bd678",
+     "90895ec4717aa545c895f6e326067731492a9dd84a5bd4b7bd5be78d8cf78e67",
+     "9268a18193569fdd6e31efdf095d0271b9af1cd2d8d05be7174ef34ae7581dac",
+     true},
+    {"u2 with top and bottom comb bits",
+     "dbb430960467f02c269b80fd4fe83bde1110fac0bfd7505942d5e7b0eb7b4c9f",
+     "475f4d19c721edc64841b8ce0c99c6b2c6fb87cf75edd396292e45f7c8232356",
+     "954e156ff6cff93b1f15b4317228a133500d8865fd38bb223a1fc70a3faf4482",
+     "25edc78d83e4a225d874e28b5c7e053b8fdb938c302ee5fbe6a7be8b651d371c",
+     "09c4311a8a1bac0039333eea09318fa58fb2176cfe380d975717e60702d681e3",
+     true},
+    {"s = 1",
+     "32660e6c92cb58687a59485b3a3cca7a395391d9481e3a9c70369351ee8d4d38",
+     "cedb762806fdd4eb75cc558fcab743e45057f78bbf70dcb10c524bf0da4afd5b",
+     "a19f04029066cdcc4a4a1936b4e96730f806349554db82879d15ccb5cc0cd1ac",
+     "e3bc3185c9a0540847e3ec0dc05acd8b07e1fa92401eb8fdc63cae77482f007d",
+     "0000000000000000000000000000000000000000000000000000000000000001",
+     true},
+    {"s = n - 1",
+     "1cae85729b20bac2eddc04195e5dc608a660f466f2ce1ea5a46b3b223bfc65ab",
+     "5750b51d8a79dd8aebc0dcda6e80148def621c1936ffe1490ffdfcee65bb2e9c",
+     "e01d25e6b3e3665229c90dbd6e23e6ec9e01340a6bcd72f72aef666fb606393f",
+     "447957ecf046b07d7c1a7bc2f91b839c1d8e68e18f5a58aa5f25360e718c0ab1",
+     "ffffffff00000000ffffffffffffffffbce6faada7179e84f3b9cac2fc632550",
+     true},
+    {"hash = n + 1",
+     "8cdc38677d5c53328912d8c198f1ac9a52080ec8dbe886a237ce26fbee0ffc9e",
+     "2707e62317004504fda02fda3e525cd8a4a25e4b771ce7e316c6b6d65b88aafd",
+     "ffffffff00000000ffffffffffffffffbce6faada7179e84f3b9cac2fc632552",
+     "4194d71490768dacb84713252aaf5a75c32af29b3e9e8951f672e34e7b5e7dbd",
+     "1f1321c6baf089abf27d5c9992eafd134c209872898ba8c503657979f1b649be",
+     true},
+    {"hash = 2^256 - 1",
+     "d4f49a36301f856332a62c8dada681908e709b8d0744c5ab4e7bf3cb106df18a",
+     "c5dd2031398ed2631e4348a712a97c95ac587061de0a40a95e13a1751f34594f",
+     "ffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffff",
+     "88b32615e113eab6773baf4ded169a77944988835b1165453cf96ebee5387e7d",
+     "8602f9250a25cdd71be1a0bab6adb4ddbd084441579522c0a4ba8e007cd38289",
+     true},
+    {"u1 G = u2 Q",
+     "794294ec078e2db2421d1bdb4a7d8d8191707f7a26a21aac525968e3b32c990f",
+     "691e11c7c5d41c058a4e7f084b3dc8396a03554e35b58f11c2285235ba4d2e27",
+     "faf580d25368528fcb3f4ba2f8019ccb4051221f9d36901bc3f6f031136356e5",
+     "d0794698be1616b8c768c95133947fe71180860094df7fe0215da93f410a715b",
+     "7ff08253b844350412571727094a649d7e4a2246da5e04c781b8d06d473e9234",
+     true},
+    {"key = G, u1 = u2",
+     "6b17d1f2e12c4247f8bce6e563a440f277037d812deb33a0f4a13945d898c296",
+     "4fe342e2fe1a7f9b8ee7eb4a7c0f9e162bce33576b315ececbb6406837bf51f5",
+     "d2949e86414625b8b0b58103971bdadc3c53a4bfafa460087a681c60f76c8339",
+     "d2949e86414625b8b0b58103971bdadc3c53a4bfafa460087a681c60f76c8339",
+     "e9e216a3ec3ec5569f2e29c438ca7253669878d40b7aeac891cf6974e90e0c63",
+     true},
+    {"key = G",
+     "6b17d1f2e12c4247f8bce6e563a440f277037d812deb33a0f4a13945d898c296",
+     "4fe342e2fe1a7f9b8ee7eb4a7c0f9e162bce33576b315ececbb6406837bf51f5",
+     "976bd21059d6f1ccd9513f563e827bd85d6e4cb35e936bcdd3bca321410513d5",
+     "94cef157db17543a5e276d8866f9ab15f4492dc08da79f6c1368ecd5d07f9157",
+     "5dd9ec4067ff269e921af1d137cf4e4905e025cda9753efc5b329d965f5ea34d",
+     true},
+    {"key = -G, u1 and u2 with the same top bits",
+     "6b17d1f2e12c4247f8bce6e563a440f277037d812deb33a0f4a13945d898c296",
+     "b01cbd1c01e58065711814b583f061e9d431cca994cea1313449bf97c840ae0a",
+     "199ad1ab314748943dfed03630ccf5d569b89e5985b0ba234d2754b8dd05ae24",
+     "a85b3aad6f3a346d85523141cb434e1caf4c642b2b3cc952cb07a635cb6a1df1",
+     "c3a41af4e11c096bc17bccf478dffc1b93e0863a583502621a393c7beba1687a",
+     true},
+    {"u1 G + u2 Q at infinity",
+     "9975bf812e3ead45f6bcca14656a9071b8e5c3980f9b743194db8ea8ccd816fb",
+     "c943cc8b5a76239a1017085426eaccd9c57fb410c1727ab64e0d3ea9d22d3ebf",
+     "e817785d5a8ee1036aead5d969d9af471d561d2df4074ec80d5bd48f8e78357f",
+     "45edda6dc32e75da946b0b0a8cc8192b26b55b6288ee603ebbe87ae5e57fc84e",
+     "57bc37c37dc2d21f901e160c14a8f66092223927fd59461adbb9a3879e75f3d1",
+     false},
+    {"R.x = r + n",
+     "20628c6839c7502c287c7f2358735afba6c9565c471b2de1c6114be6aface5fb",
+     "860b3137ed587b535f093fb1c830a2258c5f89f2c41258e504993444830d1b2d",
+     "487a0abdfaec37bcc7f1be52e8fde10d38113c3769147ae3f70130fb1dfd619c",
+     "0000000000000000000000000000000000000000000000000000000000000003",
+     "1043e9d623c03d1899004bb57d3fd31cc27d551ad823800c9077551b4d851b3f",
+     true},
+    {"R.x = r + n, r not reduced",
+     "20628c6839c7502c287c7f2358735afba6c9565c471b2de1c6114be6aface5fb",
+     "860b3137ed587b535f093fb1c830a2258c5f89f2c41258e504993444830d1b2d",
+     "487a0abdfaec37bcc7f1be52e8fde10d38113c3769147ae3f70130fb1dfd619c",
+     "ffffffff00000000ffffffffffffffffbce6faada7179e84f3b9cac2fc632554",
+     "1043e9d623c03d1899004bb57d3fd31cc27d551ad823800c9077551b4d851b3f",
+     false},
+    {"R.x = r + n, hash modified",
+     "20628c6839c7502c287c7f2358735afba6c9565c471b2de1c6114be6aface5fb",
+     "860b3137ed587b535f093fb1c830a2258c5f89f2c41258e504993444830d1b2d",
+     "487a0abdfaec37bcc7f1be52e8fde10d38113c3769147ae3f70130fb1dfd619d",
+     "0000000000000000000000000000000000000000000000000000000000000003",
+     "1043e9d623c03d1899004bb57d3fd31cc27d551ad823800c9077551b4d851b3f",
+     false},
+    {"small r",
+     "da06377c7459087f8361a0ae003912bf6d8dfd4c002c80c5c9783e7ee05d9014",
+     "0eebb767d987885a47a85e36f4e4c7ef48c111b783099849175ce44476be0d44",
+     "78f471e89fbdb4904a6e43454b1189f012275b33abc1e482c3eee3ea646cf3ed",
+     "0000000000000000000000000000000000000000000000000000000000000005",
+     "f760a712c36f1de485a9fdc8905db44fcf46caab6f40d3900493a30dd2dbb831",
+     true},
+    {"R.x = r + n - p",
+     "31b798255eb7005d35982d9884d3ab57fd0ad55f1283daf4067e66bc7170a16b",
+     "c9a8bd210ea316fb37ad395b936776dc4bcf94b2843979533fa58c83aaa0ddee",
+     "78f471e89fbdb4904a6e43454b1189f012275b33abc1e482c3eee3ea646cf3ed",
+     "000000000000000000000000000000004319055358e8617b0c46353d039cdab3",
+     "f760a712c36f1de485a9fdc8905db44fcf46caab6f40d3900493a30dd2dbb831",
+     false},
+};
+
+#if defined(OE_BUILD_ENCLAVE)
+/* The enclave, like mbedTLS, verifies the leftmost 32 bytes of longer hashes,
+ * which the host rejects, and rejects the signatures of hashes e = 0 mod n,
+ * which do not depend on the private key. */
+static const ecdsa_vector_t _ECDSA_ENCLAVE_VECTORS[] = {
+    {"hash of 64 bytes, truncated",
+     "ee50a4435525e8aa58367ad4e5135e3fe9530b355a9bc1c96153302092db9903",
+     "14331ba620e7231b4e86a96c63e1bb39a2a62d7f546c3bc481bac56f7e4bcd31",
+     "cad08becf72fcc47f15179064388d4eb00290f121a3a8beef515f5fb060e9291"
+     "abababababababababababababababababababababababababababababababab",
+     "11f5081613b0bf7bc7b34c888252add6a8a251cf79d99dab1da37cd8b62f6b40",
+     "ca68fcae52a474c62f7313e6b111d380a0f5c9391751ca2a2f93681542c16c21",
+     true},
+    {"hash = 0",
+     "7c9049ab76a372b599afcba67795a4691e9a6e74d68665bd54c383191c32e0e0",
+     "8e51a16f34ecc555d983aadd67a4b10dca1fbecd90f4caaf441db2faccf1f728",
+     "0000000000000000000000000000000000000000000000000000000000000000",
+     "63e6f87a8aa1cf40655f10c95b9e7b19d3fe2923afa6302fbf4741bc70706aaa",
+     "fe9323c94ddeb893a3ea331e166c5fdc230215c44e4ffc1a5dc0e83a472dfb09",
+     false},
+    {"hash = n",
+     "7c9049ab76a372b599afcba67795a4691e9a6e74d68665bd54c383191c32e0e0",
+     "8e51a16f34ecc555d983aadd67a4b10dca1fbecd90f4caaf441db2faccf1f728",
+     "ffffffff00000000ffffffffffffffffbce6faada7179e84f3b9cac2fc632551",
+     "63e6f87a8aa1cf40655f10c95b9e7b19d3fe2923afa6302fbf4741bc70706aaa",
+     "fe9323c94ddeb893a3ea331e166c5fdc230215c44e4ffc1a5dc0e83a472dfb09",
+     false},
+};
+#endif
+
+static void _test_ecdsa_vector(const ecdsa_vector_t* vector)
+{
+    oe_ec_public_key_t key = {0};
+    uint8_t x[32];
+    uint8_t y[32];
+    uint8_t hash[64];
+    uint8_t r[33];
+    uint8_t s[33];
+    uint8_t signature[max_sign_size];
+    size_t signature_size = sizeof(signature);
+    const size_t hash_size = strlen(vector->hash) / 2;
+
+    hex_to_buf(vector->x, x, sizeof(x));
+    hex_to_buf(vector->y, y, sizeof(y));
+    hex_to_buf(vector->hash, hash, sizeof(hash));
+    hex_to_buf(vector->r, r, sizeof(r));
+    hex_to_buf(vector->s, s, sizeof(s));
+
+    OE_TEST(
+        oe_ec_public_key_from_coordinates(
+            &key, OE_EC_TYPE_SECP256R1, x, sizeof(x), y, sizeof(y)) == OE_OK);
+
+    OE_TEST(
+        oe_ecdsa_signature_write_der(
+            signature,
+            &signature_size,
+            r,
+            strlen(vector->r) / 2,
+            s,
+            strlen(vector->s) / 2) == OE_OK);
+
+    /* The enclave caches the table of the key the second time */
+    for (size_t i = 0; i < 2; i++)
+    {
+        oe_result_t result = oe_ec_public_key_verify(
+            &key,
+            OE_HASH_TYPE_SHA256,
+            hash,
+            hash_size,
+            signature,
+            signature_size);
+
+        if (result != (vector->valid ? OE_OK : OE_VERIFY_FAILED))
+        {
+            printf("%s: %s\n", vector->comment, oe_result_str(result));
+            OE_TEST(false);
+        }
+    }
+
+    oe_ec_public_key_free(&key);
+}
+
+static void _test_verify_vectors()
+{
+    printf("=== begin %s()\n", __FUNCTION__);
+
+    for (size_t i = 0; i < OE_COUNTOF(_ECDSA_VECTORS); i++)
+        _test_ecdsa_vector(&_ECDSA_VECTORS[i]);
+
+#if defined(OE_BUILD_ENCLAVE)
+    for (size_t i = 0; i < OE_COUNTOF(_ECDSA_ENCLAVE_VECTORS); i++)
+        _test_ecdsa_vector(&_ECDSA_ENCLAVE_VECTORS[i]);
+#endif
+
+    printf("=== passed %s()\n", __FUNCTION__);
+}
+
 static void _verify_generated_keys(
     const oe_ec_private_key_t* private_key,
     const oe_ec_public_key_t* public_key)
@@ -660,6 +1152,194 @@ static void _test_key_from_bytes()
     printf("=== passed %s()\n", __FUNCTION__);
 }
 
+#if defined(OE_BUILD_ENCLAVE)
+static void _test_share_keys()
+{
+    printf("=== begin %s()\n", __FUNCTION__);
+
+    oe_result_t r;
+    oe_ec_private_key_t private_key = {0};
+    oe_ec_private_key_t private_key2 = {0};
+    oe_ec_public_key_t public_key = {0};
+    oe_ec_public_key_t public_key2 = {0};
+    uint8_t signature[1024];
+    size_t signature_size = sizeof(signature);
+    bool equal = false;
+
+    r = oe_ec_private_key_read_pem(
+        &private_key, (const uint8_t*)_PRIVATE_KEY, private_key_size + 1);
+    OE_TEST(r == OE_OK);
+
+    r = oe_ec_public_key_from_coordinates(
+        &public_key, OE_EC_TYPE_SECP256R1, x_data, x_size, y_data, y_size);
+    OE_TEST(r == OE_OK);
+
+    /* A key cannot be shared into its own handle */
+    OE_TEST(
+        oe_ec_public_key_share(&public_key, &public_key) ==
+        OE_INVALID_PARAMETER);
+    OE_TEST(oe_ec_public_key_share(NULL, &public_key2) == OE_INVALID_PARAMETER);
+
+    OE_TEST(oe_ec_private_key_share(&private_key, &private_key2) == OE_OK);
+    OE_TEST(oe_ec_public_key_share(&public_key, &public_key2) == OE_OK);
+
+    r = oe_ec_public_key_equal(&public_key, &public_key2, &equal);
+    OE_TEST(r == OE_OK);
+    OE_TEST(equal);
+
+    /* The shared handles keep the keys after the first handles are freed */
+    OE_TEST(oe_ec_private_key_free(&private_key) == OE_OK);
+    OE_TEST(oe_ec_public_key_free(&public_key) == OE_OK);
+
+    r = oe_ec_private_key_sign(
+        &private_key2,
+        OE_HASH_TYPE_SHA256,
+        &ALPHABET_HASH,
+        sizeof(ALPHABET_HASH),
+        signature,
+        &signature_size);
+    OE_TEST(r == OE_OK);
+
+    r = oe_ec_public_key_verify(
+        &public_key2,
+        OE_HASH_TYPE_SHA256,
+        &ALPHABET_HASH,
+        sizeof(ALPHABET_HASH),
+        signature,
+        signature_size);
+    OE_TEST(r == OE_OK);
+
+    OE_TEST(oe_ec_private_key_free(&private_key2) == OE_OK);
+    OE_TEST(oe_ec_public_key_free(&public_key2) == OE_OK);
+
+    printf("=== passed %s()\n", __FUNCTION__);
+}
+
+/* More than one batch of the nonces that are inverted together */
+#define BATCH_COUNT 40
+
+static void _test_batch_sign_and_verify()
+{
+    printf("=== begin %s()\n", __FUNCTION__);
+
+    oe_result_t r;
+    oe_ec_private_key_t private_key = {0};
+    oe_ec_public_key_t public_key = {0};
+    OE_SHA256 hashes[BATCH_COUNT];
+    uint8_t signatures[BATCH_COUNT][128];
+    size_t signature_sizes[BATCH_COUNT];
+    const void* hash_list[BATCH_COUNT];
+    uint8_t* signature_list[BATCH_COUNT];
+    const uint8_t* const* const_signature_list =
+        (const uint8_t* const*)signature_list;
+
+    r = oe_ec_private_key_read_pem(
+        &private_key, (const uint8_t*)_PRIVATE_KEY, private_key_size + 1);
+    OE_TEST(r == OE_OK);
+
+    r = oe_ec_public_key_read_pem(
+        &public_key, (const uint8_t*)_PUBLIC_KEY, public_key_size + 1);
+    OE_TEST(r == OE_OK);
+
+    for (size_t i = 0; i < BATCH_COUNT; i++)
+    {
+        OE_TEST(oe_random_internal(&hashes[i], sizeof(hashes[i])) == OE_OK);
+        hash_list[i] = &hashes[i];
+        signature_list[i] = signatures[i];
+        signature_sizes[i] = sizeof(signatures[i]);
+    }
+
+    /* A buffer that is too small gets the size required, and the other
+     * signatures are written */
+    signature_sizes[1] = 8;
+
+    r = oe_ec_private_key_sign_batch(
+        &private_key,
+        OE_HASH_TYPE_SHA256,
+        hash_list,
+        sizeof(OE_SHA256),
+        signature_list,
+        signature_sizes,
+        BATCH_COUNT);
+    OE_TEST(r == OE_BUFFER_TOO_SMALL);
+    OE_TEST(signature_sizes[1] > 8);
+    OE_TEST(signature_sizes[1] <= sizeof(signatures[1]));
+
+    r = oe_ec_private_key_sign_batch(
+        &private_key,
+        OE_HASH_TYPE_SHA256,
+        hash_list,
+        sizeof(OE_SHA256),
+        signature_list,
+        signature_sizes,
+        BATCH_COUNT);
+    OE_TEST(r == OE_OK);
+
+    /* Each signature verifies on its own */
+    for (size_t i = 0; i < BATCH_COUNT; i++)
+    {
+        r = oe_ec_public_key_verify(
+            &public_key,
+            OE_HASH_TYPE_SHA256,
+            &hashes[i],
+            sizeof(hashes[i]),
+            signatures[i],
+            signature_sizes[i]);
+        OE_TEST(r == OE_OK);
+    }
+
+    r = oe_ec_public_key_verify_batch(
+        &public_key,
+        OE_HASH_TYPE_SHA256,
+        hash_list,
+        sizeof(OE_SHA256),
+        const_signature_list,
+        signature_sizes,
+        BATCH_COUNT);
+    OE_TEST(r == OE_OK);
+
+    /* A batch fails if any signature in it does */
+    hashes[BATCH_COUNT - 1].buf[0] ^= 1;
+
+    r = oe_ec_public_key_verify_batch(
+        &public_key,
+        OE_HASH_TYPE_SHA256,
+        hash_list,
+        sizeof(OE_SHA256),
+        const_signature_list,
+        signature_sizes,
+        BATCH_COUNT);
+    OE_TEST(r == OE_VERIFY_FAILED);
+
+    /* The signatures of the first batch are still valid */
+    r = oe_ec_public_key_verify_batch(
+        &public_key,
+        OE_HASH_TYPE_SHA256,
+        hash_list,
+        sizeof(OE_SHA256),
+        const_signature_list,
+        signature_sizes,
+        BATCH_COUNT - 1);
+    OE_TEST(r == OE_OK);
+
+    /* A public key cannot sign */
+    r = oe_ec_private_key_sign_batch(
+        (oe_ec_private_key_t*)&public_key,
+        OE_HASH_TYPE_SHA256,
+        hash_list,
+        sizeof(OE_SHA256),
+        signature_list,
+        signature_sizes,
+        BATCH_COUNT);
+    OE_TEST(r == OE_INVALID_PARAMETER);
+
+    OE_TEST(oe_ec_private_key_free(&private_key) == OE_OK);
+    OE_TEST(oe_ec_public_key_free(&public_key) == OE_OK);
+
+    printf("=== passed %s()\n", __FUNCTION__);
+}
+#endif
+
 static void _test_cert_chain_read()
 {
     printf("=== begin %s()\n", __FUNCTION__);
@@ -963,11 +1643,17 @@ void TestEC()
     _test_cert_without_extensions();
     _test_crl_distribution_points();
     _test_sign_and_verify();
+    _test_verify_repeated();
+    _test_verify_vectors();
     _test_generate_from_private();
     _test_private_key_limits();
     _test_write_private();
     _test_write_public();
     _test_cert_methods();
     _test_key_from_bytes();
+#if defined(OE_BUILD_ENCLAVE)
+    _test_share_keys();
+    _test_batch_sign_and_verify();
+#endif
     _test_cert_chain_read();
 }
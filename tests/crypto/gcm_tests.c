@@ -0,0 +1,246 @@
+// Copyright (c) Open Enclave SDK contributors.
+// Licensed under the MIT License.
+
+#include <openenclave/enclave.h>
+#include <openenclave/internal/crypto/gcm.h>
+#include <openenclave/internal/tests.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "tests.h"
+#include "utils.h"
+
+#define MAX_KAT_SIZE 64
+#define MAX_SIZE 4103
+#define MAX_AAD_SIZE 129
+
+typedef struct _gcm_kat
+{
+    const char* key;
+    const char* iv;
+    const char* aad;
+    const char* plaintext;
+    const char* ciphertext;
+    const char* tag;
+} gcm_kat_t;
+
+// Test cases 1 to 4 of the GCM specification submitted to NIST (McGrew and
+// Viega), which SP 800-38D is based on, and vectors of the NIST CAVP
+// validation file gcmEncryptExtIV128.rsp.
+static const gcm_kat_t _kats[] = {
+    {"00000000000000000000000000000000",
+     "000000000000000000000000",
+     "",
+     "",
+     "",
+     "58e2fccefa7e3061367f1d57a4e7455a"},
+    {"00000000000000000000000000000000",
+     "000000000000000000000000",
+     "",
+     "00000000000000000000000000000000",
+     "0388dace60b6a392f328c2b971b2fe78",
+     "ab6e47d42cec13bdf53a67b21257bddf"},
+    {"feffe9928665731c6d6a8f9467308308",
+     "cafebabefacedbaddecaf888",
+     "",
+     "d9313225f88406e5a55909c5aff5269a86a7a9531534f7da2e4c303d8a318a72"
+     "1c3c0c95956809532fcf0e2449a6b525b16aedf5aa0de657ba637b391aafd255",
+     "42831ec2217774244b7221b784d0d49ce3aa212f2c02a4e035c17e2329aca12e"
+     "21d514b25466931c7d8f6a5aac84aa051ba30b396a0aac973d58e091473f5985",
+     "4d5c2af327cd64a62cf35abd2ba6fab4"},
+    {"feffe9928665731c6d6a8f9467308308",
+     "cafebabefacedbaddecaf888",
+     "feedfacedeadbeeffeedfacedeadbeefabaddad2",
+     "d9313225f88406e5a55909c5aff5269a86a7a9531534f7da2e4c303d8a318a72"
+     "1c3c0c95956809532fcf0e2449a6b525b16aedf5aa0de657ba637b39",
+     "42831ec2217774244b7221b784d0d49ce3aa212f2c02a4e035c17e2329aca12e"
+     "21d514b25466931c7d8f6a5aac84aa051ba30b396a0aac973d58e091",
+     "5bc94fbc3221a5db94fae95ae7121a47"},
+    {"11754cd72aec309bf52f7687212e8957",
+     "3c819d9a9bed087615030b65",
+     "",
+     "",
+     "",
+     "250327c674aaf477aef2675748cf6971"},
+    {"c939cc13397c1d37de6ae0e1cb7c423c",
+     "b3d8cc017cbb89b39e0f67e2",
+     "24825602bd12a984e0092d3e448eda5f",
+     "c3b3c41f113a31b73d9a5cd432103069",
+     "93fe7d9e9bfd10348a5606e5cafa7354",
+     "0032a1dc85f1c9786925a2e71d8272dd"},
+};
+
+typedef oe_result_t (*init_key_t)(const uint8_t*, size_t, oe_aes_gcm_key_t*);
+
+static void _test_kat(const gcm_kat_t* kat, init_key_t init_key)
+{
+    uint8_t key[16];
+    uint8_t iv[OE_GCM_IV_SIZE];
+    uint8_t aad[MAX_KAT_SIZE];
+    uint8_t plaintext[MAX_KAT_SIZE];
+    uint8_t ciphertext[MAX_KAT_SIZE];
+    uint8_t tag[OE_GCM_TAG_SIZE];
+    uint8_t output[MAX_KAT_SIZE];
+    uint8_t output_tag[OE_GCM_TAG_SIZE];
+    const size_t aad_size = strlen(kat->aad) / 2;
+    const size_t size = strlen(kat->plaintext) / 2;
+    oe_aes_gcm_key_t gcm_key;
+
+    hex_to_buf(kat->key, key, sizeof(key));
+    hex_to_buf(kat->iv, iv, sizeof(iv));
+    hex_to_buf(kat->aad, aad, sizeof(aad));
+    hex_to_buf(kat->plaintext, plaintext, sizeof(plaintext));
+    hex_to_buf(kat->ciphertext, ciphertext, sizeof(ciphertext));
+    hex_to_buf(kat->tag, tag, sizeof(tag));
+
+    OE_TEST(init_key(key, sizeof(key), &gcm_key) == OE_OK);
+
+    OE_TEST(
+        oe_aes_gcm_encrypt(
+            &gcm_key, iv, aad, aad_size, plaintext, size, output, output_tag) ==
+        OE_OK);
+    OE_TEST(memcmp(output, ciphertext, size) == 0);
+    OE_TEST(memcmp(output_tag, tag, sizeof(tag)) == 0);
+
+    OE_TEST(
+        oe_aes_gcm_decrypt(
+            &gcm_key, iv, aad, aad_size, ciphertext, size, output, tag) ==
+        OE_OK);
+    OE_TEST(memcmp(output, plaintext, size) == 0);
+
+    // A wrong tag is rejected and the output wiped.
+    tag[sizeof(tag) - 1] ^= 1;
+    OE_TEST(
+        oe_aes_gcm_decrypt(
+            &gcm_key, iv, aad, aad_size, ciphertext, size, output, tag) ==
+        OE_CRYPTO_ERROR);
+
+    for (size_t i = 0; i < size; i++)
+        OE_TEST(output[i] == 0);
+
+    oe_aes_gcm_free_key(&gcm_key);
+}
+
+static void _test_gcm_kats(void)
+{
+    printf("=== begin %s()\n", __FUNCTION__);
+
+    for (size_t i = 0; i < OE_COUNTOF(_kats); i++)
+    {
+        _test_kat(&_kats[i], oe_aes_gcm_init_key);
+        _test_kat(&_kats[i], oe_aes_gcm_init_key_portable);
+    }
+
+    printf("=== passed %s()\n", __FUNCTION__);
+}
+
+static void _fill(uint8_t* buf, size_t size, uint32_t seed)
+{
+    for (size_t i = 0; i < size; i++)
+    {
+        seed = seed * 1103515245 + 12345;
+        buf[i] = (uint8_t)(seed >> 16);
+    }
+}
+
+// Messages encrypted with AES-NI and PCLMULQDQ decrypt with mbedTLS and the
+// other way around, at sizes around the block size and the number of blocks
+// processed at once. On CPUs without them, both keys use mbedTLS.
+static void _test_gcm_implementations_agree(void)
+{
+    printf("=== begin %s()\n", __FUNCTION__);
+
+    static const size_t sizes[] = {
+        0, 1, 15, 16, 17, 112, 127, 128, 129, 255, 256, 1000, MAX_SIZE};
+    static const size_t aad_sizes[] = {0, 1, 16, 20, 128, MAX_AAD_SIZE};
+    static uint8_t plaintext[MAX_SIZE];
+    static uint8_t ciphertext[MAX_SIZE];
+    static uint8_t portable_ciphertext[MAX_SIZE];
+    static uint8_t output[MAX_SIZE];
+    uint8_t key[16];
+    uint8_t iv[OE_GCM_IV_SIZE];
+    uint8_t aad[MAX_AAD_SIZE];
+    uint8_t tag[OE_GCM_TAG_SIZE];
+    uint8_t portable_tag[OE_GCM_TAG_SIZE];
+    oe_aes_gcm_key_t gcm_key;
+    oe_aes_gcm_key_t portable_key;
+    uint32_t seed = 1;
+
+    for (size_t i = 0; i < OE_COUNTOF(sizes); i++)
+    {
+        for (size_t j = 0; j < OE_COUNTOF(aad_sizes); j++)
+        {
+            const size_t size = sizes[i];
+            const size_t aad_size = aad_sizes[j];
+
+            _fill(key, sizeof(key), seed++);
+            _fill(iv, sizeof(iv), seed++);
+            _fill(aad, aad_size, seed++);
+            _fill(plaintext, size, seed++);
+
+            OE_TEST(oe_aes_gcm_init_key(key, sizeof(key), &gcm_key) == OE_OK);
+            OE_TEST(
+                oe_aes_gcm_init_key_portable(
+                    key, sizeof(key), &portable_key) == OE_OK);
+
+            OE_TEST(
+                oe_aes_gcm_encrypt(
+                    &gcm_key,
+                    iv,
+                    aad,
+                    aad_size,
+                    plaintext,
+                    size,
+                    ciphertext,
+                    tag) == OE_OK);
+            OE_TEST(
+                oe_aes_gcm_encrypt(
+                    &portable_key,
+                    iv,
+                    aad,
+                    aad_size,
+                    plaintext,
+                    size,
+                    portable_ciphertext,
+                    portable_tag) == OE_OK);
+            OE_TEST(memcmp(ciphertext, portable_ciphertext, size) == 0);
+            OE_TEST(memcmp(tag, portable_tag, sizeof(tag)) == 0);
+
+            OE_TEST(
+                oe_aes_gcm_decrypt(
+                    &portable_key,
+                    iv,
+                    aad,
+                    aad_size,
+                    ciphertext,
+                    size,
+                    output,
+                    tag) == OE_OK);
+            OE_TEST(memcmp(output, plaintext, size) == 0);
+
+            // In place
+            OE_TEST(
+                oe_aes_gcm_decrypt(
+                    &gcm_key,
+                    iv,
+                    aad,
+                    aad_size,
+                    portable_ciphertext,
+                    size,
+                    portable_ciphertext,
+                    portable_tag) == OE_OK);
+            OE_TEST(memcmp(portable_ciphertext, plaintext, size) == 0);
+
+            oe_aes_gcm_free_key(&gcm_key);
+            oe_aes_gcm_free_key(&portable_key);
+        }
+    }
+
+    printf("=== passed %s()\n", __FUNCTION__);
+}
+
+void TestGCM(void)
+{
+    _test_gcm_kats();
+    _test_gcm_implementations_agree();
+}
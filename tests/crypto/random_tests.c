@@ -50,9 +50,36 @@ static void _test_random(size_t seq_length)
     printf("=== passed %s()\n", __FUNCTION__);
 }
 
+/* Requests beyond the bytes generated under one key span several keys */
+static void _test_random_large(void)
+{
+    const size_t half = 64 * 1024;
+    uint8_t* buf = (uint8_t*)malloc(2 * half);
+
+    printf("=== begin %s()\n", __FUNCTION__);
+
+    OE_TEST(buf != NULL);
+    memset(buf, 0, 2 * half);
+    OE_TEST(oe_random_internal(buf, 2 * half) == OE_OK);
+    OE_TEST(memcmp(buf, buf + half, half) != 0);
+
+    for (size_t i = 0; i < 2 * half; i += half / 4)
+    {
+        static const uint8_t zeros[16];
+        OE_TEST(memcmp(buf + i, zeros, sizeof(zeros)) != 0);
+    }
+
+    free(buf);
+
+    printf("=== passed %s()\n", __FUNCTION__);
+}
+
 void TestRandom(void)
 {
+    _test_random(8);
     _test_random(19);
+    _test_random(32);
+    _test_random(33);
     _test_random(1023);
     _test_random(1024);
     _test_random(1025);
@@ -60,4 +87,5 @@ void TestRandom(void)
     _test_random(2048);
     _test_random(2049);
     OE_STATIC_ASSERT(SEQ_LENGTH_MAX == 2049);
+    _test_random_large();
 }
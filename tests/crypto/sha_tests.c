@@ -3,6 +3,9 @@
 
 #if defined(OE_BUILD_ENCLAVE)
 #include <openenclave/enclave.h>
+#if defined(__x86_64__)
+#include <openenclave/internal/sha256.h>
+#endif
 #endif
 
 #include <openenclave/internal/crypto/sha.h>
@@ -12,6 +15,20 @@
 #include "hash.h"
 #include "tests.h"
 
+/* SHA-256 of one million 'a' characters (FIPS 180-2, appendix B.3) */
+static const OE_SHA256 _MILLION_A_HASH = {
+    {0xcd, 0xc7, 0x6e, 0x5c, 0x99, 0x14, 0xfb, 0x92, 0x81, 0xa1, 0xc7,
+     0xe2, 0x84, 0xd7, 0x3e, 0x67, 0xf1, 0x80, 0x9a, 0x48, 0xa4, 0x97,
+     0x20, 0x0e, 0x04, 0x6d, 0x39, 0xcc, 0xc7, 0x11, 0x2c, 0xd0}};
+
+static void _sha256(const void* data, size_t size, OE_SHA256* hash)
+{
+    oe_sha256_context_t ctx = {0};
+    OE_TEST(oe_sha256_init(&ctx) == OE_OK);
+    OE_TEST(oe_sha256_update(&ctx, data, size) == OE_OK);
+    OE_TEST(oe_sha256_final(&ctx, hash) == OE_OK);
+}
+
 // Test computation of SHA-256 hash over an ASCII alphabet string.
 void TestSHA(void)
 {
@@ -26,3 +43,96 @@ void TestSHA(void)
 
     printf("=== passed %s()\n", __FUNCTION__);
 }
+
+// Test a long message hashed in updates that are not multiples of the block
+// size.
+static void _test_sha_long(void)
+{
+    printf("=== begin %s()\n", __FUNCTION__);
+
+    static uint8_t data[1000];
+    OE_SHA256 hash = {0};
+    oe_sha256_context_t ctx = {0};
+
+    memset(data, 'a', sizeof(data));
+    OE_TEST(oe_sha256_init(&ctx) == OE_OK);
+
+    for (size_t i = 0; i < 1000; i++)
+        OE_TEST(oe_sha256_update(&ctx, data, sizeof(data)) == OE_OK);
+
+    OE_TEST(oe_sha256_final(&ctx, &hash) == OE_OK);
+    OE_TEST(memcmp(&hash, &_MILLION_A_HASH, sizeof(OE_SHA256)) == 0);
+
+    printf("=== passed %s()\n", __FUNCTION__);
+}
+
+// Test that splitting a message into two updates does not change its hash,
+// for every split point.
+static void _test_sha_split(void)
+{
+    printf("=== begin %s()\n", __FUNCTION__);
+
+    uint8_t data[300];
+    OE_SHA256 expected = {0};
+
+    for (size_t i = 0; i < sizeof(data); i++)
+        data[i] = (uint8_t)(i * 7 + 3);
+
+    _sha256(data, sizeof(data), &expected);
+
+    for (size_t split = 0; split <= sizeof(data); split++)
+    {
+        OE_SHA256 hash = {0};
+        oe_sha256_context_t ctx = {0};
+
+        OE_TEST(oe_sha256_init(&ctx) == OE_OK);
+        OE_TEST(oe_sha256_update(&ctx, data, split) == OE_OK);
+        OE_TEST(
+            oe_sha256_update(&ctx, data + split, sizeof(data) - split) ==
+            OE_OK);
+        OE_TEST(oe_sha256_final(&ctx, &hash) == OE_OK);
+        OE_TEST(memcmp(&hash, &expected, sizeof(OE_SHA256)) == 0);
+    }
+
+    printf("=== passed %s()\n", __FUNCTION__);
+}
+
+#if defined(OE_BUILD_ENCLAVE) && defined(__x86_64__)
+// Test that the SHA extensions, when the CPU has them, and the portable
+// implementation compute the same hashes.
+static void _test_sha_implementations(void)
+{
+    printf("=== begin %s()\n", __FUNCTION__);
+
+    static uint8_t data[4096];
+    bool hardware = oe_sha256_set_hardware_enabled(true);
+
+    printf("SHA extensions: %s\n", hardware ? "yes" : "no");
+
+    for (size_t i = 0; i < sizeof(data); i++)
+        data[i] = (uint8_t)(i * 13 + i / 256);
+
+    for (size_t size = 0; size <= sizeof(data); size += 61)
+    {
+        OE_SHA256 hash = {0};
+        OE_SHA256 expected = {0};
+
+        OE_TEST(oe_sha256_set_hardware_enabled(false) == false);
+        _sha256(data, size, &expected);
+        OE_TEST(oe_sha256_set_hardware_enabled(true) == hardware);
+        _sha256(data, size, &hash);
+        OE_TEST(memcmp(&hash, &expected, sizeof(OE_SHA256)) == 0);
+    }
+
+    printf("=== passed %s()\n", __FUNCTION__);
+}
+#endif
+
+void TestSHALong(void)
+{
+    _test_sha_long();
+    _test_sha_split();
+#if defined(OE_BUILD_ENCLAVE) && defined(__x86_64__)
+    _test_sha_implementations();
+#endif
+}
@@ -9,6 +9,7 @@ void TestAll()
     TestASN1();
 #endif
     TestCRL();
+    TestCertVerify();
     TestEC();
     TestRSA();
     TestRandom();
@@ -18,5 +19,10 @@ void TestAll()
 #endif
     TestHMAC();
     TestKDF();
+#if defined(OE_BUILD_ENCLAVE)
+    // AES-GCM is implemented for enclaves only.
+    TestGCM();
+#endif
     TestSHA();
+    TestSHALong();
 }
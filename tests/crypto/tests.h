@@ -5,13 +5,16 @@
 #define _TESTS_CRYPTO_TESTS_H
 
 void TestASN1(void);
+void TestCertVerify(void);
 void TestCRL(void);
 void TestEC(void);
+void TestGCM(void);
 void TestKDF(void);
 void TestRandom(void);
 void TestCpuEntropy(void);
 void TestRSA(void);
 void TestSHA(void);
+void TestSHALong(void);
 void TestHMAC(void);
 void TestAll();
 
@@ -0,0 +1,72 @@
+// Copyright (c) Open Enclave SDK contributors.
+// Licensed under the MIT License.
+
+#include <openenclave/enclave.h>
+#include <openenclave/internal/globals.h>
+#include <openenclave/internal/syscall/unistd.h>
+#include <stdlib.h>
+#include <string.h>
+#include "dynamic_heap_t.h"
+
+#define BLOCK_SIZE (1024 * 1024)
+#define MAX_BLOCKS 64
+
+static oe_result_t _allocate_and_release(size_t nblocks, uint8_t** peak_brk)
+{
+    oe_result_t result = OE_UNEXPECTED;
+    void* blocks[MAX_BLOCKS] = {0};
+    size_t i;
+
+    for (i = 0; i < nblocks; i++)
+    {
+        if (!(blocks[i] = malloc(BLOCK_SIZE)))
+        {
+            result = OE_OUT_OF_MEMORY;
+            goto done;
+        }
+
+        /* Touch every page to make sure it was committed */
+        memset(blocks[i], (int)i, BLOCK_SIZE);
+    }
+
+    *peak_brk = (uint8_t*)oe_sbrk(0);
+    result = OE_OK;
+
+done:
+    /* Free in reverse order so the top chunk can be trimmed */
+    while (i--)
+        free(blocks[i]);
+
+    return result;
+}
+
+oe_result_t test_dynamic_heap()
+{
+    oe_result_t result = OE_UNEXPECTED;
+    const uint8_t* base = (const uint8_t*)__oe_get_heap_base();
+    const uint8_t* end = (const uint8_t*)__oe_get_heap_end();
+    size_t nblocks = ((size_t)(end - base) / BLOCK_SIZE) * 3 / 4;
+    uint8_t* peak_brk = NULL;
+
+    if (!__oe_is_heap_dynamic())
+        return OE_FAILURE;
+
+    if (nblocks > MAX_BLOCKS)
+        nblocks = MAX_BLOCKS;
+
+    /* Repeat to make sure trimmed pages can be committed again */
+    for (size_t n = 0; n < 2; n++)
+    {
+        if ((result = _allocate_and_release(nblocks, &peak_brk)) != OE_OK)
+            return result;
+
+        if (!(base <= peak_brk && peak_brk <= end))
+            return OE_FAILURE;
+
+        /* The allocator returns free memory at the top of the heap */
+        if ((uint8_t*)oe_sbrk(0) >= peak_brk)
+            return OE_FAILURE;
+    }
+
+    return OE_OK;
+}
@@ -0,0 +1,47 @@
+// Copyright (c) Open Enclave SDK contributors.
+// Licensed under the MIT License.
+
+#include <openenclave/host.h>
+#include <openenclave/internal/tests.h>
+#include "dynamic_heap_u.h"
+
+#define SKIP_RETURN_CODE 2
+
+int main(int argc, const char* argv[])
+{
+    oe_result_t result;
+    const uint32_t flags = oe_get_create_flags();
+    oe_enclave_t* enclave = NULL;
+
+    if (argc != 2)
+    {
+        fprintf(stderr, "Usage: %s ENCLAVE_PATH\n", argv[0]);
+        return 1;
+    }
+
+    result = oe_create_dynamic_heap_enclave(
+        argv[1], OE_ENCLAVE_TYPE_SGX, flags, NULL, 0, &enclave);
+
+    /* Skip the test on hardware, where a dynamic heap is not supported */
+    if (result == OE_UNSUPPORTED)
+    {
+        fprintf(
+            stderr,
+            "%s: warning: dynamic heap is not supported on this platform\n",
+            argv[0]);
+        return SKIP_RETURN_CODE;
+    }
+
+    OE_TEST(result == OE_OK);
+
+    oe_result_t return_value;
+    result = test_dynamic_heap(enclave, &return_value);
+    OE_TEST(result == OE_OK);
+    OE_TEST(return_value == OE_OK);
+
+    OE_TEST(oe_terminate_enclave(enclave) == OE_OK);
+
+    printf("=== passed all tests (%s)\n", argv[0]);
+
+    return 0;
+}
@@ -0,0 +1,282 @@
+// Copyright (c) Open Enclave SDK contributors.
+// Licensed under the MIT License.
+
+#include <mbedtls/pk.h>
+#include <openenclave/enclave.h>
+#include <openenclave/internal/ec.h>
+#include <openenclave/internal/crypto/sha.h>
+#include <openenclave/internal/random.h>
+#include <string.h>
+
+#include "ecdsa_perf_t.h"
+
+/* Key 0 is cached. The other keys are more than the enclave remembers as
+ * candidates for caching, so verifying them in turn never uses a cached
+ * table. */
+#define KEY_COUNT 32
+
+#define MAX_SIGNATURE_SIZE 80
+#define MAX_PEM_SIZE 256
+
+/* The number of messages that the batch methods sign or verify at once */
+#define BATCH_SIZE 64
+
+typedef struct _key
+{
+    oe_ec_private_key_t private_key;
+    oe_ec_public_key_t public_key;
+    mbedtls_pk_context pk;
+    OE_SHA256 hash;
+    uint8_t signature[MAX_SIGNATURE_SIZE];
+    size_t signature_size;
+} test_key_t;
+
+static test_key_t _keys[KEY_COUNT];
+static size_t _key_count;
+
+/* Signatures of the hash of key 0 for METHOD_VERIFY_BATCH */
+static uint8_t _signatures[BATCH_SIZE][MAX_SIGNATURE_SIZE];
+static uint8_t* _signature_list[BATCH_SIZE];
+static size_t _signature_sizes[BATCH_SIZE];
+
+static oe_result_t _init_key(test_key_t* key)
+{
+    oe_result_t result = OE_FAILURE;
+    uint8_t private_raw[32];
+    uint8_t pem[MAX_PEM_SIZE];
+    size_t pem_size = sizeof(pem);
+
+    mbedtls_pk_init(&key->pk);
+
+    if ((result = oe_random_internal(private_raw, sizeof(private_raw))) !=
+        OE_OK)
+        goto done;
+
+    /* Keep the private key below the group order */
+    private_raw[0] &= 0x7f;
+
+    if ((result = oe_ec_generate_key_pair_from_private(
+             OE_EC_TYPE_SECP256R1,
+             private_raw,
+             sizeof(private_raw),
+             &key->private_key,
+             &key->public_key)) != OE_OK)
+        goto done;
+
+    if ((result = oe_random_internal(&key->hash, sizeof(key->hash))) != OE_OK)
+        goto done;
+
+    key->signature_size = sizeof(key->signature);
+
+    if ((result = oe_ec_private_key_sign(
+             &key->private_key,
+             OE_HASH_TYPE_SHA256,
+             &key->hash,
+             sizeof(key->hash),
+             key->signature,
+             &key->signature_size)) != OE_OK)
+        goto done;
+
+    /* The same key for mbedTLS */
+    if ((result = oe_ec_public_key_write_pem(
+             &key->public_key, pem, &pem_size)) != OE_OK)
+        goto done;
+
+    if (mbedtls_pk_parse_public_key(&key->pk, pem, pem_size) != 0)
+    {
+        result = OE_FAILURE;
+        goto done;
+    }
+
+    result = OE_OK;
+
+done:
+    return result;
+}
+
+static oe_result_t _verify(const test_key_t* key)
+{
+    return oe_ec_public_key_verify(
+        &key->public_key,
+        OE_HASH_TYPE_SHA256,
+        &key->hash,
+        sizeof(key->hash),
+        key->signature,
+        key->signature_size);
+}
+
+/* Sign the hash of key 0 count times with oe_ec_private_key_sign_batch() */
+static oe_result_t _sign_batch(
+    uint8_t* const* signatures,
+    size_t* signature_sizes,
+    size_t count)
+{
+    const void* hashes[BATCH_SIZE];
+
+    for (size_t i = 0; i < count; i++)
+    {
+        hashes[i] = &_keys[0].hash;
+        signature_sizes[i] = MAX_SIGNATURE_SIZE;
+    }
+
+    return oe_ec_private_key_sign_batch(
+        &_keys[0].private_key,
+        OE_HASH_TYPE_SHA256,
+        hashes,
+        sizeof(_keys[0].hash),
+        signatures,
+        signature_sizes,
+        count);
+}
+
+/* Verify the signatures of _signatures with oe_ec_public_key_verify_batch() */
+static oe_result_t _verify_batch(size_t count)
+{
+    const void* hashes[BATCH_SIZE];
+
+    for (size_t i = 0; i < count; i++)
+        hashes[i] = &_keys[0].hash;
+
+    return oe_ec_public_key_verify_batch(
+        &_keys[0].public_key,
+        OE_HASH_TYPE_SHA256,
+        hashes,
+        sizeof(_keys[0].hash),
+        (const uint8_t* const*)_signature_list,
+        _signature_sizes,
+        count);
+}
+
+oe_result_t enc_init(void)
+{
+    oe_result_t result;
+
+    for (; _key_count < KEY_COUNT; _key_count++)
+    {
+        if ((result = _init_key(&_keys[_key_count])) != OE_OK)
+        {
+            oe_ec_private_key_free(&_keys[_key_count].private_key);
+            mbedtls_pk_free(&_keys[_key_count].pk);
+            return result;
+        }
+    }
+
+    /* A key is cached the second time it is seen */
+    for (size_t i = 0; i < 2; i++)
+    {
+        if ((result = _verify(&_keys[0])) != OE_OK)
+            return result;
+    }
+
+    for (size_t i = 0; i < BATCH_SIZE; i++)
+        _signature_list[i] = _signatures[i];
+
+    return _sign_batch(_signature_list, _signature_sizes, BATCH_SIZE);
+}
+
+static oe_result_t _run_batch(method_t method, uint64_t iterations)
+{
+    uint8_t signatures[BATCH_SIZE][MAX_SIGNATURE_SIZE];
+    uint8_t* signature_list[BATCH_SIZE];
+    size_t signature_sizes[BATCH_SIZE];
+    oe_result_t result;
+
+    for (size_t i = 0; i < BATCH_SIZE; i++)
+        signature_list[i] = signatures[i];
+
+    for (uint64_t i = 0; i < iterations; i += BATCH_SIZE)
+    {
+        size_t count = BATCH_SIZE;
+
+        if (iterations - i < BATCH_SIZE)
+            count = (size_t)(iterations - i);
+
+        if (method == METHOD_SIGN_BATCH)
+            result = _sign_batch(signature_list, signature_sizes, count);
+        else
+            result = _verify_batch(count);
+
+        if (result != OE_OK)
+            return result;
+    }
+
+    return OE_OK;
+}
+
+oe_result_t enc_run(method_t method, uint64_t iterations)
+{
+    if (_key_count != KEY_COUNT)
+        return OE_UNEXPECTED;
+
+    if (method == METHOD_SIGN_BATCH || method == METHOD_VERIFY_BATCH)
+        return _run_batch(method, iterations);
+
+    if (method != METHOD_MBEDTLS && method != METHOD_UNCACHED &&
+        method != METHOD_CACHED && method != METHOD_SIGN)
+        return OE_INVALID_PARAMETER;
+
+    for (uint64_t i = 0; i < iterations; i++)
+    {
+        const test_key_t* key = &_keys[0];
+
+        if (method == METHOD_SIGN)
+        {
+            uint8_t signature[MAX_SIGNATURE_SIZE];
+            size_t signature_size = sizeof(signature);
+
+            if (oe_ec_private_key_sign(
+                    &key->private_key,
+                    OE_HASH_TYPE_SHA256,
+                    &key->hash,
+                    sizeof(key->hash),
+                    signature,
+                    &signature_size) != OE_OK)
+                return OE_FAILURE;
+
+            continue;
+        }
+
+        if (method == METHOD_MBEDTLS)
+        {
+            /* How oe_ec_public_key_verify() verified before */
+            if (mbedtls_pk_verify(
+                    (mbedtls_pk_context*)&key->pk,
+                    MBEDTLS_MD_SHA256,
+                    key->hash.buf,
+                    sizeof(key->hash),
+                    key->signature,
+                    key->signature_size) != 0)
+                return OE_VERIFY_FAILED;
+
+            continue;
+        }
+
+        if (method == METHOD_UNCACHED)
+            key = &_keys[1 + i % (KEY_COUNT - 1)];
+
+        if (_verify(key) != OE_OK)
+            return OE_VERIFY_FAILED;
+    }
+
+    return OE_OK;
+}
+
+void enc_free(void)
+{
+    for (size_t i = 0; i < _key_count; i++)
+    {
+        oe_ec_private_key_free(&_keys[i].private_key);
+        oe_ec_public_key_free(&_keys[i].public_key);
+        mbedtls_pk_free(&_keys[i].pk);
+    }
+
+    _key_count = 0;
+}
+
+OE_SET_ENCLAVE_SGX(
+    1,    /* ProductID */
+    1,    /* SecurityVersion */
+    true, /* AllowDebug */
+    1024, /* HeapPageCount */
+    64,   /* StackPageCount */
+    8);   /* TCSCount */
@@ -0,0 +1,180 @@
+// Copyright (c) Open Enclave SDK contributors.
+// Licensed under the MIT License.
+
+#include <openenclave/host.h>
+#include <openenclave/internal/tests.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "ecdsa_perf_u.h"
+
+#define DEFAULT_ITERATIONS 1000
+#define DEFAULT_THREADS 4
+
+/* Must not exceed the TCSCount of the enclave */
+#define MAX_THREADS 8
+
+/*
+**==============================================================================
+**
+** Enclave P-256 ECDSA benchmark:
+**
+**     ecdsa_perf_host ENCLAVE [ITERATIONS] [THREADS]
+**
+**         Verifies or signs ITERATIONS SHA-256 hashes with P-256 ECDSA in
+**         the enclave with each method and reports the operations per
+**         second:
+**
+**             mbedtls       mbedtls_pk_verify(), as oe_ec_public_key_verify()
+**                           did before it used p256.c
+**             uncached      oe_ec_public_key_verify() with 31 keys in turn,
+**                           none of which is cached
+**             cached        oe_ec_public_key_verify() with a cached key
+**             verify-batch  oe_ec_public_key_verify_batch() with batches of
+**                           64 signatures
+**             sign          oe_ec_private_key_sign()
+**             sign-batch    oe_ec_private_key_sign_batch() with batches of
+**                           64 hashes
+**
+**         The methods with a cached key are then run on THREADS threads at
+**         once, each of which does ITERATIONS operations, to show how the
+**         throughput scales with the enclave threads.
+**
+**==============================================================================
+*/
+
+typedef struct _thread_args
+{
+    method_t method;
+    oe_result_t result;
+} thread_args_t;
+
+static oe_enclave_t* _enclave;
+static uint64_t _iterations = DEFAULT_ITERATIONS;
+
+static const char* _method_names[] = {
+    "mbedtls",
+    "uncached",
+    "cached",
+    "verify-batch",
+    "sign",
+    "sign-batch",
+};
+
+static double _get_time_in_seconds(void)
+{
+    struct timespec current_time;
+    clock_gettime(CLOCK_MONOTONIC, &current_time);
+    return (double)current_time.tv_sec + (double)current_time.tv_nsec / 1e9;
+}
+
+static void* _thread(void* arg)
+{
+    thread_args_t* args = (thread_args_t*)arg;
+    oe_result_t result =
+        enc_run(_enclave, &args->result, args->method, _iterations);
+
+    if (result != OE_OK)
+        args->result = result;
+
+    return NULL;
+}
+
+static void _run(method_t method, size_t threads)
+{
+    pthread_t ids[MAX_THREADS];
+    thread_args_t args[MAX_THREADS];
+    double start;
+    double elapsed;
+
+    start = _get_time_in_seconds();
+
+    for (size_t i = 0; i < threads; i++)
+    {
+        args[i].method = method;
+        args[i].result = OE_UNEXPECTED;
+        OE_TEST(pthread_create(&ids[i], NULL, _thread, &args[i]) == 0);
+    }
+
+    for (size_t i = 0; i < threads; i++)
+    {
+        pthread_join(ids[i], NULL);
+        OE_TEST(args[i].result == OE_OK);
+    }
+
+    elapsed = _get_time_in_seconds() - start;
+
+    printf(
+        "%-12s %7zu %16.0f\n",
+        _method_names[method],
+        threads,
+        (double)threads * (double)_iterations / elapsed);
+}
+
+int main(int argc, const char* argv[])
+{
+    oe_result_t result;
+    oe_result_t return_value;
+    size_t threads = DEFAULT_THREADS;
+
+    if (argc < 2 || argc > 4)
+    {
+        fprintf(
+            stderr, "Usage: %s ENCLAVE [ITERATIONS] [THREADS]\n", argv[0]);
+        return 1;
+    }
+
+    if (argc > 2)
+        _iterations = strtoull(argv[2], NULL, 10);
+
+    if (argc > 3)
+        threads = strtoul(argv[3], NULL, 10);
+
+    if (!_iterations || threads < 1 || threads > MAX_THREADS)
+    {
+        fprintf(
+            stderr,
+            "%s: ITERATIONS must be at least 1, THREADS 1 to %d\n",
+            argv[0],
+            MAX_THREADS);
+        return 1;
+    }
+
+    result = oe_create_ecdsa_perf_enclave(
+        argv[1],
+        OE_ENCLAVE_TYPE_AUTO,
+        oe_get_create_flags(),
+        NULL,
+        0,
+        &_enclave);
+    OE_TEST(result == OE_OK);
+
+    OE_TEST(enc_init(_enclave, &return_value) == OE_OK);
+    OE_TEST(return_value == OE_OK);
+
+    printf("%-12s %7s %16s\n", "method", "threads", "operations/s");
+
+    _run(METHOD_MBEDTLS, 1);
+    _run(METHOD_UNCACHED, 1);
+    _run(METHOD_CACHED, 1);
+    _run(METHOD_VERIFY_BATCH, 1);
+    _run(METHOD_SIGN, 1);
+    _run(METHOD_SIGN_BATCH, 1);
+
+    if (threads > 1)
+    {
+        _run(METHOD_CACHED, threads);
+        _run(METHOD_VERIFY_BATCH, threads);
+        _run(METHOD_SIGN, threads);
+        _run(METHOD_SIGN_BATCH, threads);
+    }
+
+    OE_TEST(enc_free(_enclave) == OE_OK);
+    OE_TEST(oe_terminate_enclave(_enclave) == OE_OK);
+
+    printf("=== passed all tests (ecdsa_perf)\n");
+
+    return 0;
+}
@@ -0,0 +1,60 @@
+// Copyright (c) Open Enclave SDK contributors.
+// Licensed under the MIT License.
+
+#include <openenclave/enclave.h>
+#include <openenclave/internal/malloc.h>
+#include <stdlib.h>
+
+#include "heap_profiler_t.h"
+
+#define MAX_BLOCKS 4096
+
+static void* _blocks[MAX_BLOCKS];
+static size_t _num_blocks;
+
+oe_result_t enc_start(uint64_t sampling_rate)
+{
+    return oe_heap_profiler_start(sampling_rate);
+}
+
+oe_result_t enc_stop(void)
+{
+    return oe_heap_profiler_stop();
+}
+
+oe_result_t enc_allocate(size_t size, size_t count)
+{
+    if (count > MAX_BLOCKS - _num_blocks)
+        return OE_INVALID_PARAMETER;
+
+    for (size_t i = 0; i < count; i++)
+    {
+        if (!(_blocks[_num_blocks] = malloc(size)))
+            return OE_OUT_OF_MEMORY;
+
+        _num_blocks++;
+    }
+
+    return OE_OK;
+}
+
+void enc_free(void)
+{
+    for (size_t i = 0; i < _num_blocks; i++)
+        free(_blocks[i]);
+
+    _num_blocks = 0;
+}
+
+oe_result_t enc_dump(const char* name)
+{
+    return oe_heap_profiler_dump(name);
+}
+
+OE_SET_ENCLAVE_SGX(
+    1,    /* ProductID */
+    1,    /* SecurityVersion */
+    true, /* AllowDebug */
+    2048, /* HeapPageCount */
+    64,   /* StackPageCount */
+    1);   /* TCSCount */
@@ -0,0 +1,210 @@
+// Copyright (c) Open Enclave SDK contributors.
+// Licensed under the MIT License.
+
+#include <openenclave/host.h>
+#include <openenclave/internal/tests.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "heap_profiler_u.h"
+
+#define SAMPLING_RATE 4096
+#define BLOCK_SIZE 1024
+#define NUM_BLOCKS 2000
+
+/* The probability that a block of BLOCK_SIZE bytes is sampled,
+ * 1 - exp(-BLOCK_SIZE / SAMPLING_RATE) */
+#define SAMPLE_PROBABILITY 0.22119921692859512
+
+typedef struct _profile
+{
+    uint64_t header_count;
+    uint64_t header_bytes;
+    uint64_t rate;
+    uint64_t num_samples;
+    uint64_t sampled_bytes;
+    uint64_t num_blocks;
+    uint64_t min_addr;
+    uint64_t max_addr;
+    uint64_t map_start;
+    uint64_t map_end;
+} profile_t;
+
+/* Parse a profile of the legacy pprof heap format */
+static void _parse(const char* path, profile_t* profile)
+{
+    FILE* file = fopen(path, "r");
+    char line[4096];
+    bool mapped_libraries = false;
+
+    OE_TEST(file != NULL);
+    memset(profile, 0, sizeof(*profile));
+    profile->min_addr = UINT64_MAX;
+
+    OE_TEST(fgets(line, sizeof(line), file) != NULL);
+    OE_TEST(
+        sscanf(
+            line,
+            "heap profile: %lu: %lu [%*u: %*u] @ heap_v2/%lu",
+            &profile->header_count,
+            &profile->header_bytes,
+            &profile->rate) == 3);
+
+    while (fgets(line, sizeof(line), file))
+    {
+        uint64_t count;
+        uint64_t bytes;
+        int n;
+
+        if (strcmp(line, "\n") == 0)
+            continue;
+
+        if (strcmp(line, "MAPPED_LIBRARIES:\n") == 0)
+        {
+            mapped_libraries = true;
+            continue;
+        }
+
+        if (mapped_libraries)
+        {
+            OE_TEST(
+                sscanf(
+                    line,
+                    "%lx-%lx r-xp",
+                    &profile->map_start,
+                    &profile->map_end) == 2);
+            continue;
+        }
+
+        OE_TEST(
+            sscanf(line, "%lu: %lu [%*u: %*u] @%n", &count, &bytes, &n) == 2);
+        OE_TEST(count == 1);
+
+        profile->num_samples++;
+        profile->sampled_bytes += bytes;
+
+        if (bytes == BLOCK_SIZE)
+            profile->num_blocks++;
+
+        for (char* p = line + n; *p != '\n';)
+        {
+            uint64_t addr = strtoull(p, &p, 16);
+
+            OE_TEST(addr != 0);
+
+            if (addr < profile->min_addr)
+                profile->min_addr = addr;
+
+            if (addr > profile->max_addr)
+                profile->max_addr = addr;
+        }
+    }
+
+    fclose(file);
+
+    OE_TEST(mapped_libraries);
+}
+
+int main(int argc, const char* argv[])
+{
+    oe_result_t result;
+    oe_result_t ret;
+    oe_enclave_t* enclave = NULL;
+    char path[64];
+    profile_t profile;
+    double estimate;
+
+    if (argc != 2)
+    {
+        fprintf(stderr, "Usage: %s ENCLAVE_PATH\n", argv[0]);
+        return 1;
+    }
+
+    result = oe_create_heap_profiler_enclave(
+        argv[1],
+        OE_ENCLAVE_TYPE_AUTO,
+        oe_get_create_flags(),
+        NULL,
+        0,
+        &enclave);
+    OE_TEST(result == OE_OK);
+
+    OE_TEST(enc_start(enclave, &ret, SAMPLING_RATE) == OE_OK);
+
+    if (ret == OE_UNSUPPORTED)
+    {
+        printf("=== skipped heap profiler tests (allocator unsupported)\n");
+        OE_TEST(oe_terminate_enclave(enclave) == OE_OK);
+        return 0;
+    }
+
+    OE_TEST(ret == OE_OK);
+
+    OE_TEST(enc_start(enclave, &ret, 0) == OE_OK);
+    OE_TEST(ret == OE_INVALID_PARAMETER);
+
+    snprintf(path, sizeof(path), "heap_profiler_%d.prof", (int)getpid());
+
+    /* The host writes no profile unless it names a directory for them */
+    OE_TEST(unsetenv("OE_HEAP_PROFILE_DIR") == 0);
+    OE_TEST(enc_dump(enclave, &ret, path) == OE_OK);
+    OE_TEST(ret == OE_UNSUPPORTED);
+
+    /* The enclave names a file in that directory and nothing else */
+    OE_TEST(setenv("OE_HEAP_PROFILE_DIR", ".", 1) == 0);
+    OE_TEST(enc_dump(enclave, &ret, "../heap_profiler.prof") == OE_OK);
+    OE_TEST(ret == OE_INVALID_PARAMETER);
+    OE_TEST(enc_dump(enclave, &ret, "/tmp/heap_profiler.prof") == OE_OK);
+    OE_TEST(ret == OE_INVALID_PARAMETER);
+    OE_TEST(enc_dump(enclave, &ret, "..") == OE_OK);
+    OE_TEST(ret == OE_INVALID_PARAMETER);
+
+    /* The samples of the blocks in use estimate their total size */
+    OE_TEST(enc_allocate(enclave, &ret, BLOCK_SIZE, NUM_BLOCKS) == OE_OK);
+    OE_TEST(ret == OE_OK);
+    OE_TEST(enc_dump(enclave, &ret, path) == OE_OK);
+    OE_TEST(ret == OE_OK);
+
+    _parse(path, &profile);
+    OE_TEST(profile.rate == SAMPLING_RATE);
+    OE_TEST(profile.header_count == profile.num_samples);
+    OE_TEST(profile.header_bytes == profile.sampled_bytes);
+    OE_TEST(profile.num_blocks > 0);
+    OE_TEST(profile.min_addr >= profile.map_start);
+    OE_TEST(profile.max_addr < profile.map_end);
+
+    estimate = (double)profile.num_blocks * BLOCK_SIZE / SAMPLE_PROBABILITY;
+    printf(
+        "%lu samples, estimated %.0f bytes in use of %d\n",
+        profile.num_blocks,
+        estimate,
+        BLOCK_SIZE * NUM_BLOCKS);
+
+    /* About 440 samples are expected, so 20% is about five deviations */
+    OE_TEST(estimate > 0.8 * BLOCK_SIZE * NUM_BLOCKS);
+    OE_TEST(estimate < 1.2 * BLOCK_SIZE * NUM_BLOCKS);
+
+    /* Freed blocks are no longer reported */
+    OE_TEST(enc_free(enclave) == OE_OK);
+    OE_TEST(enc_dump(enclave, &ret, path) == OE_OK);
+    OE_TEST(ret == OE_OK);
+
+    _parse(path, &profile);
+    OE_TEST(profile.num_blocks == 0);
+
+    /* Nothing is dumped after the profiler has stopped */
+    OE_TEST(enc_stop(enclave, &ret) == OE_OK);
+    OE_TEST(ret == OE_OK);
+    OE_TEST(enc_dump(enclave, &ret, path) == OE_OK);
+    OE_TEST(ret == OE_UNEXPECTED);
+
+    remove(path);
+
+    OE_TEST(oe_terminate_enclave(enclave) == OE_OK);
+
+    printf("=== passed all tests (heap_profiler)\n");
+
+    return 0;
+}
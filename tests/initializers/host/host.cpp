@@ -2,6 +2,7 @@
 // Licensed under the MIT License.
 
 #include <cstdio>
+#include <cstring>
 
 #include <openenclave/host.h>
 #include <openenclave/internal/error.h>
@@ -90,6 +91,91 @@ static void _globals_test(oe_enclave_t* enclave)
         OE_TEST(global_array[i] == 1);
 }
 
+static void _startup_trace_test(const char* path, uint32_t flags)
+{
+    const char* json_path = "initializers_startup_trace.json";
+    oe_enclave_t* enclave = NULL;
+    oe_enclave_setting_startup_trace_t trace_setting = {json_path};
+    oe_enclave_setting_t setting;
+    oe_startup_phase_timing_t timings[OE_STARTUP_PHASE_COUNT];
+    size_t count = 0;
+    oe_result_t result;
+
+    setting.setting_type = OE_ENCLAVE_SETTING_STARTUP_TRACE;
+    setting.u.startup_trace_setting = &trace_setting;
+
+    OE_TEST(
+        oe_create_initializers_enclave(
+            path, OE_ENCLAVE_TYPE_AUTO, flags, &setting, 1, &enclave) ==
+        OE_OK);
+
+    result = oe_get_enclave_startup_trace(enclave, NULL, &count);
+
+    if (result == OE_UNSUPPORTED)
+    {
+        printf("Startup trace is not supported, skipping.\n");
+        oe_terminate_enclave(enclave);
+        return;
+    }
+
+    /* Every phase completes exactly once during creation */
+    OE_TEST(result == OE_BUFFER_TOO_SMALL);
+    OE_TEST(count == OE_STARTUP_PHASE_COUNT);
+    OE_TEST(oe_get_enclave_startup_trace(enclave, timings, &count) == OE_OK);
+
+    const oe_startup_phase_timing_t* total = &timings[count - 1];
+    OE_TEST(total->phase == OE_STARTUP_PHASE_CREATE_ENCLAVE);
+    OE_TEST(total->start_ns == 0);
+
+    for (size_t i = 0; i < count; i++)
+    {
+        const oe_startup_phase_timing_t* t = &timings[i];
+
+        printf(
+            "%-20s start=%8llu us duration=%8llu us pages=%llu\n",
+            t->name,
+            (unsigned long long)(t->start_ns / 1000),
+            (unsigned long long)(t->duration_ns / 1000),
+            (unsigned long long)t->num_pages);
+
+        /* Phases are sequential and nested within the whole call */
+        OE_TEST(t->phase == (oe_startup_phase_t)i);
+        if (i > 0)
+            OE_TEST(
+                t->start_ns >=
+                timings[i - 1].start_ns + timings[i - 1].duration_ns);
+
+        OE_TEST(t->start_ns + t->duration_ns <= total->duration_ns);
+    }
+
+    OE_TEST(timings[OE_STARTUP_PHASE_ADD_IMAGE_PAGES].num_pages > 0);
+    OE_TEST(timings[OE_STARTUP_PHASE_ADD_THREAD_PAGES].num_pages > 0);
+
+    /* The Chrome trace file was written */
+    {
+        char buf[16] = {0};
+        FILE* stream = fopen(json_path, "r");
+
+        OE_TEST(stream != NULL);
+        OE_TEST(fread(buf, 1, sizeof(buf) - 1, stream) > 0);
+        OE_TEST(strncmp(buf, "{\"traceEvents\"", 14) == 0);
+        fclose(stream);
+        remove(json_path);
+    }
+
+    oe_terminate_enclave(enclave);
+
+    /* An enclave created without the setting has no trace */
+    OE_TEST(
+        oe_create_initializers_enclave(
+            path, OE_ENCLAVE_TYPE_AUTO, flags, NULL, 0, &enclave) == OE_OK);
+    count = OE_STARTUP_PHASE_COUNT;
+    OE_TEST(
+        oe_get_enclave_startup_trace(enclave, timings, &count) ==
+        OE_NOT_FOUND);
+    oe_terminate_enclave(enclave);
+}
+
 int main(int argc, const char* argv[])
 {
     oe_result_t result;
@@ -112,9 +198,12 @@ int main(int argc, const char* argv[])
     printf("===Starting globals test.\n");
     _globals_test(enclave);
 
-    printf("===All tests pass.\n");
-
     oe_terminate_enclave(enclave);
 
+    printf("===Starting startup trace test.\n");
+    _startup_trace_test(argv[1], flags);
+
+    printf("===All tests pass.\n");
+
     return 0;
 }
@@ -3,11 +3,13 @@
 
 #include <openenclave/enclave.h>
 #include <openenclave/internal/globals.h>
+#include <openenclave/internal/malloc.h>
 #include <openenclave/internal/tests.h>
 
 #include <malloc.h>
 #include <stdint.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include "memory_t.h"
 
@@ -197,3 +199,115 @@ void test_malloc_usable_size(void)
     free(p1);
     free(p2);
 }
+
+/* A block freed by test_thread_cache(), in a size no ecall dispatch uses */
+#define _CACHED_BLOCK_SIZE 440
+static void* _cached_block;
+
+void test_thread_cache(void)
+{
+    oe_result_t result = oe_set_malloc_thread_cache_enabled(true);
+
+    /* The debug allocator and snmalloc have no thread cache to switch. */
+    if (result == OE_UNSUPPORTED)
+        return;
+    OE_TEST(result == OE_OK);
+
+    /* A freed small block is handed out again by this thread with the same
+     * usable size, and calloc clears it. */
+    unsigned char* p1 = (unsigned char*)malloc(100);
+    OE_TEST(p1 != NULL);
+    const size_t size = malloc_usable_size(p1);
+    OE_TEST(size >= 100);
+    memset(p1, 0xff, size);
+    free(p1);
+
+    unsigned char* p2 = (unsigned char*)calloc(1, 100);
+    OE_TEST(p2 == p1);
+    OE_TEST(malloc_usable_size(p2) == size);
+    for (size_t i = 0; i < 100; i++)
+        OE_TEST(p2[i] == 0);
+
+    /* A cached block can be resized. */
+    p2 = (unsigned char*)realloc(p2, 4096);
+    OE_TEST(p2 != NULL);
+    for (size_t i = 0; i < 100; i++)
+        OE_TEST(p2[i] == 0);
+    free(p2);
+
+    /* Free more blocks than the cache holds, so that some are returned to
+     * the heap, then allocate them again. */
+    void* blocks[1024];
+    for (int round = 0; round < 2; round++)
+    {
+        for (size_t i = 0; i < OE_COUNTOF(blocks); i++)
+        {
+            blocks[i] = malloc(16 + (i % 32) * 8);
+            OE_TEST(blocks[i] != NULL);
+            memset(blocks[i], (int)i, 16);
+        }
+
+        for (size_t i = 0; i < OE_COUNTOF(blocks); i++)
+        {
+            unsigned char* block = (unsigned char*)blocks[i];
+            OE_TEST(block[0] == (unsigned char)i && block[15] == block[0]);
+            free(block);
+        }
+    }
+
+    /* Blocks cached before the cache is disabled can still be freed. */
+    p1 = (unsigned char*)malloc(64);
+    OE_TEST(p1 != NULL);
+    OE_TEST(oe_set_malloc_thread_cache_enabled(false) == OE_OK);
+    p2 = (unsigned char*)malloc(64);
+    OE_TEST(p2 != NULL && p2 != p1);
+    free(p1);
+    free(p2);
+    OE_TEST(oe_set_malloc_thread_cache_enabled(true) == OE_OK);
+
+    /* Leave a block in the cache for test_thread_cache_across_ecalls() */
+    _cached_block = malloc(_CACHED_BLOCK_SIZE);
+    OE_TEST(_cached_block != NULL);
+    free(_cached_block);
+}
+
+void test_thread_cache_across_ecalls(void)
+{
+    /* The host makes this ecall after test_thread_cache() from the same
+     * thread, which is given the same TCS. Its cache is kept between the
+     * ecalls. */
+    if (!_cached_block)
+        return;
+
+    void* p = malloc(_CACHED_BLOCK_SIZE);
+    OE_TEST(p == _cached_block);
+    free(p);
+    _cached_block = NULL;
+}
+
+/* Blocks kept across ecalls, so that the host sees them in the heap
+ * statistics */
+static void* _heap_stats_blocks[256];
+static size_t _heap_stats_num_blocks;
+
+void heap_stats_allocate(size_t size, size_t count)
+{
+    OE_TEST(_heap_stats_num_blocks == 0);
+    OE_TEST(count <= OE_COUNTOF(_heap_stats_blocks));
+
+    for (size_t i = 0; i < count; i++)
+    {
+        _heap_stats_blocks[i] = malloc(size);
+        OE_TEST(_heap_stats_blocks[i] != NULL);
+    }
+
+    _heap_stats_num_blocks = count;
+}
+
+void heap_stats_free(void)
+{
+    for (size_t i = 0; i < _heap_stats_num_blocks; i++)
+        free(_heap_stats_blocks[i]);
+
+    _heap_stats_num_blocks = 0;
+}
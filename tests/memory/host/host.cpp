@@ -23,6 +23,74 @@ static void _malloc_basic_test(oe_enclave_t* enclave)
     OE_TEST(test_memalign(enclave) == OE_OK);
     OE_TEST(test_posix_memalign(enclave) == OE_OK);
     OE_TEST(test_malloc_usable_size(enclave) == OE_OK);
+    OE_TEST(test_thread_cache(enclave) == OE_OK);
+    OE_TEST(test_thread_cache_across_ecalls(enclave) == OE_OK);
+}
+
+#define HEAP_STATS_BLOCK_SIZE 100
+#define HEAP_STATS_NUM_BLOCKS 64
+
+/* The size class of blocks of 65 to 128 bytes */
+#define HEAP_STATS_SIZE_CLASS 3
+
+static uint64_t _total_allocs(const oe_enclave_heap_stats_t& stats)
+{
+    uint64_t total = 0;
+
+    for (size_t i = 0; i < OE_HEAP_STATS_NUM_SIZE_CLASSES; i++)
+        total += stats.alloc_count[i];
+
+    return total;
+}
+
+static void _heap_stats_test(oe_enclave_t* enclave)
+{
+    oe_enclave_heap_stats_t before;
+    oe_enclave_heap_stats_t allocated;
+    oe_enclave_heap_stats_t freed;
+    const size_t c = HEAP_STATS_SIZE_CLASS;
+
+    OE_TEST(oe_get_enclave_heap_stats(enclave, NULL) == OE_INVALID_PARAMETER);
+    OE_TEST(oe_get_enclave_heap_stats(enclave, &before) == OE_OK);
+
+    OE_TEST(
+        heap_stats_allocate(
+            enclave, HEAP_STATS_BLOCK_SIZE, HEAP_STATS_NUM_BLOCKS) == OE_OK);
+    OE_TEST(oe_get_enclave_heap_stats(enclave, &allocated) == OE_OK);
+
+    OE_TEST(heap_stats_free(enclave) == OE_OK);
+    OE_TEST(oe_get_enclave_heap_stats(enclave, &freed) == OE_OK);
+
+    /* The heap never grows beyond its end */
+    OE_TEST(before.heap_size > 0);
+    OE_TEST(allocated.heap_peak_used_bytes >= allocated.heap_used_bytes);
+    OE_TEST(allocated.heap_peak_used_bytes <= allocated.heap_size);
+    OE_TEST(allocated.heap_committed_bytes >= allocated.heap_used_bytes);
+    OE_TEST(allocated.heap_committed_bytes <= allocated.heap_size);
+
+    /* snmalloc keeps no allocation counters */
+    if (_total_allocs(allocated) == 0)
+        return;
+
+    /* dlmalloc grows the heap through sbrk */
+    OE_TEST(before.heap_grow_count > 0);
+    OE_TEST(allocated.heap_used_bytes > 0);
+
+    OE_TEST(
+        allocated.alloc_count[c] - before.alloc_count[c] >=
+        HEAP_STATS_NUM_BLOCKS);
+    OE_TEST(
+        allocated.in_use_bytes >=
+        HEAP_STATS_BLOCK_SIZE * HEAP_STATS_NUM_BLOCKS);
+    OE_TEST(
+        freed.free_count[c] - allocated.free_count[c] >=
+        HEAP_STATS_NUM_BLOCKS);
+    OE_TEST(
+        allocated.in_use_bytes - freed.in_use_bytes >=
+        HEAP_STATS_BLOCK_SIZE * HEAP_STATS_NUM_BLOCKS);
+
+    for (size_t i = 0; i < OE_HEAP_STATS_NUM_SIZE_CLASSES; i++)
+        OE_TEST(freed.free_count[i] <= freed.alloc_count[i]);
 }
 
 static void _malloc_stress_test_single_thread(
@@ -137,6 +205,9 @@ int main(int argc, const char* argv[])
     printf("===Starting basic malloc test.\n");
     _malloc_basic_test(enclave);
 
+    printf("===Starting heap statistics test.\n");
+    _heap_stats_test(enclave);
+
     printf("===Starting malloc stress test.\n");
     _malloc_stress_test(enclave);
 
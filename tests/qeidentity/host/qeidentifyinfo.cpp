@@ -3,6 +3,7 @@
 #ifdef OE_LINK_SGX_DCAP_QL
 
 #include <openenclave/host.h>
+#include <openenclave/internal/datetime.h>
 #include <openenclave/internal/error.h>
 #include <openenclave/internal/hexdump.h>
 #include <openenclave/internal/safecrt.h>
@@ -111,6 +112,49 @@ void check_parsed_v2_values(oe_parsed_qe_identity_info_t& parsed_info)
     check_parsed_common_values(parsed_info);
 }
 
+// Compile the info on the host and check that looking up the platform's tcb
+// level in the compiled info gives the same results as parsing it.
+void check_compiled_qe_identity_info(
+    const std::vector<uint8_t>& info_json,
+    uint32_t isvsvn,
+    oe_result_t expected_result,
+    const oe_parsed_qe_identity_info_t* expected_info)
+{
+    oe_compiled_qe_identity_info_t compiled;
+    oe_qe_identity_info_tcb_level_t platform_tcb_level = {{isvsvn}};
+    oe_parsed_qe_identity_info_t parsed_info = {0};
+    oe_result_t result = oe_compile_qe_identity_info_json(
+        &info_json[0], info_json.size(), &compiled);
+
+    if (result == OE_OK)
+    {
+        result = oe_compiled_qe_identity_info_get_tcb_level(
+            &compiled, &platform_tcb_level, &parsed_info);
+        oe_free_compiled_qe_identity_info(&compiled);
+    }
+
+    OE_TEST(result == expected_result);
+
+    if (expected_info)
+    {
+        OE_TEST(parsed_info.version == expected_info->version);
+        OE_TEST(parsed_info.id == expected_info->id);
+        OE_TEST(parsed_info.isvprodid == expected_info->isvprodid);
+        OE_TEST(parsed_info.isvsvn == expected_info->isvsvn);
+        OE_TEST(
+            parsed_info.tcb_level.tcb_status.AsUINT32 ==
+            expected_info->tcb_level.tcb_status.AsUINT32);
+        OE_TEST(
+            memcmp(
+                parsed_info.mrsigner,
+                expected_info->mrsigner,
+                sizeof(parsed_info.mrsigner)) == 0);
+        OE_TEST(
+            oe_datetime_compare(
+                &parsed_info.next_update, &expected_info->next_update) == 0);
+    }
+}
+
 void run_qe_identity_test_cases(oe_enclave_t* enclave)
 {
     // validate positive case
@@ -130,6 +174,8 @@ void run_qe_identity_test_cases(oe_enclave_t* enclave)
             &parsed_info) == OE_OK);
     OE_TEST(ecall_result == OE_OK);
     check_parsed_v1_values(parsed_info);
+    check_compiled_qe_identity_info(
+        positive_qe_id_info, 0, OE_OK, &parsed_info);
 
     // validate negative case
     qe_identity_test_case_t test_cases[] = {
@@ -172,6 +218,8 @@ void run_qe_identity_test_cases(oe_enclave_t* enclave)
             oe_result_str(ecall_result),
             oe_result_str(test_cases[i].expected_result));
         OE_TEST(ecall_result == test_cases[i].expected_result);
+        check_compiled_qe_identity_info(
+            qeIdInfo, 0, test_cases[i].expected_result, NULL);
         printf("passed\n");
     }
 }
@@ -249,6 +297,8 @@ void run_qe_identity_v2_test_cases(oe_enclave_t* enclave)
     OE_TEST(ecall_result == OE_OK);
     OE_TEST(parsed_info.id == QE_IDENTITY_ID_QE);
     check_parsed_v2_values(parsed_info);
+    check_compiled_qe_identity_info(
+        positive_qe_id_info, 2, OE_OK, &parsed_info);
     printf("\n\nQE Identity V2 positive test. PASSED.\n");
 
     // QE Identity V2 negative, OutOfDate
@@ -263,6 +313,8 @@ void run_qe_identity_v2_test_cases(oe_enclave_t* enclave)
     OE_TEST(ecall_result == OE_TCB_LEVEL_INVALID);
     OE_TEST(parsed_info.id == QE_IDENTITY_ID_QE);
     OE_TEST(parsed_info.tcb_level.tcb_status.fields.outofdate == 1);
+    check_compiled_qe_identity_info(
+        positive_qe_id_info, 1, OE_TCB_LEVEL_INVALID, &parsed_info);
     printf("\n\nQE Identity V2 positive test, OutOfDate. PASSED.\n");
 
     // QE Identity V2 positive with advisoryIDs
@@ -321,6 +373,8 @@ void run_qe_identity_v2_test_cases(oe_enclave_t* enclave)
     OE_TEST(ecall_result == OE_OK);
     OE_TEST(parsed_info.id == QE_IDENTITY_ID_QVE);
     check_parsed_v2_values(parsed_info);
+    check_compiled_qe_identity_info(
+        positive_qve_id_info, 2, OE_OK, &parsed_info);
     printf("\n\nQVE Identity V2 positive test. PASSED.\n");
 
     // negative test without a valid platform_tcb_level
@@ -390,6 +444,8 @@ void run_qe_identity_v2_test_cases(oe_enclave_t* enclave)
             oe_result_str(ecall_result),
             oe_result_str(test_cases[i].expected_result));
         OE_TEST(ecall_result == test_cases[i].expected_result);
+        check_compiled_qe_identity_info(
+            qeIdInfo, 0, test_cases[i].expected_result, NULL);
         printf("passed\n");
     }
 }
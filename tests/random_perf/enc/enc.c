@@ -0,0 +1,71 @@
+// Copyright (c) Open Enclave SDK contributors.
+// Licensed under the MIT License.
+
+#include <mbedtls/ctr_drbg.h>
+#include <openenclave/enclave.h>
+#include <openenclave/internal/rdrand.h>
+#include <string.h>
+
+#include "random_perf_t.h"
+
+#define MAX_REQUEST_SIZE 4096
+
+/* The per-thread DRBG of the crypto library (enclave/crypto/ctr_drbg.h) */
+mbedtls_ctr_drbg_context* oe_mbedtls_get_drbg();
+
+/* The way oe_random() generated bytes before the keystream, one RDRAND per
+ * 8 bytes */
+static void _rdrand(uint8_t* data, size_t size)
+{
+    for (size_t i = 0; i < size; i += sizeof(uint64_t))
+    {
+        uint64_t r = oe_rdrand();
+        size_t n = size - i < sizeof(r) ? size - i : sizeof(r);
+        memcpy(data + i, &r, n);
+    }
+}
+
+oe_result_t enc_run(
+    generator_t generator,
+    size_t request_size,
+    uint64_t iterations)
+{
+    uint8_t data[MAX_REQUEST_SIZE];
+    mbedtls_ctr_drbg_context* drbg = NULL;
+
+    if (request_size > MAX_REQUEST_SIZE)
+        return OE_INVALID_PARAMETER;
+
+    if (generator == GENERATOR_DRBG && !(drbg = oe_mbedtls_get_drbg()))
+        return OE_FAILURE;
+
+    for (uint64_t i = 0; i < iterations; i++)
+    {
+        switch (generator)
+        {
+            case GENERATOR_RDRAND:
+                _rdrand(data, request_size);
+                break;
+            case GENERATOR_OE_RANDOM:
+                if (oe_random(data, request_size) != OE_OK)
+                    return OE_FAILURE;
+                break;
+            case GENERATOR_DRBG:
+                if (mbedtls_ctr_drbg_random(drbg, data, request_size) != 0)
+                    return OE_FAILURE;
+                break;
+            default:
+                return OE_INVALID_PARAMETER;
+        }
+    }
+
+    return OE_OK;
+}
+
+OE_SET_ENCLAVE_SGX(
+    1,    /* ProductID */
+    1,    /* SecurityVersion */
+    true, /* AllowDebug */
+    1024, /* HeapPageCount */
+    64,   /* StackPageCount */
+    16);  /* TCSCount */
@@ -0,0 +1,193 @@
+// Copyright (c) Open Enclave SDK contributors.
+// Licensed under the MIT License.
+
+#include <openenclave/host.h>
+#include <openenclave/internal/tests.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "random_perf_u.h"
+
+#define DEFAULT_THREADS 4
+#define DEFAULT_BYTES (16 * 1024 * 1024)
+
+/* Must not exceed the TCSCount of the enclave */
+#define MAX_THREADS 16
+
+/*
+**==============================================================================
+**
+** Enclave randomness benchmark:
+**
+**     random_perf_host ENCLAVE [THREADS] [BYTES]
+**
+**         Generates BYTES random bytes per thread in the enclave, in
+**         requests of several sizes, on 1, 2, 4, ... up to THREADS threads
+**         at once, and reports the throughput of all threads together:
+**
+**             rdrand     one RDRAND instruction per 8 bytes, which is how
+**                        oe_random() used to generate its bytes
+**             oe_random  oe_random(), which serves small requests from a
+**                        buffer and bulk requests from an AES-CTR keystream
+**             drbg       mbedtls_ctr_drbg_random() on the per-thread DRBG of
+**                        the crypto library
+**
+**==============================================================================
+*/
+
+typedef struct _workload
+{
+    generator_t generator;
+    size_t request_size;
+} workload_t;
+
+typedef struct _thread_args
+{
+    const workload_t* workload;
+    oe_result_t result;
+} thread_args_t;
+
+static oe_enclave_t* _enclave;
+static uint64_t _bytes = DEFAULT_BYTES;
+
+/* The mbedTLS DRBG serves at most 1024 bytes per request */
+static const workload_t _workloads[] = {
+    {GENERATOR_RDRAND, 16},
+    {GENERATOR_OE_RANDOM, 16},
+    {GENERATOR_DRBG, 16},
+    {GENERATOR_RDRAND, 1024},
+    {GENERATOR_OE_RANDOM, 1024},
+    {GENERATOR_DRBG, 1024},
+    {GENERATOR_RDRAND, 4096},
+    {GENERATOR_OE_RANDOM, 4096},
+};
+
+static const char* _generator_names[] = {
+    "rdrand",
+    "oe_random",
+    "drbg",
+};
+
+static double _get_time_in_seconds(void)
+{
+    struct timespec current_time;
+    clock_gettime(CLOCK_MONOTONIC, &current_time);
+    return (double)current_time.tv_sec + (double)current_time.tv_nsec / 1e9;
+}
+
+static uint64_t _iterations(const workload_t* workload)
+{
+    uint64_t iterations = _bytes / workload->request_size;
+    return iterations ? iterations : 1;
+}
+
+static void* _thread(void* arg)
+{
+    thread_args_t* args = (thread_args_t*)arg;
+    oe_result_t result = enc_run(
+        _enclave,
+        &args->result,
+        args->workload->generator,
+        args->workload->request_size,
+        _iterations(args->workload));
+
+    if (result != OE_OK)
+        args->result = result;
+
+    return NULL;
+}
+
+static void _run(const workload_t* workload, size_t threads)
+{
+    pthread_t ids[MAX_THREADS];
+    thread_args_t args[MAX_THREADS];
+    double start;
+    double elapsed;
+    double bytes;
+
+    start = _get_time_in_seconds();
+
+    for (size_t i = 0; i < threads; i++)
+    {
+        args[i].workload = workload;
+        args[i].result = OE_UNEXPECTED;
+        OE_TEST(pthread_create(&ids[i], NULL, _thread, &args[i]) == 0);
+    }
+
+    for (size_t i = 0; i < threads; i++)
+    {
+        pthread_join(ids[i], NULL);
+        OE_TEST(args[i].result == OE_OK);
+    }
+
+    elapsed = _get_time_in_seconds() - start;
+    bytes = (double)threads * (double)_iterations(workload) *
+            (double)workload->request_size;
+
+    printf(
+        "%-10s %12zu %7zu %12.1f\n",
+        _generator_names[workload->generator],
+        workload->request_size,
+        threads,
+        bytes / elapsed / 1e6);
+}
+
+int main(int argc, const char* argv[])
+{
+    oe_result_t result;
+    size_t threads = DEFAULT_THREADS;
+
+    if (argc < 2 || argc > 4)
+    {
+        fprintf(stderr, "Usage: %s ENCLAVE [THREADS] [BYTES]\n", argv[0]);
+        return 1;
+    }
+
+    if (argc > 2)
+        threads = strtoul(argv[2], NULL, 10);
+
+    if (argc > 3)
+        _bytes = strtoull(argv[3], NULL, 10);
+
+    if (threads < 1 || threads > MAX_THREADS || !_bytes)
+    {
+        fprintf(
+            stderr,
+            "%s: THREADS must be 1 to %d, BYTES at least 1\n",
+            argv[0],
+            MAX_THREADS);
+        return 1;
+    }
+
+    result = oe_create_random_perf_enclave(
+        argv[1],
+        OE_ENCLAVE_TYPE_AUTO,
+        oe_get_create_flags(),
+        NULL,
+        0,
+        &_enclave);
+    OE_TEST(result == OE_OK);
+
+    printf(
+        "%-10s %12s %7s %12s\n",
+        "generator",
+        "request size",
+        "threads",
+        "MB/s");
+
+    for (size_t i = 0; i < OE_COUNTOF(_workloads); i++)
+    {
+        for (size_t n = 1; n < threads; n *= 2)
+            _run(&_workloads[i], n);
+
+        _run(&_workloads[i], threads);
+    }
+
+    OE_TEST(oe_terminate_enclave(_enclave) == OE_OK);
+
+    printf("=== passed all tests (random_perf)\n");
+
+    return 0;
+}
@@ -3,18 +3,27 @@
 
 #include "../common/tests.h"
 #include <openenclave/internal/crypto/cmac.h>
+#include <openenclave/internal/datetime.h>
 #include <openenclave/internal/raise.h>
 #include <openenclave/internal/report.h>
 #include <openenclave/internal/tests.h>
 
 #ifndef OE_BUILD_ENCLAVE
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
 #include "../../../host/sgx/sgxquoteprovider.h"
 #endif
 #include "../../../common/oe_host_stdlib.h"
 #include "../../../common/sgx/collateral.h"
+#include "../../../common/sgx/certchaincache.h"
+#include "../../../common/sgx/collateralcache.h"
 #include "../../../common/sgx/endorsements.h"
 #include "../../../common/sgx/qeidentity.h"
 #include "../../../common/sgx/quote.h"
+#include "../../../common/sgx/tcbinfocache.h"
+#include "../../../common/sgx/verificationcache.h"
 
 #include <time.h>
 
@@ -1283,6 +1292,59 @@ void test_verify_report_with_collaterals()
 
     if (GetCollaterals(&collaterals_buffer_ptr, &collaterals_ptr_size) == OE_OK)
     {
+        /* The collaterals of the same platform are served from the cache */
+        {
+            oe_sgx_collateral_cache_stats_t before = {0};
+            oe_sgx_collateral_cache_stats_t after = {0};
+            uint8_t* cached_ptr = NULL;
+            size_t cached_size = 0;
+
+            oe_sgx_collateral_cache_get_stats(&before);
+            OE_TEST(GetCollaterals(&cached_ptr, &cached_size) == OE_OK);
+            oe_sgx_collateral_cache_get_stats(&after);
+
+            OE_TEST(after.hits > before.hits);
+            OE_TEST(after.fetches == before.fetches);
+            OE_TEST(cached_size == collaterals_ptr_size);
+            OE_TEST(
+                VerifyReportWithCollaterals(
+                    report_buffer_ptr,
+                    report_ptr_size,
+                    cached_ptr,
+                    cached_size,
+                    NULL,
+                    NULL) == OE_OK);
+            oe_free_collaterals(cached_ptr);
+        }
+
+        /* Verifying again only parses and verifies the PCK certificate; the
+         * issuer chains in the quote and the collaterals, and the compiled
+         * TCB info and QE identity info, are cached */
+        {
+            oe_sgx_cert_chain_cache_stats_t before = {0};
+            oe_sgx_cert_chain_cache_stats_t after = {0};
+            oe_sgx_tcb_info_cache_stats_t tcb_before = {0};
+            oe_sgx_tcb_info_cache_stats_t tcb_after = {0};
+
+            oe_sgx_cert_chain_cache_get_stats(&before);
+            oe_sgx_tcb_info_cache_get_stats(&tcb_before);
+            OE_TEST(
+                VerifyReportWithCollaterals(
+                    report_buffer_ptr,
+                    report_ptr_size,
+                    collaterals_buffer_ptr,
+                    collaterals_ptr_size,
+                    NULL,
+                    NULL) == OE_OK);
+            oe_sgx_cert_chain_cache_get_stats(&after);
+            oe_sgx_tcb_info_cache_get_stats(&tcb_after);
+
+            OE_TEST(after.hits > before.hits);
+            OE_TEST(after.misses == before.misses);
+            OE_TEST(tcb_after.hits >= tcb_before.hits + 2);
+            OE_TEST(tcb_after.misses == tcb_before.misses);
+        }
+
         OE_TEST(
             VerifyReportWithCollaterals(
                 report_buffer_ptr,
@@ -1379,6 +1441,92 @@ void test_verify_report_with_collaterals()
                 collaterals_ptr_size,
                 &valid_until,
                 NULL) == OE_VERIFY_FAILED_TO_FIND_VALIDITY_PERIOD);
+
+        /* With the verification result cache enabled, verifying the same
+         * report and collaterals again is answered from the cache, but only
+         * for a time within their validity period */
+        {
+            oe_verification_result_cache_stats_t before = {0};
+            oe_verification_result_cache_stats_t after = {0};
+
+            OE_TEST(oe_set_verification_result_cache_size(4) == OE_OK);
+            OE_TEST(
+                VerifyReportWithCollaterals(
+                    report_buffer_ptr,
+                    report_ptr_size,
+                    collaterals_buffer_ptr,
+                    collaterals_ptr_size,
+                    NULL,
+                    NULL) == OE_OK);
+
+            OE_TEST(oe_get_verification_result_cache_stats(&before) == OE_OK);
+            OE_TEST(
+                VerifyReportWithCollaterals(
+                    report_buffer_ptr,
+                    report_ptr_size,
+                    collaterals_buffer_ptr,
+                    collaterals_ptr_size,
+                    NULL,
+                    NULL) == OE_OK);
+            OE_TEST(oe_get_verification_result_cache_stats(&after) == OE_OK);
+            OE_TEST(after.hits == before.hits + 1);
+            OE_TEST(after.misses == before.misses);
+
+            /* Endorsements that are fetched again get a new creation
+             * datetime, which is not part of the key */
+            {
+                oe_sgx_endorsements_t sgx_endorsements = {{{0}}};
+                oe_sgx_endorsement_item* item = NULL;
+                oe_datetime_t created = valid_until;
+                size_t created_size = 0;
+
+                /* valid_until is a year past the validity period by now */
+                created.year -= 1;
+
+                OE_TEST(
+                    oe_parse_sgx_endorsements(
+                        (oe_endorsements_t*)collaterals_buffer_ptr,
+                        collaterals_ptr_size,
+                        &sgx_endorsements) == OE_OK);
+                item = &sgx_endorsements
+                            .items[OE_SGX_ENDORSEMENT_FIELD_CREATION_DATETIME];
+                created_size = item->size;
+                OE_TEST(
+                    oe_datetime_to_string(
+                        &created, (char*)item->data, &created_size) == OE_OK);
+
+                OE_TEST(
+                    VerifyReportWithCollaterals(
+                        report_buffer_ptr,
+                        report_ptr_size,
+                        collaterals_buffer_ptr,
+                        collaterals_ptr_size,
+                        NULL,
+                        NULL) == OE_OK);
+                OE_TEST(
+                    oe_get_verification_result_cache_stats(&after) == OE_OK);
+                OE_TEST(after.hits == before.hits + 2);
+                OE_TEST(after.misses == before.misses);
+            }
+
+            OE_TEST(
+                VerifyReportWithCollaterals(
+                    report_buffer_ptr,
+                    report_ptr_size,
+                    collaterals_buffer_ptr,
+                    collaterals_ptr_size,
+                    &valid_until,
+                    NULL) == OE_VERIFY_FAILED_TO_FIND_VALIDITY_PERIOD);
+            OE_TEST(oe_get_verification_result_cache_stats(&after) == OE_OK);
+            OE_TEST(after.hits == before.hits + 2);
+            OE_TEST(after.misses == before.misses + 1);
+
+            OE_TEST(
+                oe_set_verification_result_cache_size(
+                    OE_SGX_VERIFICATION_CACHE_MAX_SIZE + 1) ==
+                OE_INVALID_PARAMETER);
+            OE_TEST(oe_set_verification_result_cache_size(0) == OE_OK);
+        }
     }
 
     oe_free_collaterals(collaterals_buffer_ptr);
@@ -1387,3 +1535,265 @@ void test_verify_report_with_collaterals()
     collaterals_buffer_ptr = NULL;
     report_buffer_ptr = NULL;
 }
+
+typedef struct _stub_collateral
+{
+    oe_result_t result;
+    oe_datetime_t next_update;
+    uint8_t value;
+    size_t fetches;
+} stub_collateral_t;
+
+static oe_result_t _fetch_stub_collateral(
+    void* arg,
+    uint8_t** data,
+    size_t* size,
+    oe_datetime_t* next_update)
+{
+    stub_collateral_t* stub = (stub_collateral_t*)arg;
+
+    stub->fetches++;
+    if (stub->result != OE_OK)
+        return stub->result;
+
+    if (!(*data = (uint8_t*)oe_malloc(1)))
+        return OE_OUT_OF_MEMORY;
+
+    (*data)[0] = stub->value;
+    *size = 1;
+    *next_update = stub->next_update;
+
+    return OE_OK;
+}
+
+static void _get_stub_collateral(
+    const uint8_t fmspc[6],
+    const char* ca,
+    stub_collateral_t* stub,
+    uint8_t expected_value)
+{
+    uint8_t* data = NULL;
+    size_t size = 0;
+
+    OE_TEST(
+        oe_sgx_collateral_cache_get(
+            fmspc, ca, _fetch_stub_collateral, stub, &data, &size) == OE_OK);
+    OE_TEST(size == 1 && data[0] == expected_value);
+    oe_free(data);
+}
+
+// A self-signed P-256 certificate that is valid from 2020 to 2120.
+static const char _TEST_ROOT_CERT_PEM[] =
+    "-----BEGIN CERTIFICATE-----\n"
+    "MIIBUDCB96ADAgECAgEBMAoGCCqGSM49BAMCMBcxFTATBgNVBAMMDFRlc3QgUm9v\n"
+    "dCBDQTAgFw0yMDAxMDEwMDAwMDBaGA8yMTIwMDEwMTAwMDAwMFowFzEVMBMGA1UE\n"
+    "AwwMVGVzdCBSb290IENBMFkwEwYHKoZIzj0CAQYIKoZIzj0DAQcDQgAEajAG+xed\n"
+    "1lLwn22J9zOG+chd3cLK5fCkIqGANqB6StULMg0RTq92yBva5ItAmLoZkB7I7gKi\n"
+    "tWwUy34rv2pdyKMyMDAwDwYDVR0TAQH/BAUwAwEB/zAdBgNVHQ4EFgQUhibg4gAF\n"
+    "wJuP+JR/GEceGjsafo4wCgYIKoZIzj0EAwIDSAAwRQIgVKRqtK84vn/dlHG2nadD\n"
+    "GpgieAIo7IkYatAF4dIqAyUCIQCjoJxdllhh4e7z87SW0cfdVW1wK9Q3Pk2/MbNM\n"
+    "XbBTSA==\n"
+    "-----END CERTIFICATE-----\n";
+
+void test_cert_chain_cache()
+{
+    oe_sgx_cert_chain_cache_stats_t before = {0};
+    oe_sgx_cert_chain_cache_stats_t after = {0};
+
+    /* Chains that are not anchored at Intel's root CA are verified on every
+     * call and never cached */
+    oe_sgx_cert_chain_cache_get_stats(&before);
+    for (int i = 0; i < 2; i++)
+    {
+        oe_sgx_cert_chain_t chain = {0};
+
+        OE_TEST(
+            oe_sgx_get_cert_chain(
+                (const uint8_t*)_TEST_ROOT_CERT_PEM,
+                sizeof(_TEST_ROOT_CERT_PEM),
+                &chain) == OE_OK);
+        OE_TEST(!chain.intel_root);
+        OE_TEST(chain.chain == &chain.owned_chain);
+        oe_sgx_free_cert_chain(&chain);
+    }
+    oe_sgx_cert_chain_cache_get_stats(&after);
+
+    OE_TEST(after.hits == before.hits);
+    OE_TEST(after.misses == before.misses + 2);
+}
+
+#ifndef OE_BUILD_ENCLAVE
+typedef struct _slow_collateral
+{
+    uint8_t value;
+    std::atomic<int> fetches;
+
+    /* Set when the fetch starts. If wait_for is set, the fetch returns only
+     * once wait_for has started too, or fails after a few seconds */
+    std::atomic<bool> started;
+    struct _slow_collateral* wait_for;
+} slow_collateral_t;
+
+static oe_result_t _fetch_slow_collateral(
+    void* arg,
+    uint8_t** data,
+    size_t* size,
+    oe_datetime_t* next_update)
+{
+    slow_collateral_t* slow = (slow_collateral_t*)arg;
+
+    slow->fetches++;
+    slow->started = true;
+
+    if (slow->wait_for)
+    {
+        auto deadline =
+            std::chrono::steady_clock::now() + std::chrono::seconds(5);
+
+        while (!slow->wait_for->started)
+        {
+            if (std::chrono::steady_clock::now() > deadline)
+                return OE_FAILURE;
+
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+    else
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    }
+
+    if (!(*data = (uint8_t*)oe_malloc(1)))
+        return OE_OUT_OF_MEMORY;
+
+    (*data)[0] = slow->value;
+    *size = 1;
+    OE_TEST(oe_datetime_now(next_update) == OE_OK);
+    next_update->year += 1;
+
+    return OE_OK;
+}
+
+static void _get_slow_collateral(
+    const uint8_t* fmspc,
+    slow_collateral_t* slow)
+{
+    uint8_t* data = NULL;
+    size_t size = 0;
+
+    OE_TEST(
+        oe_sgx_collateral_cache_get(
+            fmspc,
+            OE_SGX_PCK_CA_PROCESSOR,
+            _fetch_slow_collateral,
+            slow,
+            &data,
+            &size) == OE_OK);
+    OE_TEST(size == 1 && data[0] == slow->value);
+    oe_free(data);
+}
+
+static void _test_collateral_cache_concurrency()
+{
+    const uint8_t fmspc1[6] = {0xff, 0xff, 0xff, 0xff, 0xff, 0x01};
+    const uint8_t fmspc2[6] = {0xff, 0xff, 0xff, 0xff, 0xff, 0x02};
+    slow_collateral_t slow1;
+    slow_collateral_t slow2;
+    std::vector<std::thread> threads;
+
+    slow1.value = 1;
+    slow1.fetches = 0;
+    slow1.started = false;
+    slow1.wait_for = NULL;
+    slow2.value = 2;
+    slow2.fetches = 0;
+    slow2.started = false;
+    slow2.wait_for = NULL;
+
+    /* Concurrent misses for one platform fetch once */
+    oe_sgx_collateral_cache_clear();
+    for (int i = 0; i < 8; i++)
+        threads.emplace_back(_get_slow_collateral, fmspc1, &slow1);
+    for (auto& thread : threads)
+        thread.join();
+    OE_TEST(slow1.fetches == 1);
+
+    /* Misses for different platforms fetch concurrently: each fetch waits
+     * until the other one has started */
+    oe_sgx_collateral_cache_clear();
+    threads.clear();
+    slow1.started = false;
+    slow1.wait_for = &slow2;
+    slow2.wait_for = &slow1;
+    threads.emplace_back(_get_slow_collateral, fmspc1, &slow1);
+    threads.emplace_back(_get_slow_collateral, fmspc2, &slow2);
+    for (auto& thread : threads)
+        thread.join();
+    OE_TEST(slow1.fetches == 2 && slow2.fetches == 1);
+
+    oe_sgx_collateral_cache_clear();
+}
+#endif
+
+void test_collateral_cache()
+{
+    const uint8_t fmspc1[6] = {0xff, 0xff, 0xff, 0xff, 0xff, 0x01};
+    const uint8_t fmspc2[6] = {0xff, 0xff, 0xff, 0xff, 0xff, 0x02};
+    oe_datetime_t now = {0};
+    stub_collateral_t stub = {OE_OK, {0}, 1, 0};
+    stub_collateral_t other = {OE_OK, {0}, 2, 0};
+    uint8_t* data = NULL;
+    size_t size = 0;
+
+    OE_TEST(oe_datetime_now(&now) == OE_OK);
+    stub.next_update = now;
+    stub.next_update.year += 1;
+    other.next_update = stub.next_update;
+
+    /* Only the first request for a platform fetches */
+    oe_sgx_collateral_cache_clear();
+    _get_stub_collateral(fmspc1, OE_SGX_PCK_CA_PROCESSOR, &stub, 1);
+    _get_stub_collateral(fmspc1, OE_SGX_PCK_CA_PROCESSOR, &stub, 1);
+    _get_stub_collateral(fmspc1, OE_SGX_PCK_CA_PROCESSOR, &other, 1);
+    OE_TEST(stub.fetches == 1 && other.fetches == 0);
+
+    /* Platforms are keyed by both FMSPC and CA */
+    _get_stub_collateral(fmspc2, OE_SGX_PCK_CA_PROCESSOR, &other, 2);
+    _get_stub_collateral(fmspc1, OE_SGX_PCK_CA_PLATFORM, &other, 2);
+    _get_stub_collateral(fmspc1, OE_SGX_PCK_CA_PROCESSOR, &stub, 1);
+    OE_TEST(stub.fetches == 1 && other.fetches == 2);
+
+    /* Collateral that is already stale is not cached */
+    oe_sgx_collateral_cache_clear();
+    stub.next_update = now;
+    stub.next_update.year -= 1;
+    _get_stub_collateral(fmspc1, OE_SGX_PCK_CA_PROCESSOR, &stub, 1);
+    _get_stub_collateral(fmspc1, OE_SGX_PCK_CA_PROCESSOR, &stub, 1);
+    OE_TEST(stub.fetches == 3);
+
+    /* Failures are returned and not cached */
+    stub.result = OE_QUOTE_PROVIDER_CALL_ERROR;
+    OE_TEST(
+        oe_sgx_collateral_cache_get(
+            fmspc1,
+            OE_SGX_PCK_CA_PROCESSOR,
+            _fetch_stub_collateral,
+            &stub,
+            &data,
+            &size) == OE_QUOTE_PROVIDER_CALL_ERROR);
+    OE_TEST(data == NULL && size == 0);
+    stub.result = OE_OK;
+    stub.next_update.year += 2;
+    _get_stub_collateral(fmspc1, OE_SGX_PCK_CA_PROCESSOR, &stub, 1);
+    OE_TEST(stub.fetches == 5);
+
+    /* The collateral of the successful retry is cached */
+    _get_stub_collateral(fmspc1, OE_SGX_PCK_CA_PROCESSOR, &stub, 1);
+    OE_TEST(stub.fetches == 5);
+
+    oe_sgx_collateral_cache_clear();
+
+#ifndef OE_BUILD_ENCLAVE
+    _test_collateral_cache_concurrency();
+#endif
+}
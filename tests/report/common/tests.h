@@ -26,5 +26,7 @@ void test_parse_report_negative();
 void test_local_verify_report();
 void test_remote_verify_report();
 void test_verify_report_with_collaterals();
+void test_collateral_cache();
+void test_cert_chain_cache();
 
 #endif
@@ -137,6 +137,31 @@ void enclave_test_verify_report_with_collaterals()
     test_verify_report_with_collaterals();
 }
 
+void enclave_test_collateral_cache()
+{
+    test_collateral_cache();
+}
+
+void enclave_generate_remote_reports(size_t count)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        uint8_t* report = NULL;
+        size_t report_size = 0;
+
+        OE_TEST(
+            oe_get_report(
+                OE_REPORT_FLAGS_REMOTE_ATTESTATION,
+                NULL,
+                0,
+                NULL,
+                0,
+                &report,
+                &report_size) == OE_OK);
+        oe_free_report(report);
+    }
+}
+
 OE_SET_ENCLAVE_SGX(
     0,    /* ProductID */
     0,    /* SecurityVersion */
@@ -7,6 +7,7 @@
 #include <openenclave/internal/hexdump.h>
 #include <openenclave/internal/tests.h>
 #include <openenclave/internal/utils.h>
+#include <chrono>
 #include <ctime>
 #include <vector>
 #include "../../../common/sgx/tcbinfo.h"
@@ -32,6 +33,28 @@ extern void TestVerifyTCBInfoV2_AdvisoryIDs(
     const char* test_filename);
 extern int FileToBytes(const char* path, std::vector<uint8_t>* output);
 
+#ifdef OE_LINK_SGX_DCAP_QL
+// Measure the throughput of remote report generation in the enclave. The
+// first report fetches the QE target info; later ones reuse it.
+static void benchmark_remote_reports(oe_enclave_t* enclave)
+{
+    const size_t count = 100;
+
+    OE_TEST(enclave_generate_remote_reports(enclave, 1) == OE_OK);
+
+    auto start = std::chrono::steady_clock::now();
+    OE_TEST(enclave_generate_remote_reports(enclave, count) == OE_OK);
+    auto end = std::chrono::steady_clock::now();
+
+    double seconds = std::chrono::duration<double>(end - start).count();
+    printf(
+        "Generated %zu remote reports in %.3f s (%.1f reports/second)\n",
+        count,
+        seconds,
+        seconds > 0 ? (double)count / seconds : 0.0);
+}
+#endif
+
 void generate_and_save_report(oe_enclave_t* enclave)
 {
 #ifdef OE_LINK_SGX_DCAP_QL
@@ -156,6 +179,10 @@ int main(int argc, const char* argv[])
      */
     g_enclave = enclave;
 
+    test_collateral_cache();
+    test_cert_chain_cache();
+    OE_TEST(enclave_test_collateral_cache(enclave) == OE_OK);
+
 #ifdef OE_LINK_SGX_DCAP_QL
 
     /* Initialize the target info */
@@ -192,6 +219,8 @@ int main(int argc, const char* argv[])
 
     OE_TEST(enclave_test_verify_report_with_collaterals(enclave) == OE_OK);
 
+    benchmark_remote_reports(enclave);
+
     TestVerifyTCBInfo(enclave, "./data/tcbInfo.json");
     TestVerifyTCBInfo(enclave, "./data/tcbInfo_with_pceid.json");
 
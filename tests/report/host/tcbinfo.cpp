@@ -107,6 +107,34 @@ void TestVerifyTCBInfo(
 
     oe_datetime_t nextUpdate = {2019, 6, 6, 10, 12, 17};
     OE_TEST(oe_datetime_compare(&parsed_info->next_update, &nextUpdate) == 0);
+
+    // Looking up the platform's TCB level in the compiled TCB info must give
+    // the same results as parsing the TCB info.
+    oe_compiled_tcb_info_t compiled;
+    oe_tcb_info_tcb_level_t compiled_tcb_level = *platform_tcb_level;
+    oe_parsed_tcb_info_t compiled_info = {0};
+
+    OE_TEST(
+        oe_compile_tcb_info_json(&tcbInfo[0], tcbInfo.size(), &compiled) ==
+        OE_OK);
+    OE_TEST(
+        oe_compiled_tcb_info_get_tcb_level(
+            &compiled, &compiled_tcb_level, &compiled_info) == expected);
+    oe_free_compiled_tcb_info(&compiled);
+
+    OE_TEST(
+        compiled_tcb_level.status.AsUINT32 ==
+        platform_tcb_level->status.AsUINT32);
+    AssertParsedValues(compiled_info, version);
+    OE_TEST(
+        memcmp(
+            compiled_info.tcb_level.sgx_tcb_comp_svn,
+            parsed_info->tcb_level.sgx_tcb_comp_svn,
+            sizeof(compiled_info.tcb_level.sgx_tcb_comp_svn)) == 0);
+    OE_TEST(compiled_info.tcb_level.pce_svn == parsed_info->tcb_level.pce_svn);
+    OE_TEST(
+        compiled_info.tcb_level.status.AsUINT32 ==
+        parsed_info->tcb_level.status.AsUINT32);
 }
 
 void TestVerifyTCBInfo(oe_enclave_t* enclave, const char* test_filename)
@@ -533,10 +533,280 @@ bool TestAsymKey()
     return true;
 }
 
+// Test the cache of derived asymmetric keys: the cached keys must be the
+// keys that are derived without it.
+bool TestAsymKeyCache()
+{
+    oe_asymmetric_key_params_t params = {};
+    uint8_t* privkey = NULL;
+    size_t privkey_size = 0;
+    uint8_t* privkey2 = NULL;
+    size_t privkey2_size = 0;
+    bool ret = false;
+
+    params.type = OE_ASYMMETRIC_KEY_EC_SECP256P1;
+    params.format = OE_ASYMMETRIC_KEY_PEM;
+
+    if (oe_set_asymmetric_key_cache_size(1000) != OE_INVALID_PARAMETER)
+        goto done;
+
+    if (oe_get_private_key_by_policy(
+            OE_SEAL_POLICY_UNIQUE,
+            &params,
+            &privkey,
+            &privkey_size,
+            NULL,
+            NULL) != OE_OK)
+        goto done;
+
+    // Two entries are fewer than the keys of TestAsymKey(), which evicts
+    // keys as well.
+    if (oe_set_asymmetric_key_cache_size(2) != OE_OK)
+        goto done;
+
+    for (size_t i = 0; i < 2; i++)
+    {
+        if (oe_get_private_key_by_policy(
+                OE_SEAL_POLICY_UNIQUE,
+                &params,
+                &privkey2,
+                &privkey2_size,
+                NULL,
+                NULL) != OE_OK)
+            goto done;
+
+        if (privkey2_size != privkey_size ||
+            memcmp(privkey, privkey2, privkey_size) != 0)
+            goto done;
+
+        oe_free_key(privkey2, privkey2_size, NULL, 0);
+        privkey2 = NULL;
+    }
+
+    if (!TestAsymKey())
+        goto done;
+
+    ret = true;
+
+done:
+    oe_set_asymmetric_key_cache_size(0);
+    oe_free_key(privkey, privkey_size, NULL, 0);
+    oe_free_key(privkey2, privkey2_size, NULL, 0);
+    return ret;
+}
+
+// Test sealing and unsealing data with oe_seal() and oe_unseal().
+bool TestSeal()
+{
+    const uint8_t ad[] = "additional data";
+    uint8_t data[1000];
+    uint8_t blob[OE_SEALED_SIZE(sizeof(data))];
+    uint8_t unsealed[sizeof(data)];
+    size_t blob_size;
+    size_t unsealed_size;
+
+    for (size_t i = 0; i < sizeof(data); i++)
+        data[i] = (uint8_t)i;
+
+    for (uint32_t seal_policy = OE_SEAL_POLICY_UNIQUE;
+         seal_policy <= OE_SEAL_POLICY_PRODUCT;
+         seal_policy++)
+    {
+        // Query the size of the sealed data.
+        blob_size = 0;
+        if (oe_seal(
+                (oe_seal_policy_t)seal_policy,
+                data,
+                sizeof(data),
+                ad,
+                sizeof(ad),
+                NULL,
+                &blob_size) != OE_BUFFER_TOO_SMALL ||
+            blob_size != sizeof(blob))
+            return false;
+
+        if (oe_seal(
+                (oe_seal_policy_t)seal_policy,
+                data,
+                sizeof(data),
+                ad,
+                sizeof(ad),
+                blob,
+                &blob_size) != OE_OK)
+            return false;
+
+        unsealed_size = sizeof(unsealed);
+        if (oe_unseal(
+                blob, blob_size, ad, sizeof(ad), unsealed, &unsealed_size) !=
+                OE_OK ||
+            unsealed_size != sizeof(data) ||
+            memcmp(unsealed, data, sizeof(data)) != 0)
+            return false;
+
+        // The additional data must match.
+        if (oe_unseal(blob, blob_size, NULL, 0, unsealed, &unsealed_size) !=
+            OE_CRYPTO_ERROR)
+            return false;
+
+        // The magic, the reserved field and the nonce (including its unused
+        // bytes) occupy the first 24 bytes of the header.
+        for (size_t i = 0; i < 24; i++)
+        {
+            blob[i] ^= 1;
+            oe_result_t result = oe_unseal(
+                blob, blob_size, ad, sizeof(ad), unsealed, &unsealed_size);
+            blob[i] ^= 1;
+
+            if (result == OE_OK)
+                return false;
+        }
+
+        // Any modification of the header or the ciphertext must be detected.
+        for (size_t i = 4; i < blob_size; i += 97)
+        {
+            blob[i] ^= 1;
+            oe_result_t result = oe_unseal(
+                blob, blob_size, ad, sizeof(ad), unsealed, &unsealed_size);
+            blob[i] ^= 1;
+
+            if (result == OE_OK)
+                return false;
+        }
+    }
+
+    return true;
+}
+
+// Test sealing and unsealing chunks of a stream.
+bool TestSealStream()
+{
+    const uint8_t ad[] = "additional data";
+    uint8_t header[OE_SEAL_HEADER_SIZE];
+    uint8_t data[3][100];
+    uint8_t chunks[3][sizeof(data[0]) + OE_SEAL_TAG_SIZE];
+    uint8_t unsealed[sizeof(data[0])];
+    size_t size;
+    uint32_t index;
+    oe_seal_stream_t* stream = NULL;
+    bool ret = false;
+
+    for (size_t i = 0; i < sizeof(data); i++)
+        data[i / sizeof(data[0])][i % sizeof(data[0])] = (uint8_t)i;
+
+    if (oe_seal_stream_init(
+            OE_SEAL_POLICY_UNIQUE,
+            ad,
+            sizeof(ad),
+            header,
+            sizeof(header),
+            &stream) != OE_OK)
+        goto done;
+
+    // A chunk that does not fit uses no number.
+    size = 0;
+    if (oe_seal_stream_chunk(
+            stream, false, data[0], sizeof(data[0]), NULL, &size, &index) !=
+            OE_BUFFER_TOO_SMALL ||
+        size != sizeof(chunks[0]))
+        goto done;
+
+    // The chunks are numbered in the order they are sealed.
+    for (uint32_t i = 0; i < 3; i++)
+    {
+        size = sizeof(chunks[i]);
+        if (oe_seal_stream_chunk(
+                stream,
+                i == 2,
+                data[i],
+                sizeof(data[i]),
+                chunks[i],
+                &size,
+                &index) != OE_OK ||
+            size != sizeof(chunks[i]) || index != i)
+            goto done;
+    }
+
+    // Nothing is sealed after the last chunk.
+    size = sizeof(chunks[0]);
+    if (oe_seal_stream_chunk(
+            stream,
+            false,
+            data[0],
+            sizeof(data[0]),
+            chunks[0],
+            &size,
+            &index) != OE_UNEXPECTED)
+        goto done;
+
+    oe_seal_stream_free(stream);
+    stream = NULL;
+
+    // A stream with other additional data has another key.
+    if (oe_unseal_stream_init(header, sizeof(header), NULL, 0, &stream) !=
+        OE_OK)
+        goto done;
+
+    size = sizeof(unsealed);
+    if (oe_unseal_stream_chunk(
+            stream, 0, false, chunks[0], sizeof(chunks[0]), unsealed, &size) !=
+        OE_CRYPTO_ERROR)
+        goto done;
+
+    oe_seal_stream_free(stream);
+    stream = NULL;
+
+    if (oe_unseal_stream_init(
+            header, sizeof(header), ad, sizeof(ad), &stream) != OE_OK)
+        goto done;
+
+    // A stream opened for unsealing would reuse the IVs of its chunks.
+    size = sizeof(unsealed);
+    if (oe_seal_stream_chunk(
+            stream, false, data[0], sizeof(data[0]), unsealed, &size, &index) !=
+        OE_INVALID_PARAMETER)
+        goto done;
+
+    // Chunks may be unsealed in any order.
+    for (uint32_t i = 3; i-- > 0;)
+    {
+        size = sizeof(unsealed);
+        if (oe_unseal_stream_chunk(
+                stream,
+                i,
+                i == 2,
+                chunks[i],
+                sizeof(chunks[i]),
+                unsealed,
+                &size) != OE_OK ||
+            size != sizeof(data[i]) ||
+            memcmp(unsealed, data[i], sizeof(data[i])) != 0)
+            goto done;
+    }
+
+    // Reordered and truncated streams must be detected.
+    size = sizeof(unsealed);
+    if (oe_unseal_stream_chunk(
+            stream, 1, false, chunks[0], sizeof(chunks[0]), unsealed, &size) !=
+        OE_CRYPTO_ERROR)
+        goto done;
+
+    if (oe_unseal_stream_chunk(
+            stream, 1, true, chunks[1], sizeof(chunks[1]), unsealed, &size) !=
+        OE_CRYPTO_ERROR)
+        goto done;
+
+    ret = true;
+
+done:
+    oe_seal_stream_free(stream);
+    return ret;
+}
+
 int test_seal_key(int in)
 {
     if (TestOEGetPrivilegeKeys() && TestOEGetRegularKeys() &&
-        TestOEGetSealKey() && TestAsymKey())
+        TestOEGetSealKey() && TestAsymKey() && TestAsymKeyCache() &&
+        TestSeal() && TestSealStream())
     {
         return 0;
     }
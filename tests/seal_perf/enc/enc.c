@@ -0,0 +1,157 @@
+// Copyright (c) Open Enclave SDK contributors.
+// Licensed under the MIT License.
+
+#include <mbedtls/gcm.h>
+#include <openenclave/enclave.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "seal_perf_t.h"
+
+#define IV_SIZE 12
+#define TAG_SIZE 16
+
+static oe_seal_stream_t* _stream;
+
+/* How enclaves sealed data before oe_seal() (samples/data-sealing): derive
+ * the seal key with EGETKEY on every call and encrypt with mbedTLS */
+static oe_result_t _baseline_seal(
+    const uint8_t* data,
+    size_t size,
+    uint8_t* output)
+{
+    oe_result_t result = OE_FAILURE;
+    uint8_t* key = NULL;
+    size_t key_size = 0;
+    uint8_t* key_info = NULL;
+    size_t key_info_size = 0;
+    uint8_t iv[IV_SIZE];
+    mbedtls_gcm_context gcm;
+
+    mbedtls_gcm_init(&gcm);
+
+    if (oe_get_seal_key_by_policy(
+            OE_SEAL_POLICY_UNIQUE,
+            &key,
+            &key_size,
+            &key_info,
+            &key_info_size) != OE_OK)
+        goto done;
+
+    if (oe_random(iv, sizeof(iv)) != OE_OK)
+        goto done;
+
+    if (mbedtls_gcm_setkey(
+            &gcm, MBEDTLS_CIPHER_ID_AES, key, (unsigned int)key_size * 8) ||
+        mbedtls_gcm_crypt_and_tag(
+            &gcm,
+            MBEDTLS_GCM_ENCRYPT,
+            size,
+            iv,
+            sizeof(iv),
+            NULL,
+            0,
+            data,
+            output,
+            TAG_SIZE,
+            output + size))
+        goto done;
+
+    result = OE_OK;
+
+done:
+    mbedtls_gcm_free(&gcm);
+    oe_free_seal_key(key, key_info);
+    return result;
+}
+
+oe_result_t enc_init_stream()
+{
+    uint8_t header[OE_SEAL_HEADER_SIZE];
+
+    return oe_seal_stream_init(
+        OE_SEAL_POLICY_UNIQUE, NULL, 0, header, sizeof(header), &_stream);
+}
+
+oe_result_t enc_run(
+    operation_t operation,
+    size_t size,
+    uint64_t iterations)
+{
+    oe_result_t result = OE_FAILURE;
+    uint8_t* data = NULL;
+    uint8_t* blob = NULL;
+    size_t blob_size = OE_SEALED_SIZE(size);
+    size_t data_size = size;
+    uint32_t index;
+
+    if (size > OE_SIZE_MAX - OE_SEALED_SIZE(0) ||
+        (operation == OPERATION_STREAM && !_stream))
+        return OE_INVALID_PARAMETER;
+
+    if (!(data = (uint8_t*)calloc(1, size ? size : 1)) ||
+        !(blob = (uint8_t*)malloc(blob_size)))
+        goto done;
+
+    if (operation == OPERATION_UNSEAL &&
+        oe_seal(OE_SEAL_POLICY_UNIQUE, data, size, NULL, 0, blob, &blob_size) !=
+            OE_OK)
+        goto done;
+
+    for (uint64_t i = 0; i < iterations; i++)
+    {
+        switch (operation)
+        {
+            case OPERATION_BASELINE:
+                if (_baseline_seal(data, size, blob) != OE_OK)
+                    goto done;
+                break;
+            case OPERATION_SEAL:
+                if (oe_seal(
+                        OE_SEAL_POLICY_UNIQUE,
+                        data,
+                        size,
+                        NULL,
+                        0,
+                        blob,
+                        &blob_size) != OE_OK)
+                    goto done;
+                break;
+            case OPERATION_UNSEAL:
+                if (oe_unseal(blob, blob_size, NULL, 0, data, &data_size) !=
+                    OE_OK)
+                    goto done;
+                break;
+            case OPERATION_STREAM:
+                if (oe_seal_stream_chunk(
+                        _stream, false, data, size, blob, &blob_size, &index) !=
+                    OE_OK)
+                    goto done;
+                break;
+            default:
+                result = OE_INVALID_PARAMETER;
+                goto done;
+        }
+    }
+
+    result = OE_OK;
+
+done:
+    free(data);
+    free(blob);
+    return result;
+}
+
+void enc_free_stream()
+{
+    oe_seal_stream_free(_stream);
+    _stream = NULL;
+}
+
+OE_SET_ENCLAVE_SGX(
+    1,     /* ProductID */
+    1,     /* SecurityVersion */
+    true,  /* AllowDebug */
+    12288, /* HeapPageCount */
+    64,    /* StackPageCount */
+    16);   /* TCSCount */
@@ -0,0 +1,206 @@
+// Copyright (c) Open Enclave SDK contributors.
+// Licensed under the MIT License.
+
+#include <openenclave/host.h>
+#include <openenclave/internal/tests.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "seal_perf_u.h"
+
+#define SKIP_RETURN_CODE 2
+
+#define DEFAULT_THREADS 4
+#define DEFAULT_BYTES (64 * 1024 * 1024)
+
+/* Must not exceed the TCSCount of the enclave */
+#define MAX_THREADS 16
+
+/*
+**==============================================================================
+**
+** Sealing benchmark:
+**
+**     seal_perf_host ENCLAVE [THREADS] [BYTES]
+**
+**         Seals or unseals BYTES bytes per thread in the enclave, in
+**         messages of several sizes, on 1, 2, 4, ... up to THREADS threads
+**         at once, and reports the throughput of all threads together:
+**
+**             baseline   oe_get_seal_key_by_policy() and mbedTLS AES-GCM
+**                        per message, as in samples/data-sealing
+**             oe_seal    oe_seal()
+**             oe_unseal  oe_unseal()
+**             stream     oe_seal_stream_chunk() on one stream shared by all
+**                        threads
+**
+**==============================================================================
+*/
+
+typedef struct _workload
+{
+    operation_t operation;
+    size_t size;
+} workload_t;
+
+typedef struct _thread_args
+{
+    const workload_t* workload;
+    oe_result_t result;
+} thread_args_t;
+
+static oe_enclave_t* _enclave;
+static uint64_t _bytes = DEFAULT_BYTES;
+
+static const workload_t _workloads[] = {
+    {OPERATION_BASELINE, 1024},
+    {OPERATION_SEAL, 1024},
+    {OPERATION_UNSEAL, 1024},
+    {OPERATION_STREAM, 1024},
+    {OPERATION_BASELINE, 64 * 1024},
+    {OPERATION_SEAL, 64 * 1024},
+    {OPERATION_UNSEAL, 64 * 1024},
+    {OPERATION_STREAM, 64 * 1024},
+    {OPERATION_BASELINE, 1024 * 1024},
+    {OPERATION_SEAL, 1024 * 1024},
+    {OPERATION_UNSEAL, 1024 * 1024},
+    {OPERATION_STREAM, 1024 * 1024},
+};
+
+static const char* _operation_names[] = {
+    "baseline",
+    "oe_seal",
+    "oe_unseal",
+    "stream",
+};
+
+static double _get_time_in_seconds(void)
+{
+    struct timespec current_time;
+    clock_gettime(CLOCK_MONOTONIC, &current_time);
+    return (double)current_time.tv_sec + (double)current_time.tv_nsec / 1e9;
+}
+
+static uint64_t _iterations(const workload_t* workload)
+{
+    uint64_t iterations = _bytes / workload->size;
+    return iterations ? iterations : 1;
+}
+
+static void* _thread(void* arg)
+{
+    thread_args_t* args = (thread_args_t*)arg;
+    oe_result_t result = enc_run(
+        _enclave,
+        &args->result,
+        args->workload->operation,
+        args->workload->size,
+        _iterations(args->workload));
+
+    if (result != OE_OK)
+        args->result = result;
+
+    return NULL;
+}
+
+static void _run(const workload_t* workload, size_t threads)
+{
+    pthread_t ids[MAX_THREADS];
+    thread_args_t args[MAX_THREADS];
+    double start;
+    double elapsed;
+    double bytes;
+
+    start = _get_time_in_seconds();
+
+    for (size_t i = 0; i < threads; i++)
+    {
+        args[i].workload = workload;
+        args[i].result = OE_UNEXPECTED;
+        OE_TEST(pthread_create(&ids[i], NULL, _thread, &args[i]) == 0);
+    }
+
+    for (size_t i = 0; i < threads; i++)
+    {
+        pthread_join(ids[i], NULL);
+        OE_TEST(args[i].result == OE_OK);
+    }
+
+    elapsed = _get_time_in_seconds() - start;
+    bytes = (double)threads * (double)_iterations(workload) *
+            (double)workload->size;
+
+    printf(
+        "%-10s %12zu %7zu %12.1f\n",
+        _operation_names[workload->operation],
+        workload->size,
+        threads,
+        bytes / elapsed / 1e6);
+}
+
+int main(int argc, const char* argv[])
+{
+    oe_result_t result;
+    oe_result_t return_value;
+    size_t threads = DEFAULT_THREADS;
+    const uint32_t flags = oe_get_create_flags();
+
+    if (argc < 2 || argc > 4)
+    {
+        fprintf(stderr, "Usage: %s ENCLAVE [THREADS] [BYTES]\n", argv[0]);
+        return 1;
+    }
+
+    if (argc > 2)
+        threads = strtoul(argv[2], NULL, 10);
+
+    if (argc > 3)
+        _bytes = strtoull(argv[3], NULL, 10);
+
+    if (threads < 1 || threads > MAX_THREADS || !_bytes)
+    {
+        fprintf(
+            stderr,
+            "%s: THREADS must be 1 to %d, BYTES at least 1\n",
+            argv[0],
+            MAX_THREADS);
+        return 1;
+    }
+
+    if ((flags & OE_ENCLAVE_FLAG_SIMULATE) != 0)
+    {
+        printf("=== Skipped unsupported test in simulation mode (seal_perf)\n");
+        return SKIP_RETURN_CODE;
+    }
+
+    result = oe_create_seal_perf_enclave(
+        argv[1], OE_ENCLAVE_TYPE_AUTO, flags, NULL, 0, &_enclave);
+    OE_TEST(result == OE_OK);
+
+    OE_TEST(enc_init_stream(_enclave, &return_value) == OE_OK);
+    OE_TEST(return_value == OE_OK);
+
+    printf(
+        "%-10s %12s %7s %12s\n",
+        "operation",
+        "message size",
+        "threads",
+        "MB/s");
+
+    for (size_t i = 0; i < OE_COUNTOF(_workloads); i++)
+    {
+        for (size_t n = 1; n < threads; n *= 2)
+            _run(&_workloads[i], n);
+
+        _run(&_workloads[i], threads);
+    }
+
+    OE_TEST(enc_free_stream(_enclave) == OE_OK);
+    OE_TEST(oe_terminate_enclave(_enclave) == OE_OK);
+
+    printf("=== passed all tests (seal_perf)\n");
+
+    return 0;
+}
@@ -0,0 +1,57 @@
+// Copyright (c) Open Enclave SDK contributors.
+// Licensed under the MIT License.
+
+#include <openenclave/enclave.h>
+#include <openenclave/internal/crypto/sha.h>
+#include <openenclave/internal/sha256.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "sha_perf_t.h"
+
+oe_result_t enc_run(
+    implementation_t implementation,
+    size_t message_size,
+    uint64_t iterations)
+{
+    oe_result_t result = OE_FAILURE;
+    uint8_t* message = NULL;
+    bool hardware = implementation == IMPLEMENTATION_SHA_NI;
+
+    if (oe_sha256_set_hardware_enabled(hardware) != hardware)
+    {
+        result = OE_UNSUPPORTED;
+        goto done;
+    }
+
+    if (!(message = (uint8_t*)malloc(message_size ? message_size : 1)))
+        goto done;
+
+    memset(message, 0x5a, message_size);
+
+    for (uint64_t i = 0; i < iterations; i++)
+    {
+        oe_sha256_context_t context;
+        OE_SHA256 hash;
+
+        if (oe_sha256_init(&context) != OE_OK ||
+            oe_sha256_update(&context, message, message_size) != OE_OK ||
+            oe_sha256_final(&context, &hash) != OE_OK)
+            goto done;
+    }
+
+    result = OE_OK;
+
+done:
+    free(message);
+    oe_sha256_set_hardware_enabled(true);
+    return result;
+}
+
+OE_SET_ENCLAVE_SGX(
+    1,    /* ProductID */
+    1,    /* SecurityVersion */
+    true, /* AllowDebug */
+    1024, /* HeapPageCount */
+    64,   /* StackPageCount */
+    1);   /* TCSCount */
@@ -0,0 +1,126 @@
+// Copyright (c) Open Enclave SDK contributors.
+// Licensed under the MIT License.
+
+#include <openenclave/host.h>
+#include <openenclave/internal/tests.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "sha_perf_u.h"
+
+#define DEFAULT_BYTES (64 * 1024 * 1024)
+
+/*
+**==============================================================================
+**
+** Enclave SHA-256 benchmark:
+**
+**     sha_perf_host ENCLAVE [BYTES]
+**
+**         Hashes BYTES bytes in the enclave with oe_sha256_init(),
+**         oe_sha256_update() and oe_sha256_final(), in messages of several
+**         sizes, and reports the throughput of each implementation of the
+**         SHA-256 compression function:
+**
+**             portable   the C implementation
+**             sha-ni     the SHA extensions of the CPU, if it has them
+**
+**==============================================================================
+*/
+
+static oe_enclave_t* _enclave;
+static uint64_t _bytes = DEFAULT_BYTES;
+
+static const size_t _message_sizes[] = {64, 1024, 16 * 1024, 1024 * 1024};
+
+static const char* _implementation_names[] = {
+    "portable",
+    "sha-ni",
+};
+
+static double _get_time_in_seconds(void)
+{
+    struct timespec current_time;
+    clock_gettime(CLOCK_MONOTONIC, &current_time);
+    return (double)current_time.tv_sec + (double)current_time.tv_nsec / 1e9;
+}
+
+static void _run(implementation_t implementation, size_t message_size)
+{
+    uint64_t iterations = _bytes / message_size ? _bytes / message_size : 1;
+    oe_result_t return_value;
+    double start;
+    double elapsed;
+
+    start = _get_time_in_seconds();
+    OE_TEST(
+        enc_run(
+            _enclave,
+            &return_value,
+            implementation,
+            message_size,
+            iterations) == OE_OK);
+    elapsed = _get_time_in_seconds() - start;
+
+    if (return_value == OE_UNSUPPORTED)
+    {
+        printf(
+            "%-10s %12zu %12s\n",
+            _implementation_names[implementation],
+            message_size,
+            "unsupported");
+        return;
+    }
+
+    OE_TEST(return_value == OE_OK);
+
+    printf(
+        "%-10s %12zu %12.1f\n",
+        _implementation_names[implementation],
+        message_size,
+        (double)iterations * (double)message_size / elapsed / 1e6);
+}
+
+int main(int argc, const char* argv[])
+{
+    oe_result_t result;
+
+    if (argc < 2 || argc > 3)
+    {
+        fprintf(stderr, "Usage: %s ENCLAVE [BYTES]\n", argv[0]);
+        return 1;
+    }
+
+    if (argc > 2)
+        _bytes = strtoull(argv[2], NULL, 10);
+
+    if (!_bytes)
+    {
+        fprintf(stderr, "%s: BYTES must be at least 1\n", argv[0]);
+        return 1;
+    }
+
+    result = oe_create_sha_perf_enclave(
+        argv[1],
+        OE_ENCLAVE_TYPE_AUTO,
+        oe_get_create_flags(),
+        NULL,
+        0,
+        &_enclave);
+    OE_TEST(result == OE_OK);
+
+    printf("%-10s %12s %12s\n", "hash", "message size", "MB/s");
+
+    for (size_t i = 0; i < OE_COUNTOF(_message_sizes); i++)
+    {
+        _run(IMPLEMENTATION_PORTABLE, _message_sizes[i]);
+        _run(IMPLEMENTATION_SHA_NI, _message_sizes[i]);
+    }
+
+    OE_TEST(oe_terminate_enclave(_enclave) == OE_OK);
+
+    printf("=== passed all tests (sha_perf)\n");
+
+    return 0;
+}
@@ -0,0 +1,87 @@
+// Copyright (c) Open Enclave SDK contributors.
+// Licensed under the MIT License.
+
+#include <openenclave/enclave.h>
+#include <openenclave/internal/tests.h>
+#include "stack_classes_t.h"
+
+/* Must match sign.conf */
+#define NUM_SMALL_STACK_THREADS 2
+#define NUM_SMALL_STACK_PAGES 8
+#define NUM_LARGE_STACK_THREADS 2
+#define NUM_LARGE_STACK_PAGES 256
+#define NUM_THREADS (NUM_SMALL_STACK_THREADS + NUM_LARGE_STACK_THREADS)
+
+/* Guard page + stack + guard page + control pages (see host/sgx/create.c) */
+#define THREAD_SIZE(STACK_PAGES) (((STACK_PAGES) + 2 + 6) * OE_PAGE_SIZE)
+
+/* More than a small stack could possibly hold */
+#define LARGE_STACK_USAGE (512 * 1024)
+
+static volatile uint64_t _stack_addresses[NUM_THREADS];
+static volatile int _num_entered;
+static volatile int _num_published;
+
+static void _wait_for_threads(volatile int* counter, int num_threads)
+{
+    while (__atomic_load_n(counter, __ATOMIC_ACQUIRE) < num_threads)
+        asm volatile("pause");
+}
+
+static __attribute__((noinline)) void _use_large_stack(void)
+{
+    volatile uint8_t buffer[LARGE_STACK_USAGE];
+
+    /* Touch every page, starting from the top of the stack */
+    for (size_t i = sizeof(buffer); i > 0; i -= OE_PAGE_SIZE)
+        buffer[i - 1] = (uint8_t)(i / OE_PAGE_SIZE);
+
+    for (size_t i = sizeof(buffer); i > 0; i -= OE_PAGE_SIZE)
+        OE_TEST(buffer[i - 1] == (uint8_t)(i / OE_PAGE_SIZE));
+}
+
+void enclave_thread(int num_threads)
+{
+    uint64_t stack_address = (uint64_t)&stack_address;
+    size_t rank = 0;
+
+    OE_TEST(num_threads == NUM_THREADS);
+
+    /* Publish the stack address of this thread */
+    int index = __atomic_fetch_add(&_num_entered, 1, __ATOMIC_ACQ_REL);
+    OE_TEST(index < NUM_THREADS);
+    _stack_addresses[index] = stack_address;
+    __atomic_add_fetch(&_num_published, 1, __ATOMIC_ACQ_REL);
+
+    /* Every TCS is in use once all threads have published their address */
+    _wait_for_threads(&_num_published, NUM_THREADS);
+
+    /* Threads are laid out in increasing address order, small stacks first */
+    for (size_t i = 0; i < NUM_THREADS; i++)
+    {
+        if (_stack_addresses[i] < stack_address)
+            rank++;
+    }
+
+    /* The next thread runs at the same depth within its own stack, so the
+     * distance to its stack is the size of the next thread's pages */
+    if (rank < NUM_THREADS - 1)
+    {
+        uint64_t next = OE_UINT64_MAX;
+        uint64_t next_stack_pages = rank + 1 < NUM_SMALL_STACK_THREADS
+                                        ? NUM_SMALL_STACK_PAGES
+                                        : NUM_LARGE_STACK_PAGES;
+
+        for (size_t i = 0; i < NUM_THREADS; i++)
+        {
+            if (_stack_addresses[i] > stack_address &&
+                _stack_addresses[i] < next)
+                next = _stack_addresses[i];
+        }
+
+        OE_TEST(next - stack_address == THREAD_SIZE(next_stack_pages));
+    }
+
+    if (rank >= NUM_SMALL_STACK_THREADS)
+        _use_large_stack();
+}
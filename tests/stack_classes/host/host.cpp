@@ -0,0 +1,48 @@
+// Copyright (c) Open Enclave SDK contributors.
+// Licensed under the MIT License.
+
+#include <openenclave/host.h>
+#include <openenclave/internal/tests.h>
+#include <cstdio>
+#include <thread>
+#include <vector>
+#include "stack_classes_u.h"
+
+#define NUM_THREADS 4
+
+static void _enclave_thread(oe_enclave_t* enclave)
+{
+    OE_TEST(enclave_thread(enclave, NUM_THREADS) == OE_OK);
+}
+
+int main(int argc, const char* argv[])
+{
+    oe_result_t result;
+    const uint32_t flags = oe_get_create_flags();
+    oe_enclave_t* enclave = NULL;
+    std::vector<std::thread> threads;
+
+    if (argc != 2)
+    {
+        fprintf(stderr, "Usage: %s ENCLAVE_PATH\n", argv[0]);
+        return 1;
+    }
+
+    result = oe_create_stack_classes_enclave(
+        argv[1], OE_ENCLAVE_TYPE_SGX, flags, NULL, 0, &enclave);
+    OE_TEST(result == OE_OK);
+
+    // All threads stay in the enclave until every thread has entered, so
+    // each of them is bound to a different TCS.
+    for (int i = 0; i < NUM_THREADS; i++)
+        threads.emplace_back(std::thread(_enclave_thread, enclave));
+
+    for (auto& thread : threads)
+        thread.join();
+
+    OE_TEST(oe_terminate_enclave(enclave) == OE_OK);
+
+    printf("=== passed all tests (%s)\n", argv[0]);
+
+    return 0;
+}
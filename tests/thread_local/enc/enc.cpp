@@ -101,6 +101,20 @@ void prepare_for_test(int total_num_threads)
     g_lock.release();
 }
 
+void check_thread_local_init()
+{
+    // .tdata variables start with their template values and the parts of
+    // g_x that are not explicitly initialized are zero.
+    OE_TEST(__thread_int == 1);
+    OE_TEST(g_x[0] == 8);
+    for (size_t i = 1; i < OE_COUNTOF(g_x); i++)
+        OE_TEST(g_x[i] == 0);
+
+    // Modify them, the next ecall must not observe the new values.
+    __thread_int = 2;
+    g_x[1] = 3;
+}
+
 void increment_num_threads()
 {
     g_lock.acquire();
@@ -7,9 +7,11 @@
 #include <openenclave/internal/elf.h>
 #include <openenclave/internal/error.h>
 #include <openenclave/internal/tests.h>
+#include <openenclave/internal/types.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <chrono>
 #include <thread>
 #include "thread_local_u.h"
 
@@ -27,6 +29,56 @@ void run_enclave_thread(
     OE_TEST(enclave_thread(enclave, thread_num, iters, step) == OE_OK);
 }
 
+void time_first_ecall(oe_enclave_t* enclave, uint64_t* first, uint64_t* next)
+{
+    auto start = std::chrono::steady_clock::now();
+    OE_TEST(check_thread_local_init(enclave) == OE_OK);
+    auto middle = std::chrono::steady_clock::now();
+    OE_TEST(check_thread_local_init(enclave) == OE_OK);
+    auto end = std::chrono::steady_clock::now();
+
+    *first = (uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(
+                 middle - start)
+                 .count();
+    *next = (uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(
+                end - middle)
+                .count();
+}
+
+// Measure the latency of the first ecall made on each TCS, which includes
+// binding the TCS and initializing its thread data and thread-local storage,
+// and compare it with the latency of the following ecall on the same thread.
+void benchmark_first_ecall(oe_enclave_t* enclave)
+{
+    const int num_threads = 16;
+    std::thread threads[num_threads];
+    uint64_t first[num_threads];
+    uint64_t next[num_threads];
+    uint64_t first_total = 0;
+    uint64_t next_total = 0;
+
+    for (int t = 0; t < num_threads; ++t)
+        threads[t] =
+            std::thread(time_first_ecall, enclave, &first[t], &next[t]);
+
+    for (int t = 0; t < num_threads; ++t)
+    {
+        threads[t].join();
+        printf(
+            "TCS %2d: first ecall %llu us, next ecall %llu us\n",
+            t,
+            OE_LLU(first[t]),
+            OE_LLU(next[t]));
+        first_total += first[t];
+        next_total += next[t];
+    }
+
+    printf(
+        "average: first ecall %llu us, next ecall %llu us\n",
+        OE_LLU(first_total / (uint64_t)num_threads),
+        OE_LLU(next_total / (uint64_t)num_threads));
+}
+
 int main(int argc, const char* argv[])
 {
     oe_result_t result;
@@ -84,6 +136,8 @@ int main(int argc, const char* argv[])
              argv[1], OE_ENCLAVE_TYPE_SGX, flags, NULL, 0, &enclave)) != OE_OK)
         oe_put_err("oe_create_enclave(): result=%u", result);
 
+    benchmark_first_ecall(enclave);
+
     // Run it twice to make sure the enclave thread is correctly reinitialized.
     for (int i = 0; i < 2; ++i)
     {
@@ -131,6 +131,11 @@ done:
 typedef struct _config_file_options
 {
     bool debug;
+    uint8_t dynamic_heap;
+    uint8_t prerelocate;
+    uint8_t no_stack_fill;
+    size_t num_tcs_classes;
+    oe_sgx_tcs_class_t tcs_classes[OE_SGX_MAX_TCS_CLASSES];
     uint64_t num_heap_pages;
     uint64_t num_stack_pages;
     uint64_t num_tcs;
@@ -140,7 +145,9 @@ typedef struct _config_file_options
 
 #define CONFIG_FILE_OPTIONS_INITIALIZER                                 \
     {                                                                   \
-        .debug = false, .num_heap_pages = OE_UINT64_MAX,                \
+        .debug = false, .dynamic_heap = OE_UINT8_MAX,                   \
+        .prerelocate = OE_UINT8_MAX, .no_stack_fill = OE_UINT8_MAX,     \
+        .num_tcs_classes = 0, .num_heap_pages = OE_UINT64_MAX,          \
         .num_stack_pages = OE_UINT64_MAX, .num_tcs = OE_UINT64_MAX,     \
         .product_id = OE_UINT16_MAX, .security_version = OE_UINT16_MAX, \
     }
@@ -183,6 +190,38 @@ static int _check_for_missing_options(const ConfigFileOptions* options)
     return ret;
 }
 
+/* Parse a thread class of the form NUM_TCS:NUM_STACK_PAGES */
+static int _parse_tcs_class(str_t* str, oe_sgx_tcs_class_t* tcs_class)
+{
+    int rc = -1;
+    str_t num_tcs = STR_NULL_INIT;
+    str_t num_stack_pages = STR_NULL_INIT;
+
+    if (str_dynamic(&num_tcs, NULL, 0) != 0)
+        goto done;
+
+    if (str_dynamic(&num_stack_pages, NULL, 0) != 0)
+        goto done;
+
+    if (str_split(str, ":", &num_tcs, &num_stack_pages) != 0 ||
+        str_u32(&num_tcs, &tcs_class->num_tcs) != 0 ||
+        str_u32(&num_stack_pages, &tcs_class->num_stack_pages) != 0)
+        goto done;
+
+    /* Threads need a stack */
+    if (tcs_class->num_tcs > OE_SGX_MAX_TCS ||
+        (tcs_class->num_tcs && !tcs_class->num_stack_pages))
+        goto done;
+
+    rc = 0;
+
+done:
+    str_free(&num_tcs);
+    str_free(&num_stack_pages);
+
+    return rc;
+}
+
 static int _load_config_file(const char* path, ConfigFileOptions* options)
 {
     int rc = -1;
@@ -241,6 +280,66 @@ static int _load_config_file(const char* path, ConfigFileOptions* options)
 
             options->debug = (bool)value;
         }
+        else if (strcmp(str_ptr(&lhs), "DynamicHeap") == 0)
+        {
+            uint64_t value;
+
+            // DynamicHeap must be 0 or 1
+            if (str_u64(&rhs, &value) != 0 || (value > 1))
+            {
+                Err("%s(%zu): bad value for 'DynamicHeap'", path, line);
+                goto done;
+            }
+
+            options->dynamic_heap = (uint8_t)value;
+        }
+        else if (strcmp(str_ptr(&lhs), "PreRelocate") == 0)
+        {
+            uint64_t value;
+
+            // PreRelocate must be 0 or 1
+            if (str_u64(&rhs, &value) != 0 || (value > 1))
+            {
+                Err("%s(%zu): bad value for 'PreRelocate'", path, line);
+                goto done;
+            }
+
+            options->prerelocate = (uint8_t)value;
+        }
+        else if (strcmp(str_ptr(&lhs), "NoStackFill") == 0)
+        {
+            uint64_t value;
+
+            // NoStackFill must be 0 or 1
+            if (str_u64(&rhs, &value) != 0 || (value > 1))
+            {
+                Err("%s(%zu): bad value for 'NoStackFill'", path, line);
+                goto done;
+            }
+
+            options->no_stack_fill = (uint8_t)value;
+        }
+        else if (strcmp(str_ptr(&lhs), "TCSClass") == 0)
+        {
+            if (options->num_tcs_classes == OE_SGX_MAX_TCS_CLASSES)
+            {
+                Err("%s(%zu): too many 'TCSClass' settings (max=%d)",
+                    path,
+                    line,
+                    OE_SGX_MAX_TCS_CLASSES);
+                goto done;
+            }
+
+            if (_parse_tcs_class(
+                    &rhs, &options->tcs_classes[options->num_tcs_classes]) !=
+                0)
+            {
+                Err("%s(%zu): bad value for 'TCSClass'", path, line);
+                goto done;
+            }
+
+            options->num_tcs_classes++;
+        }
         else if (strcmp(str_ptr(&lhs), "NumHeapPages") == 0)
         {
             uint64_t n;
@@ -456,6 +555,24 @@ void _merge_config_file_options(
     if (options->debug)
         properties->config.attributes |= SGX_FLAGS_DEBUG;
 
+    /* If DynamicHeap option is present */
+    if (options->dynamic_heap == 1)
+        properties->config.flags |= OE_SGX_CONFIG_FLAGS_DYNAMIC_HEAP;
+    else if (options->dynamic_heap == 0)
+        properties->config.flags &= ~OE_SGX_CONFIG_FLAGS_DYNAMIC_HEAP;
+
+    /* If PreRelocate option is present */
+    if (options->prerelocate == 1)
+        properties->config.flags |= OE_SGX_CONFIG_FLAGS_PRERELOCATE;
+    else if (options->prerelocate == 0)
+        properties->config.flags &= ~OE_SGX_CONFIG_FLAGS_PRERELOCATE;
+
+    /* If NoStackFill option is present */
+    if (options->no_stack_fill == 1)
+        properties->config.flags |= OE_SGX_CONFIG_FLAGS_NO_STACK_FILL;
+    else if (options->no_stack_fill == 0)
+        properties->config.flags &= ~OE_SGX_CONFIG_FLAGS_NO_STACK_FILL;
+
     /* If ProductID option is present */
     if (options->product_id != OE_UINT16_MAX)
         properties->config.product_id = options->product_id;
@@ -477,6 +594,17 @@ void _merge_config_file_options(
     /* If NumTCS option is present */
     if (options->num_tcs != OE_UINT64_MAX)
         properties->header.size_settings.num_tcs = options->num_tcs;
+
+    /* If TCSClass options are present, they replace all thread classes */
+    if (options->num_tcs_classes)
+    {
+        memset(
+            properties->tcs_classes, 0, sizeof(properties->tcs_classes));
+        memcpy(
+            properties->tcs_classes,
+            options->tcs_classes,
+            options->num_tcs_classes * sizeof(oe_sgx_tcs_class_t));
+    }
 }
 
 static const char _usage_gen[] =
@@ -523,9 +651,28 @@ static const char _usage_sign[] =
     "        ProductID - the product identified number\n"
     "        SecurityVersion - the security version number\n"
     "        NumHeapPages - the number of heap pages for this enclave\n"
+    "        DynamicHeap - whether heap pages are committed on demand (1) "
+    "or\n"
+    "            added when the enclave is created (0); requires SGX2\n"
+    "        PreRelocate - whether thread-local relocations are resolved "
+    "when\n"
+    "            the image is measured (1) or by the enclave at runtime (0)\n"
     "        NumStackPages - the number of stack pages for this enclave\n"
     "        NumTCS - the number of thread control structures for this "
     "enclave\n"
+    "        TCSClass - NUM_TCS:NUM_STACK_PAGES, adds NUM_TCS thread "
+    "control\n"
+    "            structures with NUM_STACK_PAGES stack pages each; may be "
+    "given\n"
+    "            up to 4 times\n"
+    "        NoStackFill - whether stack pages are added zero-filled and "
+    "unmeasured\n"
+    "            (1) or filled with a pattern for debugging (0); "
+    "unmeasured stack\n"
+    "            pages hold host-controlled data when the enclave starts, "
+    "so only\n"
+    "            use 1 if the enclave never reads stack memory before writing "
+    "it\n"
     "\n"
     "    The configuration file contains simple NAME=VALUE entries. For "
     "example:\n"
@@ -576,6 +723,9 @@ int oesign(
     oe_sgx_enclave_properties_t props;
     oe_sgx_load_context_t context;
 
+    /* oe_sgx_build_enclave() keeps enc.startup_trace, which must be NULL */
+    memset(&enc, 0, sizeof(enc));
+
     /* Load the configuration file */
     if (_load_config_file(conffile, &options) != 0)
     {
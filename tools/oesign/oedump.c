@@ -192,6 +192,29 @@ void dump_enclave_properties(const oe_sgx_enclave_properties_t* props)
 
     printf("num_tcs=%llu\n", OE_LLU(props->header.size_settings.num_tcs));
 
+    bool dynamic_heap =
+        props->config.flags & OE_SGX_CONFIG_FLAGS_DYNAMIC_HEAP;
+    printf("dynamic_heap=%u\n", dynamic_heap);
+
+    bool prerelocate = props->config.flags & OE_SGX_CONFIG_FLAGS_PRERELOCATE;
+    printf("prerelocate=%u\n", prerelocate);
+
+    bool no_stack_fill =
+        props->config.flags & OE_SGX_CONFIG_FLAGS_NO_STACK_FILL;
+    printf("no_stack_fill=%u\n", no_stack_fill);
+
+    for (size_t i = 0; i < OE_SGX_MAX_TCS_CLASSES; i++)
+    {
+        const oe_sgx_tcs_class_t* tcs_class = &props->tcs_classes[i];
+
+        if (tcs_class->num_tcs)
+            printf(
+                "tcs_class[%zu]=%u:%u\n",
+                i,
+                tcs_class->num_tcs,
+                tcs_class->num_stack_pages);
+    }
+
     sigstruct = (const sgx_sigstruct_t*)props->sigstruct;
 
     printf("mrenclave=");